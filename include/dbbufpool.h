@@ -0,0 +1,192 @@
+#ifndef DBBUFPOOL_H
+#define DBBUFPOOL_H
+
+/*
+    Buffer pool of pages of index runs kept in RAM.
+    Pool simulates which pages are resident: every access is a hit (page in RAM) or a miss
+    (page is read from SSD and loaded into pool, if pool is full victim is evicted).
+
+    Policies:
+        LRU    - least recently used page is evicted
+        CLOCK  - second chance, hand clears reference bits until page without it is found
+        PINNED - no replacement, whole runs are pinned by owner of pool (see db_bufpool_pin)
+
+    Run which is rewritten has to be invalidated, its pages are dropped from pool.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum DB_bufpool_policy
+{
+    DB_BUFPOOL_LRU = 0,
+    DB_BUFPOOL_CLOCK,
+    DB_BUFPOOL_PINNED,
+    DB_BUFPOOL_NUM_POLICIES
+} DB_bufpool_policy;
+
+typedef struct DB_bufpool_frame
+{
+    uint64_t page;
+    size_t run;
+
+    /* LRU list, the most recently used page is first */
+    size_t prev;
+    size_t next;
+
+    /* list of pages of the same run, in free frame next is next free frame */
+    size_t run_prev;
+    size_t run_next;
+
+    bool used;
+    bool ref; /* CLOCK reference bit */
+} DB_bufpool_frame;
+
+typedef struct DB_bufpool
+{
+    DB_bufpool_policy policy;
+    size_t capacity; /* in pages */
+
+    /* frames are allocated when they are needed, so empty pool of big capacity is cheap */
+    DB_bufpool_frame *frames;
+    size_t num_frames;
+    size_t max_frames;
+    size_t free_frames;
+
+    /* (run, page) -> frame, open addressing with linear probing */
+    uint64_t *map_keys;
+    size_t *map_frames;
+    size_t map_capacity; /* power of 2 */
+
+    size_t lru_first;
+    size_t lru_last;
+    size_t hand;
+
+    size_t runs;
+    size_t *run_first;
+    size_t *run_pages; /* resident pages of run */
+
+    size_t hits;
+    size_t misses;
+    size_t evicted;
+    size_t invalidated;
+} DB_bufpool;
+
+/*
+    Create empty buffer pool
+
+    PARAMS
+    @IN policy - replacement policy
+    @IN capacity - pages which can be resident
+    @IN runs - number of runs, runs are numbered from 0
+
+    RETURN
+    NULL iff failure
+    Pointer to new pool
+*/
+DB_bufpool *db_bufpool_create(DB_bufpool_policy policy, size_t capacity, size_t runs);
+
+/*
+    Destroy buffer pool
+
+    PARAMS
+    @IN pool - pointer to pool
+
+    RETURN
+    This is a void function
+*/
+void db_bufpool_destroy(DB_bufpool *pool);
+
+/*
+    Add runs to pool, new runs are numbered after existing ones
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN runs - number of runs after call (not less than current number)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_bufpool_add_runs(DB_bufpool *pool, size_t runs);
+
+/*
+    Access page of run, on miss page is loaded into pool (except PINNED policy)
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN run - run
+    @IN page - page in run (< 2^48)
+
+    RETURN
+    true iff page was resident (hit)
+*/
+bool db_bufpool_access(DB_bufpool *pool, size_t run, uint64_t page);
+
+/*
+    Drop all pages of run, use it when run is rewritten
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN run - run
+
+    RETURN
+    Number of dropped pages
+*/
+size_t db_bufpool_invalidate(DB_bufpool *pool, size_t run);
+
+/*
+    Pin run in pool (PINNED policy only), every page of pinned run is resident
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN run - run
+    @IN pages - pages of run (0 unpins run)
+
+    RETURN
+    This is a void function
+*/
+void db_bufpool_pin(DB_bufpool *pool, size_t run, size_t pages);
+
+/*
+    Get resident pages of run
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN run - run
+
+    RETURN
+    Number of resident pages
+*/
+size_t db_bufpool_resident(const DB_bufpool *pool, size_t run);
+
+/*
+    Parse name of policy (lru, clock, pinned)
+
+    PARAMS
+    @IN str - name
+    @OUT policy - policy
+
+    RETURN
+    0 iff success
+    Non-zero value iff name is unknown
+*/
+int db_bufpool_policy_parse(const char *str, DB_bufpool_policy *policy);
+
+/*
+    Get name of policy
+
+    PARAMS
+    @IN policy - policy
+
+    RETURN
+    Name of policy
+*/
+const char *db_bufpool_policy_name(DB_bufpool_policy policy);
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef DBINDEX_H
+#define DBINDEX_H
+
+/*
+    Pluggable index: table of operations implemented by every cost model, so experiments
+    can run the same workload on different indexes which share the same SSD model.
+
+    Indexes:
+        fdtree       - FDTree (see dbindex_fdtree.h)
+        btree        - B+tree with in place updates (see dbindex_btree.h)
+        lsm-leveling - LSM-tree with one run per lvl (see dbindex_lsm.h)
+        lsm-tiering  - LSM-tree with size_ratio runs per lvl (see dbindex_lsm.h)
+        betree       - Bε-tree (see dbindex_betree.h)
+
+    Every index keeps one page of writes in RAM (HEAD, memtable or root) and nothing else,
+    extra RAM of FDTree (Bloom filters, buffer pool) is configured only through its own API.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <ssd.h>
+#include <dbstat.h>
+#include <dbindex_fdtree.h>
+
+typedef enum DB_index_type
+{
+    DB_INDEX_TYPE_FDTREE = 0,
+    DB_INDEX_TYPE_BTREE,
+    DB_INDEX_TYPE_LSM_LEVELING,
+    DB_INDEX_TYPE_LSM_TIERING,
+    DB_INDEX_TYPE_BETREE,
+    DB_INDEX_TYPE_NUM_TYPES
+} DB_index_type;
+
+/* Operations of index, void *index is index created by create */
+typedef struct DB_index_ops
+{
+    const char *name;
+
+    /* runs_ratio is ratio of lvls of FDTree and LSM-tree, B+tree and Bε-tree ignore it */
+    void *(*create)(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio);
+    void (*destroy)(void *index);
+
+    /* every operation returns its time and charges it to DB_stat of index */
+    double (*insert)(void *index, size_t entries);
+    double (*bulkload)(void *index, size_t entries);
+    double (*point_search)(void *index, size_t entries);
+    double (*range_search)(void *index, size_t entries, size_t queries);
+    double (*delete)(void *index, size_t entries);
+    double (*update)(void *index, size_t entries);
+
+    size_t (*num_entries)(const void *index);
+    double (*write_amplification)(const void *index);
+    double (*read_amplification)(const void *index);
+    double (*space_amplification)(const void *index);
+    void (*stat_print)(const void *index);
+} DB_index_ops;
+
+typedef struct DB_index
+{
+    const DB_index_ops *ops;
+    void *index;
+    DB_stat *stat;
+} DB_index;
+
+/*
+    Get operations of index
+
+    PARAMS
+    @IN type - type of index
+
+    RETURN
+    NULL iff type is unknown
+    Pointer to operations
+*/
+const DB_index_ops *db_index_ops(DB_index_type type);
+
+/*
+    Create empty index
+
+    PARAMS
+    @OUT index - pointer to index
+    @IN type - type of index
+    @IN SSD - ssd
+    @IN stat - statistics context, index charges time of every operation to it
+    @IN key_size - size of key in Bytes
+    @IN entry_size - size of entry in Bytes
+    @IN runs_ratio - ratio between capacity of lvl and lvl - 1 (FDTree and LSM-tree)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_create(DB_index *index, DB_index_type type, SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio);
+
+/*
+    Use created FDTree (with its modes) through operations of index, FDTree is destroyed with index
+
+    PARAMS
+    @OUT index - pointer to index
+    @IN fdtree - pointer to FDTree
+
+    RETURN
+    This is a void function
+*/
+void db_index_from_fdtree(DB_index *index, DB_index_fdtree *fdtree);
+
+/*
+    Destroy index
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_index_destroy(DB_index *index);
+
+/*
+    Parse name of index (fdtree, btree, lsm-leveling, lsm-tiering, betree)
+
+    PARAMS
+    @IN str - name
+    @OUT type - type of index
+
+    RETURN
+    0 iff success
+    Non-zero value iff name is unknown
+*/
+int db_index_type_parse(const char *str, DB_index_type *type);
+
+/*
+    Get name of index
+
+    PARAMS
+    @IN type - type of index
+
+    RETURN
+    Name of index
+*/
+const char *db_index_type_name(DB_index_type type);
+
+static inline double db_index_insert(const DB_index *index, size_t entries);
+static inline double db_index_bulkload(const DB_index *index, size_t entries);
+static inline double db_index_point_search(const DB_index *index, size_t entries);
+static inline double db_index_range_search_repeat(const DB_index *index, size_t entries, size_t queries);
+static inline double db_index_delete(const DB_index *index, size_t entries);
+static inline double db_index_update(const DB_index *index, size_t entries);
+static inline size_t db_index_num_entries(const DB_index *index);
+
+static inline double db_index_insert(const DB_index *index, size_t entries)
+{
+    return index->ops->insert(index->index, entries);
+}
+
+static inline double db_index_bulkload(const DB_index *index, size_t entries)
+{
+    return index->ops->bulkload(index->index, entries);
+}
+
+static inline double db_index_point_search(const DB_index *index, size_t entries)
+{
+    return index->ops->point_search(index->index, entries);
+}
+
+static inline double db_index_range_search_repeat(const DB_index *index, size_t entries, size_t queries)
+{
+    return index->ops->range_search(index->index, entries, queries);
+}
+
+static inline double db_index_delete(const DB_index *index, size_t entries)
+{
+    return index->ops->delete(index->index, entries);
+}
+
+static inline double db_index_update(const DB_index *index, size_t entries)
+{
+    return index->ops->update(index->index, entries);
+}
+
+static inline size_t db_index_num_entries(const DB_index *index)
+{
+    return index->ops->num_entries(index->index);
+}
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef DBINDEX_BETREE_H
+#define DBINDEX_BETREE_H
+
+/*
+    Bε-tree Cost Model
+
+    Inner node has DBINDEX_BETREE_NODE_PAGES pages split between pivots and buffer of messages:
+    node of B pointers has up to B^ε children, rest of node buffers messages (insert, delete,
+    update) on their way down. Leaves are pages like in B+tree. Root is kept in RAM (like HEAD
+    of FDTree). Write puts message into root, node which buffers more than it can hold is flushed:
+    messages of the child with the most of them are moved to it, pages of both nodes with these
+    messages are updated in place (ssd_update_pages). Messages which reach leaves are applied,
+    leaves split like in B+tree (DBINDEX_BTREE_FILL) and tree grows from the root.
+
+    Search reads one page of every node on path from root to leaf (pivots and buffered messages
+    of child are kept together), leaves created by splits are read randomly by range search,
+    only leaves written by bulkload (DBINDEX_BTREE_FILL full) sequentially.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <ssd.h>
+#include <dbstat.h>
+
+/* part of node for pivots: node has pointers_per_node^ε children */
+#define DBINDEX_BETREE_EPSILON 0.5
+
+/* pages of inner node, big nodes let flush move many messages to one child */
+#define DBINDEX_BETREE_NODE_PAGES 16
+
+/* Lvl of nodes, lvl 0 is root, the last lvl are leaves */
+typedef struct BELvl
+{
+    size_t nodes;
+
+    /* messages buffered in nodes of lvl */
+    size_t messages;
+    size_t inserts;
+    size_t deletes;
+
+    size_t flushes; /* flushes of nodes of lvl into lvl + 1 */
+    size_t pages_updated; /* nodes of lvl + 1 and lvl rewritten by flushes */
+} BELvl;
+
+/* Work requested by user and I/O done for it */
+typedef struct BEIndex_stat
+{
+    size_t entries_written; /* inserted, deleted and updated entries */
+    size_t point_lookups;
+    size_t range_searches;
+
+    size_t search_pages_rread;
+    size_t search_pages_sread;
+
+    size_t pages_swrite; /* nodes written by bulkload */
+    size_t pages_rwrite; /* nodes created by splits */
+    size_t pages_updated; /* nodes rewritten in place by flushes */
+
+    size_t leaf_splits;
+    size_t inner_splits;
+} BEIndex_stat;
+
+typedef struct DB_index_betree
+{
+    size_t num_entries; /* live entries with messages not applied yet */
+    size_t entry_size; /* in bytes */
+    size_t key_size; /* in bytes */
+
+    size_t fanout; /* average children of node */
+    size_t buffer_entries; /* messages which fit into inner node */
+
+    /* lvls of nodes, they are added from the root when tree grows */
+    BELvl *lvls;
+    size_t height;
+
+    size_t leaf_entries; /* entries in leaves */
+    size_t leaves;
+    size_t inner_nodes;
+    size_t sorted_leaves; /* leaves written by bulkload in order of keys */
+
+    /* CPU time of keeping buffer of root sorted (in seconds) */
+    double buffer_time;
+
+    SSD *ssd;
+    DB_stat *stat;
+    BEIndex_stat index_stat;
+} DB_index_betree;
+
+/*
+    Create empty index
+
+    PARAMS
+    @IN SSD - ssd
+    @IN stat - statistics context, index charges time of every operation to it
+    @IN key_size - size of key in Bytes
+    @IN entry_size - size of entry in Bytes
+
+    RETURN
+    NULL iff failure
+    Pointer to new index
+*/
+DB_index_betree *db_index_betree_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size);
+
+/*
+    Destroy index
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_index_betree_destroy(DB_index_betree *index);
+
+/*
+    Insert entries to index
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to insert
+
+    RETURN
+    Insert time
+*/
+double db_index_betree_insert(DB_index_betree *index, size_t entries);
+
+/*
+    Bulkload sorted entries, empty index is built bottom up by sequential writes,
+    otherwise entries are inserted
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to load
+
+    RETURN
+    Bulkload time
+*/
+double db_index_betree_bulkload(DB_index_betree *index, size_t entries);
+
+/*
+    Search entries
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to find
+
+    RETURN
+    Search time
+*/
+double db_index_betree_point_search(DB_index_betree *index, size_t entries);
+
+/*
+    Range search
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries in range
+
+    RETURN
+    Search time
+*/
+double db_index_betree_range_search(DB_index_betree *index, size_t entries);
+
+/*
+    Repeat the same range search, index is not changed by search
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries in range
+    @IN queries - number of searches
+
+    RETURN
+    Time of all searches
+*/
+double db_index_betree_range_search_repeat(DB_index_betree *index, size_t entries, size_t queries);
+
+/*
+    Delete entries from index (delete messages are put into root)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to delete
+
+    RETURN
+    Delete time
+*/
+double db_index_betree_delete(DB_index_betree *index, size_t entries);
+
+/*
+    Update entries (update messages are put into root)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to update
+
+    RETURN
+    Update time
+*/
+double db_index_betree_update(DB_index_betree *index, size_t entries);
+
+/*
+    Get write amplification: bytes written to SSD / bytes of written entries
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Write amplification (0 iff nothing was written)
+*/
+double db_index_betree_write_amplification(const DB_index_betree *index);
+
+/*
+    Get read amplification: random pages read per search
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Read amplification (0 iff nothing was searched)
+*/
+double db_index_betree_read_amplification(const DB_index_betree *index);
+
+/*
+    Get space amplification: bytes of nodes / bytes of live entries
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Space amplification (0 iff index is empty)
+*/
+double db_index_betree_space_amplification(const DB_index_betree *index);
+
+/*
+    Print statistics of index on stdout
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_index_betree_stat_print(const DB_index_betree *index);
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef DBINDEX_BTREE_H
+#define DBINDEX_BTREE_H
+
+/*
+    B+tree Cost Model
+
+    Node is one page, root is kept in RAM (like HEAD of FDTree), every other node is on SSD.
+    Write goes down to its leaf and updates it in place (ssd_update_pages), leaf which overflows
+    is split: new leaf is written and its parent is updated. After random inserts leaves are
+    DBINDEX_BTREE_FILL full on average (Yao), leaves created by splits are not contiguous, so range
+    search reads them randomly, only leaves written by bulkload (DBINDEX_BTREE_FILL full too)
+    are read sequentially.
+    Deletes do not merge leaves (free at empty).
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <ssd.h>
+#include <dbstat.h>
+
+/* average fill of node after random inserts (ln 2) */
+#define DBINDEX_BTREE_FILL 0.69
+
+/* Work requested by user and I/O done for it */
+typedef struct BTIndex_stat
+{
+    size_t entries_written; /* inserted, deleted and updated entries */
+    size_t point_lookups;
+    size_t range_searches;
+
+    size_t search_pages_rread;
+    size_t search_pages_sread;
+    size_t write_pages_rread; /* inner nodes on path of writes */
+
+    size_t pages_swrite; /* nodes written by bulkload */
+    size_t pages_rwrite; /* nodes created by splits */
+    size_t pages_updated; /* nodes rewritten in place */
+
+    size_t leaf_splits;
+    size_t inner_splits;
+} BTIndex_stat;
+
+typedef struct DB_index_btree
+{
+    size_t num_entries;
+    size_t entry_size; /* in bytes */
+    size_t key_size; /* in bytes */
+    size_t height; /* levels of nodes with leaves and root */
+
+    size_t leaves;
+    size_t inner_nodes;
+    size_t sorted_leaves; /* leaves written by bulkload in order of keys */
+
+    SSD *ssd;
+    DB_stat *stat;
+    BTIndex_stat index_stat;
+} DB_index_btree;
+
+/*
+    Create empty index
+
+    PARAMS
+    @IN SSD - ssd
+    @IN stat - statistics context, index charges time of every operation to it
+    @IN key_size - size of key in Bytes
+    @IN entry_size - size of entry in Bytes
+
+    RETURN
+    NULL iff failure
+    Pointer to new index
+*/
+DB_index_btree *db_index_btree_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size);
+
+/*
+    Destroy index
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_index_btree_destroy(DB_index_btree *index);
+
+/*
+    Insert entries to index
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to insert
+
+    RETURN
+    Insert time
+*/
+double db_index_btree_insert(DB_index_btree *index, size_t entries);
+
+/*
+    Bulkload sorted entries, empty index is built bottom up by sequential writes,
+    otherwise entries are inserted
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to load
+
+    RETURN
+    Bulkload time
+*/
+double db_index_btree_bulkload(DB_index_btree *index, size_t entries);
+
+/*
+    Search entries
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to find
+
+    RETURN
+    Search time
+*/
+double db_index_btree_point_search(DB_index_btree *index, size_t entries);
+
+/*
+    Range search
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries in range
+
+    RETURN
+    Search time
+*/
+double db_index_btree_range_search(DB_index_btree *index, size_t entries);
+
+/*
+    Repeat the same range search, index is not changed by search
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries in range
+    @IN queries - number of searches
+
+    RETURN
+    Time of all searches
+*/
+double db_index_btree_range_search_repeat(DB_index_btree *index, size_t entries, size_t queries);
+
+/*
+    Delete entries from index
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to delete
+
+    RETURN
+    Delete time
+*/
+double db_index_btree_delete(DB_index_btree *index, size_t entries);
+
+/*
+    Update entries in place
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to update
+
+    RETURN
+    Update time
+*/
+double db_index_btree_update(DB_index_btree *index, size_t entries);
+
+/*
+    Get write amplification: bytes written to SSD / bytes of written entries
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Write amplification (0 iff nothing was written)
+*/
+double db_index_btree_write_amplification(const DB_index_btree *index);
+
+/*
+    Get read amplification: random pages read per search
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Read amplification (0 iff nothing was searched)
+*/
+double db_index_btree_read_amplification(const DB_index_btree *index);
+
+/*
+    Get space amplification: bytes of nodes / bytes of live entries
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Space amplification (0 iff index is empty)
+*/
+double db_index_btree_space_amplification(const DB_index_btree *index);
+
+/*
+    Print statistics of index on stdout
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_index_btree_stat_print(const DB_index_btree *index);
+
+#endif
@@ -11,38 +11,230 @@
 
 
 #include <stddef.h>
+#include <stdbool.h>
 #include <sys/types.h>
 #include <ssd.h>
+#include <ssd_ftl.h>
+#include <dbstat.h>
+#include <dbkeyset.h>
+#include <dbbufpool.h>
 
-#define DBINDEX_FDTREE_MAX_LVL    10
 #define DBINDEX_FDTREE_RUNS_RATIO 50
 
+/* time of operation which cannot be done (SSD is full or RAM for new lvl cannot be allocated) */
+#define DBINDEX_FDTREE_INVALID_TIME ((double)9999999999)
+
+/* CPU time of one key comparison in HEAD, in seconds */
+#define DBINDEX_FDTREE_HEAD_CMP_TIME 0.000000005
+
+/* CPU time of hashing one key into Bloom filter (all hash functions), in seconds */
+#define DBINDEX_FDTREE_BLOOM_KEY_TIME 0.00000005
+
+/* I/O done on lvl, merge into lvl is charged to lvl */
+typedef struct FDLvl_stat
+{
+    size_t pages_sread;
+    size_t pages_rread;
+    size_t pages_swrite;
+    size_t pages_rwrite;
+    size_t fence_pages;
+
+    size_t merges;
+    size_t entries_moved;
+    size_t tombstones_moved;
+
+    /* keys hashed into Bloom filter of lvl, filter is rebuilt by every merge into lvl */
+    size_t bloom_keys;
+
+    /* pages of searches found in buffer pool (not counted in pages_rread) */
+    size_t pages_hit;
+
+    /* time spent for merging into lvl (in seconds) */
+    double time;
+} FDLvl_stat;
+
+/* Work requested by user */
+typedef struct FDIndex_stat
+{
+    size_t entries_written; /* inserted and deleted entries */
+    size_t point_lookups;
+    size_t range_searches;
+    size_t range_pages_sread;
+
+    size_t updates;
+    size_t updates_absorbed; /* replaced version buffered in HEAD */
+    size_t updates_flushed; /* left HEAD by merge with lvl 0 */
+} FDIndex_stat;
+
 typedef struct FDLvl
 {
     size_t num_entries;
     size_t num_entries_to_delete;
     size_t max_entries;
+
+    /* max_entries of lvl / max_entries of lvl - 1 (HEAD for lvl 0) */
+    size_t runs_ratio;
+
+    /* logical space of run, used only in SSD FTL mode */
+    SSD_ftl_extent extent;
+
+    FDLvl_stat stat;
 } FDLvl;
 
+/* HEAD is sorted buffer in RAM, entry put into HEAD costs log2(max_entries) key comparisons */
 typedef struct FDHead
 {
     size_t num_entries;
     size_t num_entries_to_delete;
     size_t max_entries;
+    size_t pages;
+
+    /* entries which replace older version below HEAD (part of num_entries) */
+    size_t num_updates;
+
+    /* expected updates of buffered keys not counted yet */
+    double absorbed_carry;
+
+    /* CPU time spent for keeping HEAD sorted (in seconds) */
+    double time;
 } FDHead;
 
+/*
+    Key level mode: every run (HEAD and lvls) keeps set of its keys, so versions of the same key
+    meet in HEAD or during merge. Newer version replaces older one and tombstone is kept only
+    while older live version of key exists in deeper lvl, otherwise tombstone and entry cancel.
+*/
+typedef struct FDKeys
+{
+    DB_keyset head;
+    DB_keyset *lvls; /* one per lvl of index */
+
+    /* keys of operations without key (see db_index_fdtree_enable_keys) */
+    uint64_t next_insert_key;
+    uint64_t next_delete_key;
+    uint64_t next_update_key;
+
+    size_t absorbed_in_head; /* writes which replaced version in HEAD */
+    size_t cancelled_in_head; /* deletes which removed entry from HEAD without tombstone */
+    size_t cancelled_in_merge; /* tombstones which met entry during merge and both vanished */
+    size_t versions_dropped; /* older versions replaced during merge */
+} FDKeys;
+
+/*
+    Bloom filters of lvls kept in RAM. Point search reads page of lvl only if filter answers maybe,
+    so lookup of existing key reads lvl with its newest version and lvls above with false positives.
+    Budget is spread over lvls like in Monkey: false positive rate of lvl is proportional to its keys,
+    which minimises expected number of false positive probes for given budget.
+*/
+typedef struct FDBloom
+{
+    size_t budget; /* in bits */
+    bool stale; /* lvls have changed since last allocation */
+
+    /* arrays have one element per lvl of index */
+    double *keys; /* keys of lvl seen by last allocation */
+    double *bits_per_key;
+    double *fpr;
+
+    /* expected pages read from lvl by one lookup and part of page not charged yet */
+    double *probes;
+    double *carry;
+
+    double false_positives_per_lookup;
+    double false_positives; /* expected pages read because of false positives */
+} FDBloom;
+
+/*
+    Buffer pool of pages of lvls in RAM. Every page read by search goes through pool,
+    sequential reads of range search and merges bypass it. HEAD is always in RAM and its pages
+    are taken from budget. Lvl rewritten by merge (merge into lvl or lvl into lvl + 1)
+    is invalidated before next search.
+*/
+typedef struct FDPool
+{
+    DB_bufpool *pool;
+    size_t head_pages;
+
+    /* merges into lvl and lvl + 1 seen by pool, lvl has been rewritten iff sum has changed */
+    size_t *generation;
+
+    /* chooses page of lvl read by search */
+    uint64_t rand;
+} FDPool;
+
+/*
+    Incremental merge: flush of HEAD switches runs at once (HEAD is empty and new version of lvls
+    is searched), but I/O of whole cascade is done in steps charged to next writes. Merge is spread
+    evenly over writes left before next flush, so it ends before HEAD is full again, and write does
+    the rest at once when it is at most budget pages. Second flush cannot start before previous merge
+    ends, so write which fills HEAD while merge is not finished (absorbed writes) stalls and does rest of it.
+*/
+typedef struct FDMerge
+{
+    size_t budget; /* rest of merge done at once by one write */
+
+    /* merge in progress: pages not done yet and their time */
+    double pending_pages;
+    double pending_time;
+
+    size_t deferred; /* flushes done incrementally */
+    size_t steps; /* writes which did part of merge */
+    size_t stalls; /* flushes which waited for previous merge */
+    double stalled_pages;
+    double stall_time;
+} FDMerge;
+
 typedef struct DB_index_fdtree
 {
     size_t num_entries;
     size_t entry_size; /* in bytes */
     size_t key_size; /* in bytes */
     size_t height;
-    size_t runs_ratio;
+
+    /*
+        Ratios of lvls set by user, lvl i has runs_ratios[i] (the last one for deeper lvls).
+        With re-leveling (max_runs_ratio > 0) ratio of the deepest lvl grows twice instead of adding
+        new lvl until it reaches max_runs_ratio, lvl which stops to be the deepest gets back its ratio
+    */
+    size_t *runs_ratios;
+    size_t num_runs_ratios;
+    size_t max_runs_ratio;
+    size_t relevels; /* ratio changes made by re-leveling */
+
+    /* requests issued in parallel by index (1 - every I/O waits for previous one) */
+    size_t io_depth;
+
+    /*
+        Time of the last insert, delete or update split into CPU of HEAD and I/O of merges,
+        so scheduler (see dbsim.h) can charge them to different resources.
+        last_merge_time is I/O of merges started by write (whole merge also when it is done
+        incrementally), last_step_time is I/O of earlier merges done by write (steps and stalls)
+    */
+    double last_head_time;
+    double last_merge_time;
+    double last_step_time;
 
     SSD* ssd;
+    DB_stat *stat;
+    FDIndex_stat index_stat;
 
     FDHead headtree;
-    FDLvl sortedruns[DBINDEX_FDTREE_MAX_LVL];
+
+    /* lvls are added when they are needed, per lvl arrays of modes grow with them */
+    FDLvl *sortedruns;
+    size_t num_lvls;
+
+    /* NULL iff key level mode is off */
+    FDKeys *keys;
+
+    /* NULL iff Bloom filters are off */
+    FDBloom *bloom;
+
+    /* NULL iff buffer pool is off (every searched page is read from SSD) */
+    FDPool *pool;
+
+    /* NULL iff merges are done at once by write which fills HEAD */
+    FDMerge *merge;
 } DB_index_fdtree;
 
 
@@ -51,13 +243,16 @@ typedef struct DB_index_fdtree
 
     PARAMS
     @IN SSD - ssd
+    @IN stat - statistics context, index charges time of every operation to it
     @IN key_size - size of key in Bytes
     @IN entry_size - size of entry in Bytes
+    @IN runs_ratio - ratio between capacity of lvl and lvl - 1
 
     RETURN
+    NULL iff failure
     Pointer to new index
 */
-DB_index_fdtree *db_index_fdtree_create(SSD *ssd, size_t key_size, size_t entry_size, size_t runs_ratio);
+DB_index_fdtree *db_index_fdtree_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio);
 
 /*
     Destroy index
@@ -83,7 +278,154 @@ void db_index_fdtree_destroy(DB_index_fdtree *index);
 double db_index_fdtree_insert(DB_index_fdtree *index, size_t entries);
 
 /*
-    Insert entries via bulkload method
+    Set number of requests issued by index in parallel.
+    With io_depth > 1 both inputs of merge are read in parallel and batch of searches
+    runs io_depth searches at time
+
+    PARAMS
+    @IN index - pointer to index
+    @IN io_depth - requests in parallel (0 is treated as 1)
+
+    RETURN
+    This is a void function
+*/
+void db_index_fdtree_set_io_depth(DB_index_fdtree *index, size_t io_depth);
+
+/*
+    Set size of HEAD, capacities of all lvls are recomputed (lvl 0 holds runs_ratio HEADs).
+    Index has to be empty
+
+    PARAMS
+    @IN index - pointer to index
+    @IN pages - pages of RAM used by HEAD (0 is treated as 1)
+
+    RETURN
+    0 iff success
+    Non-zero value iff index is not empty
+*/
+int db_index_fdtree_set_head_pages(DB_index_fdtree *index, size_t pages);
+
+/*
+    Set ratios of lvls, lvl i gets ratios[i] and lvls deeper than num - 1 get ratios[num - 1].
+    Index has to be empty
+
+    PARAMS
+    @IN index - pointer to index
+    @IN ratios - ratios of lvls (at least 2)
+    @IN num - number of ratios
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_set_runs_ratios(DB_index_fdtree *index, const size_t *ratios, size_t num);
+
+/*
+    Turn on re-leveling (see DB_index_fdtree) or change its limit
+
+    PARAMS
+    @IN index - pointer to index
+    @IN max_ratio - the biggest ratio of the deepest lvl (0 turns re-leveling off)
+
+    RETURN
+    This is a void function
+*/
+void db_index_fdtree_set_relevel(DB_index_fdtree *index, size_t max_ratio);
+
+/*
+    Turn on Bloom filters of lvls (see FDBloom) or change their budget
+
+    PARAMS
+    @IN index - pointer to index
+    @IN bytes - RAM used by all filters in bytes (0 turns filters off)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_set_bloom(DB_index_fdtree *index, size_t bytes);
+
+/*
+    Turn on buffer pool (see FDPool) or replace it by new empty pool
+
+    PARAMS
+    @IN index - pointer to index
+    @IN policy - replacement policy, PINNED pins whole lvls from lvl 0 while they fit
+    @IN bytes - RAM of pool and HEAD in bytes (0 turns pool off)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_set_buffer_pool(DB_index_fdtree *index, DB_bufpool_policy policy, size_t bytes);
+
+/*
+    Turn on incremental merge (see FDMerge) or change its budget
+
+    PARAMS
+    @IN index - pointer to index
+    @IN pages - pages of merge which one write does at once (0 turns incremental merge off)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure (merge cannot be turned off while it is in progress)
+*/
+int db_index_fdtree_set_merge_budget(DB_index_fdtree *index, size_t pages);
+
+/*
+    Turn on key level mode (see FDKeys), index has to be empty.
+    Operations without key get keys from 2^63: insert uses new key, delete removes the oldest such key,
+    update goes round robin over live such keys
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_enable_keys(DB_index_fdtree *index);
+
+/*
+    Insert entry with key (key level mode only)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+
+    RETURN
+    Insert time
+*/
+double db_index_fdtree_insert_key(DB_index_fdtree *index, uint64_t key);
+
+/*
+    Delete entry with key (key level mode only)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+
+    RETURN
+    Delete time
+*/
+double db_index_fdtree_delete_key(DB_index_fdtree *index, uint64_t key);
+
+/*
+    Update entry with key (key level mode only)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+
+    RETURN
+    Update time
+*/
+double db_index_fdtree_update_key(DB_index_fdtree *index, uint64_t key);
+
+/*
+    Insert presorted entries via bulkload: HEAD, lvls above target lvl and new entries
+    are written in one sequential pass into the first lvl which can hold all of them,
+    so index does not have to be empty. New entries are newer than entries in index.
 
     PARAMS
     @IN index - pointer to index
@@ -118,6 +460,20 @@ double db_index_fdtree_point_search(DB_index_fdtree *index, size_t entries);
 */
 double db_index_fdtree_range_search(DB_index_fdtree *index, size_t entries);
 
+/*
+    Run the same range search many times.
+    Range search does not change index, so time of one search is charged queries times
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to find in each search
+    @IN queries - number of searches
+
+    RETURN
+    Search time of all searches
+*/
+double db_index_fdtree_range_search_repeat(DB_index_fdtree *index, size_t entries, size_t queries);
+
 /*
     Delete entries from index
 
@@ -131,7 +487,9 @@ double db_index_fdtree_range_search(DB_index_fdtree *index, size_t entries);
 double db_index_fdtree_delete(DB_index_fdtree *index, size_t entries);
 
 /*
-    Update entries in index
+    Update entries in index. Update puts new version into HEAD, if version of key is already
+    buffered in HEAD it is replaced in place (key is uniform over live entries), otherwise
+    new version takes slot of HEAD and older version is dropped when merge meets it
 
     PARAMS
     @IN index - pointer to index
@@ -142,4 +500,48 @@ double db_index_fdtree_delete(DB_index_fdtree *index, size_t entries);
 */
 double db_index_fdtree_update(DB_index_fdtree *index, size_t entries);
 
+/*
+    Get write amplification: bytes written on SSD per byte written by user
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Write amplification
+*/
+double db_index_fdtree_write_amplification(const DB_index_fdtree *index);
+
+/*
+    Get read amplification: pages read in random way per search
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Read amplification
+*/
+double db_index_fdtree_read_amplification(const DB_index_fdtree *index);
+
+/*
+    Get space amplification: bytes used by all lvls per byte of live entries
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Space amplification
+*/
+double db_index_fdtree_space_amplification(const DB_index_fdtree *index);
+
+/*
+    Print on stdout I/O statistics of every lvl and amplifications
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_index_fdtree_stat_print(const DB_index_fdtree *index);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,195 @@
+#ifndef DBINDEX_FDTREE_FILE_H
+#define DBINDEX_FDTREE_FILE_H
+
+/*
+    Real FDTree engine on files, used to validate cost model (dbindex_fdtree.h) against real I/O.
+    Layout is the same as in model: head tree (1 page) in RAM and sorted runs on disk,
+    capacity of lvl is runs_ratio times capacity of lvl - 1.
+    Every lvl is one file (path.lvl<i>), merge writes new run out of place and renames it.
+    Fence pointers (first key of every page) are kept in RAM, so search reads 1 page per lvl.
+
+    Entry layout: key as uint64_t in first 8 Bytes of key, tombstone flag after key, rest is payload.
+    Newer entry wins, delete inserts tombstone, tombstones are dropped in the last lvl.
+
+    I/O is done by pread / pwrite, with direct flag files are opened with O_DIRECT
+    (page cache is skipped, page size has to be multiple of logical block size).
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct FDFile_lvl
+{
+    int fd; /* -1 iff lvl has never been written */
+    size_t num_entries; /* with tombstones */
+    size_t max_entries;
+
+    /* first key of every page */
+    uint64_t *fences;
+    size_t num_pages;
+} FDFile_lvl;
+
+typedef struct FDFile_stat
+{
+    size_t pages_read;
+    size_t pages_written;
+    size_t merges;
+} FDFile_stat;
+
+typedef struct DB_index_fdtree_file
+{
+    char *path;
+    bool direct;
+
+    size_t page_size; /* in bytes */
+    size_t key_size; /* in bytes */
+    size_t entry_size; /* in bytes */
+    size_t entries_per_page;
+    size_t runs_ratio;
+
+    /* head tree: sorted array of entries */
+    uint8_t *head;
+    size_t head_entries;
+    size_t head_max_entries;
+
+    FDFile_lvl *lvls;
+    size_t height;
+    size_t max_height; /* allocated lvls */
+
+    /* aligned buffer for point search */
+    uint8_t *page;
+
+    FDFile_stat stat;
+} DB_index_fdtree_file;
+
+/*
+    Create empty index on files
+
+    PARAMS
+    @IN path - prefix of files used by index
+    @IN page_size - size of page in Bytes
+    @IN key_size - size of key in Bytes (at least 8)
+    @IN entry_size - size of entry in Bytes (bigger than key_size)
+    @IN runs_ratio - ratio between capacity of lvl and lvl - 1
+    @IN direct - true iff I/O has to skip page cache (O_DIRECT)
+
+    RETURN
+    NULL iff failure
+    Pointer to new index
+*/
+DB_index_fdtree_file *db_index_fdtree_file_create(const char *path, size_t page_size, size_t key_size, size_t entry_size, size_t runs_ratio, bool direct);
+
+/*
+    Destroy index and remove its files
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_index_fdtree_file_destroy(DB_index_fdtree_file *index);
+
+/*
+    Set size of head tree, capacities of all lvls are recomputed (lvl 0 holds runs_ratio heads).
+    Index has to be empty
+
+    PARAMS
+    @IN index - pointer to index
+    @IN pages - pages of RAM used by head tree (0 is treated as 1)
+
+    RETURN
+    0 iff success
+    Non-zero value iff index is not empty or failure
+*/
+int db_index_fdtree_file_set_head_pages(DB_index_fdtree_file *index, size_t pages);
+
+/*
+    Insert entry (or overwrite entry with the same key)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_file_insert(DB_index_fdtree_file *index, uint64_t key);
+
+/*
+    Insert entries via bulkload: keys are sorted in RAM and written with head and lvls above target lvl
+    in one sequential pass into the first lvl which can hold all of them
+
+    PARAMS
+    @IN index - pointer to index
+    @IN keys - keys of entries
+    @IN entries - number of entries
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_file_bulkload(DB_index_fdtree_file *index, const uint64_t *keys, size_t entries);
+
+/*
+    Search entry with key
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+    @OUT found - true iff entry exists
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_file_point_search(DB_index_fdtree_file *index, uint64_t key, bool *found);
+
+/*
+    Read entries with keys >= key
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - first key
+    @IN entries - max number of entries to read
+    @OUT found - number of read entries
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_file_range_search(DB_index_fdtree_file *index, uint64_t key, size_t entries, size_t *found);
+
+/*
+    Delete entry with key
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_file_delete(DB_index_fdtree_file *index, uint64_t key);
+
+/*
+    Update entry with key (delete old version and insert new one)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_file_update(DB_index_fdtree_file *index, uint64_t key);
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef DBINDEX_LSM_H
+#define DBINDEX_LSM_H
+
+/*
+    LSM-tree Cost Model
+
+    Writes go to buffer in RAM (memtable, the same size as default HEAD of FDTree), full buffer
+    is flushed as sorted run into lvl 0. Lvl i holds size_ratio times more entries than lvl i - 1.
+
+    Policies:
+        LEVELING - lvl has one run, flush merges buffer into run of lvl 0 and lvl which is full is
+                   merged into run of lvl + 1 (read both runs, write new one)
+        TIERING  - lvl has up to size_ratio runs, flush writes new run, lvl with size_ratio runs
+                   is merged into one new run of lvl + 1 (every entry is written once per lvl)
+
+    Deletes are tombstones and updates are new versions, both stay in runs until they reach
+    the deepest lvl, then tombstone and its entry (or older version) vanish.
+    Point search reads one page of every run (no filters), range search reads start page of
+    every run and pages of entries with garbage of runs.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <ssd.h>
+#include <dbstat.h>
+
+/* pages of buffer in RAM */
+#define DBINDEX_LSM_BUFFER_PAGES 1
+
+typedef enum DB_index_lsm_policy
+{
+    DB_INDEX_LSM_LEVELING = 0,
+    DB_INDEX_LSM_TIERING,
+    DB_INDEX_LSM_NUM_POLICIES
+} DB_index_lsm_policy;
+
+/* I/O done on lvl, merge into lvl is charged to lvl */
+typedef struct LSMLvl_stat
+{
+    size_t merges;
+    size_t pages_sread;
+    size_t pages_swrite;
+    size_t pages_rread; /* start pages of searches */
+
+    /* time spent for merging into lvl (in seconds) */
+    double time;
+} LSMLvl_stat;
+
+typedef struct LSMLvl
+{
+    size_t num_entries; /* entries in runs with tombstones and old versions */
+    size_t tombstones;
+    size_t versions; /* updates which replace version in deeper lvl */
+    size_t runs;
+
+    /* LEVELING: entries of lvl, TIERING: entries of one run */
+    size_t max_entries;
+
+    LSMLvl_stat stat;
+} LSMLvl;
+
+/* Work requested by user */
+typedef struct LSMIndex_stat
+{
+    size_t entries_written; /* inserted, deleted and updated entries */
+    size_t point_lookups;
+    size_t range_searches;
+    size_t range_pages_sread;
+    size_t garbage_dropped; /* tombstones, deleted entries and old versions removed in the deepest lvl */
+} LSMIndex_stat;
+
+typedef struct DB_index_lsm
+{
+    DB_index_lsm_policy policy;
+
+    size_t num_entries; /* live entries */
+    size_t entry_size; /* in bytes */
+    size_t key_size; /* in bytes */
+    size_t size_ratio;
+
+    /* buffer in RAM, flushed when it has max_entries */
+    LSMLvl buffer;
+    double buffer_time; /* CPU time of keeping buffer sorted (in seconds) */
+
+    /* lvls are added when they are needed */
+    LSMLvl *lvls;
+    size_t num_lvls;
+
+    SSD *ssd;
+    DB_stat *stat;
+    LSMIndex_stat index_stat;
+} DB_index_lsm;
+
+/*
+    Create empty index
+
+    PARAMS
+    @IN SSD - ssd
+    @IN stat - statistics context, index charges time of every operation to it
+    @IN key_size - size of key in Bytes
+    @IN entry_size - size of entry in Bytes
+    @IN size_ratio - ratio between capacity of lvl and lvl - 1 (at least 2)
+    @IN policy - merge policy
+
+    RETURN
+    NULL iff failure
+    Pointer to new index
+*/
+DB_index_lsm *db_index_lsm_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t size_ratio, DB_index_lsm_policy policy);
+
+/*
+    Destroy index
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_index_lsm_destroy(DB_index_lsm *index);
+
+/*
+    Insert entries to index
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to insert
+
+    RETURN
+    Insert time
+*/
+double db_index_lsm_insert(DB_index_lsm *index, size_t entries);
+
+/*
+    Bulkload sorted entries, into empty index they are written as one run of the first lvl
+    which can hold them, otherwise entries are inserted
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to load
+
+    RETURN
+    Bulkload time
+*/
+double db_index_lsm_bulkload(DB_index_lsm *index, size_t entries);
+
+/*
+    Search entries
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to find
+
+    RETURN
+    Search time
+*/
+double db_index_lsm_point_search(DB_index_lsm *index, size_t entries);
+
+/*
+    Range search
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries in range
+
+    RETURN
+    Search time
+*/
+double db_index_lsm_range_search(DB_index_lsm *index, size_t entries);
+
+/*
+    Repeat the same range search, index is not changed by search
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries in range
+    @IN queries - number of searches
+
+    RETURN
+    Time of all searches
+*/
+double db_index_lsm_range_search_repeat(DB_index_lsm *index, size_t entries, size_t queries);
+
+/*
+    Delete entries from index (tombstones are inserted)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to delete
+
+    RETURN
+    Delete time
+*/
+double db_index_lsm_delete(DB_index_lsm *index, size_t entries);
+
+/*
+    Update entries (new versions are inserted)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to update
+
+    RETURN
+    Update time
+*/
+double db_index_lsm_update(DB_index_lsm *index, size_t entries);
+
+/*
+    Get write amplification: bytes written to SSD / bytes of written entries
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Write amplification (0 iff nothing was written)
+*/
+double db_index_lsm_write_amplification(const DB_index_lsm *index);
+
+/*
+    Get read amplification: random pages read per search
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Read amplification (0 iff nothing was searched)
+*/
+double db_index_lsm_read_amplification(const DB_index_lsm *index);
+
+/*
+    Get space amplification: bytes of runs / bytes of live entries
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Space amplification (0 iff index is empty)
+*/
+double db_index_lsm_space_amplification(const DB_index_lsm *index);
+
+/*
+    Print statistics of index on stdout
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_index_lsm_stat_print(const DB_index_lsm *index);
+
+/*
+    Get name of policy
+
+    PARAMS
+    @IN policy - policy
+
+    RETURN
+    Name of policy
+*/
+const char *db_index_lsm_policy_name(DB_index_lsm_policy policy);
+
+#endif
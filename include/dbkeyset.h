@@ -0,0 +1,107 @@
+#ifndef DBKEYSET_H
+#define DBKEYSET_H
+
+/*
+    Set of keys with state of newest version (entry or tombstone) in one run of index.
+    Open addressing with linear probing, table grows x2 when it is 3/4 full,
+    removal shifts back following keys, so there are no deleted markers.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum DB_keyset_state
+{
+    DB_KEYSET_NONE = 0, /* key is not in set (empty slot) */
+    DB_KEYSET_ENTRY,
+    DB_KEYSET_TOMBSTONE
+} DB_keyset_state;
+
+typedef struct DB_keyset
+{
+    uint64_t *keys;
+    uint8_t *states; /* DB_keyset_state of every slot */
+    size_t capacity; /* power of 2 */
+    size_t size; /* entries and tombstones */
+    size_t tombstones;
+} DB_keyset;
+
+/*
+    Init empty set
+
+    PARAMS
+    @IN set - pointer to set
+    @IN capacity - initial capacity (rounded up to power of 2)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_keyset_init(DB_keyset *set, size_t capacity);
+
+/*
+    Free memory of set
+
+    PARAMS
+    @IN set - pointer to set
+
+    RETURN
+    This is a void function
+*/
+void db_keyset_free(DB_keyset *set);
+
+/*
+    Remove all keys from set (memory is kept)
+
+    PARAMS
+    @IN set - pointer to set
+
+    RETURN
+    This is a void function
+*/
+void db_keyset_clear(DB_keyset *set);
+
+/*
+    Get state of key
+
+    PARAMS
+    @IN set - pointer to set
+    @IN key - key
+
+    RETURN
+    DB_KEYSET_NONE iff key is not in set
+    State of key
+*/
+DB_keyset_state db_keyset_get(const DB_keyset *set, uint64_t key);
+
+/*
+    Insert key or change state of key
+
+    PARAMS
+    @IN set - pointer to set
+    @IN key - key
+    @IN state - new state (DB_KEYSET_ENTRY or DB_KEYSET_TOMBSTONE)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_keyset_put(DB_keyset *set, uint64_t key, DB_keyset_state state);
+
+/*
+    Remove key from set
+
+    PARAMS
+    @IN set - pointer to set
+    @IN key - key
+
+    RETURN
+    This is a void function
+*/
+void db_keyset_remove(DB_keyset *set, uint64_t key);
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef DBOPTIMIZE_H
+#define DBOPTIMIZE_H
+
+/*
+    Workload aware optimizer of index configuration.
+    Optimizer searches runs_ratio (given by number of lvls), size of HEAD and split of rest of RAM
+    between Bloom filters and buffer pool. Every candidate is ranked by closed form cost of mix:
+
+        write   - entry is merged into every lvl, merge into lvl reads and writes run of lvl - 1
+                  and (on average) half of lvl (the whole last lvl), so it costs (1 + r / 2) pages of lvl
+        read    - page of every lvl (without filters) or of lvl with key and false positives of lvls
+                  above it (Monkey allocation of filters), pages of the upper lvls which fit into pool are hits
+        scan    - start point like read and pages of entries read sequentially
+
+    Closed form does not know replacement of pool, queue depth and state of lvls after real history,
+    so the best candidates are simulated on index model (N entries are inserted, then mix is run)
+    and simulated cost decides.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <dbprofile.h>
+#include <dbworkload.h>
+
+#define DB_OPTIMIZE_MAX_SIM          16
+#define DB_OPTIMIZE_BLOOM_STEPS      10 /* RAM of Bloom filters is k / steps of RAM left by HEAD */
+#define DB_OPTIMIZE_SIM_CANDIDATES   5
+#define DB_OPTIMIZE_SIM_OPS          100000
+#define DB_OPTIMIZE_SIM_ROUND        1000 /* operations of mix issued at once by simulation */
+#define DB_OPTIMIZE_SIM_FLUSHES      4 /* simulation of writes lasts at least so many flushes of HEAD */
+#define DB_OPTIMIZE_SIM_MAX_SCALE    100 /* but not longer than scale * sim_ops */
+
+typedef struct DB_optimize_request
+{
+    DB_workload_mix mix;
+    size_t records; /* N */
+    double selectivity; /* part of N read by scan, 0 - scan length of mix */
+    size_t memory; /* RAM of HEAD, Bloom filters and buffer pool in bytes */
+
+    size_t sim_ops; /* operations of simulation (more when writes need it), 0 - closed form only */
+    size_t sim_candidates; /* the best candidates of closed form which are simulated */
+} DB_optimize_request;
+
+typedef struct DB_optimize_config
+{
+    size_t runs_ratio;
+    size_t lvls;
+    size_t head_pages;
+    size_t bloom_bytes;
+    size_t pool_bytes; /* RAM of pool and HEAD (see db_index_fdtree_set_buffer_pool), 0 iff pool is off */
+
+    /* closed form: seconds per operation */
+    double op_cost[DB_WORKLOAD_OP_NUM];
+    double cost; /* per operation of mix */
+
+    bool simulated;
+    double sim_cost; /* seconds per operation of mix in simulation */
+} DB_optimize_config;
+
+typedef struct DB_optimize_result
+{
+    DB_optimize_config best;
+
+    /* simulated candidates in order of closed form */
+    DB_optimize_config sim[DB_OPTIMIZE_MAX_SIM];
+    size_t num_sim;
+
+    size_t candidates; /* configurations ranked by closed form */
+    double time; /* wall time of optimizer in seconds */
+} DB_optimize_result;
+
+/*
+    Get default request: RAM 64MB, simulation of DB_OPTIMIZE_SIM_CANDIDATES candidates
+
+    PARAMS
+    @IN mix - mix of workload
+    @IN records - N
+
+    RETURN
+    Request
+*/
+DB_optimize_request db_optimize_request_default(const DB_workload_mix *mix, size_t records);
+
+/*
+    Find configuration of the lowest cost of mix on SSD and entry of profile
+    (index parameters of profile other than key_size, entry_size, io_depth and pool_policy are ignored)
+
+    PARAMS
+    @IN profile - pointer to profile
+    @IN request - pointer to request
+    @OUT result - the best configuration and simulated candidates
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure (error is printed on stderr)
+*/
+int db_optimize_run(const DB_profile *profile, const DB_optimize_request *request, DB_optimize_result *result);
+
+/*
+    Print on stdout result of optimizer with profile keys of the best configuration
+
+    PARAMS
+    @IN result - pointer to result
+
+    RETURN
+    This is a void function
+*/
+void db_optimize_print(const DB_optimize_result *result);
+
+#endif
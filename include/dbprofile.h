@@ -0,0 +1,116 @@
+#ifndef DBPROFILE_H
+#define DBPROFILE_H
+
+/*
+    Text profile of experiment configuration: SSD model and index parameters.
+    One "key = value" per line, '#' starts comment, times are in microseconds.
+
+    SSD keys:
+        ssd - (optional) built-in SSD used as base (samsung840, intelDCP4511, toshibaVX500),
+              keys given in file override its parameters
+        name, page_size, block_size, blocks, r_read_us, r_write_us, s_read_us, s_write_us,
+        erase_us, bus_us, channels, dies_per_channel, queue_depth, endurance
+
+        Without base: page_size, block_size, blocks, r_read_us, r_write_us, s_read_us, s_write_us
+        are required, erase_us defaults to 10 x r_write_us per page of block, bus_us to page over
+        SATA link (at most s_read_us), parallelism to 1 and endurance to DB_PROFILE_ENDURANCE
+
+    Index keys (optional): key_size, entry_size, runs_ratio, io_depth,
+        runs_ratios - ratios of lvls from lvl 0 "4,8,16" (the last one is used by deeper lvls), instead of runs_ratio
+        max_runs_ratio - re-leveling: ratio of the deepest lvl grows up to it before new lvl is added
+        memory_bytes - RAM of host (default DB_PROFILE_MEMORY_BYTES), HEAD has to fit into it
+        head_pages or head_bytes - RAM of HEAD (default 1 page), capacities of lvls follow it
+        bloom_bytes - RAM budget of Bloom filters of lvls (filters are off without it)
+        pool_bytes - RAM of buffer pool (pool is off without it)
+        pool_policy - replacement policy of buffer pool: lru (default), clock, pinned
+        merge_budget_pages - incremental merges: rest of merge done at once by one write (merges are done at once without it)
+
+    Profile saved by ssd_profile_save (see ssd.h) is a valid profile.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <ssd.h>
+#include <dbbufpool.h>
+
+#define DB_PROFILE_NAME_MAX    64
+#define DB_PROFILE_KEY_SIZE    sizeof(long)
+#define DB_PROFILE_ENTRY_SIZE  140
+#define DB_PROFILE_ENDURANCE   3000
+#define DB_PROFILE_MAX_RUNS_RATIOS 16
+#define DB_PROFILE_MEMORY_BYTES ((size_t)16 * 1024 * 1024 * 1024)
+
+typedef struct DB_profile
+{
+    char name[DB_PROFILE_NAME_MAX];
+
+    /* SSD parameters, new SSD is created by db_profile_ssd_create */
+    SSD ssd;
+
+    size_t key_size; /* in bytes */
+    size_t entry_size; /* in bytes */
+    size_t runs_ratio;
+    size_t runs_ratios[DB_PROFILE_MAX_RUNS_RATIOS];
+    size_t num_runs_ratios; /* 0 iff every lvl has runs_ratio */
+    size_t max_runs_ratio; /* 0 iff re-leveling is off */
+    size_t io_depth;
+    size_t memory_bytes;
+    size_t head_pages;
+    size_t bloom_bytes; /* 0 iff Bloom filters are off */
+    size_t pool_bytes; /* 0 iff buffer pool is off */
+    DB_bufpool_policy pool_policy;
+    size_t merge_budget; /* 0 iff merges are not incremental */
+} DB_profile;
+
+/*
+    Get default profile: samsung840 and default index
+
+    PARAMS
+    @OUT profile - default profile
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_profile_default(DB_profile *profile);
+
+/*
+    Load and validate profile from file
+
+    PARAMS
+    @IN path - path of profile file
+    @OUT profile - loaded profile
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure (every error is printed on stderr as path:line: message)
+*/
+int db_profile_load(const char *path, DB_profile *profile);
+
+/*
+    Create SSD described by profile
+
+    PARAMS
+    @IN profile - pointer to profile (name of SSD points to profile, so profile has to outlive SSD)
+
+    RETURN
+    NULL iff failure
+    Pointer to new SSD
+*/
+SSD *db_profile_ssd_create(const DB_profile *profile);
+
+/*
+    Print on stdout profile
+
+    PARAMS
+    @IN profile - pointer to profile
+
+    RETURN
+    This is a void function
+*/
+void db_profile_print(const DB_profile *profile);
+
+#endif
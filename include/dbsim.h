@@ -0,0 +1,192 @@
+#ifndef DBSIM_H
+#define DBSIM_H
+
+/*
+    Discrete event simulation of index on SSD.
+    Queries arrive in simulated time (Poisson process) and are served by the device,
+    merges caused by inserts are background jobs which share the device with searches.
+    Searches have priority, merges are executed in slices, so search waits for at most one slice.
+    Head tree is double buffered: write which fills the head while previous merge is still running
+    stalls (together with all next writes) until that merge is done.
+    Write is served by CPU (HEAD) without device, only I/O of merge started by write goes to device.
+    Merge done incrementally by index (see FDMerge) is one merge here, its steps paid by next writes
+    are ignored, because device does the whole merge in slices
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <dbstat.h>
+#include <dbindex_fdtree.h>
+
+typedef enum DB_sim_event_type
+{
+    DB_SIM_EVENT_ARRIVAL = 0, /* next query arrives */
+    DB_SIM_EVENT_DEVICE_DONE /* device finished query or merge slice */
+} DB_sim_event_type;
+
+typedef struct DB_sim_event
+{
+    double time; /* in seconds */
+    uint64_t seq; /* events with the same time are popped in push order */
+    DB_sim_event_type type;
+} DB_sim_event;
+
+/* Event queue (binary min heap by time) */
+typedef struct DB_sim_queue
+{
+    DB_sim_event *events;
+    size_t num_events;
+    size_t max_events;
+    uint64_t seq;
+} DB_sim_queue;
+
+typedef struct DB_sim_config
+{
+    size_t preload; /* entries bulkloaded before simulation */
+    size_t queries;
+    double arrival_rate; /* queries per second */
+
+    /* weight of every operation in workload (bulkload is ignored) */
+    double mix[DB_STAT_OP_NUM];
+
+    size_t range_entries; /* entries read by range search */
+
+    /* the longest piece of merge which cannot be interrupted by search (in seconds) */
+    double merge_slice;
+
+    uint64_t seed;
+} DB_sim_config;
+
+typedef struct DB_sim_result
+{
+    /* from arrival to finish of query */
+    DB_histogram response[DB_STAT_OP_NUM];
+
+    /* from arrival to start of service (or end of stall for writes) */
+    DB_histogram queueing[DB_STAT_OP_NUM];
+
+    double clock; /* simulated time when last job has finished */
+    double foreground_time; /* device busy with searches */
+    double background_time; /* device busy with merges */
+
+    size_t queries;
+    size_t merges;
+    size_t stalls; /* writes which waited for previous merge */
+    size_t max_queue; /* the longest queue of searches */
+} DB_sim_result;
+
+/*
+    Create empty event queue
+
+    PARAMS
+    @OUT queue - pointer to queue
+
+    RETURN
+    This is a void function
+*/
+void db_sim_queue_init(DB_sim_queue *queue);
+
+/*
+    Free memory of event queue
+
+    PARAMS
+    @IN queue - pointer to queue
+
+    RETURN
+    This is a void function
+*/
+void db_sim_queue_destroy(DB_sim_queue *queue);
+
+/*
+    Schedule event
+
+    PARAMS
+    @IN queue - pointer to queue
+    @IN time - time of event
+    @IN type - type of event
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_sim_queue_push(DB_sim_queue *queue, double time, DB_sim_event_type type);
+
+/*
+    Take the earliest event
+
+    PARAMS
+    @IN queue - pointer to queue
+    @OUT event - the earliest event
+
+    RETURN
+    false iff queue is empty
+*/
+bool db_sim_queue_pop(DB_sim_queue *queue, DB_sim_event *event);
+
+/*
+    Get default configuration: 50% inserts, 40% point searches, 5% range searches, 5% deletes
+
+    PARAMS
+    @IN ssd - pointer to SSD (merge slice is time of writing one erase block)
+    @IN queries - number of queries
+    @IN arrival_rate - queries per second
+
+    RETURN
+    Configuration
+*/
+DB_sim_config db_sim_config_default(const SSD *ssd, size_t queries, double arrival_rate);
+
+/*
+    Run simulation on index. Cost of every query is taken from index cost model
+    when query arrives, so index statistics are updated as in synchronous mode.
+    Write is split by last_head_time and last_merge_time of index
+
+    PARAMS
+    @IN index - pointer to index
+    @IN config - pointer to configuration
+
+    RETURN
+    NULL iff failure
+    Pointer to result
+*/
+DB_sim_result *db_sim_run(DB_index_fdtree *index, const DB_sim_config *config);
+
+/*
+    Destroy result of simulation
+
+    PARAMS
+    @IN result - pointer to result
+
+    RETURN
+    This is a void function
+*/
+void db_sim_result_destroy(DB_sim_result *result);
+
+/*
+    Get throughput of simulation
+
+    PARAMS
+    @IN result - pointer to result
+
+    RETURN
+    Queries per second of simulated time
+*/
+double db_sim_result_throughput(const DB_sim_result *result);
+
+/*
+    Print on stdout result of simulation
+
+    PARAMS
+    @IN result - pointer to result
+
+    RETURN
+    This is a void function
+*/
+void db_sim_result_print(const DB_sim_result *result);
+
+#endif
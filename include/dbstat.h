@@ -3,22 +3,66 @@
 
 /*
     Data base statistics included total time consumptions, current query time
+    Every simulation has own statistics context (DB_stat), so simulations can run in parallel.
+    Threads can keep own DB_stat as shard and merge shards at the end
+
     Author: Michal Kukowski
     email: michalkukowski10@gmail.com
     LICENCE GPL 3.0
 */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 
+/*
+    Latency histogram is log-bucketed (HDR style): values are kept in nanoseconds,
+    every power of 2 is split into 2^DB_HIST_SUB_BUCKET_BITS linear sub buckets,
+    so relative error of reported value is below 2^-DB_HIST_SUB_BUCKET_BITS
+*/
+#define DB_HIST_SUB_BUCKET_BITS 5
+#define DB_HIST_SUB_BUCKETS     ((size_t)1 << DB_HIST_SUB_BUCKET_BITS)
+#define DB_HIST_BUCKETS         ((64 - DB_HIST_SUB_BUCKET_BITS + 1) * DB_HIST_SUB_BUCKETS)
+
+typedef enum DB_stat_op
+{
+    DB_STAT_OP_INSERT = 0,
+    DB_STAT_OP_BULKLOAD,
+    DB_STAT_OP_POINT_SEARCH,
+    DB_STAT_OP_RANGE_SEARCH,
+    DB_STAT_OP_DELETE,
+    DB_STAT_OP_UPDATE,
+    DB_STAT_OP_NUM
+} DB_stat_op;
+
+typedef struct DB_histogram
+{
+    uint64_t counts[DB_HIST_BUCKETS];
+    uint64_t count;
+
+    /* in nanoseconds */
+    uint64_t max;
+} DB_histogram;
+
 typedef struct DB_snapshot
 {
     /* time in seconds */
     double query_time;
+
+    /* number of queries included in snapshot */
+    size_t queries;
 } DB_snapshot;
 
-extern DB_snapshot db_current_query;
-extern DB_snapshot db_total;
+typedef struct DB_stat
+{
+    DB_snapshot current_query;
+    DB_stat_op current_op;
+
+    DB_snapshot total;
+
+    /* latency of single query for each operation */
+    DB_histogram latency[DB_STAT_OP_NUM];
+} DB_stat;
 
 /*
     Private function, do not use directly
@@ -29,117 +73,267 @@ extern DB_snapshot db_total;
 
     Sum of all fields related to time
 */
-static inline double __db_stat_get_time(DB_snapshot *sh);
+static inline double __db_stat_get_time(const DB_snapshot *sh);
 
 
-static inline double __db_stat_get_time(DB_snapshot *sh)
+static inline double __db_stat_get_time(const DB_snapshot *sh)
 {
     return  sh->query_time;
 }
 
 /*
-    Reset whole DB Stat
+    Private function, do not use directly
+
+    PARAMS
+    @IN ns - value in nanoseconds
+
+    RETURN
+    Index of bucket for value
+*/
+static inline size_t __db_hist_bucket(uint64_t ns);
+
+
+static inline size_t __db_hist_bucket(uint64_t ns)
+{
+    size_t msb;
+
+    if (ns < DB_HIST_SUB_BUCKETS)
+        return (size_t)ns;
+
+    msb = (size_t)(63 - __builtin_clzll(ns));
+
+    return ((msb - DB_HIST_SUB_BUCKET_BITS + 1) << DB_HIST_SUB_BUCKET_BITS) + (size_t)((ns >> (msb - DB_HIST_SUB_BUCKET_BITS)) & (DB_HIST_SUB_BUCKETS - 1));
+}
+
+/*
+    Record value in histogram
+
+    PARAMS
+    @IN hist - pointer to histogram
+    @IN s - value in seconds
+    @IN count - how many times value occurred
+
+    RETURN
+    This is a void function
+*/
+static inline void db_hist_record(DB_histogram *hist, double s, size_t count);
+
+
+static inline void db_hist_record(DB_histogram *hist, double s, size_t count)
+{
+    const double ns_d = s * 1000000000.0 + 0.5;
+    const uint64_t ns = ns_d >= 18446744073709551615.0 ? UINT64_MAX : (ns_d > 0.0 ? (uint64_t)ns_d : 0);
+
+    hist->counts[__db_hist_bucket(ns)] += count;
+    hist->count += count;
+
+    if (count > 0 && ns > hist->max)
+        hist->max = ns;
+}
+
+/*
+    Get value at percentile
+
+    PARAMS
+    @IN hist - pointer to histogram
+    @IN percentile - percentile in range [0.0, 100.0]
+
+    RETURN
+    Highest value in seconds from bucket where percentile is
+*/
+double db_hist_percentile(const DB_histogram *hist, double percentile);
+
+/*
+    Get the biggest recorded value
+
+    PARAMS
+    @IN hist - pointer to histogram
+
+    RETURN
+    Max value in seconds
+*/
+double db_hist_max(const DB_histogram *hist);
+
+/*
+    Add all values from src to dst
+
+    PARAMS
+    @IN dst - pointer to histogram
+    @IN src - pointer to histogram
+
+    RETURN
+    This is a void function
+*/
+void db_hist_merge(DB_histogram *dst, const DB_histogram *src);
+
+/*
+    Get name of operation
+
+    PARAMS
+    @IN op - operation
+
+    RETURN
+    Name of operation
+*/
+const char *db_stat_op_name(DB_stat_op op);
+
+/*
+    Create empty statistics context
 
     PARAMS
     NO PARAMS
 
+    RETURN
+    NULL iff failure
+    Pointer to new statistics
+*/
+DB_stat *db_stat_create(void);
+
+/*
+    Destroy statistics context
+
+    PARAMS
+    @IN stat - pointer to statistics
+
+    RETURN
+    This is a void function
+*/
+void db_stat_destroy(DB_stat *stat);
+
+/*
+    Reset whole DB Stat
+
+    PARAMS
+    @IN stat - pointer to statistics
+
     RETURN
     This is a void function
 */
-void db_stat_reset(void);
+void db_stat_reset(DB_stat *stat);
 
 /*
     Reset only current query statictics
 
     PARAMS
-    NO PARAMS
+    @IN stat - pointer to statistics
 
     RETURN
     This is a void function
 */
-void db_stat_reset_query(void);
+void db_stat_reset_query(DB_stat *stat);
 
 /*
     Start new query
 
     PARAMS
-    NO PARAMS
+    @IN stat - pointer to statistics
+    @IN op - operation done by query
 
     RETURN
     This is a void function
 */
-void db_stat_start_query(void);
+void db_stat_start_query(DB_stat *stat, DB_stat_op op);
 
 /*
-    Finish current query and update total statistics
+    Start batch of identical read-only queries.
+    Index function called once for whole batch charges time of all queries,
+    so total time and number of queries are updated in one step
 
     PARAMS
-    NO PARAMS
+    @IN stat - pointer to statistics
+    @IN op - operation done by queries
+    @IN queries - number of queries in batch
 
     RETURN
     This is a void function
 */
-void db_stat_finish_query(void);
+void db_stat_start_queries(DB_stat *stat, DB_stat_op op, size_t queries);
+
+/*
+    Finish current query (or batch of queries) and update total statistics.
+    Latency of operation is recorded once per query in batch
+
+    PARAMS
+    @IN stat - pointer to statistics
+
+    RETURN
+    This is a void function
+*/
+void db_stat_finish_query(DB_stat *stat);
+
+/*
+    Add total statistics of src to total statistics of dst.
+    Use it to merge per thread shards when threads have finished, no locks are needed
+
+    PARAMS
+    @IN dst - pointer to statistics
+    @IN src - pointer to statistics
+
+    RETURN
+    This is a void function
+*/
+void db_stat_merge(DB_stat *dst, const DB_stat *src);
 
 /*
     Print on stdout info about current query
 
     PARAMS
-    NO PARAMS
+    @IN stat - pointer to statistics
 
     RETURN
     This is a void function
 */
-void db_stat_current_print(void);
+void db_stat_current_print(const DB_stat *stat);
 
 /*
-    Print on stdout summary info
+    Print on stdout summary info with latency percentiles of every operation
 
     PARAMS
-    NO PARAMS
+    @IN stat - pointer to statistics
 
     RETURN
     This is a void function
 */
-void db_stat_summary_print(void);
+void db_stat_summary_print(const DB_stat *stat);
 
 /*
     Update statistics  for current query
 
     PARAMS
+    @IN stat - pointer to statistics
     @IN s - seconds
 
     RETURN
     This is a void function
 */
-static inline void db_stat_update_query_time(double s);
+static inline void db_stat_update_query_time(DB_stat *stat, double s);
 
 /*
     Get query time  current query and total time
 
     PARAMS
-    NO PARAMS
+    @IN stat - pointer to statistics
 
     RETURN
     Query time
 */
-static inline double db_stat_get_current_time(void);
-static inline double db_stat_get_total_time(void);
+static inline double db_stat_get_current_time(const DB_stat *stat);
+static inline double db_stat_get_total_time(const DB_stat *stat);
 
 
-static inline void db_stat_update_query_time(double s)
+static inline void db_stat_update_query_time(DB_stat *stat, double s)
 {
-    db_current_query.query_time += s;
+    stat->current_query.query_time += s;
 }
 
-static inline double db_stat_get_current_time(void)
+static inline double db_stat_get_current_time(const DB_stat *stat)
 {
-    return __db_stat_get_time(&db_current_query);
+    return __db_stat_get_time(&stat->current_query);
 }
 
-static inline double db_stat_get_total_time(void)
+static inline double db_stat_get_total_time(const DB_stat *stat)
 {
-    return __db_stat_get_time(&db_total);
+    return __db_stat_get_time(&stat->total);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,97 @@
+#ifndef DBSWEEP_H
+#define DBSWEEP_H
+
+/*
+    Parameter sweep over SSD models and index configurations.
+    Every grid point runs normal workload experiment with own index, SSD and statistics,
+    grid points are executed in parallel by pool of threads with work stealing
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <ssd.h>
+#include <dbstat.h>
+#include <dbprofile.h>
+
+typedef SSD *(*DB_sweep_ssd_create)(void);
+
+/*
+    Grid is cartesian product of all parameters.
+    Grid order: ssd is the most significant parameter, then runs_ratio, then entry, then N.
+    SSDs of grid are built-in SSDs (ssds) followed by SSDs of loaded profiles (only SSD part of profile is used).
+    key_sizes[i] and entry_sizes[i] describe one entry, so both arrays have num_entries elements
+*/
+typedef struct DB_sweep_grid
+{
+    const DB_sweep_ssd_create *ssds;
+    size_t num_ssds;
+
+    const DB_profile *profiles;
+    size_t num_profiles;
+
+    const size_t *runs_ratios;
+    size_t num_runs_ratios;
+
+    const size_t *key_sizes; /* in bytes */
+    const size_t *entry_sizes; /* in bytes */
+    size_t num_entries;
+
+    const size_t *queries; /* N */
+    size_t num_queries;
+
+    double ops_per_second; /* rate of operations used for SSD lifetime projection */
+} DB_sweep_grid;
+
+typedef struct DB_sweep_result
+{
+    const char *ssd_name;
+    size_t runs_ratio;
+    size_t key_size;
+    size_t entry_size;
+    size_t queries;
+
+    DB_snapshot total;
+    double lifetime_days;
+} DB_sweep_result;
+
+/*
+    Get number of points in grid
+
+    PARAMS
+    @IN grid - pointer to grid
+
+    RETURN
+    Number of grid points
+*/
+size_t db_sweep_grid_size(const DB_sweep_grid *grid);
+
+/*
+    Run normal workload experiment for every grid point
+
+    PARAMS
+    @IN grid - pointer to grid
+    @IN threads - number of threads (0 - number of online CPUs)
+    @OUT total - (can be NULL) statistics of all points are added to total
+
+    RETURN
+    NULL iff failure
+    Pointer to array of db_sweep_grid_size(grid) results in grid order
+*/
+DB_sweep_result *db_sweep_run(const DB_sweep_grid *grid, size_t threads, DB_stat *total);
+
+/*
+    Print on stdout results of sweep
+
+    PARAMS
+    @IN results - array of results
+    @IN num_results - number of results
+
+    RETURN
+    This is a void function
+*/
+void db_sweep_print(const DB_sweep_result *results, size_t num_results);
+
+#endif
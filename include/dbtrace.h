@@ -0,0 +1,158 @@
+#ifndef DBTRACE_H
+#define DBTRACE_H
+
+/*
+    Binary workload trace.
+    File is header followed by fixed size records in host byte order, one record per run of operations
+    of the same type. Replay maps file into memory and streams records through db_index_fdtree API,
+    so traces bigger than RAM can be replayed without any allocation per record.
+
+    Text trace (converted by db_trace_convert) has one record per line, '#' starts comment:
+        op [count] [range] [@timestamp]
+    op - insert, bulkload, point, range, delete, update
+    count - number of operations (entries for bulkload), default 1
+    range - entries read by every range search (required only for range)
+    timestamp - time of record in nanoseconds
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <dbindex_fdtree.h>
+
+#define DB_TRACE_MAGIC      "FDTTRACE"
+#define DB_TRACE_VERSION    1
+
+/* record flags */
+#define DB_TRACE_TIMESTAMP  0x1
+
+typedef struct DB_trace_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t num_records;
+    uint64_t reserved;
+} DB_trace_header;
+
+typedef struct DB_trace_record
+{
+    uint8_t op; /* DB_stat_op */
+    uint8_t flags;
+    uint8_t reserved[6];
+    uint64_t count;
+    uint64_t range; /* entries read by every range search */
+    uint64_t timestamp; /* in nanoseconds, valid iff flags & DB_TRACE_TIMESTAMP */
+} DB_trace_record;
+
+typedef struct DB_trace_writer
+{
+    FILE *file;
+    uint64_t num_records;
+} DB_trace_writer;
+
+typedef struct DB_trace_summary
+{
+    size_t records;
+    size_t ops[DB_STAT_OP_NUM];
+
+    /* timestamps of first and last record with timestamp */
+    size_t timestamps;
+    uint64_t first_timestamp;
+    uint64_t last_timestamp;
+} DB_trace_summary;
+
+/*
+    Create trace file, header is finished by db_trace_writer_close
+
+    PARAMS
+    @IN path - path of trace file
+    @OUT writer - writer of trace
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_trace_writer_open(const char *path, DB_trace_writer *writer);
+
+/*
+    Append record to trace
+
+    PARAMS
+    @IN writer - pointer to writer
+    @IN record - pointer to record
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_trace_writer_append(DB_trace_writer *writer, const DB_trace_record *record);
+
+/*
+    Write header and close trace file
+
+    PARAMS
+    @IN writer - pointer to writer
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_trace_writer_close(DB_trace_writer *writer);
+
+/*
+    Convert text trace to binary trace
+
+    PARAMS
+    @IN text_path - path of text trace
+    @IN trace_path - path of binary trace
+    @OUT records - (can be NULL) number of written records
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure (errors are printed on stderr as path:line: message)
+*/
+int db_trace_convert(const char *text_path, const char *trace_path, size_t *records);
+
+/*
+    Replay binary trace on index
+
+    PARAMS
+    @IN index - pointer to index
+    @IN path - path of binary trace
+    @OUT summary - (can be NULL) summary of replayed trace
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure (errors are printed on stderr)
+*/
+int db_trace_replay(DB_index_fdtree *index, const char *path, DB_trace_summary *summary);
+
+/*
+    Get rate of operations recorded in trace
+
+    PARAMS
+    @IN summary - pointer to summary
+
+    RETURN
+    0.0 iff trace has less than 2 timestamps
+    Operations per second
+*/
+double db_trace_ops_per_second(const DB_trace_summary *summary);
+
+/*
+    Print on stdout summary of trace
+
+    PARAMS
+    @IN summary - pointer to summary
+
+    RETURN
+    This is a void function
+*/
+void db_trace_summary_print(const DB_trace_summary *summary);
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef DBWORKLOAD_H
+#define DBWORKLOAD_H
+
+/*
+    YCSB style workload generator.
+    Workload loads records keys and then runs ops operations drawn from mix of reads, updates,
+    inserts, deletes, scans and read-modify-writes. Keys are drawn from uniform, zipfian (scrambled,
+    so hot keys are spread over key space) or latest (recently inserted keys are hot) distribution,
+    inserts append new keys so key space grows during run.
+
+    Operations are generated into batch and batch is issued to index, consecutive operations
+    of the same kind (and scan length) are issued by one call.
+    If index is in key level mode (see db_index_fdtree_enable_keys) writes are issued with their keys.
+
+    Presets (YCSB core workloads):
+        A - 50% read, 50% update, zipfian
+        B - 95% read, 5% update, zipfian
+        C - 100% read, zipfian
+        D - 95% read, 5% insert, latest
+        E - 95% scan (1 - 100 entries), 5% insert, zipfian
+        F - 50% read, 50% read-modify-write, zipfian
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <dbindex_fdtree.h>
+
+#define DB_WORKLOAD_ZIPF_THETA  0.99
+#define DB_WORKLOAD_BATCH       1024
+
+typedef enum DB_workload_dist
+{
+    DB_WORKLOAD_DIST_UNIFORM = 0,
+    DB_WORKLOAD_DIST_ZIPFIAN,
+    DB_WORKLOAD_DIST_LATEST
+} DB_workload_dist;
+
+typedef enum DB_workload_op_type
+{
+    DB_WORKLOAD_READ = 0,
+    DB_WORKLOAD_UPDATE,
+    DB_WORKLOAD_INSERT,
+    DB_WORKLOAD_DELETE,
+    DB_WORKLOAD_SCAN,
+    DB_WORKLOAD_RMW, /* read and update of the same key */
+    DB_WORKLOAD_OP_NUM
+} DB_workload_op_type;
+
+/* xoshiro256** */
+typedef struct DB_rand
+{
+    uint64_t s[4];
+} DB_rand;
+
+typedef struct DB_workload_mix
+{
+    /* proportions of operations, sum does not have to be 1 */
+    double ratio[DB_WORKLOAD_OP_NUM];
+
+    /* length of scan is uniform in [scan_min, scan_max] */
+    size_t scan_min;
+    size_t scan_max;
+
+    DB_workload_dist dist;
+} DB_workload_mix;
+
+typedef struct DB_workload_config
+{
+    DB_workload_mix mix;
+    size_t records; /* keys loaded before run */
+    size_t ops;
+    size_t batch; /* operations generated at once */
+    double zipf_theta;
+    uint64_t seed;
+} DB_workload_config;
+
+typedef struct DB_workload_op
+{
+    DB_workload_op_type type;
+    uint64_t key;
+    size_t scan_length;
+} DB_workload_op;
+
+/* zipfian over [0, items), zeta is extended incrementally when items grows */
+typedef struct DB_zipf
+{
+    double theta;
+    double alpha;
+    double zeta2;
+    double zetan;
+    double eta;
+    size_t items;
+} DB_zipf;
+
+typedef struct DB_workload_summary
+{
+    size_t ops[DB_WORKLOAD_OP_NUM];
+    size_t scan_entries;
+    size_t hot_ops; /* operations on 1% of the most popular keys */
+    size_t records; /* keys after run */
+} DB_workload_summary;
+
+typedef struct DB_workload
+{
+    DB_workload_config config;
+
+    /* cumulative distribution of mix */
+    double cdf[DB_WORKLOAD_OP_NUM];
+
+    DB_rand rand;
+    DB_zipf zipf;
+    size_t records;
+    size_t generated;
+
+    DB_workload_op *batch;
+
+    DB_workload_summary summary;
+} DB_workload;
+
+/*
+    Seed generator (state is expanded by splitmix64)
+
+    PARAMS
+    @IN rand - pointer to generator
+    @IN seed - seed
+
+    RETURN
+    This is a void function
+*/
+void db_rand_seed(DB_rand *rand, uint64_t seed);
+
+/*
+    Get next random number
+
+    PARAMS
+    @IN rand - pointer to generator
+
+    RETURN
+    Random number
+*/
+uint64_t db_rand_next(DB_rand *rand);
+
+/*
+    Get random number from [0, 1)
+
+    PARAMS
+    @IN rand - pointer to generator
+
+    RETURN
+    Random number
+*/
+double db_rand_double(DB_rand *rand);
+
+/*
+    Get preset of YCSB core workload
+
+    PARAMS
+    @IN name - name of workload (A - F, case insensitive)
+    @OUT mix - mix of workload
+
+    RETURN
+    0 iff success
+    Non-zero value iff name is unknown
+*/
+int db_workload_mix_preset(const char *name, DB_workload_mix *mix);
+
+/*
+    Parse custom mix "read=0.5,update=0.3,insert=0.1,delete=0,scan=0.1,rmw=0"
+    (missing operations have ratio 0, scan length and distribution are not changed)
+
+    PARAMS
+    @IN str - string with mix
+    @OUT mix - parsed mix
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure (error is printed on stderr)
+*/
+int db_workload_mix_parse(const char *str, DB_workload_mix *mix);
+
+/*
+    Parse name of distribution (uniform, zipfian, latest)
+
+    PARAMS
+    @IN str - name
+    @OUT dist - distribution
+
+    RETURN
+    0 iff success
+    Non-zero value iff name is unknown
+*/
+int db_workload_dist_parse(const char *str, DB_workload_dist *dist);
+
+/*
+    Get name of operation
+
+    PARAMS
+    @IN op - operation
+
+    RETURN
+    Name of operation
+*/
+const char *db_workload_op_name(DB_workload_op_type op);
+
+/*
+    Get default configuration: YCSB A, 1M records, 1M ops
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    Configuration
+*/
+DB_workload_config db_workload_config_default(void);
+
+/*
+    Create workload
+
+    PARAMS
+    @IN config - pointer to configuration
+
+    RETURN
+    NULL iff failure (invalid configuration is reported on stderr)
+    Pointer to new workload
+*/
+DB_workload *db_workload_create(const DB_workload_config *config);
+
+/*
+    Destroy workload
+
+    PARAMS
+    @IN workload - pointer to workload
+
+    RETURN
+    This is a void function
+*/
+void db_workload_destroy(DB_workload *workload);
+
+/*
+    Generate next operation
+
+    PARAMS
+    @IN workload - pointer to workload
+    @OUT op - operation
+
+    RETURN
+    0 iff operation has been generated
+    Non-zero value iff all operations have been generated
+*/
+int db_workload_next(DB_workload *workload, DB_workload_op *op);
+
+/*
+    Load records and run all operations on index, statistics of index are not reset
+
+    PARAMS
+    @IN workload - pointer to workload
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+void db_workload_run(DB_workload *workload, DB_index_fdtree *index);
+
+/*
+    Print on stdout summary of generated operations
+
+    PARAMS
+    @IN workload - pointer to workload
+
+    RETURN
+    This is a void function
+*/
+void db_workload_summary_print(const DB_workload *workload);
+
+#endif
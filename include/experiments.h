@@ -10,6 +10,16 @@
 */
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <ssd.h>
+#include <ssd_ftl.h>
+#include <dbstat.h>
+#include <dbprofile.h>
+#include <dbworkload.h>
+#include <dbindex.h>
+
+/* rate of operations used for SSD lifetime projection */
+#define DB_EXPERIMENT_OPS_PER_SECOND 10000.0
 
 /*
     Normal workload experiment
@@ -29,4 +39,167 @@
 */
 void db_index_fdtree_experiment_workload(size_t queries);
 
+/*
+    Normal workload experiment (see db_index_fdtree_experiment_workload) on SSD and index from profile
+
+    PARAMS
+    @IN profile - pointer to profile
+    @IN queries - number of queries in batch (N)
+
+    RETURN
+    This is a void function
+*/
+void db_index_fdtree_experiment_workload_profile(const DB_profile *profile, size_t queries);
+
+/*
+    Replay binary trace (see dbtrace.h) on SSD and index from profile, lifetime of SSD is projected
+    with rate of operations from trace timestamps (DB_EXPERIMENT_OPS_PER_SECOND without timestamps)
+
+    PARAMS
+    @IN profile - pointer to profile
+    @IN path - path of binary trace
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_experiment_replay(const DB_profile *profile, const char *path);
+
+/*
+    YCSB style workload (see dbworkload.h) on SSD and index from profile
+
+    PARAMS
+    @IN profile - pointer to profile
+    @IN config - pointer to configuration of workload
+    @IN key_level - true iff index runs in key level mode (see db_index_fdtree_enable_keys)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int db_index_fdtree_experiment_ycsb(const DB_profile *profile, const DB_workload_config *config, bool key_level);
+
+/*
+    Normal workload experiment (see db_index_fdtree_experiment_workload) on SSD in FTL mode
+
+    PARAMS
+    @IN queries - number of queries in batch (N)
+    @IN blocks - number of physical blocks of SSD
+    @IN over_provisioning - part of physical space hidden from host
+    @IN policy - GC victim policy
+    @IN wl_policy - wear leveling policy
+    @IN wl_threshold - max gap between P/E cycles of blocks (used by static WL)
+
+    RETURN
+    This is a void function
+*/
+void db_index_fdtree_experiment_workload_ftl(size_t queries, size_t blocks, double over_provisioning, SSD_ftl_gc_policy policy,
+                                             SSD_ftl_wl_policy wl_policy, size_t wl_threshold);
+
+/*
+    Discrete event simulation (see dbsim.h) with default workload mix on samsung840.
+    With arrival_rate > 0 prints full result, otherwise prints throughput vs latency curve
+    for range of arrival rates
+
+    PARAMS
+    @IN queries - number of queries (and entries bulkloaded before simulation)
+    @IN arrival_rate - queries per second
+
+    RETURN
+    This is a void function
+*/
+void db_index_fdtree_experiment_sim(size_t queries, double arrival_rate);
+
+/*
+    Check discrete event simulation against index: writes which fit into HEAD do not use device
+    (no merge, stall or queueing), otherwise number of merges is number of flushes of HEAD
+
+    PARAMS
+    @IN queries - number of queries (and entries bulkloaded before simulation)
+
+    RETURN
+    0 iff all checks have passed
+    Non-zero value iff any check has failed
+*/
+int db_index_fdtree_experiment_sim_check(size_t queries);
+
+/*
+    Normal workload experiment (see db_index_fdtree_experiment_workload) on every SSD model
+    with growing number of requests issued in parallel by index. Prints total time for every pair
+
+    PARAMS
+    @IN queries - number of queries in batch (N)
+
+    RETURN
+    This is a void function
+*/
+void db_index_fdtree_experiment_workload_qd(size_t queries);
+
+/*
+    Validate cost model: run normal workload (see db_index_fdtree_experiment_workload) through
+    real FDTree engine on files (see dbindex_fdtree_file.h) and through model on given SSD,
+    then print predicted and measured time of every phase.
+    Search phases run at most samples queries on engine, measured time is scaled to all queries
+
+    PARAMS
+    @IN ssd - model of SSD where files are
+    @IN path - prefix of engine files
+    @IN queries - number of queries in batch (N)
+    @IN samples - max number of searches executed by engine in one phase
+    @IN direct - true iff engine has to use O_DIRECT
+    @IN head_pages - pages of HEAD of model and engine
+
+    RETURN
+    This is a void function
+*/
+void db_index_fdtree_experiment_validate(SSD *ssd, const char *path, size_t queries, size_t samples, bool direct, size_t head_pages);
+
+/*
+    Normal workload experiment (see db_index_fdtree_experiment_workload) on given configuration.
+    Statistics are reset before experiment
+
+    PARAMS
+    @IN stat - statistics context
+    @IN ssd - ssd
+    @IN key_size - size of key in Bytes
+    @IN entry_size - size of entry in Bytes
+    @IN runs_ratio - ratio between capacity of lvl and lvl - 1
+    @IN queries - number of queries in batch (N)
+
+    RETURN
+    Total statistics of experiment
+*/
+DB_snapshot db_index_fdtree_experiment_workload_run(DB_stat *stat, SSD *ssd, size_t key_size, size_t entry_size, size_t runs_ratio, size_t queries);
+
+
+/*
+    Normal workload experiment (see db_index_fdtree_experiment_workload) on index of type.
+    SSD, key_size, entry_size and runs_ratio are taken from profile, FDTree uses whole profile
+    (see db_index_fdtree_experiment_workload_profile)
+
+    PARAMS
+    @IN type - type of index
+    @IN profile - pointer to profile
+    @IN queries - number of queries in batch (N)
+
+    RETURN
+    This is a void function
+*/
+void db_index_experiment_workload(DB_index_type type, const DB_profile *profile, size_t queries);
+
+/*
+    Normal workload experiment (see db_index_fdtree_experiment_workload) on every index
+    under the same assumptions: new SSD from profile, key_size, entry_size and runs_ratio of profile,
+    one page of writes in RAM, io_depth 1. Prints time of every operation, amplifications
+    and wear of SSD for every index
+
+    PARAMS
+    @IN profile - pointer to profile
+    @IN queries - number of queries in batch (N)
+
+    RETURN
+    This is a void function
+*/
+void db_index_experiment_compare(const DB_profile *profile, size_t queries);
+
 #endif
\ No newline at end of file
@@ -12,6 +12,22 @@
 
 #define SSD_INT_CEIL_DIV(n, k) (((n) + (k) - 1) / (k))
 
+/* host interface bandwidth (bytes per second), SATA III link and PCIe 3.0 x4 NVMe */
+#define SSD_SATA_BANDWIDTH (600.0 * 1000.0 * 1000.0)
+#define SSD_NVME_BANDWIDTH (3000.0 * 1000.0 * 1000.0)
+
+/* time to transfer one page over host interface */
+#define SSD_BUS_TIME(page_size, bandwidth) ((double)(page_size) / (bandwidth))
+
+struct SSD_ftl;
+
+/* Wear caused by host */
+typedef struct SSD_stat
+{
+    size_t pages_written;
+    size_t blocks_erased;
+} SSD_stat;
+
 typedef struct SSD
 {
     /* random access time (seconds per page) */
@@ -25,11 +41,28 @@ typedef struct SSD
     /* erase time (seconds per block) */
     double erase_time;
 
+    /* interface transfer time (seconds per page), the lowest time per page of parallel I/O */
+    double bus_time;
+
+    /* internal parallelism, random requests in flight are served by different dies */
+    size_t channels;
+    size_t dies_per_channel;
+    size_t queue_depth; /* max requests in flight (NCQ / NVMe queue) */
+
     size_t page_size; /* in bytes */
     size_t block_size; /* in bytes */
+    size_t blocks; /* capacity in blocks */
+
+    /* rated P/E cycles of one block */
+    size_t endurance;
 
     size_t dirty_pages;
 
+    /* NULL iff FTL mode is off (see ssd_ftl.h) */
+    struct SSD_ftl *ftl;
+
+    SSD_stat stat;
+
     const char *name;
 } SSD;
 
@@ -77,6 +110,73 @@ SSD *ssd_create_toshibaVX500(void);
 */
 void ssd_destroy(SSD *ssd);
 
+/*
+    Create SSD with all parameters set to 0 (parameters have to be set by caller)
+
+    PARAMS
+    @IN name - name of SSD (not copied)
+
+    RETURN
+    NULL iff failure
+    Pointer to new SSD
+*/
+SSD *ssd_create_empty(const char *name);
+
+/*
+    Save SSD parameters as text profile (key = value lines, times in microseconds)
+
+    PARAMS
+    @IN ssd - pointer to SSD
+    @IN path - path of profile file
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int ssd_profile_save(const SSD *ssd, const char *path);
+
+/*
+    Project lifetime of SSD. Workload which has been simulated on SSD is repeated with given rate
+    until the most worn block reaches endurance. Without FTL wear leveling is assumed to be ideal
+    and every written page needs one erase of its place
+
+    PARAMS
+    @IN ssd - pointer to SSD
+    @IN ops - number of operations simulated on SSD
+    @IN ops_per_second - rate of operations
+
+    RETURN
+    Lifetime in days
+*/
+double ssd_lifetime_days(const SSD *ssd, double ops, double ops_per_second);
+
+/*
+    Print on stdout wear statistics and projected lifetime
+
+    PARAMS
+    @IN ssd - pointer to SSD
+    @IN ops - number of operations simulated on SSD
+    @IN ops_per_second - rate of operations
+
+    RETURN
+    This is a void function
+*/
+void ssd_wear_print(const SSD *ssd, double ops, double ops_per_second);
+
+/*
+    Add difference between SSD stat and before times to SSD stat.
+    Use it when cost of repeated work is charged at once
+
+    PARAMS
+    @IN ssd - pointer to SSD
+    @IN before - stat before work
+    @IN times - how many times work is repeated
+
+    RETURN
+    This is a void function
+*/
+static inline void ssd_stat_repeat(SSD *ssd, const SSD_stat *before, size_t times);
+
 /*
     Get number of pages per block in SSD
 
@@ -86,7 +186,7 @@ void ssd_destroy(SSD *ssd);
     RETURN
     Number of pages per block
 */
-static inline size_t ssd_pages_per_block(SSD *ssd);
+static inline size_t ssd_pages_per_block(const SSD *ssd);
 
 /*
     Read in random way pages from SSD.
@@ -140,6 +240,59 @@ static inline double ssd_sread_pages(SSD *ssd, size_t pages);
 */
 static inline double ssd_sread(SSD *ssd, size_t bytes);
 
+/*
+    Get number of requests which device really serves in parallel
+
+    PARAMS
+    @IN ssd - pointer to SSD
+    @IN in_flight - number of requests issued in parallel by host
+
+    RETURN
+    Number of requests served in parallel (at least 1)
+*/
+static inline size_t ssd_parallelism(const SSD *ssd, size_t in_flight);
+
+/*
+    Read in random way pages from SSD with in_flight requests in parallel.
+    Every die serves one request, throughput is limited by interface
+
+    PARAMS
+    @IN ssd - pointer to SSD
+    @IN pages - number of pages to read
+    @IN in_flight - number of requests issued in parallel by host
+
+    RETURN
+    Time spent on reading
+*/
+static inline double ssd_rread_pages_qd(SSD *ssd, size_t pages, size_t in_flight);
+
+/*
+    Read in sequential way pages from SSD by streams in parallel (pages are split between streams).
+    Throughput is limited by interface
+
+    PARAMS
+    @IN ssd - pointer to SSD
+    @IN pages - number of pages to read by all streams
+    @IN streams - number of streams
+
+    RETURN
+    Time spent on reading
+*/
+static inline double ssd_sread_pages_qd(SSD *ssd, size_t pages, size_t streams);
+
+/*
+    Read in sequential way 2 runs in parallel (e.g. both inputs of merge)
+
+    PARAMS
+    @IN ssd - pointer to SSD
+    @IN pages1 - number of pages of first run
+    @IN pages2 - number of pages of second run
+
+    RETURN
+    Time spent on reading
+*/
+static inline double ssd_sread_pages_overlap(SSD *ssd, size_t pages1, size_t pages2);
+
 /*
     Erase block (use only when you need erase block without writing or updating).
     NOTE: Update has own erasing if dirty pages are full
@@ -241,7 +394,13 @@ static inline double ssd_update_pages(SSD *ssd, size_t pages);
 */
 static inline double ssd_update(SSD *ssd, size_t bytes);
 
-static inline size_t ssd_pages_per_block(SSD *ssd)
+static inline void ssd_stat_repeat(SSD *ssd, const SSD_stat *before, size_t times)
+{
+    ssd->stat.pages_written += (ssd->stat.pages_written - before->pages_written) * times;
+    ssd->stat.blocks_erased += (ssd->stat.blocks_erased - before->blocks_erased) * times;
+}
+
+static inline size_t ssd_pages_per_block(const SSD *ssd)
 {
     return ssd->block_size / ssd->page_size;
 }
@@ -263,6 +422,64 @@ static inline double ssd_sread_pages(SSD *ssd, size_t pages)
     return time;
 }
 
+static inline size_t ssd_parallelism(const SSD *ssd, size_t in_flight)
+{
+    size_t parallelism = ssd->channels * ssd->dies_per_channel;
+
+    if (in_flight < parallelism)
+        parallelism = in_flight;
+
+    if (ssd->queue_depth < parallelism)
+        parallelism = ssd->queue_depth;
+
+    return parallelism > 0 ? parallelism : 1;
+}
+
+static inline double ssd_rread_pages_qd(SSD *ssd, size_t pages, size_t in_flight)
+{
+    const size_t parallelism = ssd_parallelism(ssd, in_flight);
+    double time_per_page;
+
+    if (parallelism == 1)
+        return ssd_rread_pages(ssd, pages);
+
+    time_per_page = ssd->r_read_time / (double)parallelism;
+    if (time_per_page < ssd->bus_time)
+        time_per_page = ssd->bus_time;
+
+    return time_per_page * (double)pages;
+}
+
+static inline double ssd_sread_pages_qd(SSD *ssd, size_t pages, size_t streams)
+{
+    double time_per_page;
+
+    if (streams > ssd->queue_depth)
+        streams = ssd->queue_depth;
+
+    if (streams <= 1)
+        return ssd_sread_pages(ssd, pages);
+
+    time_per_page = ssd->s_read_time / (double)streams;
+    if (time_per_page < ssd->bus_time)
+        time_per_page = ssd->bus_time;
+
+    return time_per_page * (double)pages;
+}
+
+static inline double ssd_sread_pages_overlap(SSD *ssd, size_t pages1, size_t pages2)
+{
+    const size_t longer = pages1 > pages2 ? pages1 : pages2;
+    const double stream_time = ssd->s_read_time * (double)longer;
+    const double bus_time = ssd->bus_time * (double)(pages1 + pages2);
+
+    if (ssd->queue_depth < 2)
+        return ssd_sread_pages(ssd, pages1) + ssd_sread_pages(ssd, pages2);
+
+    /* longer run is read to the end alone */
+    return stream_time > bus_time ? stream_time : bus_time;
+}
+
 static inline double ssd_sread(SSD *ssd, size_t bytes)
 {
     return ssd_sread_pages(ssd, SSD_INT_CEIL_DIV(bytes, ssd->page_size));
@@ -271,12 +488,14 @@ static inline double ssd_sread(SSD *ssd, size_t bytes)
 static inline double ssd_erase_blocks(SSD *ssd, size_t blocks)
 {
     const double time = ssd->erase_time * (double)blocks;
+    ssd->stat.blocks_erased += blocks;
     return time;
 }
 
 static inline double ssd_rwrite_pages(SSD *ssd, size_t pages)
 {
     const double time = ssd->r_write_time * (double)pages;
+    ssd->stat.pages_written += pages;
     return time;
 }
 
@@ -288,6 +507,7 @@ static inline double ssd_rwrite(SSD *ssd, size_t bytes)
 static inline double ssd_swrite_pages(SSD *ssd, size_t pages)
 {
     const double time = ssd->s_write_time * (double)pages;
+    ssd->stat.pages_written += pages;
     return time;
 }
 
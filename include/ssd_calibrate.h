@@ -0,0 +1,90 @@
+#ifndef SSD_CALIBRATE_H
+#define SSD_CALIBRATE_H
+
+/*
+    Calibration of SSD model on local drive.
+    O_DIRECT microbenchmarks (random and sequential reads and writes) are run on file or block device:
+        page size - knee of random read throughput (bigger request costs the same until it exceeds page),
+        erase block size - smallest aligned random write which reaches sequential write throughput,
+        parallelism - random read throughput with many threads in flight.
+    Erase time cannot be seen from host, it is estimated from extra cost of random writes.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <ssd.h>
+
+typedef struct SSD_calibrate_config
+{
+    size_t size; /* bytes of target used by benchmarks */
+    size_t ops; /* requests of every random benchmark */
+    size_t threads; /* requests in flight in parallel benchmark */
+
+    /*
+        page is the biggest request with random read latency at most (2 - knee) x latency of the smallest one,
+        erase block is the smallest chunk with random write throughput at least knee x sequential throughput
+    */
+    double knee;
+
+    /* existing files and block devices are written only if true, their data is lost */
+    bool destructive;
+} SSD_calibrate_config;
+
+typedef struct SSD_calibrate_result
+{
+    /* random read time (seconds per request) for request sizes 512B * 2^i */
+    double r_read_latency[16];
+    size_t num_r_read_latency;
+
+    /* random aligned write throughput (bytes per second) for chunks 64KB * 2^i */
+    double chunk_write_throughput[8];
+    size_t num_chunk_write_throughput;
+
+    double s_read_throughput; /* bytes per second */
+    double s_write_throughput; /* bytes per second */
+    double parallel_read_time; /* seconds per page with threads requests in flight */
+
+    bool erase_time_measured; /* false iff erase time is taken from 10 x random write heuristic */
+} SSD_calibrate_result;
+
+/*
+    Get default configuration: 256MB, 2000 ops, 32 threads, knee 0.9
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    Configuration
+*/
+SSD_calibrate_config ssd_calibrate_config_default(void);
+
+/*
+    Measure drive and create SSD model of it
+
+    PARAMS
+    @IN path - new file (created and removed after), existing file or block device (destructive only)
+    @IN config - pointer to configuration
+    @OUT result - (can be NULL) raw measurements
+
+    RETURN
+    NULL iff failure (message is printed on stderr)
+    Pointer to new SSD
+*/
+SSD *ssd_calibrate(const char *path, const SSD_calibrate_config *config, SSD_calibrate_result *result);
+
+/*
+    Print on stdout raw measurements
+
+    PARAMS
+    @IN result - pointer to result
+
+    RETURN
+    This is a void function
+*/
+void ssd_calibrate_result_print(const SSD_calibrate_result *result);
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef SSD_FTL_H
+#define SSD_FTL_H
+
+/*
+    Page mapped FTL (Flash Translation Layer) with garbage collection.
+    Optional mode of SSD: when enabled, writes go to logical pages (LPN) which are mapped
+    to physical pages. Rewritten or trimmed pages become invalid and GC copies
+    valid pages out of victim block before erasing it.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+    LICENCE GPL 3.0
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ssd.h>
+
+typedef enum SSD_ftl_gc_policy
+{
+    SSD_FTL_GC_GREEDY = 0, /* victim has the least valid pages */
+    SSD_FTL_GC_COST_BENEFIT /* victim has the biggest age * (1 - u) / 2u */
+} SSD_ftl_gc_policy;
+
+typedef enum SSD_ftl_wl_policy
+{
+    SSD_FTL_WL_NONE = 0, /* free blocks are reused in LIFO order */
+    SSD_FTL_WL_DYNAMIC, /* free block with the least P/E cycles is used first */
+    SSD_FTL_WL_STATIC /* dynamic + cold blocks are relocated when P/E gap is too big */
+} SSD_ftl_wl_policy;
+
+typedef struct SSD_ftl_extent
+{
+    size_t lpn;
+    size_t pages;
+} SSD_ftl_extent;
+
+typedef struct SSD_ftl_stat
+{
+    size_t host_pages_written;
+    size_t gc_pages_copied;
+    size_t erases;
+    size_t gc_runs;
+    size_t wl_relocations;
+
+    /* time spent by host writes waiting for GC (in seconds) */
+    double gc_time;
+    double max_gc_stall;
+} SSD_ftl_stat;
+
+typedef struct SSD_ftl
+{
+    SSD_ftl_gc_policy policy;
+
+    SSD_ftl_wl_policy wl_policy;
+    size_t wl_threshold; /* max P/E gap for static WL */
+    size_t wl_last_check; /* erases at last static WL check */
+
+    size_t pages_per_block;
+    size_t physical_blocks;
+    size_t logical_pages;
+
+    /* GC runs when there are only reserved_blocks free blocks */
+    size_t reserved_blocks;
+
+    size_t *l2p; /* SIZE_MAX iff not mapped */
+    size_t *p2l; /* SIZE_MAX iff page is free or invalid */
+
+    /* per block */
+    size_t *valid;
+    uint64_t *last_write;
+    uint8_t *state;
+    size_t *erase_count;
+    size_t max_erase_count;
+
+    /* closed blocks grouped by valid pages (doubly linked lists) */
+    size_t *bucket_head;
+    size_t *next;
+    size_t *prev;
+
+    /* stack or min heap by erase_count (dynamic and static WL) */
+    size_t *free_blocks;
+    size_t num_free_blocks;
+
+    /* write frontiers (SIZE_MAX iff no block) */
+    size_t host_block;
+    size_t host_page;
+    size_t gc_block;
+    size_t gc_page;
+
+    /* host writes counter used as clock */
+    uint64_t clock;
+
+    /* free logical space, sorted by lpn */
+    SSD_ftl_extent *free_extents;
+    size_t num_free_extents;
+    size_t max_free_extents;
+
+    SSD_ftl_stat stat;
+} SSD_ftl;
+
+/*
+    Turn on FTL mode in SSD
+
+    PARAMS
+    @IN ssd - pointer to SSD
+    @IN blocks - number of physical blocks
+    @IN over_provisioning - part of physical space hidden from host in range [0.0, 1.0)
+    @IN policy - GC victim policy
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int ssd_ftl_enable(SSD *ssd, size_t blocks, double over_provisioning, SSD_ftl_gc_policy policy);
+
+/*
+    Set wear leveling policy of FTL
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+    @IN policy - wear leveling policy
+    @IN threshold - max gap between P/E cycles of blocks (used by static WL)
+
+    RETURN
+    This is a void function
+*/
+void ssd_ftl_set_wear_leveling(SSD *ssd, SSD_ftl_wl_policy policy, size_t threshold);
+
+/*
+    Get the smallest number of P/E cycles of block
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+
+    RETURN
+    Min P/E cycles
+*/
+size_t ssd_ftl_min_erase_count(const SSD *ssd);
+
+/*
+    Destroy FTL
+
+    PARAMS
+    @IN ftl - pointer to FTL
+
+    RETURN
+    This is a void function
+*/
+void ssd_ftl_destroy(SSD_ftl *ftl);
+
+/*
+    Allocate logical space
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+    @IN pages - number of pages
+    @OUT extent - allocated extent
+
+    RETURN
+    false iff there is no free logical space
+*/
+bool ssd_ftl_alloc(SSD *ssd, size_t pages, SSD_ftl_extent *extent);
+
+/*
+    Free logical space and trim its pages
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+    @IN extent - extent to free, after call it is empty
+
+    RETURN
+    This is a void function
+*/
+void ssd_ftl_free(SSD *ssd, SSD_ftl_extent *extent);
+
+/*
+    Write logical pages
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+    @IN lpn - first logical page
+    @IN pages - number of pages
+    @IN sequential - true iff write is sequential
+
+    RETURN
+    Time spent on writing with GC stalls
+*/
+double ssd_ftl_write(SSD *ssd, size_t lpn, size_t pages, bool sequential);
+
+/*
+    Get device write amplification: pages programmed on flash per page written by host
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+
+    RETURN
+    Write amplification
+*/
+double ssd_ftl_write_amplification(const SSD *ssd);
+
+/*
+    Print on stdout FTL statistics
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+
+    RETURN
+    This is a void function
+*/
+void ssd_ftl_stat_print(const SSD *ssd);
+
+#endif
@@ -0,0 +1,541 @@
+#include <dbbufpool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define DB_BUFPOOL_NONE       SIZE_MAX
+#define DB_BUFPOOL_MIN_FRAMES 1024
+#define DB_BUFPOOL_KEY(run, page) (((uint64_t)(run) << 48) | (page))
+
+static const char *const db_bufpool_policy_names[DB_BUFPOOL_NUM_POLICIES] =
+{
+    [DB_BUFPOOL_LRU] = "lru",
+    [DB_BUFPOOL_CLOCK] = "clock",
+    [DB_BUFPOOL_PINNED] = "pinned"
+};
+
+/*
+    Get home slot of key in map
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN key - key
+
+    RETURN
+    Slot
+*/
+static inline size_t db_bufpool_slot(const DB_bufpool *pool, uint64_t key);
+
+/*
+    Find slot of key or empty slot where key should be
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN key - key
+
+    RETURN
+    Slot
+*/
+static size_t db_bufpool_find(const DB_bufpool *pool, uint64_t key);
+
+/*
+    Remove key from map, following keys are shifted back
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN key - key
+
+    RETURN
+    This is a void function
+*/
+static void db_bufpool_map_remove(DB_bufpool *pool, uint64_t key);
+
+/*
+    Double number of allocated frames (and map), but not more than capacity
+
+    PARAMS
+    @IN pool - pointer to pool
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_bufpool_grow(DB_bufpool *pool);
+
+/*
+    Unlink frame from LRU list
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN frame - frame
+
+    RETURN
+    This is a void function
+*/
+static void db_bufpool_lru_unlink(DB_bufpool *pool, size_t frame);
+
+/*
+    Unlink frame from list of its run
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN frame - frame
+
+    RETURN
+    This is a void function
+*/
+static void db_bufpool_run_unlink(DB_bufpool *pool, size_t frame);
+
+/*
+    Insert frame at front of LRU list
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN frame - frame
+
+    RETURN
+    This is a void function
+*/
+static void db_bufpool_lru_push(DB_bufpool *pool, size_t frame);
+
+/*
+    Drop page from frame and put frame on free list
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN frame - frame
+
+    RETURN
+    This is a void function
+*/
+static void db_bufpool_release(DB_bufpool *pool, size_t frame);
+
+/*
+    Get frame for new page: free frame, new frame or victim chosen by policy
+
+    PARAMS
+    @IN pool - pointer to pool
+
+    RETURN
+    DB_BUFPOOL_NONE iff failure
+    Frame
+*/
+static size_t db_bufpool_victim(DB_bufpool *pool);
+
+static inline size_t db_bufpool_slot(const DB_bufpool *pool, uint64_t key)
+{
+    /* murmur3 finalizer */
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ULL;
+    key ^= key >> 33;
+
+    return (size_t)key & (pool->map_capacity - 1);
+}
+
+static size_t db_bufpool_find(const DB_bufpool *pool, uint64_t key)
+{
+    size_t slot = db_bufpool_slot(pool, key);
+
+    while (pool->map_frames[slot] != DB_BUFPOOL_NONE && pool->map_keys[slot] != key)
+        slot = (slot + 1) & (pool->map_capacity - 1);
+
+    return slot;
+}
+
+static void db_bufpool_map_remove(DB_bufpool *pool, uint64_t key)
+{
+    size_t slot = db_bufpool_find(pool, key);
+    size_t next;
+
+    if (pool->map_frames[slot] == DB_BUFPOOL_NONE)
+        return;
+
+    pool->map_frames[slot] = DB_BUFPOOL_NONE;
+
+    /* shift back keys which cannot be found behind new hole */
+    next = (slot + 1) & (pool->map_capacity - 1);
+    while (pool->map_frames[next] != DB_BUFPOOL_NONE)
+    {
+        const size_t home = db_bufpool_slot(pool, pool->map_keys[next]);
+        const bool movable = slot <= next ? (home <= slot || home > next) : (home <= slot && home > next);
+
+        if (movable)
+        {
+            pool->map_keys[slot] = pool->map_keys[next];
+            pool->map_frames[slot] = pool->map_frames[next];
+            pool->map_frames[next] = DB_BUFPOOL_NONE;
+            slot = next;
+        }
+
+        next = (next + 1) & (pool->map_capacity - 1);
+    }
+}
+
+static int db_bufpool_grow(DB_bufpool *pool)
+{
+    DB_bufpool_frame *frames;
+    uint64_t *map_keys;
+    size_t *map_frames;
+    size_t max_frames = pool->max_frames > 0 ? pool->max_frames * 2 : DB_BUFPOOL_MIN_FRAMES;
+    size_t map_capacity = 1;
+
+    if (max_frames > pool->capacity)
+        max_frames = pool->capacity;
+
+    if (max_frames <= pool->max_frames)
+        return 1;
+
+    frames = (DB_bufpool_frame *)realloc(pool->frames, sizeof(DB_bufpool_frame) * max_frames);
+    if (frames == NULL)
+        return 1;
+
+    pool->frames = frames;
+    pool->max_frames = max_frames;
+
+    /* map is at most half full */
+    while (map_capacity < max_frames * 2)
+        map_capacity *= 2;
+
+    if (map_capacity == pool->map_capacity)
+        return 0;
+
+    map_keys = (uint64_t *)malloc(sizeof(uint64_t) * map_capacity);
+    map_frames = (size_t *)malloc(sizeof(size_t) * map_capacity);
+    if (map_keys == NULL || map_frames == NULL)
+    {
+        free(map_keys);
+        free(map_frames);
+        return 1;
+    }
+
+    free(pool->map_keys);
+    free(pool->map_frames);
+    pool->map_keys = map_keys;
+    pool->map_frames = map_frames;
+    pool->map_capacity = map_capacity;
+
+    for (size_t i = 0; i < map_capacity; ++i)
+        map_frames[i] = DB_BUFPOOL_NONE;
+
+    for (size_t i = 0; i < pool->num_frames; ++i)
+        if (pool->frames[i].used)
+        {
+            const uint64_t key = DB_BUFPOOL_KEY(pool->frames[i].run, pool->frames[i].page);
+            const size_t slot = db_bufpool_find(pool, key);
+
+            map_keys[slot] = key;
+            map_frames[slot] = i;
+        }
+
+    return 0;
+}
+
+static void db_bufpool_lru_unlink(DB_bufpool *pool, size_t frame)
+{
+    DB_bufpool_frame *f = &pool->frames[frame];
+
+    if (f->prev != DB_BUFPOOL_NONE)
+        pool->frames[f->prev].next = f->next;
+    else
+        pool->lru_first = f->next;
+
+    if (f->next != DB_BUFPOOL_NONE)
+        pool->frames[f->next].prev = f->prev;
+    else
+        pool->lru_last = f->prev;
+
+    f->prev = DB_BUFPOOL_NONE;
+    f->next = DB_BUFPOOL_NONE;
+}
+
+static void db_bufpool_run_unlink(DB_bufpool *pool, size_t frame)
+{
+    DB_bufpool_frame *f = &pool->frames[frame];
+
+    if (f->run_prev != DB_BUFPOOL_NONE)
+        pool->frames[f->run_prev].run_next = f->run_next;
+    else
+        pool->run_first[f->run] = f->run_next;
+
+    if (f->run_next != DB_BUFPOOL_NONE)
+        pool->frames[f->run_next].run_prev = f->run_prev;
+}
+
+static void db_bufpool_lru_push(DB_bufpool *pool, size_t frame)
+{
+    DB_bufpool_frame *f = &pool->frames[frame];
+
+    f->prev = DB_BUFPOOL_NONE;
+    f->next = pool->lru_first;
+
+    if (pool->lru_first != DB_BUFPOOL_NONE)
+        pool->frames[pool->lru_first].prev = frame;
+
+    pool->lru_first = frame;
+    if (pool->lru_last == DB_BUFPOOL_NONE)
+        pool->lru_last = frame;
+}
+
+static void db_bufpool_release(DB_bufpool *pool, size_t frame)
+{
+    DB_bufpool_frame *f = &pool->frames[frame];
+
+    db_bufpool_map_remove(pool, DB_BUFPOOL_KEY(f->run, f->page));
+    db_bufpool_run_unlink(pool, frame);
+
+    /* frames of CLOCK are not on LRU list */
+    if (pool->policy == DB_BUFPOOL_LRU)
+        db_bufpool_lru_unlink(pool, frame);
+
+    --pool->run_pages[f->run];
+    f->used = false;
+    f->ref = false;
+    f->run_next = pool->free_frames;
+    pool->free_frames = frame;
+}
+
+static size_t db_bufpool_victim(DB_bufpool *pool)
+{
+    size_t frame;
+
+    if (pool->free_frames != DB_BUFPOOL_NONE)
+    {
+        frame = pool->free_frames;
+        pool->free_frames = pool->frames[frame].run_next;
+
+        return frame;
+    }
+
+    if (pool->num_frames < pool->capacity)
+    {
+        if (pool->num_frames == pool->max_frames && db_bufpool_grow(pool) != 0)
+            return DB_BUFPOOL_NONE;
+
+        return pool->num_frames++;
+    }
+
+    if (pool->num_frames == 0)
+        return DB_BUFPOOL_NONE;
+
+    if (pool->policy == DB_BUFPOOL_LRU)
+        frame = pool->lru_last;
+    else
+    {
+        /* every frame is used, so hand stops after at most one round */
+        while (pool->frames[pool->hand].ref)
+        {
+            pool->frames[pool->hand].ref = false;
+            pool->hand = (pool->hand + 1) % pool->num_frames;
+        }
+
+        frame = pool->hand;
+        pool->hand = (pool->hand + 1) % pool->num_frames;
+    }
+
+    ++pool->evicted;
+    db_bufpool_release(pool, frame);
+
+    /* victim is on top of free list */
+    pool->free_frames = pool->frames[frame].run_next;
+
+    return frame;
+}
+
+DB_bufpool *db_bufpool_create(DB_bufpool_policy policy, size_t capacity, size_t runs)
+{
+    DB_bufpool *pool;
+
+    pool = (DB_bufpool *)calloc(1, sizeof(DB_bufpool));
+    if (pool == NULL)
+        return NULL;
+
+    pool->policy = policy;
+    pool->capacity = capacity;
+    pool->runs = runs;
+    pool->free_frames = DB_BUFPOOL_NONE;
+    pool->lru_first = DB_BUFPOOL_NONE;
+    pool->lru_last = DB_BUFPOOL_NONE;
+
+    pool->run_first = (size_t *)malloc(sizeof(size_t) * runs);
+    pool->run_pages = (size_t *)calloc(runs, sizeof(size_t));
+    if (pool->run_first == NULL || pool->run_pages == NULL)
+    {
+        db_bufpool_destroy(pool);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < runs; ++i)
+        pool->run_first[i] = DB_BUFPOOL_NONE;
+
+    return pool;
+}
+
+void db_bufpool_destroy(DB_bufpool *pool)
+{
+    if (pool == NULL)
+        return;
+
+    free(pool->frames);
+    free(pool->map_keys);
+    free(pool->map_frames);
+    free(pool->run_first);
+    free(pool->run_pages);
+    free(pool);
+}
+
+int db_bufpool_add_runs(DB_bufpool *pool, size_t runs)
+{
+    size_t *run_first;
+    size_t *run_pages;
+
+    if (runs <= pool->runs)
+        return 0;
+
+    run_first = (size_t *)realloc(pool->run_first, sizeof(size_t) * runs);
+    if (run_first == NULL)
+        return 1;
+
+    pool->run_first = run_first;
+
+    run_pages = (size_t *)realloc(pool->run_pages, sizeof(size_t) * runs);
+    if (run_pages == NULL)
+        return 1;
+
+    pool->run_pages = run_pages;
+
+    for (size_t i = pool->runs; i < runs; ++i)
+    {
+        pool->run_first[i] = DB_BUFPOOL_NONE;
+        pool->run_pages[i] = 0;
+    }
+
+    pool->runs = runs;
+
+    return 0;
+}
+
+bool db_bufpool_access(DB_bufpool *pool, size_t run, uint64_t page)
+{
+    const uint64_t key = DB_BUFPOOL_KEY(run, page);
+    DB_bufpool_frame *f;
+    size_t frame;
+    size_t slot;
+
+    if (pool->policy == DB_BUFPOOL_PINNED)
+    {
+        if (pool->run_pages[run] > 0)
+        {
+            ++pool->hits;
+            return true;
+        }
+
+        ++pool->misses;
+        return false;
+    }
+
+    if (pool->capacity == 0)
+    {
+        ++pool->misses;
+        return false;
+    }
+
+    if (pool->map_capacity > 0)
+    {
+        slot = db_bufpool_find(pool, key);
+        if (pool->map_frames[slot] != DB_BUFPOOL_NONE)
+        {
+            frame = pool->map_frames[slot];
+            if (pool->policy == DB_BUFPOOL_LRU)
+            {
+                db_bufpool_lru_unlink(pool, frame);
+                db_bufpool_lru_push(pool, frame);
+            }
+            else
+                pool->frames[frame].ref = true;
+
+            ++pool->hits;
+            return true;
+        }
+    }
+
+    ++pool->misses;
+
+    /* page is read from SSD, pool without memory for frame does not keep it */
+    frame = db_bufpool_victim(pool);
+    if (frame == DB_BUFPOOL_NONE)
+        return false;
+
+    f = &pool->frames[frame];
+    f->page = page;
+    f->run = run;
+    f->used = true;
+    f->ref = true;
+    f->prev = DB_BUFPOOL_NONE;
+    f->next = DB_BUFPOOL_NONE;
+    f->run_prev = DB_BUFPOOL_NONE;
+    f->run_next = pool->run_first[run];
+    if (f->run_next != DB_BUFPOOL_NONE)
+        pool->frames[f->run_next].run_prev = frame;
+
+    pool->run_first[run] = frame;
+    ++pool->run_pages[run];
+
+    if (pool->policy == DB_BUFPOOL_LRU)
+        db_bufpool_lru_push(pool, frame);
+
+    slot = db_bufpool_find(pool, key);
+    pool->map_keys[slot] = key;
+    pool->map_frames[slot] = frame;
+
+    return false;
+}
+
+size_t db_bufpool_invalidate(DB_bufpool *pool, size_t run)
+{
+    const size_t pages = pool->run_pages[run];
+
+    if (pool->policy == DB_BUFPOOL_PINNED)
+        pool->run_pages[run] = 0;
+    else
+        while (pool->run_first[run] != DB_BUFPOOL_NONE)
+            db_bufpool_release(pool, pool->run_first[run]);
+
+    pool->invalidated += pages;
+
+    return pages;
+}
+
+void db_bufpool_pin(DB_bufpool *pool, size_t run, size_t pages)
+{
+    if (pool->policy != DB_BUFPOOL_PINNED)
+        return;
+
+    pool->run_pages[run] = pages;
+}
+
+size_t db_bufpool_resident(const DB_bufpool *pool, size_t run)
+{
+    return pool->run_pages[run];
+}
+
+int db_bufpool_policy_parse(const char *str, DB_bufpool_policy *policy)
+{
+    for (size_t i = 0; i < DB_BUFPOOL_NUM_POLICIES; ++i)
+        if (strcasecmp(str, db_bufpool_policy_names[i]) == 0)
+        {
+            *policy = (DB_bufpool_policy)i;
+            return 0;
+        }
+
+    return 1;
+}
+
+const char *db_bufpool_policy_name(DB_bufpool_policy policy)
+{
+    if (policy >= DB_BUFPOOL_NUM_POLICIES)
+        return "unknown";
+
+    return db_bufpool_policy_names[policy];
+}
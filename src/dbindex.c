@@ -0,0 +1,163 @@
+#include <dbindex.h>
+#include <dbindex_fdtree.h>
+#include <dbindex_btree.h>
+#include <dbindex_lsm.h>
+#include <dbindex_betree.h>
+#include <string.h>
+
+/*
+    Adapters of typed functions of index (prefix_insert, prefix_delete, ...) to operations
+    with void *index, every index has the same set of them
+*/
+#define DB_INDEX_ADAPTERS(prefix, type) \
+    static void prefix##_op_destroy(void *index) { prefix##_destroy((type *)index); } \
+    static double prefix##_op_insert(void *index, size_t entries) { return prefix##_insert((type *)index, entries); } \
+    static double prefix##_op_bulkload(void *index, size_t entries) { return prefix##_bulkload((type *)index, entries); } \
+    static double prefix##_op_point_search(void *index, size_t entries) { return prefix##_point_search((type *)index, entries); } \
+    static double prefix##_op_range_search(void *index, size_t entries, size_t queries) { return prefix##_range_search_repeat((type *)index, entries, queries); } \
+    static double prefix##_op_delete(void *index, size_t entries) { return prefix##_delete((type *)index, entries); } \
+    static double prefix##_op_update(void *index, size_t entries) { return prefix##_update((type *)index, entries); } \
+    static size_t prefix##_op_num_entries(const void *index) { return ((const type *)index)->num_entries; } \
+    static double prefix##_op_write_amplification(const void *index) { return prefix##_write_amplification((const type *)index); } \
+    static double prefix##_op_read_amplification(const void *index) { return prefix##_read_amplification((const type *)index); } \
+    static double prefix##_op_space_amplification(const void *index) { return prefix##_space_amplification((const type *)index); } \
+    static void prefix##_op_stat_print(const void *index) { prefix##_stat_print((const type *)index); }
+
+/* Operations of index with adapters made by DB_INDEX_ADAPTERS */
+#define DB_INDEX_OPS(str, prefix, create_op) \
+    { \
+        .name = str, \
+        .create = create_op, \
+        .destroy = prefix##_op_destroy, \
+        .insert = prefix##_op_insert, \
+        .bulkload = prefix##_op_bulkload, \
+        .point_search = prefix##_op_point_search, \
+        .range_search = prefix##_op_range_search, \
+        .delete = prefix##_op_delete, \
+        .update = prefix##_op_update, \
+        .num_entries = prefix##_op_num_entries, \
+        .write_amplification = prefix##_op_write_amplification, \
+        .read_amplification = prefix##_op_read_amplification, \
+        .space_amplification = prefix##_op_space_amplification, \
+        .stat_print = prefix##_op_stat_print \
+    }
+
+DB_INDEX_ADAPTERS(db_index_fdtree, DB_index_fdtree)
+DB_INDEX_ADAPTERS(db_index_btree, DB_index_btree)
+DB_INDEX_ADAPTERS(db_index_lsm, DB_index_lsm)
+DB_INDEX_ADAPTERS(db_index_betree, DB_index_betree)
+
+/*
+    Create index of type (see create of DB_index_ops)
+
+    PARAMS
+    @IN SSD - ssd
+    @IN stat - statistics context
+    @IN key_size - size of key in Bytes
+    @IN entry_size - size of entry in Bytes
+    @IN runs_ratio - ratio between capacity of lvl and lvl - 1
+
+    RETURN
+    NULL iff failure
+    Pointer to new index
+*/
+static void *db_index_fdtree_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio);
+static void *db_index_btree_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio);
+static void *db_index_lsm_leveling_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio);
+static void *db_index_lsm_tiering_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio);
+static void *db_index_betree_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio);
+
+static void *db_index_fdtree_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio)
+{
+    return db_index_fdtree_create(ssd, stat, key_size, entry_size, runs_ratio);
+}
+
+static void *db_index_btree_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio)
+{
+    (void)runs_ratio;
+
+    return db_index_btree_create(ssd, stat, key_size, entry_size);
+}
+
+static void *db_index_lsm_leveling_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio)
+{
+    return db_index_lsm_create(ssd, stat, key_size, entry_size, runs_ratio, DB_INDEX_LSM_LEVELING);
+}
+
+static void *db_index_lsm_tiering_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio)
+{
+    return db_index_lsm_create(ssd, stat, key_size, entry_size, runs_ratio, DB_INDEX_LSM_TIERING);
+}
+
+static void *db_index_betree_op_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio)
+{
+    (void)runs_ratio;
+
+    return db_index_betree_create(ssd, stat, key_size, entry_size);
+}
+
+static const DB_index_ops db_index_ops_table[DB_INDEX_TYPE_NUM_TYPES] =
+{
+    [DB_INDEX_TYPE_FDTREE] = DB_INDEX_OPS("fdtree", db_index_fdtree, db_index_fdtree_op_create),
+    [DB_INDEX_TYPE_BTREE] = DB_INDEX_OPS("btree", db_index_btree, db_index_btree_op_create),
+    [DB_INDEX_TYPE_LSM_LEVELING] = DB_INDEX_OPS("lsm-leveling", db_index_lsm, db_index_lsm_leveling_op_create),
+    [DB_INDEX_TYPE_LSM_TIERING] = DB_INDEX_OPS("lsm-tiering", db_index_lsm, db_index_lsm_tiering_op_create),
+    [DB_INDEX_TYPE_BETREE] = DB_INDEX_OPS("betree", db_index_betree, db_index_betree_op_create)
+};
+
+const DB_index_ops *db_index_ops(DB_index_type type)
+{
+    if ((size_t)type >= DB_INDEX_TYPE_NUM_TYPES)
+        return NULL;
+
+    return &db_index_ops_table[type];
+}
+
+int db_index_create(DB_index *index, DB_index_type type, SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio)
+{
+    const DB_index_ops *ops = db_index_ops(type);
+
+    if (ops == NULL)
+        return 1;
+
+    index->ops = ops;
+    index->stat = stat;
+    index->index = ops->create(ssd, stat, key_size, entry_size, runs_ratio);
+
+    return index->index == NULL;
+}
+
+void db_index_from_fdtree(DB_index *index, DB_index_fdtree *fdtree)
+{
+    index->ops = &db_index_ops_table[DB_INDEX_TYPE_FDTREE];
+    index->index = fdtree;
+    index->stat = fdtree->stat;
+}
+
+void db_index_destroy(DB_index *index)
+{
+    if (index == NULL || index->index == NULL)
+        return;
+
+    index->ops->destroy(index->index);
+    index->index = NULL;
+}
+
+int db_index_type_parse(const char *str, DB_index_type *type)
+{
+    for (size_t i = 0; i < DB_INDEX_TYPE_NUM_TYPES; ++i)
+        if (strcmp(str, db_index_ops_table[i].name) == 0)
+        {
+            *type = (DB_index_type)i;
+            return 0;
+        }
+
+    return 1;
+}
+
+const char *db_index_type_name(DB_index_type type)
+{
+    const DB_index_ops *ops = db_index_ops(type);
+
+    return ops != NULL ? ops->name : "unknown";
+}
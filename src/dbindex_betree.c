@@ -0,0 +1,492 @@
+#include <dbindex_betree.h>
+#include <dbindex_btree.h>
+#include <dbindex_fdtree.h>
+#include <ssd.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <dbutils.h>
+#include <dbstat.h>
+
+/*
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Pages read by search from root to leaf (root is in RAM)
+*/
+static inline size_t db_index_betree_path_pages(const DB_index_betree *index);
+
+/*
+    Set lvls of nodes over leaves, new lvls are added over the root
+
+    PARAMS
+    @IN index - pointer to index
+    @OUT new_nodes - inner nodes added by call
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_index_betree_reshape(DB_index_betree *index, size_t *new_nodes);
+
+/*
+    Apply messages which reach leaves, leaves which overflow are split
+
+    PARAMS
+    @IN index - pointer to index
+    @IN inserts - insert messages
+    @IN deletes - delete messages
+
+    RETURN
+    Time of splits
+*/
+static double db_index_betree_apply(DB_index_betree *index, size_t inserts, size_t deletes);
+
+/*
+    Get messages moved by flush: child with the most of buffered messages
+    gets about m/f + sqrt(2 * m/f * ln(f)) of m messages spread over f children
+
+    PARAMS
+    @IN index - pointer to index
+    @IN children - children of flushed node
+
+    RETURN
+    Messages moved to one child
+*/
+static size_t db_index_betree_flush_entries(const DB_index_betree *index, size_t children);
+
+/*
+    Flush nodes of lvl which cannot hold their messages into lvl + 1
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl of inner nodes
+
+    RETURN
+    Time of flushes
+*/
+static double db_index_betree_flush_lvl(DB_index_betree *index, size_t lvl);
+
+/*
+    Put messages into root and flush lvls which overflow
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - messages
+    @IN inserts - insert messages (part of entries)
+    @IN deletes - delete messages (part of entries)
+
+    RETURN
+    Time of writes
+*/
+static double db_index_betree_put(DB_index_betree *index, size_t entries, size_t inserts, size_t deletes);
+
+static inline size_t db_index_betree_path_pages(const DB_index_betree *index)
+{
+    return index->height - 1;
+}
+
+static int db_index_betree_reshape(DB_index_betree *index, size_t *new_nodes)
+{
+    size_t height = 1;
+    size_t inner = 0;
+    size_t nodes;
+
+    for (nodes = index->leaves; nodes > 1; ++height)
+        nodes = INT_CEIL_DIV(nodes, index->fanout);
+
+    /* tree grows from the root, buffered messages stay in their nodes */
+    if (height > index->height)
+    {
+        const size_t added = height - index->height;
+        BELvl *lvls;
+
+        lvls = (BELvl *)realloc(index->lvls, height * sizeof(BELvl));
+        if (lvls == NULL)
+            return 1;
+
+        (void)memmove(&lvls[added], &lvls[0], index->height * sizeof(BELvl));
+        (void)memset(&lvls[0], 0, added * sizeof(BELvl));
+
+        index->lvls = lvls;
+        index->height = height;
+    }
+
+    nodes = index->leaves;
+    index->lvls[index->height - 1].nodes = nodes;
+    for (size_t i = index->height - 1; i > 0; --i)
+    {
+        nodes = INT_CEIL_DIV(nodes, index->fanout);
+        index->lvls[i - 1].nodes = nodes;
+        inner += nodes;
+    }
+
+    *new_nodes = inner > index->inner_nodes ? inner - index->inner_nodes : 0;
+    index->inner_nodes = inner;
+
+    return 0;
+}
+
+static double db_index_betree_apply(DB_index_betree *index, size_t inserts, size_t deletes)
+{
+    const size_t entries_per_page = db_utils_entries_per_page(index->ssd->page_size, index->entry_size);
+    const double leaf_entries = (double)entries_per_page * DBINDEX_BTREE_FILL;
+    double _leaves;
+    size_t leaves;
+    size_t splits;
+    size_t new_nodes;
+    double time = 0.0;
+
+    index->leaf_entries += inserts;
+    index->leaf_entries -= deletes < index->leaf_entries ? deletes : index->leaf_entries;
+
+    _leaves = ceil((double)index->leaf_entries / leaf_entries);
+    leaves = (size_t)_leaves;
+    if (leaves <= index->leaves)
+        return time;
+
+    /* every insert splits at most one leaf, parent is rewritten by flush */
+    splits = leaves - index->leaves;
+    if (splits > inserts)
+        splits = inserts;
+
+    index->leaves += splits;
+    index->sorted_leaves -= splits < index->sorted_leaves ? splits : index->sorted_leaves;
+    index->index_stat.leaf_splits += splits;
+
+    if (db_index_betree_reshape(index, &new_nodes) != 0)
+        return DBINDEX_FDTREE_INVALID_TIME;
+
+    index->index_stat.inner_splits += new_nodes;
+    index->index_stat.pages_rwrite += splits + new_nodes * DBINDEX_BETREE_NODE_PAGES;
+    time += ssd_rwrite_pages(index->ssd, splits + new_nodes * DBINDEX_BETREE_NODE_PAGES);
+
+    return time;
+}
+
+static size_t db_index_betree_flush_entries(const DB_index_betree *index, size_t children)
+{
+    const double mean = (double)index->buffer_entries / (double)children;
+    const double _entries = ceil(mean + sqrt(2.0 * mean * log((double)children)));
+    const size_t entries = (size_t)_entries;
+
+    if (entries == 0)
+        return 1;
+
+    return entries < index->buffer_entries ? entries : index->buffer_entries;
+}
+
+static double db_index_betree_flush_lvl(DB_index_betree *index, size_t lvl)
+{
+    BELvl *belvl = &index->lvls[lvl];
+    const size_t capacity = belvl->nodes * index->buffer_entries;
+    const size_t children = INT_CEIL_DIV(index->lvls[lvl + 1].nodes, belvl->nodes);
+    const size_t per_flush = db_index_betree_flush_entries(index, children);
+    const size_t moved_pages = db_utils_pages_for_entries(index->ssd->page_size, index->entry_size, per_flush);
+    size_t flushes;
+    size_t moved;
+    size_t inserts;
+    size_t deletes;
+    size_t pages;
+    double time = 0.0;
+
+    if (belvl->messages <= capacity)
+        return time;
+
+    /* full node moves messages of its fullest child only */
+    flushes = INT_CEIL_DIV(belvl->messages - capacity, per_flush);
+    moved = flushes * per_flush;
+    if (moved > belvl->messages)
+        moved = belvl->messages;
+
+    inserts = (size_t)((double)belvl->inserts * (double)moved / (double)belvl->messages);
+    deletes = (size_t)((double)belvl->deletes * (double)moved / (double)belvl->messages);
+
+    belvl->messages -= moved;
+    belvl->inserts -= inserts;
+    belvl->deletes -= deletes;
+
+    /* child gets pages of messages and pivot page (leaf is one page), node drops them (root is in RAM) */
+    pages = flushes * ((lvl + 2 == index->height ? 1 : moved_pages + 1) + (lvl > 0 ? moved_pages + 1 : 0));
+
+    belvl->flushes += flushes;
+    belvl->pages_updated += pages;
+    index->index_stat.pages_updated += pages;
+    time += ssd_update_pages(index->ssd, pages);
+
+    if (lvl + 2 == index->height)
+        time += db_index_betree_apply(index, inserts, deletes);
+    else
+    {
+        BELvl *next = &index->lvls[lvl + 1];
+
+        next->messages += moved;
+        next->inserts += inserts;
+        next->deletes += deletes;
+    }
+
+    return time;
+}
+
+static double db_index_betree_put(DB_index_betree *index, size_t entries, size_t inserts, size_t deletes)
+{
+    const double cmps = index->buffer_entries > 1 ? log2((double)index->buffer_entries) : 1.0;
+    double time = 0.0;
+
+    index->index_stat.entries_written += entries;
+
+    /* the same CPU cost as HEAD of FDTree */
+    time += (double)entries * cmps * DBINDEX_FDTREE_HEAD_CMP_TIME;
+    index->buffer_time += time;
+
+    /* root is the only leaf, it is in RAM */
+    if (index->height == 1)
+        return time + db_index_betree_apply(index, inserts, deletes);
+
+    index->lvls[0].messages += entries;
+    index->lvls[0].inserts += inserts;
+    index->lvls[0].deletes += deletes;
+
+    /* flush moves messages down, so next lvl is checked after it */
+    for (size_t i = 0; i + 1 < index->height; ++i)
+        time += db_index_betree_flush_lvl(index, i);
+
+    return time;
+}
+
+DB_index_betree *db_index_betree_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size)
+{
+    DB_index_betree *index;
+    const size_t node_size = ssd->page_size * DBINDEX_BETREE_NODE_PAGES;
+    const size_t pointers = db_utils_entries_per_page(node_size, key_size + sizeof(void *));
+    const double _pivots = floor(pow((double)pointers, DBINDEX_BETREE_EPSILON));
+    const size_t pivots = (size_t)_pivots;
+    const size_t fanout = (size_t)((double)pivots * DBINDEX_BTREE_FILL);
+
+    index = (DB_index_betree *)calloc(1, sizeof(DB_index_betree));
+    if (index == NULL)
+        return NULL;
+
+    index->ssd = ssd;
+    index->stat = stat;
+    index->key_size = key_size;
+    index->entry_size = entry_size;
+    index->fanout = fanout > 2 ? fanout : 2;
+
+    /* rest of node after pivots */
+    if (pivots * (key_size + sizeof(void *)) < node_size)
+        index->buffer_entries = (node_size - pivots * (key_size + sizeof(void *))) / entry_size;
+
+    if (index->buffer_entries == 0)
+        index->buffer_entries = 1;
+
+    /* empty tree is one leaf which is root */
+    index->lvls = (BELvl *)calloc(1, sizeof(BELvl));
+    if (index->lvls == NULL)
+    {
+        free(index);
+        return NULL;
+    }
+
+    index->height = 1;
+    index->leaves = 1;
+    index->lvls[0].nodes = 1;
+
+    return index;
+}
+
+void db_index_betree_destroy(DB_index_betree *index)
+{
+    if (index == NULL)
+        return;
+
+    free(index->lvls);
+    free(index);
+}
+
+double db_index_betree_insert(DB_index_betree *index, size_t entries)
+{
+    double time;
+
+    index->num_entries += entries;
+    time = db_index_betree_put(index, entries, entries, 0);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_betree_bulkload(DB_index_betree *index, size_t entries)
+{
+    const size_t entries_per_page = db_utils_entries_per_page(index->ssd->page_size, index->entry_size);
+    const double leaf_entries = (double)entries_per_page * DBINDEX_BTREE_FILL;
+    double _leaves;
+    double time = 0.0;
+    size_t new_nodes;
+    size_t pages;
+
+    if (index->num_entries > 0)
+        return db_index_betree_insert(index, entries);
+
+    /* leaves filled like by splits and inner nodes with empty buffers are written level by level */
+    _leaves = ceil((double)entries / leaf_entries);
+    index->leaves = (size_t)_leaves;
+    if (index->leaves == 0)
+        index->leaves = 1;
+
+    index->sorted_leaves = index->leaves;
+    if (db_index_betree_reshape(index, &new_nodes) != 0)
+    {
+        time = DBINDEX_FDTREE_INVALID_TIME;
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
+
+    index->num_entries = entries;
+    index->leaf_entries = entries;
+    index->index_stat.entries_written += entries;
+
+    pages = index->leaves + index->inner_nodes * DBINDEX_BETREE_NODE_PAGES;
+    index->index_stat.pages_swrite += pages;
+    time += ssd_swrite_pages(index->ssd, pages);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_betree_point_search(DB_index_betree *index, size_t entries)
+{
+    const size_t pages = db_index_betree_path_pages(index) * entries;
+    const double time = ssd_rread_pages(index->ssd, pages);
+
+    index->index_stat.point_lookups += entries;
+    index->index_stat.search_pages_rread += pages;
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_betree_range_search(DB_index_betree *index, size_t entries)
+{
+    return db_index_betree_range_search_repeat(index, entries, 1);
+}
+
+double db_index_betree_range_search_repeat(DB_index_betree *index, size_t entries, size_t queries)
+{
+    double time = 0.0;
+    double _pages;
+    size_t pages;
+    size_t seq_pages;
+    size_t rand_pages;
+
+    /* entries are spread over leaves as they are filled now */
+    _pages = index->leaf_entries > 0 ? ceil((double)entries * (double)index->leaves / (double)index->leaf_entries) : 1.0;
+    pages = (size_t)_pages;
+    if (pages == 0)
+        pages = 1;
+    if (pages > index->leaves)
+        pages = index->leaves;
+
+    /* inner nodes on path to the first leaf and leaves */
+    seq_pages = (size_t)((double)pages * (double)index->sorted_leaves / (double)index->leaves);
+    rand_pages = (index->height > 2 ? index->height - 2 : 0) + pages - seq_pages;
+
+    time += ssd_rread_pages(index->ssd, rand_pages);
+    time += ssd_sread_pages(index->ssd, seq_pages);
+
+    /* index is not changed, so each search costs the same */
+    time *= (double)queries;
+
+    index->index_stat.range_searches += queries;
+    index->index_stat.search_pages_rread += rand_pages * queries;
+    index->index_stat.search_pages_sread += seq_pages * queries;
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_betree_delete(DB_index_betree *index, size_t entries)
+{
+    double time;
+
+    index->num_entries -= entries < index->num_entries ? entries : index->num_entries;
+    time = db_index_betree_put(index, entries, 0, entries);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_betree_update(DB_index_betree *index, size_t entries)
+{
+    const double time = db_index_betree_put(index, entries, 0, 0);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_betree_write_amplification(const DB_index_betree *index)
+{
+    const BEIndex_stat *index_stat = &index->index_stat;
+    const size_t pages = index_stat->pages_swrite + index_stat->pages_rwrite + index_stat->pages_updated;
+
+    if (index_stat->entries_written == 0)
+        return 0.0;
+
+    return (double)(pages * index->ssd->page_size) / (double)(index_stat->entries_written * index->entry_size);
+}
+
+double db_index_betree_read_amplification(const DB_index_betree *index)
+{
+    const size_t searches = index->index_stat.point_lookups + index->index_stat.range_searches;
+
+    if (searches == 0)
+        return 0.0;
+
+    return (double)index->index_stat.search_pages_rread / (double)searches;
+}
+
+double db_index_betree_space_amplification(const DB_index_betree *index)
+{
+    if (index->num_entries == 0)
+        return 0.0;
+
+    return (double)((index->leaves + index->inner_nodes * DBINDEX_BETREE_NODE_PAGES) * index->ssd->page_size) / (double)(index->num_entries * index->entry_size);
+}
+
+void db_index_betree_stat_print(const DB_index_betree *index)
+{
+    const BEIndex_stat *index_stat = &index->index_stat;
+
+    printf("BE-TREE\n");
+    printf("\tHEIGHT                 = %zu\n", index->height);
+    printf("\tFANOUT                 = %zu\n", index->fanout);
+    printf("\tBUFFER        ENTRIES  = %zu\n", index->buffer_entries);
+    printf("\tBUFFER SORT   TIME     = %lfs\n", index->buffer_time);
+    printf("\tLEAVES                 = %zu\n", index->leaves);
+    printf("\tSORTED        LEAVES   = %zu\n", index->sorted_leaves);
+    printf("\tINNER         NODES    = %zu\n", index->inner_nodes);
+    printf("\tLEAF          SPLITS   = %zu\n", index_stat->leaf_splits);
+    printf("\tINNER         SPLITS   = %zu\n", index_stat->inner_splits);
+    printf("\tSEARCH RAND   PAGES    = %zu\n", index_stat->search_pages_rread);
+    printf("\tSEARCH SEQ    PAGES    = %zu\n", index_stat->search_pages_sread);
+    printf("\tSEQ   WRITE   PAGES    = %zu\n", index_stat->pages_swrite);
+    printf("\tRAND  WRITE   PAGES    = %zu\n", index_stat->pages_rwrite);
+    printf("\tUPDATED       PAGES    = %zu\n", index_stat->pages_updated);
+
+    for (size_t i = 0; i + 1 < index->height; ++i)
+    {
+        const BELvl *lvl = &index->lvls[i];
+
+        printf("LVL %zu\n", i);
+        printf("\tNODES                  = %zu\n", lvl->nodes);
+        printf("\tBUFFERED      MESSAGES = %zu\n", lvl->messages);
+        printf("\tFLUSHES                = %zu\n", lvl->flushes);
+        printf("\tUPDATED       PAGES    = %zu\n", lvl->pages_updated);
+    }
+
+    printf("AMPLIFICATION\n");
+    printf("\tWRITE                  = %lf\n", db_index_betree_write_amplification(index));
+    printf("\tREAD                   = %lf\n", db_index_betree_read_amplification(index));
+    printf("\tSPACE                  = %lf\n", db_index_betree_space_amplification(index));
+}
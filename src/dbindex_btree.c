@@ -0,0 +1,397 @@
+#include <dbindex_btree.h>
+#include <ssd.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <dbutils.h>
+#include <dbstat.h>
+
+/*
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Maximum number of entries that can be written on one leaf
+*/
+static inline size_t db_index_btree_entries_per_page(const DB_index_btree *index);
+
+/*
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Average number of children of inner node (at least 2)
+*/
+static inline size_t db_index_btree_fanout(const DB_index_btree *index);
+
+/*
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Pages read by write before its leaf (inner nodes without root)
+*/
+static inline size_t db_index_btree_path_pages(const DB_index_btree *index);
+
+/*
+    Count inner nodes over leaves
+
+    PARAMS
+    @IN index - pointer to index
+    @IN leaves - number of leaves
+    @OUT height - levels of nodes with leaves and root
+
+    RETURN
+    Number of inner nodes
+*/
+static size_t db_index_btree_inner_nodes(const DB_index_btree *index, size_t leaves, size_t *height);
+
+/*
+    Find leaves of written entries and update them in place
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - written entries
+
+    RETURN
+    Time of writes
+*/
+static double db_index_btree_write_leaves(DB_index_btree *index, size_t entries);
+
+/*
+    Split leaves after insert, every insert splits at most one leaf
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - inserted entries
+
+    RETURN
+    Time of splits
+*/
+static double db_index_btree_split(DB_index_btree *index, size_t entries);
+
+/*
+    Insert entries without charging time to statistics
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to insert
+
+    RETURN
+    Insert time
+*/
+static double db_index_btree_put(DB_index_btree *index, size_t entries);
+
+static inline size_t db_index_btree_entries_per_page(const DB_index_btree *index)
+{
+    return db_utils_entries_per_page(index->ssd->page_size, index->entry_size);
+}
+
+static inline size_t db_index_btree_fanout(const DB_index_btree *index)
+{
+    const size_t pointers = db_utils_entries_per_page(index->ssd->page_size, index->key_size + sizeof(void *));
+    const size_t fanout = (size_t)((double)pointers * DBINDEX_BTREE_FILL);
+
+    return fanout > 2 ? fanout : 2;
+}
+
+static inline size_t db_index_btree_path_pages(const DB_index_btree *index)
+{
+    return index->height > 2 ? index->height - 2 : 0;
+}
+
+static size_t db_index_btree_inner_nodes(const DB_index_btree *index, size_t leaves, size_t *height)
+{
+    const size_t fanout = db_index_btree_fanout(index);
+    size_t nodes = leaves;
+    size_t inner = 0;
+
+    *height = 1;
+    while (nodes > 1)
+    {
+        nodes = INT_CEIL_DIV(nodes, fanout);
+        inner += nodes;
+        ++(*height);
+    }
+
+    return inner;
+}
+
+static double db_index_btree_write_leaves(DB_index_btree *index, size_t entries)
+{
+    const size_t path_pages = db_index_btree_path_pages(index) * entries;
+    double time = 0.0;
+
+    index->index_stat.write_pages_rread += path_pages;
+    index->index_stat.pages_updated += entries;
+
+    time += ssd_rread_pages(index->ssd, path_pages);
+    time += ssd_update_pages(index->ssd, entries);
+
+    return time;
+}
+
+static double db_index_btree_split(DB_index_btree *index, size_t entries)
+{
+    const size_t entries_per_page = db_index_btree_entries_per_page(index);
+    const double leaf_entries = (double)entries_per_page * DBINDEX_BTREE_FILL;
+    const double _leaves = ceil((double)index->num_entries / leaf_entries);
+    size_t leaves = (size_t)_leaves;
+    size_t splits;
+    size_t inner;
+    size_t height;
+    double time = 0.0;
+
+    if (leaves <= index->leaves)
+        return time;
+
+    /* leaf which overflows is split into two halves */
+    splits = leaves - index->leaves;
+    if (splits > entries)
+        splits = entries;
+
+    leaves = index->leaves + splits;
+
+    /* new leaf is written, parent gets its pointer */
+    index->index_stat.leaf_splits += splits;
+    index->index_stat.pages_rwrite += splits;
+    index->index_stat.pages_updated += splits;
+    time += ssd_rwrite_pages(index->ssd, splits);
+    time += ssd_update_pages(index->ssd, splits);
+
+    /* split leaf moves half of its entries to place out of order */
+    index->sorted_leaves -= splits < index->sorted_leaves ? splits : index->sorted_leaves;
+    index->leaves = leaves;
+
+    inner = db_index_btree_inner_nodes(index, leaves, &height);
+    if (inner > index->inner_nodes)
+    {
+        splits = inner - index->inner_nodes;
+
+        index->index_stat.inner_splits += splits;
+        index->index_stat.pages_rwrite += splits;
+        index->index_stat.pages_updated += splits;
+        time += ssd_rwrite_pages(index->ssd, splits);
+        time += ssd_update_pages(index->ssd, splits);
+    }
+
+    index->inner_nodes = inner;
+    index->height = height;
+
+    return time;
+}
+
+static double db_index_btree_put(DB_index_btree *index, size_t entries)
+{
+    double time = 0.0;
+
+    index->num_entries += entries;
+    index->index_stat.entries_written += entries;
+
+    time += db_index_btree_write_leaves(index, entries);
+    time += db_index_btree_split(index, entries);
+
+    return time;
+}
+
+DB_index_btree *db_index_btree_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size)
+{
+    DB_index_btree *index;
+
+    index = (DB_index_btree *)calloc(1, sizeof(DB_index_btree));
+    if (index == NULL)
+        return NULL;
+
+    index->ssd = ssd;
+    index->stat = stat;
+    index->key_size = key_size;
+    index->entry_size = entry_size;
+
+    /* empty tree is one leaf which is root */
+    index->height = 1;
+    index->leaves = 1;
+
+    return index;
+}
+
+void db_index_btree_destroy(DB_index_btree *index)
+{
+    if (index == NULL)
+        return;
+
+    free(index);
+}
+
+double db_index_btree_insert(DB_index_btree *index, size_t entries)
+{
+    const double time = db_index_btree_put(index, entries);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_btree_bulkload(DB_index_btree *index, size_t entries)
+{
+    const size_t entries_per_page = db_index_btree_entries_per_page(index);
+    const double leaf_entries = (double)entries_per_page * DBINDEX_BTREE_FILL;
+    double _leaves;
+    double time = 0.0;
+    size_t leaves;
+    size_t pages;
+
+    if (index->num_entries > 0)
+    {
+        time = db_index_btree_put(index, entries);
+
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
+
+    /* leaves are filled like by splits (otherwise the first inserts split all of them), nodes are written level by level */
+    _leaves = ceil((double)entries / leaf_entries);
+    leaves = (size_t)_leaves;
+    if (leaves == 0)
+        leaves = 1;
+
+    index->leaves = leaves;
+    index->sorted_leaves = leaves;
+    index->inner_nodes = db_index_btree_inner_nodes(index, leaves, &index->height);
+    index->num_entries = entries;
+    index->index_stat.entries_written += entries;
+
+    pages = leaves + index->inner_nodes;
+    index->index_stat.pages_swrite += pages;
+    time += ssd_swrite_pages(index->ssd, pages);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_btree_point_search(DB_index_btree *index, size_t entries)
+{
+    const size_t pages = (index->height - 1) * entries;
+    const double time = ssd_rread_pages(index->ssd, pages);
+
+    index->index_stat.point_lookups += entries;
+    index->index_stat.search_pages_rread += pages;
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_btree_range_search(DB_index_btree *index, size_t entries)
+{
+    return db_index_btree_range_search_repeat(index, entries, 1);
+}
+
+double db_index_btree_range_search_repeat(DB_index_btree *index, size_t entries, size_t queries)
+{
+    double time = 0.0;
+    double _pages;
+    size_t pages;
+    size_t seq_pages;
+    size_t rand_pages;
+
+    /* entries are spread over leaves as they are filled now */
+    _pages = index->num_entries > 0 ? ceil((double)entries * (double)index->leaves / (double)index->num_entries) : 1.0;
+    pages = (size_t)_pages;
+    if (pages == 0)
+        pages = 1;
+    if (pages > index->leaves)
+        pages = index->leaves;
+
+    seq_pages = (size_t)((double)pages * (double)index->sorted_leaves / (double)index->leaves);
+    rand_pages = db_index_btree_path_pages(index) + pages - seq_pages;
+
+    time += ssd_rread_pages(index->ssd, rand_pages);
+    time += ssd_sread_pages(index->ssd, seq_pages);
+
+    /* index is not changed, so each search costs the same */
+    time *= (double)queries;
+
+    index->index_stat.range_searches += queries;
+    index->index_stat.search_pages_rread += rand_pages * queries;
+    index->index_stat.search_pages_sread += seq_pages * queries;
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_btree_delete(DB_index_btree *index, size_t entries)
+{
+    double time = 0.0;
+
+    index->num_entries -= entries < index->num_entries ? entries : index->num_entries;
+    index->index_stat.entries_written += entries;
+
+    time += db_index_btree_write_leaves(index, entries);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_btree_update(DB_index_btree *index, size_t entries)
+{
+    double time = 0.0;
+
+    index->index_stat.entries_written += entries;
+
+    time += db_index_btree_write_leaves(index, entries);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_btree_write_amplification(const DB_index_btree *index)
+{
+    const BTIndex_stat *index_stat = &index->index_stat;
+    const size_t pages = index_stat->pages_swrite + index_stat->pages_rwrite + index_stat->pages_updated;
+
+    if (index_stat->entries_written == 0)
+        return 0.0;
+
+    return (double)(pages * index->ssd->page_size) / (double)(index_stat->entries_written * index->entry_size);
+}
+
+double db_index_btree_read_amplification(const DB_index_btree *index)
+{
+    const size_t searches = index->index_stat.point_lookups + index->index_stat.range_searches;
+
+    if (searches == 0)
+        return 0.0;
+
+    return (double)index->index_stat.search_pages_rread / (double)searches;
+}
+
+double db_index_btree_space_amplification(const DB_index_btree *index)
+{
+    if (index->num_entries == 0)
+        return 0.0;
+
+    return (double)((index->leaves + index->inner_nodes) * index->ssd->page_size) / (double)(index->num_entries * index->entry_size);
+}
+
+void db_index_btree_stat_print(const DB_index_btree *index)
+{
+    const BTIndex_stat *index_stat = &index->index_stat;
+
+    printf("B+TREE\n");
+    printf("\tHEIGHT                 = %zu\n", index->height);
+    printf("\tFANOUT                 = %zu\n", db_index_btree_fanout(index));
+    printf("\tLEAVES                 = %zu\n", index->leaves);
+    printf("\tSORTED        LEAVES   = %zu\n", index->sorted_leaves);
+    printf("\tINNER         NODES    = %zu\n", index->inner_nodes);
+    printf("\tLEAF          SPLITS   = %zu\n", index_stat->leaf_splits);
+    printf("\tINNER         SPLITS   = %zu\n", index_stat->inner_splits);
+    printf("\tSEARCH RAND   PAGES    = %zu\n", index_stat->search_pages_rread);
+    printf("\tSEARCH SEQ    PAGES    = %zu\n", index_stat->search_pages_sread);
+    printf("\tWRITE  PATH   PAGES    = %zu\n", index_stat->write_pages_rread);
+    printf("\tSEQ   WRITE   PAGES    = %zu\n", index_stat->pages_swrite);
+    printf("\tRAND  WRITE   PAGES    = %zu\n", index_stat->pages_rwrite);
+    printf("\tUPDATED       PAGES    = %zu\n", index_stat->pages_updated);
+
+    printf("AMPLIFICATION\n");
+    printf("\tWRITE                  = %lf\n", db_index_btree_write_amplification(index));
+    printf("\tREAD                   = %lf\n", db_index_btree_read_amplification(index));
+    printf("\tSPACE                  = %lf\n", db_index_btree_space_amplification(index));
+}
@@ -2,6 +2,10 @@
 #include <ssd.h>
 #include <math.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
 #include <dbutils.h>
 #include <dbstat.h>
 
@@ -12,7 +16,7 @@
     RETURN
     Maximum number of entries that can be written on one page
 */
-static inline size_t db_index_fdtree_entries_per_page(DB_index_fdtree *index);
+static inline size_t db_index_fdtree_entries_per_page(const DB_index_fdtree *index);
 
 /*
     PARAMS
@@ -22,249 +26,2320 @@ static inline size_t db_index_fdtree_entries_per_page(DB_index_fdtree *index);
     RETURN
     Number of pages used by entries
 */
-static inline size_t db_index_fdtree_pages_for_entries(DB_index_fdtree *index, size_t entries);
+static inline size_t db_index_fdtree_pages_for_entries(const DB_index_fdtree *index, size_t entries);
 
 /*
-    Merge 2 lvls into 1 (Copy all entries from lvl1 to lvl2 and sort them like list)
-    IF lvl2 will be full, then we will merge lvl2 with lvl2 + 1 and so on
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Number of entries in HeadTree when HeadTree is merged with Lvl0
+*/
+static inline size_t db_index_fdtree_head_entries(DB_index_fdtree *index);
+
+/*
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Number of entries which can be added to HeadTree, last of them triggers merge with Lvl0
+*/
+static inline size_t db_index_fdtree_entries_to_head_merge(DB_index_fdtree *index);
+
+/*
+    Put entries into HEAD, HEAD is kept sorted
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries put into HEAD
+
+    RETURN
+    CPU time of keeping HEAD sorted
+*/
+static inline double db_index_fdtree_head_put(DB_index_fdtree *index, size_t entries);
+
+/*
+    Start new write, time of the last write is cleared
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+static inline void db_index_fdtree_write_start(DB_index_fdtree *index);
+
+/*
+    Set capacity of HEAD and lvls from size of HEAD
+
+    PARAMS
+    @IN index - pointer to index
+    @IN pages - pages of HEAD
+
+    RETURN
+    This is a void function
+*/
+static void db_index_fdtree_set_capacities(DB_index_fdtree *index, size_t pages);
+
+/*
+    Get ratio of lvl set by user
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+
+    RETURN
+    Ratio of lvl
+*/
+static inline size_t db_index_fdtree_lvl_runs_ratio(const DB_index_fdtree *index, size_t lvl);
+
+/*
+    Add new the deepest lvl, per lvl arrays of Bloom filters, buffer pool and key level mode grow too
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_index_fdtree_add_lvl(DB_index_fdtree *index);
+
+/*
+    Re-leveling: make space in the deepest lvl by growing its ratio instead of adding new lvl
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+    @IN entries - entries in run merged into lvl
+    @IN entries_to_delete - entries to delete in run merged into lvl
+
+    RETURN
+    true iff run fits into lvl now
+*/
+static bool db_index_fdtree_relevel_grow(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete);
+
+/*
+    Check if lvl has to be merged with lvl + 1 before run (entries, entries_to_delete) can be merged into it
+
+    PARAMS
+    @IN index - index
+    @IN lvl - lvl
+    @IN entries - entries in run
+    @IN entries_to_delete - entries to delete in run
+
+    RETURN
+    true iff lvl is full
+*/
+static inline bool db_index_fdtree_lvl_is_full(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete);
+
+/*
+    Write new run of lvl. In SSD FTL mode new run gets new logical space
+    and old run is trimmed
+
+    PARAMS
+    @IN index - index
+    @IN lvl - lvl
+    @IN pages - pages of new run
+
+    RETURN
+    Time spent for writing
+*/
+static double db_index_fdtree_write_run(DB_index_fdtree *index, size_t lvl, size_t pages);
+
+/*
+    Drop run of lvl (trim it in SSD FTL mode)
+
+    PARAMS
+    @IN index - index
+    @IN lvl - lvl
+
+    RETURN
+    This is a void function
+*/
+static void db_index_fdtree_free_run(DB_index_fdtree *index, size_t lvl);
+
+/*
+    Merge run (entries, entries_to_delete) into lvl which has enough space for it
+    Run comes from lvl - 1 or from HeadTree when lvl == 0
+
+    PARAMS
+    @IN index - index
+    @IN lvl - lvl
+    @IN entries - entries in run
+    @IN entries_to_delete - entries to delete in run
+
+    RETURN
+    Time spent for merging
+*/
+static double db_index_fdtree_merge_into_lvl(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete);
+
+/*
+    Add difference between lvl_stat and before times to lvl_stat.
+    Use it to charge statistics of one period of merges to the rest of periods
+
+    PARAMS
+    @IN lvl_stat - statistics of lvl after one period
+    @IN before - statistics of lvl before period
+    @IN times - how many times period is repeated
+
+    RETURN
+    This is a void function
+*/
+static void db_index_fdtree_lvl_stat_repeat(FDLvl_stat *lvl_stat, const FDLvl_stat *before, size_t times);
+
+/*
+    Merge run (entries, entries_to_delete) into lvl
+    IF lvl will be full, then we will merge lvl with lvl + 1 and so on
+
+    PARAMS
+    @IN index - index
+    @IN lvl - lvl
+    @IN entries - entries in run
+    @IN entries_to_delete - entries to delete in run
+
+    RETURN
+    Time spent for merging
+*/
+static double db_index_fdtree_merge_run_once(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete);
+
+/*
+    Merge the same run (entries, entries_to_delete) into lvl merges times.
+    Result is the same as calling db_index_fdtree_merge_run_once merges times,
+    but after first merge of lvl with lvl + 1 the lvl is periodic, so we charge whole periods at once
+    and pass them to lvl + 1 as one batch. Cost depends on number of lvls not on number of merges.
+
+    PARAMS
+    @IN index - index
+    @IN lvl - lvl
+    @IN entries - entries in run
+    @IN entries_to_delete - entries to delete in run
+    @IN merges - how many times run is merged into lvl
+
+    RETURN
+    Time spent for merging
+*/
+static double db_index_fdtree_merge_runs(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete, size_t merges);
+
+/*
+    Merge HeadTree with Lvl0
+    IF LVl0 will be full, then we will merge lvl0 with lvl1 and so on
 
     PARAMS
     @IN index - index
-    @IN lvl1 - first lvl
-    @IN lvl2 - second lvl
 
-    RETURN
-    Time spent for merging
-*/
-static double db_index_fdtree_merge_runs(DB_index_fdtree* index, size_t lvl1, size_t lvl2);
+    RETURN
+    Time spent for merging
+*/
+static double db_index_fdtree_merge_headtree(DB_index_fdtree *index);
+
+/*
+    Find newest version of key in lvls (key level mode)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - the newest lvl to check
+    @IN key - key
+
+    RETURN
+    DB_KEYSET_NONE iff key is not in lvls >= lvl
+    State of the newest version of key
+*/
+static DB_keyset_state db_index_fdtree_keys_newest(const DB_index_fdtree *index, size_t lvl, uint64_t key);
+
+/*
+    Copy counts of HEAD keys to headtree and merge HEAD if it is full (key level mode)
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Merge time
+*/
+static double db_index_fdtree_keys_sync_head(DB_index_fdtree *index);
+
+/*
+    Insert entry with key into HEAD (key level mode)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+
+    RETURN
+    Insert time
+*/
+static double db_index_fdtree_keys_insert(DB_index_fdtree *index, uint64_t key);
+
+/*
+    Delete entry with key in HEAD (key level mode)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+
+    RETURN
+    Delete time
+*/
+static double db_index_fdtree_keys_delete(DB_index_fdtree *index, uint64_t key);
+
+/*
+    Update entry with key in HEAD (key level mode)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key of entry
+
+    RETURN
+    Update time
+*/
+static double db_index_fdtree_keys_update(DB_index_fdtree *index, uint64_t key);
+
+/*
+    Merge keys of lvl - 1 (HEAD for lvl 0) into lvl (key level mode),
+    I/O is charged like in db_index_fdtree_merge_into_lvl
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+
+    RETURN
+    Merge time
+*/
+static double db_index_fdtree_merge_into_lvl_keys(DB_index_fdtree *index, size_t lvl);
+
+/*
+    Merge keys of src into dst of lvl (key level mode), src is newer and it is cleared.
+    Newer version replaces older one, tombstone without live version below lvl cancels
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl of dst
+    @IN src - newer keys
+    @IN dst - keys of lvl
+
+    RETURN
+    This is a void function
+*/
+static void db_index_fdtree_keys_merge_set(DB_index_fdtree *index, size_t lvl, DB_keyset *src, DB_keyset *dst);
+
+/*
+    Move HEAD and lvls < lvl into lvl with new entries (newer than everything in index)
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl which can hold all of them
+    @IN entries - new entries
+
+    RETURN
+    This is a void function
+*/
+static void db_index_fdtree_bulkload_counts(DB_index_fdtree *index, size_t lvl, size_t entries);
+
+/*
+    Rebuild Bloom filter of lvl after merge into lvl, every key of new run is hashed again
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+
+    RETURN
+    Time spent for rebuilding (0 iff filters are off)
+*/
+static double db_index_fdtree_bloom_rebuild(DB_index_fdtree *index, size_t lvl);
+
+/*
+    Get RAM used by filters when false positive rate of lvl is min(1, lambda * keys of lvl)
+
+    PARAMS
+    @IN keys - keys of lvls
+    @IN lvls - number of lvls
+    @IN log_lambda - ln(lambda)
+
+    RETURN
+    Memory in bits
+*/
+static double db_index_fdtree_bloom_bits(const double *keys, size_t lvls, double log_lambda);
+
+/*
+    Spread budget of filters over lvls (Monkey) and compute expected probes of lookup
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+static void db_index_fdtree_bloom_allocate(const DB_index_fdtree *index);
+
+/*
+    Point search with Bloom filters, expected pages are charged to lvls
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to find
+
+    RETURN
+    Search time
+*/
+static double db_index_fdtree_bloom_point_search(DB_index_fdtree *index, size_t entries);
+
+/*
+    Get random number (splitmix64)
+
+    PARAMS
+    @IN pool - pointer to pool of index
+
+    RETURN
+    Random number
+*/
+static inline uint64_t db_index_fdtree_pool_rand(FDPool *pool);
+
+/*
+    Invalidate lvls rewritten since last search and pin lvls which fit in pool (PINNED policy)
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    This is a void function
+*/
+static void db_index_fdtree_pool_sync(DB_index_fdtree *index);
+
+/*
+    Read random page of lvl through buffer pool, hit or miss is charged to lvl
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+
+    RETURN
+    true iff page has to be read from SSD
+*/
+static bool db_index_fdtree_pool_read(DB_index_fdtree *index, size_t lvl);
+
+/*
+    Point search through buffer pool, with Bloom filters lvl is probed with expected probability
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to find
+
+    RETURN
+    Search time
+*/
+static double db_index_fdtree_pool_point_search(DB_index_fdtree *index, size_t entries);
+
+/*
+    Get pages read and written by merges into all lvls so far
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Number of pages
+*/
+static size_t db_index_fdtree_merge_pages(const DB_index_fdtree *index);
+
+/*
+    Do part of merge in progress for writes (incremental merge). Merge is spread evenly over writes
+    left before next flush of HEAD, so flush does not wait for it, rest of at most budget pages is done at once
+
+    PARAMS
+    @IN index - pointer to index
+    @IN ops - writes which do part of merge
+
+    RETURN
+    Time of done part of merge
+*/
+static double db_index_fdtree_merge_step(DB_index_fdtree *index, size_t ops);
+
+/*
+    Finish merge in progress (incremental merge)
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Time of rest of merge
+*/
+static double db_index_fdtree_merge_drain(DB_index_fdtree *index);
+
+/*
+    Put entries or tombstones into HEAD one flush at time, so every flush is merged incrementally
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - number of entries
+    @IN tombstones - true iff entries are tombstones
+
+    RETURN
+    Time of merge steps and stalls
+*/
+static double db_index_fdtree_merge_put(DB_index_fdtree *index, size_t entries, bool tombstones);
+
+static inline size_t db_index_fdtree_entries_per_page(const DB_index_fdtree *index)
+{
+    return db_utils_entries_per_page(index->ssd->page_size, index->entry_size);
+}
+
+static inline size_t db_index_fdtree_pages_for_entries(const DB_index_fdtree *index, size_t entries)
+{
+    const size_t pages_for_entries = db_utils_pages_for_entries(index->ssd->page_size, index->entry_size, entries);
+    const size_t pages_for_pointers = db_utils_pages_for_entries(index->ssd->page_size, index->key_size + sizeof(void *), pages_for_entries);
+
+    return pages_for_entries + pages_for_pointers;
+}
+
+static inline size_t db_index_fdtree_head_entries(DB_index_fdtree *index)
+{
+    /* HEAD is merged when it is full, but at least 1 entry is needed */
+    return index->headtree.max_entries > 0 ? index->headtree.max_entries : 1;
+}
+
+static inline size_t db_index_fdtree_entries_to_head_merge(DB_index_fdtree *index)
+{
+    const FDHead *headtree = &index->headtree;
+
+    return db_index_fdtree_head_entries(index) - (headtree->num_entries + headtree->num_entries_to_delete);
+}
+
+static inline double db_index_fdtree_head_put(DB_index_fdtree *index, size_t entries)
+{
+    FDHead *headtree = &index->headtree;
+    const double cmps = headtree->max_entries > 1 ? log2((double)headtree->max_entries) : 1.0;
+    const double time = (double)entries * cmps * DBINDEX_FDTREE_HEAD_CMP_TIME;
+
+    headtree->time += time;
+    index->last_head_time += time;
+
+    return time;
+}
+
+static inline void db_index_fdtree_write_start(DB_index_fdtree *index)
+{
+    index->last_head_time = 0.0;
+    index->last_merge_time = 0.0;
+    index->last_step_time = 0.0;
+}
+
+static void db_index_fdtree_set_capacities(DB_index_fdtree *index, size_t pages)
+{
+    size_t max_entries;
+
+    index->headtree.pages = pages;
+    index->headtree.max_entries = db_index_fdtree_entries_per_page(index) * pages;
+
+    /* capacity of deep lvls of huge index saturates instead of overflow (it is compared as ssize_t) */
+    max_entries = index->headtree.max_entries;
+    for (size_t i = 0; i < index->num_lvls; ++i)
+    {
+        FDLvl *fdlvl = &index->sortedruns[i];
+
+        max_entries = max_entries <= (size_t)SSIZE_MAX / fdlvl->runs_ratio ? max_entries * fdlvl->runs_ratio : (size_t)SSIZE_MAX;
+        fdlvl->max_entries = max_entries;
+    }
+}
+
+static inline size_t db_index_fdtree_lvl_runs_ratio(const DB_index_fdtree *index, size_t lvl)
+{
+    return index->runs_ratios[lvl < index->num_runs_ratios ? lvl : index->num_runs_ratios - 1];
+}
+
+static int db_index_fdtree_add_lvl(DB_index_fdtree *index)
+{
+    const size_t lvl = index->num_lvls;
+    const size_t lvls = lvl + 1;
+    FDLvl *sortedruns;
+
+    /* arrays are resized one by one, array which has grown keeps its size if next one fails */
+    sortedruns = (FDLvl *)realloc(index->sortedruns, sizeof(FDLvl) * lvls);
+    if (sortedruns == NULL)
+        return 1;
+
+    index->sortedruns = sortedruns;
+    (void)memset(&index->sortedruns[lvl], 0, sizeof(FDLvl));
+
+    if (index->keys != NULL)
+    {
+        DB_keyset *keysets = (DB_keyset *)realloc(index->keys->lvls, sizeof(DB_keyset) * lvls);
+
+        if (keysets == NULL)
+            return 1;
+
+        index->keys->lvls = keysets;
+        if (db_keyset_init(&index->keys->lvls[lvl], 0) != 0)
+            return 1;
+    }
+
+    if (index->bloom != NULL)
+    {
+        double **arrays[] = {&index->bloom->keys, &index->bloom->bits_per_key, &index->bloom->fpr, &index->bloom->probes, &index->bloom->carry};
+
+        for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); ++i)
+        {
+            double *array = (double *)realloc(*arrays[i], sizeof(double) * lvls);
+
+            if (array == NULL)
+                return 1;
+
+            array[lvl] = 0.0;
+            *arrays[i] = array;
+        }
+
+        index->bloom->stale = true;
+    }
+
+    if (index->pool != NULL)
+    {
+        size_t *generation = (size_t *)realloc(index->pool->generation, sizeof(size_t) * lvls);
+
+        if (generation == NULL)
+            return 1;
+
+        generation[lvl] = 0;
+        index->pool->generation = generation;
+        if (db_bufpool_add_runs(index->pool->pool, lvls) != 0)
+            return 1;
+    }
+
+    index->sortedruns[lvl].runs_ratio = db_index_fdtree_lvl_runs_ratio(index, lvl);
+    index->num_lvls = lvls;
+    db_index_fdtree_set_capacities(index, index->headtree.pages);
+
+    return 0;
+}
+
+static bool db_index_fdtree_relevel_grow(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete)
+{
+    FDLvl *fdlvl = &index->sortedruns[lvl];
+
+    if (index->max_runs_ratio == 0 || lvl + 1 != index->num_lvls)
+        return false;
+
+    while (fdlvl->runs_ratio < index->max_runs_ratio && db_index_fdtree_lvl_is_full(index, lvl, entries, entries_to_delete))
+    {
+        fdlvl->runs_ratio = fdlvl->runs_ratio * 2 < index->max_runs_ratio ? fdlvl->runs_ratio * 2 : index->max_runs_ratio;
+        ++index->relevels;
+        db_index_fdtree_set_capacities(index, index->headtree.pages);
+    }
+
+    return !db_index_fdtree_lvl_is_full(index, lvl, entries, entries_to_delete);
+}
+
+static inline bool db_index_fdtree_lvl_is_full(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete)
+{
+    const FDLvl *fdlvl = &index->sortedruns[lvl];
+    const ssize_t entries_in_lvl_after_merge = (ssize_t)(entries + fdlvl->num_entries - entries_to_delete);
+
+    return entries_in_lvl_after_merge + (ssize_t)fdlvl->num_entries_to_delete >= (ssize_t)fdlvl->max_entries;
+}
+
+static double db_index_fdtree_write_run(DB_index_fdtree *index, size_t lvl, size_t pages)
+{
+    SSD_ftl_extent extent;
+    double time;
+
+    FDLvl *fdlvl = &index->sortedruns[lvl];
+
+    if (index->ssd->ftl == NULL)
+        return ssd_swrite_pages(index->ssd, pages);
+
+    /* SSD is full, mark as invalid */
+    if (!ssd_ftl_alloc(index->ssd, pages, &extent))
+        return DBINDEX_FDTREE_INVALID_TIME;
+
+    time = ssd_ftl_write(index->ssd, extent.lpn, extent.pages, true);
+
+    ssd_ftl_free(index->ssd, &fdlvl->extent);
+    fdlvl->extent = extent;
+
+    return time;
+}
+
+static void db_index_fdtree_free_run(DB_index_fdtree *index, size_t lvl)
+{
+    if (index->ssd->ftl == NULL)
+        return;
+
+    ssd_ftl_free(index->ssd, &index->sortedruns[lvl].extent);
+}
+
+static double db_index_fdtree_merge_into_lvl(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete)
+{
+    double time = 0.0;
+    size_t pages;
+    size_t src_pages;
+
+    FDLvl *fdlvl = &index->sortedruns[lvl];
+    FDLvl_stat *lvl_stat = &fdlvl->stat;
+
+    const ssize_t entries_in_lvl_after_merge = (ssize_t)(entries + fdlvl->num_entries - entries_to_delete);
+    const size_t entries_to_delete_after_merge = (entries_to_delete > fdlvl->num_entries ? entries_to_delete - fdlvl->num_entries : 0);
+
+    if (index->keys != NULL)
+        return db_index_fdtree_merge_into_lvl_keys(index, lvl);
+
+    ++lvl_stat->merges;
+
+    /* reading entries from headtree is free, lvl - 1 has to be read */
+    src_pages = 0;
+    if (lvl > 0)
+    {
+        src_pages = db_index_fdtree_pages_for_entries(index, entries + entries_to_delete);
+        lvl_stat->pages_sread += src_pages;
+    }
+
+    pages = db_index_fdtree_pages_for_entries(index, fdlvl->num_entries + fdlvl->num_entries_to_delete);
+    lvl_stat->pages_sread += pages;
+
+    /* both runs can be read in parallel */
+    if (index->io_depth > 1)
+        time += ssd_sread_pages_overlap(index->ssd, src_pages, pages);
+    else
+    {
+        if (lvl > 0)
+            time += ssd_sread_pages(index->ssd, src_pages);
+
+        time += ssd_sread_pages(index->ssd, pages);
+    }
+
+    /* write down merged run and lvl */
+    if (entries_in_lvl_after_merge > 0)
+    {
+        pages = db_index_fdtree_pages_for_entries(index, (size_t)entries_in_lvl_after_merge + fdlvl->num_entries_to_delete);
+        lvl_stat->pages_swrite += pages;
+        lvl_stat->entries_moved += (size_t)entries_in_lvl_after_merge;
+        lvl_stat->tombstones_moved += fdlvl->num_entries_to_delete;
+        time += db_index_fdtree_write_run(index, lvl, pages);
+    }
+    else if (entries_to_delete_after_merge > 0)
+    {
+        pages = db_index_fdtree_pages_for_entries(index, entries_to_delete_after_merge);
+        lvl_stat->pages_swrite += pages;
+        lvl_stat->tombstones_moved += entries_to_delete_after_merge;
+        time += db_index_fdtree_write_run(index, lvl, pages);
+    }
+    else
+        db_index_fdtree_free_run(index, lvl);
+
+    // write fences into lvl - 1
+    if (lvl > 0)
+    {
+        db_index_fdtree_free_run(index, lvl - 1);
+
+        ++lvl_stat->fence_pages;
+        time += db_index_fdtree_write_run(index, lvl - 1, 1);
+    }
+
+    if (entries_in_lvl_after_merge > 0)
+        fdlvl->num_entries = (size_t)entries_in_lvl_after_merge;
+    else
+        fdlvl->num_entries = 0;
+
+    fdlvl->num_entries_to_delete += entries_to_delete_after_merge;
+
+    time += db_index_fdtree_bloom_rebuild(index, lvl);
+
+    lvl_stat->time += time;
+
+    return time;
+}
+
+static void db_index_fdtree_lvl_stat_repeat(FDLvl_stat *lvl_stat, const FDLvl_stat *before, size_t times)
+{
+    lvl_stat->pages_sread += (lvl_stat->pages_sread - before->pages_sread) * times;
+    lvl_stat->pages_rread += (lvl_stat->pages_rread - before->pages_rread) * times;
+    lvl_stat->pages_swrite += (lvl_stat->pages_swrite - before->pages_swrite) * times;
+    lvl_stat->pages_rwrite += (lvl_stat->pages_rwrite - before->pages_rwrite) * times;
+    lvl_stat->fence_pages += (lvl_stat->fence_pages - before->fence_pages) * times;
+    lvl_stat->merges += (lvl_stat->merges - before->merges) * times;
+    lvl_stat->entries_moved += (lvl_stat->entries_moved - before->entries_moved) * times;
+    lvl_stat->tombstones_moved += (lvl_stat->tombstones_moved - before->tombstones_moved) * times;
+    lvl_stat->bloom_keys += (lvl_stat->bloom_keys - before->bloom_keys) * times;
+    lvl_stat->time += (lvl_stat->time - before->time) * (double)times;
+}
+
+static double db_index_fdtree_merge_run_once(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete)
+{
+    double time = 0.0;
+
+    FDLvl *fdlvl = &index->sortedruns[lvl];
+
+    /* we need merge lvl with lvl + 1 to make space for run entries */
+    if (db_index_fdtree_lvl_is_full(index, lvl, entries, entries_to_delete) && !db_index_fdtree_relevel_grow(index, lvl, entries, entries_to_delete))
+    {
+        if (lvl + 1 >= index->num_lvls)
+        {
+            /* lvl stops to be the deepest, its run goes down, so it can get back its ratio */
+            if (index->max_runs_ratio > 0 && fdlvl->runs_ratio != db_index_fdtree_lvl_runs_ratio(index, lvl))
+            {
+                fdlvl->runs_ratio = db_index_fdtree_lvl_runs_ratio(index, lvl);
+                ++index->relevels;
+            }
+
+            /* cannot merge, mark as invalid */
+            if (db_index_fdtree_add_lvl(index) != 0)
+                return DBINDEX_FDTREE_INVALID_TIME;
+
+            /* run of lvl has to fit into new lvl, grow it like the deepest lvl */
+            (void)db_index_fdtree_relevel_grow(index, lvl + 1, index->sortedruns[lvl].num_entries, index->sortedruns[lvl].num_entries_to_delete);
+        }
+
+        time += db_index_fdtree_merge_runs(index, lvl + 1, index->sortedruns[lvl].num_entries, index->sortedruns[lvl].num_entries_to_delete, 1);
+
+        /* lvls can be reallocated by merge */
+        fdlvl = &index->sortedruns[lvl];
+        fdlvl->num_entries = 0;
+        fdlvl->num_entries_to_delete = 0;
+    }
+
+    /* First time when we reach lvl, so height++  */
+    if (lvl > 0 && index->height < (lvl + 1) && fdlvl->num_entries == 0)
+        ++index->height;
+
+    time += db_index_fdtree_merge_into_lvl(index, lvl, entries, entries_to_delete);
+
+    return time;
+}
+
+static double db_index_fdtree_merge_runs(DB_index_fdtree *index, size_t lvl, size_t entries, size_t entries_to_delete, size_t merges)
+{
+    double time = 0.0;
+    double period_time;
+    size_t period;
+    size_t periods;
+    size_t first_entries;
+    size_t first_entries_to_delete;
+    size_t period_entries;
+    size_t period_entries_to_delete;
+    size_t i;
+
+    FDLvl *fdlvl;
+    FDLvl_stat before;
+    SSD_stat ssd_before;
+
+    if (merges == 0)
+        return 0.0;
+
+    /* cannot merge, mark as invalid */
+    while (lvl >= index->num_lvls)
+        if (db_index_fdtree_add_lvl(index) != 0)
+            return DBINDEX_FDTREE_INVALID_TIME * (double)merges;
+
+    /*
+        Height can change or lvl + 1 does not exist (capacity of the deepest lvl can change), lvl is not periodic.
+        Usually only first merge into new lvl goes here.
+        In SSD FTL mode cost of write depends on SSD state and in key level mode merge depends on keys,
+        so each merge is simulated
+    */
+    while (merges > 0 && ((lvl > 0 && index->height < lvl + 1) || lvl + 1 >= index->num_lvls || index->ssd->ftl != NULL || index->keys != NULL))
+    {
+        time += db_index_fdtree_merge_run_once(index, lvl, entries, entries_to_delete);
+        --merges;
+    }
+
+    /* lvl + 1 exists now, so lvls are not reallocated below */
+    fdlvl = &index->sortedruns[lvl];
+
+    /* merges until lvl is full */
+    while (merges > 0 && !db_index_fdtree_lvl_is_full(index, lvl, entries, entries_to_delete))
+    {
+        time += db_index_fdtree_merge_into_lvl(index, lvl, entries, entries_to_delete);
+        --merges;
+    }
+
+    if (merges == 0)
+        return time;
+
+    /* first merge of lvl with lvl + 1, after that lvl state depends only on merged run */
+    first_entries = fdlvl->num_entries;
+    first_entries_to_delete = fdlvl->num_entries_to_delete;
+    fdlvl->num_entries = 0;
+    fdlvl->num_entries_to_delete = 0;
+    time += db_index_fdtree_merge_into_lvl(index, lvl, entries, entries_to_delete);
+    --merges;
+
+    /* find one period: merges without merging lvl with lvl + 1 and one merge with it */
+    before = fdlvl->stat;
+    ssd_before = index->ssd->stat;
+    period_time = 0.0;
+    period = 0;
+    while (period < merges && !db_index_fdtree_lvl_is_full(index, lvl, entries, entries_to_delete))
+    {
+        period_time += db_index_fdtree_merge_into_lvl(index, lvl, entries, entries_to_delete);
+        ++period;
+    }
+
+    if (period == merges)
+    {
+        time += period_time;
+        time += db_index_fdtree_merge_runs(index, lvl + 1, first_entries, first_entries_to_delete, 1);
+
+        return time;
+    }
+
+    period_entries = fdlvl->num_entries;
+    period_entries_to_delete = fdlvl->num_entries_to_delete;
+    fdlvl->num_entries = 0;
+    fdlvl->num_entries_to_delete = 0;
+    period_time += db_index_fdtree_merge_into_lvl(index, lvl, entries, entries_to_delete);
+    ++period;
+
+    /* lvl is in the same state as after first merge with lvl + 1, so rest of periods cost the same */
+    periods = merges / period;
+    time += period_time * (double)periods;
+    db_index_fdtree_lvl_stat_repeat(&fdlvl->stat, &before, periods - 1);
+    ssd_stat_repeat(index->ssd, &ssd_before, periods - 1);
+
+    for (i = 0; i < merges % period; ++i)
+        time += db_index_fdtree_merge_into_lvl(index, lvl, entries, entries_to_delete);
+
+    time += db_index_fdtree_merge_runs(index, lvl + 1, first_entries, first_entries_to_delete, 1);
+    time += db_index_fdtree_merge_runs(index, lvl + 1, period_entries, period_entries_to_delete, periods);
+
+    return time;
+}
+
+static double db_index_fdtree_merge_headtree(DB_index_fdtree *index)
+{
+    double time = 0.0;
+    size_t pages = 0;
+    FDHead *headtree = &index->headtree;
+
+    /* previous merge has to end before HEAD is flushed again */
+    if (index->merge != NULL)
+    {
+        if (index->merge->pending_pages > 0.0 || index->merge->pending_time > 0.0)
+        {
+            ++index->merge->stalls;
+            index->merge->stalled_pages += index->merge->pending_pages;
+            time = db_index_fdtree_merge_drain(index);
+            index->merge->stall_time += time;
+        }
+
+        pages = db_index_fdtree_merge_pages(index);
+    }
+
+    /* older versions of updated entries are dropped like deleted entries (keysets know them in key level mode) */
+    if (index->merge == NULL)
+    {
+        time = db_index_fdtree_merge_runs(index, 0, headtree->num_entries, headtree->num_entries_to_delete + (index->keys == NULL ? headtree->num_updates : 0), 1);
+        index->last_merge_time += time;
+    }
+    else
+    {
+        index->merge->pending_time = db_index_fdtree_merge_runs(index, 0, headtree->num_entries, headtree->num_entries_to_delete + (index->keys == NULL ? headtree->num_updates : 0), 1);
+        index->merge->pending_pages = (double)(db_index_fdtree_merge_pages(index) - pages);
+        ++index->merge->deferred;
+
+        /* whole merge is started now, next writes only pay for it */
+        index->last_merge_time += index->merge->pending_time;
+    }
+
+    index->index_stat.updates_flushed += headtree->num_updates;
+    headtree->num_updates = 0;
+    headtree->num_entries_to_delete = 0;
+    headtree->num_entries = 0;
+
+    return time;
+}
+
+static size_t db_index_fdtree_merge_pages(const DB_index_fdtree *index)
+{
+    size_t pages = 0;
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+    {
+        const FDLvl_stat *lvl_stat = &index->sortedruns[i].stat;
+
+        pages += lvl_stat->pages_sread + lvl_stat->pages_swrite + lvl_stat->fence_pages;
+    }
+
+    return pages;
+}
+
+static double db_index_fdtree_merge_step(DB_index_fdtree *index, size_t ops)
+{
+    FDMerge *merge = index->merge;
+    size_t writes_left;
+    double pages;
+    double time;
+
+    if (merge == NULL || ops == 0 || (merge->pending_pages <= 0.0 && merge->pending_time <= 0.0))
+        return 0.0;
+
+    ++merge->steps;
+
+    /* HEAD space left counts ops or not, depending on caller, so ops is the least */
+    writes_left = db_index_fdtree_entries_to_head_merge(index);
+    if (writes_left < ops)
+        writes_left = ops;
+
+    /* merge without pages (only CPU) or its last step */
+    pages = merge->pending_pages * (double)ops / (double)writes_left;
+    if (pages >= merge->pending_pages || merge->pending_pages <= (double)ops * (double)merge->budget)
+        return db_index_fdtree_merge_drain(index);
+
+    /* time of merge is spread over its pages */
+    time = merge->pending_time * pages / merge->pending_pages;
+    merge->pending_pages -= pages;
+    merge->pending_time -= time;
+    index->last_step_time += time;
+
+    return time;
+}
+
+static double db_index_fdtree_merge_drain(DB_index_fdtree *index)
+{
+    FDMerge *merge = index->merge;
+    double time;
+
+    if (merge == NULL)
+        return 0.0;
+
+    time = merge->pending_time;
+    merge->pending_pages = 0.0;
+    merge->pending_time = 0.0;
+    index->last_step_time += time;
+
+    return time;
+}
+
+static double db_index_fdtree_merge_put(DB_index_fdtree *index, size_t entries, bool tombstones)
+{
+    double time = 0.0;
+    FDHead *headtree = &index->headtree;
+
+    while (entries > 0)
+    {
+        const size_t entries_to_merge = db_index_fdtree_entries_to_head_merge(index);
+        const size_t chunk = entries < entries_to_merge ? entries : entries_to_merge;
+
+        if (tombstones)
+            headtree->num_entries_to_delete += chunk;
+        else
+            headtree->num_entries += chunk;
+
+        time += db_index_fdtree_merge_step(index, chunk);
+        entries -= chunk;
+
+        if (db_index_fdtree_entries_to_head_merge(index) == 0)
+            time += db_index_fdtree_merge_headtree(index);
+    }
+
+    return time;
+}
+
+static DB_keyset_state db_index_fdtree_keys_newest(const DB_index_fdtree *index, size_t lvl, uint64_t key)
+{
+    for (size_t i = lvl; i < index->num_lvls; ++i)
+    {
+        DB_keyset_state state;
+
+        if (index->keys->lvls[i].size == 0)
+            continue;
+
+        state = db_keyset_get(&index->keys->lvls[i], key);
+        if (state != DB_KEYSET_NONE)
+            return state;
+    }
+
+    return DB_KEYSET_NONE;
+}
+
+static double db_index_fdtree_keys_sync_head(DB_index_fdtree *index)
+{
+    const DB_keyset *head = &index->keys->head;
+
+    index->headtree.num_entries = head->size - head->tombstones;
+    index->headtree.num_entries_to_delete = head->tombstones;
+
+    if (head->size < db_index_fdtree_head_entries(index))
+        return 0.0;
+
+    return db_index_fdtree_merge_headtree(index);
+}
+
+static double db_index_fdtree_keys_insert(DB_index_fdtree *index, uint64_t key)
+{
+    FDKeys *keys = index->keys;
+    const DB_keyset_state head = db_keyset_get(&keys->head, key);
+    const DB_keyset_state newest = head != DB_KEYSET_NONE ? head : db_index_fdtree_keys_newest(index, 0, key);
+
+    if (newest != DB_KEYSET_ENTRY)
+        ++index->num_entries;
+
+    ++index->index_stat.entries_written;
+
+    /* older version in HEAD is replaced in RAM */
+    if (head != DB_KEYSET_NONE)
+        ++keys->absorbed_in_head;
+
+    (void)db_keyset_put(&keys->head, key, DB_KEYSET_ENTRY);
+
+    return db_index_fdtree_head_put(index, 1) + db_index_fdtree_merge_step(index, 1) + db_index_fdtree_keys_sync_head(index);
+}
+
+static double db_index_fdtree_keys_delete(DB_index_fdtree *index, uint64_t key)
+{
+    FDKeys *keys = index->keys;
+    const DB_keyset_state head = db_keyset_get(&keys->head, key);
+    const DB_keyset_state below = db_index_fdtree_keys_newest(index, 0, key);
+    const DB_keyset_state newest = head != DB_KEYSET_NONE ? head : below;
+
+    if (newest == DB_KEYSET_ENTRY)
+        --index->num_entries;
+
+    ++index->index_stat.entries_written;
+
+    if (head == DB_KEYSET_TOMBSTONE)
+        ++keys->absorbed_in_head;
+    else if (below == DB_KEYSET_ENTRY)
+    {
+        /* live version on disk, tombstone is needed */
+        if (head == DB_KEYSET_ENTRY)
+            ++keys->absorbed_in_head;
+
+        (void)db_keyset_put(&keys->head, key, DB_KEYSET_TOMBSTONE);
+    }
+    else if (head == DB_KEYSET_ENTRY)
+    {
+        /* the only live version is in HEAD */
+        db_keyset_remove(&keys->head, key);
+        ++keys->cancelled_in_head;
+    }
+
+    return db_index_fdtree_head_put(index, 1) + db_index_fdtree_merge_step(index, 1) + db_index_fdtree_keys_sync_head(index);
+}
+
+static double db_index_fdtree_keys_update(DB_index_fdtree *index, uint64_t key)
+{
+    ++index->index_stat.updates;
+
+    /* version in HEAD is replaced in place, otherwise new version takes slot */
+    if (db_keyset_get(&index->keys->head, key) != DB_KEYSET_NONE)
+        ++index->index_stat.updates_absorbed;
+    else
+        ++index->headtree.num_updates;
+
+    return db_index_fdtree_keys_insert(index, key);
+}
+
+static double db_index_fdtree_merge_into_lvl_keys(DB_index_fdtree *index, size_t lvl)
+{
+    double time = 0.0;
+    size_t pages;
+    size_t src_pages;
+
+    FDKeys *keys = index->keys;
+    DB_keyset *src = lvl > 0 ? &keys->lvls[lvl - 1] : &keys->head;
+    DB_keyset *dst = &keys->lvls[lvl];
+    FDLvl *fdlvl = &index->sortedruns[lvl];
+    FDLvl_stat *lvl_stat = &fdlvl->stat;
+
+    ++lvl_stat->merges;
+
+    /* reading entries from headtree is free, lvl - 1 has to be read */
+    src_pages = 0;
+    if (lvl > 0)
+    {
+        src_pages = db_index_fdtree_pages_for_entries(index, src->size);
+        lvl_stat->pages_sread += src_pages;
+    }
+
+    pages = db_index_fdtree_pages_for_entries(index, dst->size);
+    lvl_stat->pages_sread += pages;
+
+    /* both runs can be read in parallel */
+    if (index->io_depth > 1)
+        time += ssd_sread_pages_overlap(index->ssd, src_pages, pages);
+    else
+    {
+        if (lvl > 0)
+            time += ssd_sread_pages(index->ssd, src_pages);
+
+        time += ssd_sread_pages(index->ssd, pages);
+    }
+
+    db_index_fdtree_keys_merge_set(index, lvl, src, dst);
+
+    /* write down merged run and lvl */
+    if (dst->size > 0)
+    {
+        pages = db_index_fdtree_pages_for_entries(index, dst->size);
+        lvl_stat->pages_swrite += pages;
+        lvl_stat->entries_moved += dst->size - dst->tombstones;
+        lvl_stat->tombstones_moved += dst->tombstones;
+        time += db_index_fdtree_write_run(index, lvl, pages);
+    }
+    else
+        db_index_fdtree_free_run(index, lvl);
+
+    // write fences into lvl - 1
+    if (lvl > 0)
+    {
+        db_index_fdtree_free_run(index, lvl - 1);
+
+        ++lvl_stat->fence_pages;
+        time += db_index_fdtree_write_run(index, lvl - 1, 1);
+    }
+
+    fdlvl->num_entries = dst->size - dst->tombstones;
+    fdlvl->num_entries_to_delete = dst->tombstones;
+
+    time += db_index_fdtree_bloom_rebuild(index, lvl);
+
+    lvl_stat->time += time;
+
+    return time;
+}
+
+static void db_index_fdtree_keys_merge_set(DB_index_fdtree *index, size_t lvl, DB_keyset *src, DB_keyset *dst)
+{
+    FDKeys *keys = index->keys;
+
+    /* newer versions from src replace versions in dst */
+    for (size_t i = 0; i < src->capacity; ++i)
+    {
+        const uint64_t key = src->keys[i];
+
+        if (src->states[i] == DB_KEYSET_NONE)
+            continue;
+
+        if (src->states[i] == DB_KEYSET_ENTRY)
+        {
+            if (db_keyset_get(dst, key) != DB_KEYSET_NONE)
+                ++keys->versions_dropped;
+
+            (void)db_keyset_put(dst, key, DB_KEYSET_ENTRY);
+        }
+        else if (db_index_fdtree_keys_newest(index, lvl + 1, key) == DB_KEYSET_ENTRY)
+            (void)db_keyset_put(dst, key, DB_KEYSET_TOMBSTONE);
+        else
+        {
+            /* tombstone has met the oldest version of key */
+            db_keyset_remove(dst, key);
+            ++keys->cancelled_in_merge;
+        }
+    }
+
+    db_keyset_clear(src);
+}
+
+static void db_index_fdtree_bulkload_counts(DB_index_fdtree *index, size_t lvl, size_t entries)
+{
+    FDLvl *fdlvl = &index->sortedruns[lvl];
+    FDHead *headtree = &index->headtree;
+
+    if (index->keys != NULL)
+    {
+        FDKeys *keys = index->keys;
+        DB_keyset *dst = &keys->lvls[lvl];
+
+        /* the oldest run first, so newer versions replace older ones */
+        for (size_t i = lvl; i > 0; --i)
+            db_index_fdtree_keys_merge_set(index, lvl, &keys->lvls[i - 1], dst);
+
+        db_index_fdtree_keys_merge_set(index, lvl, &keys->head, dst);
+
+        /* new keys are bigger than all keys inserted without key */
+        for (size_t i = 0; i < entries; ++i)
+            (void)db_keyset_put(dst, keys->next_insert_key++, DB_KEYSET_ENTRY);
+
+        fdlvl->num_entries = dst->size - dst->tombstones;
+        fdlvl->num_entries_to_delete = dst->tombstones;
+    }
+    else
+    {
+        /* entries to delete from newer run cancel entries of older one, like in merge into lvl */
+        for (size_t i = lvl; i > 0; --i)
+        {
+            const FDLvl *src = &index->sortedruns[i - 1];
+            const size_t cancelled = src->num_entries_to_delete < fdlvl->num_entries ? src->num_entries_to_delete : fdlvl->num_entries;
+
+            fdlvl->num_entries += src->num_entries - cancelled;
+            fdlvl->num_entries_to_delete += src->num_entries_to_delete - cancelled;
+        }
+
+        {
+            /* older versions of updated entries are dropped like deleted entries */
+            const size_t to_delete = headtree->num_entries_to_delete + headtree->num_updates;
+            const size_t cancelled = to_delete < fdlvl->num_entries ? to_delete : fdlvl->num_entries;
+
+            fdlvl->num_entries += headtree->num_entries - cancelled;
+            fdlvl->num_entries_to_delete += to_delete - cancelled;
+        }
+
+        fdlvl->num_entries += entries;
+    }
+
+    for (size_t i = 0; i < lvl; ++i)
+    {
+        index->sortedruns[i].num_entries = 0;
+        index->sortedruns[i].num_entries_to_delete = 0;
+    }
+
+    index->index_stat.updates_flushed += headtree->num_updates;
+    headtree->num_updates = 0;
+    headtree->num_entries = 0;
+    headtree->num_entries_to_delete = 0;
+}
+
+static double db_index_fdtree_bloom_rebuild(DB_index_fdtree *index, size_t lvl)
+{
+    FDLvl *fdlvl = &index->sortedruns[lvl];
+    const size_t keys = fdlvl->num_entries + fdlvl->num_entries_to_delete;
+
+    if (index->bloom == NULL)
+        return 0.0;
+
+    /* filter of lvl - 1 is dropped with its run, so only allocation changes */
+    index->bloom->stale = true;
+    fdlvl->stat.bloom_keys += keys;
+
+    return (double)keys * DBINDEX_FDTREE_BLOOM_KEY_TIME;
+}
+
+static double db_index_fdtree_bloom_bits(const double *keys, size_t lvls, double log_lambda)
+{
+    const double ln2_2 = log(2.0) * log(2.0);
+    double bits = 0.0;
+
+    /* bits per key of filter with false positive rate p is -ln(p) / ln(2)^2 */
+    for (size_t i = 0; i < lvls; ++i)
+        if (keys[i] > 0.0 && log_lambda + log(keys[i]) < 0.0)
+            bits += keys[i] * -(log_lambda + log(keys[i])) / ln2_2;
+
+    return bits;
+}
+
+static void db_index_fdtree_bloom_allocate(const DB_index_fdtree *index)
+{
+    FDBloom *bloom = index->bloom;
+    const double ln2_2 = log(2.0) * log(2.0);
+    double *keys = bloom->keys;
+    double min_keys = 0.0;
+    double max_keys = 0.0;
+    double live = 0.0;
+    double below;
+    double lo;
+    double hi;
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        keys[i] = 0.0;
+
+    for (size_t i = 0; i < index->height; ++i)
+    {
+        const FDLvl *fdlvl = &index->sortedruns[i];
+
+        keys[i] = (double)(fdlvl->num_entries + fdlvl->num_entries_to_delete);
+        live += (double)fdlvl->num_entries;
+
+        if (keys[i] > 0.0 && (min_keys == 0.0 || keys[i] < min_keys))
+            min_keys = keys[i];
+
+        if (keys[i] > max_keys)
+            max_keys = keys[i];
+    }
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+    {
+        bloom->bits_per_key[i] = 0.0;
+        bloom->fpr[i] = 0.0;
+        bloom->probes[i] = 0.0;
+    }
+
+    bloom->false_positives_per_lookup = 0.0;
+    bloom->stale = false;
+    if (max_keys == 0.0)
+        return;
+
+    /*
+        Lagrange multiplier gives fpr of lvl = min(1, lambda * keys of lvl),
+        memory decreases with lambda, so lambda is found by bisection on ln(lambda)
+    */
+    hi = -log(min_keys);
+    lo = -log(max_keys) - 64.0;
+    if (db_index_fdtree_bloom_bits(keys, index->height, lo) > (double)bloom->budget)
+        for (size_t iter = 0; iter < 100; ++iter)
+        {
+            const double mid = (lo + hi) / 2.0;
+
+            if (db_index_fdtree_bloom_bits(keys, index->height, mid) > (double)bloom->budget)
+                lo = mid;
+            else
+                hi = mid;
+        }
+    else
+        hi = lo;
+
+    for (size_t i = 0; i < index->height; ++i)
+    {
+        if (keys[i] == 0.0)
+            continue;
+
+        bloom->fpr[i] = exp(hi) * keys[i] < 1.0 ? exp(hi) * keys[i] : 1.0;
+        bloom->bits_per_key[i] = -log(bloom->fpr[i]) / ln2_2;
+    }
+
+    /* lookup of existing key (uniform over live entries) stops at lvl with key, misses probe every lvl */
+    below = 1.0;
+    for (size_t i = 0; i < index->height; ++i)
+    {
+        const double found = live > 0.0 ? (double)index->sortedruns[i].num_entries / live : 0.0;
+
+        below -= found;
+        if (below < 0.0)
+            below = 0.0;
+
+        bloom->probes[i] = found + bloom->fpr[i] * (live > 0.0 ? below : 1.0);
+        bloom->false_positives_per_lookup += bloom->fpr[i] * (live > 0.0 ? below : 1.0);
+    }
+}
+
+static double db_index_fdtree_bloom_point_search(DB_index_fdtree *index, size_t entries)
+{
+    FDBloom *bloom = index->bloom;
+    size_t pages = 0;
+
+    if (bloom->stale)
+        db_index_fdtree_bloom_allocate(index);
+
+    for (size_t i = 0; i < index->height; ++i)
+    {
+        const double expected = bloom->probes[i] * (double)entries + bloom->carry[i];
+        const size_t lvl_pages = (size_t)expected;
+
+        /* whole pages are charged, rest is kept for next search */
+        bloom->carry[i] = expected - (double)lvl_pages;
+        index->sortedruns[i].stat.pages_rread += lvl_pages;
+        pages += lvl_pages;
+    }
+
+    bloom->false_positives += bloom->false_positives_per_lookup * (double)entries;
+
+    index->index_stat.point_lookups += entries;
+
+    if (index->io_depth > 1)
+        return ssd_rread_pages_qd(index->ssd, pages, index->io_depth < entries ? index->io_depth : entries);
+
+    return ssd_rread_pages(index->ssd, pages);
+}
+
+static inline uint64_t db_index_fdtree_pool_rand(FDPool *pool)
+{
+    uint64_t z = (pool->rand += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+static void db_index_fdtree_pool_sync(DB_index_fdtree *index)
+{
+    FDPool *pool = index->pool;
+    size_t free_pages = pool->pool->capacity;
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+    {
+        const size_t generation = index->sortedruns[i].stat.merges + (i + 1 < index->num_lvls ? index->sortedruns[i + 1].stat.merges : 0);
+
+        if (generation != pool->generation[i])
+        {
+            (void)db_bufpool_invalidate(pool->pool, i);
+            pool->generation[i] = generation;
+        }
+    }
+
+    if (pool->pool->policy != DB_BUFPOOL_PINNED)
+        return;
+
+    /* upper lvls are read by every search, so they are pinned first */
+    for (size_t i = 0; i < index->num_lvls; ++i)
+    {
+        const FDLvl *fdlvl = &index->sortedruns[i];
+        const size_t pages = db_index_fdtree_pages_for_entries(index, fdlvl->num_entries + fdlvl->num_entries_to_delete);
+
+        if (i < index->height && pages <= free_pages)
+        {
+            db_bufpool_pin(pool->pool, i, pages > 0 ? pages : 1);
+            free_pages -= pages;
+        }
+        else
+        {
+            db_bufpool_pin(pool->pool, i, 0);
+            free_pages = 0;
+        }
+    }
+}
+
+static bool db_index_fdtree_pool_read(DB_index_fdtree *index, size_t lvl)
+{
+    FDLvl *fdlvl = &index->sortedruns[lvl];
+    size_t pages = db_index_fdtree_pages_for_entries(index, fdlvl->num_entries + fdlvl->num_entries_to_delete);
+
+    if (pages == 0)
+        pages = 1;
+
+    if (db_bufpool_access(index->pool->pool, lvl, db_index_fdtree_pool_rand(index->pool) % pages))
+    {
+        ++fdlvl->stat.pages_hit;
+        return false;
+    }
+
+    ++fdlvl->stat.pages_rread;
+    return true;
+}
+
+static double db_index_fdtree_pool_point_search(DB_index_fdtree *index, size_t entries)
+{
+    FDBloom *bloom = index->bloom;
+    size_t pages = 0;
+
+    db_index_fdtree_pool_sync(index);
+    if (bloom != NULL && bloom->stale)
+        db_index_fdtree_bloom_allocate(index);
+
+    for (size_t i = 0; i < entries; ++i)
+        for (size_t j = 0; j < index->height; ++j)
+        {
+            /* 2^-53 * 53 bit random number is uniform in [0, 1) */
+            if (bloom != NULL && (double)(db_index_fdtree_pool_rand(index->pool) >> 11) * 0x1.0p-53 >= bloom->probes[j])
+                continue;
+
+            if (db_index_fdtree_pool_read(index, j))
+                ++pages;
+        }
+
+    if (bloom != NULL)
+        bloom->false_positives += bloom->false_positives_per_lookup * (double)entries;
 
-/*
-    Merge HeadTree with Lvl0
-    IF LVl0 will be full, then we will merge lvl0 with lvl1 and so on
+    index->index_stat.point_lookups += entries;
 
-    PARAMS
-    @IN index - index
+    if (index->io_depth > 1)
+        return ssd_rread_pages_qd(index->ssd, pages, index->io_depth < entries ? index->io_depth : entries);
 
-    RETURN
-    Time spent for merging
-*/
-static double db_index_fdtree_merge_headtree(DB_index_fdtree* index);
+    return ssd_rread_pages(index->ssd, pages);
+}
 
-static inline size_t db_index_fdtree_entries_per_page(DB_index_fdtree *index)
+DB_index_fdtree *db_index_fdtree_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t runs_ratio)
 {
-    return db_utils_entries_per_page(index->ssd->page_size, index->entry_size);
+    DB_index_fdtree *index;
+
+    index = (DB_index_fdtree *)calloc(1, sizeof(DB_index_fdtree));
+    if (index == NULL)
+        return NULL;
+
+    index->ssd = ssd;
+    index->stat = stat;
+    index->key_size = key_size;
+    index->entry_size = entry_size;
+    index->io_depth = 1;
+    index->height = 1;
+    index->headtree.pages = 1;
+
+    index->runs_ratios = (size_t *)malloc(sizeof(size_t));
+    if (index->runs_ratios == NULL)
+    {
+        free(index);
+        return NULL;
+    }
+
+    index->runs_ratios[0] = runs_ratio;
+    index->num_runs_ratios = 1;
+
+    /* lvl 0 always exists */
+    if (db_index_fdtree_add_lvl(index) != 0)
+    {
+        db_index_fdtree_destroy(index);
+        return NULL;
+    }
+
+    return index;
 }
 
-static inline size_t db_index_fdtree_pages_for_entries(DB_index_fdtree *index, size_t entries)
+void db_index_fdtree_destroy(DB_index_fdtree *index)
 {
-    const size_t pages_for_entries = db_utils_pages_for_entries(index->ssd->page_size, index->entry_size, entries);
-    const size_t pages_for_pointers = db_utils_pages_for_entries(index->ssd->page_size, index->key_size + sizeof(void *), pages_for_entries);
+    if (index == NULL)
+        return;
 
-    return pages_for_entries + pages_for_pointers;
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        db_index_fdtree_free_run(index, i);
+
+    if (index->keys != NULL)
+    {
+        db_keyset_free(&index->keys->head);
+        for (size_t i = 0; i < index->num_lvls; ++i)
+            db_keyset_free(&index->keys->lvls[i]);
+
+        free(index->keys->lvls);
+        free(index->keys);
+    }
+
+    (void)db_index_fdtree_set_bloom(index, 0);
+    (void)db_index_fdtree_set_buffer_pool(index, DB_BUFPOOL_LRU, 0);
+    free(index->merge);
+    free(index->sortedruns);
+    free(index->runs_ratios);
+    free(index);
 }
 
-static double db_index_fdtree_merge_headtree(DB_index_fdtree* index)
+int db_index_fdtree_enable_keys(DB_index_fdtree *index)
 {
-    double time = 0.0;
+    FDKeys *keys;
 
-    FDLvl* fdlvl1 = &index->sortedruns[0];
-    FDHead* headtree = &index->headtree;
+    if (index->keys != NULL)
+        return 0;
 
-    ssize_t entries_in_lvl1_after_merge = (ssize_t)(fdlvl1->num_entries + headtree->num_entries - headtree->num_entries_to_delete);
+    if (index->num_entries > 0 || index->index_stat.entries_written > 0)
+        return 1;
 
-    /* First merge lvl0 with lvl1 to make space for entries from headtree */
-    if (entries_in_lvl1_after_merge + (ssize_t)fdlvl1->num_entries_to_delete >= (ssize_t)fdlvl1->max_entries)
-        time += db_index_fdtree_merge_runs(index, 0, 1);
+    keys = (FDKeys *)calloc(1, sizeof(FDKeys));
+    if (keys == NULL)
+        return 1;
 
-    /* UPDATE entries in fdlvl1 */
-    size_t entries_to_delete_after_merge = (headtree->num_entries_to_delete > fdlvl1->num_entries ? headtree->num_entries_to_delete - fdlvl1->num_entries : 0);
-    entries_in_lvl1_after_merge = (ssize_t)(fdlvl1->num_entries + headtree->num_entries - headtree->num_entries_to_delete);
+    if (db_keyset_init(&keys->head, db_index_fdtree_head_entries(index) * 2) != 0)
+    {
+        free(keys);
+        return 1;
+    }
 
-    /* reading entries from headtree is free */
+    keys->lvls = (DB_keyset *)calloc(index->num_lvls, sizeof(DB_keyset));
+    if (keys->lvls == NULL)
+    {
+        db_keyset_free(&keys->head);
+        free(keys);
+        return 1;
+    }
 
-    /* read entries from lvl0 */
-    time += ssd_sread_pages(index->ssd, db_index_fdtree_pages_for_entries(index, fdlvl1->num_entries + fdlvl1->num_entries_to_delete));
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        if (db_keyset_init(&keys->lvls[i], 0) != 0)
+        {
+            for (size_t j = 0; j < i; ++j)
+                db_keyset_free(&keys->lvls[j]);
 
-    /* write entries to lvl0 */
-    if (entries_in_lvl1_after_merge > 0)
-        time += ssd_swrite_pages(index->ssd, db_index_fdtree_pages_for_entries(index, (size_t)entries_in_lvl1_after_merge + fdlvl1->num_entries_to_delete));
-    else if (entries_to_delete_after_merge > 0)
-        time += ssd_swrite_pages(index->ssd, db_index_fdtree_pages_for_entries(index, entries_to_delete_after_merge));
+            db_keyset_free(&keys->head);
+            free(keys->lvls);
+            free(keys);
+            return 1;
+        }
 
-    headtree->num_entries_to_delete = 0;
-    headtree->num_entries = 0;
+    keys->next_insert_key = (uint64_t)1 << 63;
+    keys->next_delete_key = keys->next_insert_key;
+    index->keys = keys;
 
-    if (entries_in_lvl1_after_merge > 0)
-        fdlvl1->num_entries = (size_t)entries_in_lvl1_after_merge;
-    else
-        fdlvl1->num_entries = 0;
+    return 0;
+}
+
+double db_index_fdtree_insert_key(DB_index_fdtree *index, uint64_t key)
+{
+    double time;
 
-    fdlvl1->num_entries_to_delete += entries_to_delete_after_merge;
+    db_index_fdtree_write_start(index);
+    time = db_index_fdtree_keys_insert(index, key);
 
+    db_stat_update_query_time(index->stat, time);
     return time;
 }
 
-static double db_index_fdtree_merge_runs(DB_index_fdtree* index, size_t lvl1, size_t lvl2)
+double db_index_fdtree_delete_key(DB_index_fdtree *index, uint64_t key)
 {
-    double time = 0.0;
+    double time;
 
-    /* cannot merge, mark as invalid */
-    if (lvl2 >= DBINDEX_FDTREE_MAX_LVL)
-        return (double)9999999999;
+    db_index_fdtree_write_start(index);
+    time = db_index_fdtree_keys_delete(index, key);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
 
-    FDLvl* fdlvl1 = &index->sortedruns[lvl1];
-    FDLvl* fdlvl2 = &index->sortedruns[lvl2];
+double db_index_fdtree_update_key(DB_index_fdtree *index, uint64_t key)
+{
+    double time;
 
-    ssize_t entries_in_lvl2_after_merge = (ssize_t)(fdlvl1->num_entries + fdlvl2->num_entries - fdlvl1->num_entries_to_delete);
+    db_index_fdtree_write_start(index);
+    time = db_index_fdtree_keys_update(index, key);
 
-    /* we need merge lvl2 with lvl2 + 1 to make space for lvl1 entries */
-    if (entries_in_lvl2_after_merge + (ssize_t)fdlvl2->num_entries_to_delete >= (ssize_t)fdlvl2->max_entries)
-        time += db_index_fdtree_merge_runs(index, lvl2, lvl2 + 1);
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
 
-    entries_in_lvl2_after_merge = (ssize_t)(fdlvl1->num_entries + fdlvl2->num_entries - fdlvl1->num_entries_to_delete);
-    size_t entries_to_delete_after_merge = (fdlvl1->num_entries_to_delete > fdlvl2->num_entries ? fdlvl1->num_entries_to_delete - fdlvl2->num_entries : 0);
+int db_index_fdtree_set_head_pages(DB_index_fdtree *index, size_t pages)
+{
+    if (index->num_entries > 0 || index->index_stat.entries_written > 0)
+        return 1;
 
-    /* First time when we reach lvl2, so height++  */
-    if (index->height < (lvl2 + 1) && fdlvl2->num_entries == 0)
-        ++index->height;
+    pages = pages > 0 ? pages : 1;
 
-    /* read lvl1 and lvl2 */
-    time += ssd_sread_pages(index->ssd, db_index_fdtree_pages_for_entries(index, fdlvl1->num_entries + fdlvl1->num_entries_to_delete));
-    time += ssd_sread_pages(index->ssd, db_index_fdtree_pages_for_entries(index, fdlvl2->num_entries + fdlvl2->num_entries_to_delete));
+    /* HEAD takes pages from buffer pool */
+    if (index->pool != NULL)
+    {
+        const size_t budget = index->pool->pool->capacity + index->pool->head_pages;
 
-    /* write down merged lvl1 and lvl2 */
-    if (entries_in_lvl2_after_merge > 0)
-        time += ssd_swrite_pages(index->ssd, db_index_fdtree_pages_for_entries(index, (size_t)entries_in_lvl2_after_merge + fdlvl2->num_entries_to_delete));
-    else if (entries_to_delete_after_merge > 0)
-         time += ssd_swrite_pages(index->ssd, db_index_fdtree_pages_for_entries(index, entries_to_delete_after_merge));
+        index->pool->pool->capacity = budget > pages ? budget - pages : 0;
+        index->pool->head_pages = pages;
+    }
 
-    // write fences into lvl1
-    time += ssd_swrite_pages(index->ssd, 1);
+    db_index_fdtree_set_capacities(index, pages);
 
-    if (entries_in_lvl2_after_merge > 0)
-        fdlvl2->num_entries = (size_t)entries_in_lvl2_after_merge;
-    else
-        fdlvl2->num_entries = 0;
+    return 0;
+}
 
-    fdlvl2->num_entries_to_delete += entries_to_delete_after_merge;
-    fdlvl1->num_entries = 0;
-    fdlvl1->num_entries_to_delete = 0;
+int db_index_fdtree_set_runs_ratios(DB_index_fdtree *index, const size_t *ratios, size_t num)
+{
+    size_t *runs_ratios;
 
-    return time;
+    if (index->num_entries > 0 || index->index_stat.entries_written > 0 || num == 0)
+        return 1;
+
+    for (size_t i = 0; i < num; ++i)
+        if (ratios[i] < 2)
+            return 1;
+
+    runs_ratios = (size_t *)malloc(sizeof(size_t) * num);
+    if (runs_ratios == NULL)
+        return 1;
+
+    (void)memcpy(runs_ratios, ratios, sizeof(size_t) * num);
+    free(index->runs_ratios);
+    index->runs_ratios = runs_ratios;
+    index->num_runs_ratios = num;
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        index->sortedruns[i].runs_ratio = db_index_fdtree_lvl_runs_ratio(index, i);
+
+    db_index_fdtree_set_capacities(index, index->headtree.pages);
+
+    return 0;
 }
 
-DB_index_fdtree *db_index_fdtree_create(SSD *ssd, size_t key_size, size_t entry_size, size_t runs_ratio)
+void db_index_fdtree_set_relevel(DB_index_fdtree *index, size_t max_ratio)
 {
-    DB_index_fdtree *index;
+    index->max_runs_ratio = max_ratio;
+}
 
-    index = (DB_index_fdtree *)calloc(1, sizeof(DB_index_fdtree));
-    if (index == NULL)
-        return NULL;
+int db_index_fdtree_set_bloom(DB_index_fdtree *index, size_t bytes)
+{
+    FDBloom *bloom;
 
-    index->ssd = ssd;
-    index->key_size = key_size;
-    index->entry_size = entry_size;
-    index->runs_ratio = runs_ratio;
-    index->height = 1;
+    if (bytes == 0)
+    {
+        if (index->bloom != NULL)
+        {
+            free(index->bloom->keys);
+            free(index->bloom->bits_per_key);
+            free(index->bloom->fpr);
+            free(index->bloom->probes);
+            free(index->bloom->carry);
+            free(index->bloom);
+            index->bloom = NULL;
+        }
+
+        return 0;
+    }
+
+    if (index->bloom == NULL)
+    {
+        bloom = (FDBloom *)calloc(1, sizeof(FDBloom));
+        if (bloom == NULL)
+            return 1;
+
+        index->bloom = bloom;
+        bloom->keys = (double *)calloc(index->num_lvls, sizeof(double));
+        bloom->bits_per_key = (double *)calloc(index->num_lvls, sizeof(double));
+        bloom->fpr = (double *)calloc(index->num_lvls, sizeof(double));
+        bloom->probes = (double *)calloc(index->num_lvls, sizeof(double));
+        bloom->carry = (double *)calloc(index->num_lvls, sizeof(double));
+        if (bloom->keys == NULL || bloom->bits_per_key == NULL || bloom->fpr == NULL || bloom->probes == NULL || bloom->carry == NULL)
+        {
+            (void)db_index_fdtree_set_bloom(index, 0);
+            return 1;
+        }
+    }
 
-    index->headtree.max_entries = db_index_fdtree_entries_per_page(index);
-    index->sortedruns[0].max_entries = index->headtree.max_entries * index->runs_ratio;
+    index->bloom->budget = bytes * 8;
+    index->bloom->stale = true;
 
-    for (size_t i = 1; i < DBINDEX_FDTREE_MAX_LVL; ++i)
-        index->sortedruns[i].max_entries = index->sortedruns[i - 1].max_entries * index->runs_ratio;
+    return 0;
+}
 
-    return index;
+int db_index_fdtree_set_buffer_pool(DB_index_fdtree *index, DB_bufpool_policy policy, size_t bytes)
+{
+    FDPool *pool;
+    size_t pages;
+
+    if (index->pool != NULL)
+    {
+        db_bufpool_destroy(index->pool->pool);
+        free(index->pool->generation);
+        free(index->pool);
+        index->pool = NULL;
+    }
+
+    if (bytes == 0)
+        return 0;
+
+    pool = (FDPool *)calloc(1, sizeof(FDPool));
+    if (pool == NULL)
+        return 1;
+
+    pool->head_pages = index->headtree.pages;
+    pages = bytes / index->ssd->page_size;
+    pages = pages > pool->head_pages ? pages - pool->head_pages : 0;
+
+    pool->pool = db_bufpool_create(policy, pages, index->num_lvls);
+    pool->generation = (size_t *)malloc(sizeof(size_t) * index->num_lvls);
+    if (pool->pool == NULL || pool->generation == NULL)
+    {
+        db_bufpool_destroy(pool->pool);
+        free(pool->generation);
+        free(pool);
+        return 1;
+    }
+
+    /* lvls written before pool was created are not in pool */
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        pool->generation[i] = index->sortedruns[i].stat.merges + (i + 1 < index->num_lvls ? index->sortedruns[i + 1].stat.merges : 0);
+
+    pool->rand = 0x5EED;
+    index->pool = pool;
+
+    return 0;
 }
 
-void db_index_fdtree_destroy(DB_index_fdtree *index)
+int db_index_fdtree_set_merge_budget(DB_index_fdtree *index, size_t pages)
 {
-    if (index == NULL)
-        return;
+    if (pages == 0)
+    {
+        if (index->merge != NULL && (index->merge->pending_pages > 0.0 || index->merge->pending_time > 0.0))
+            return 1;
 
-    free(index);
+        free(index->merge);
+        index->merge = NULL;
+        return 0;
+    }
+
+    if (index->merge == NULL)
+    {
+        index->merge = (FDMerge *)calloc(1, sizeof(FDMerge));
+        if (index->merge == NULL)
+            return 1;
+    }
+
+    index->merge->budget = pages;
+
+    return 0;
+}
+
+void db_index_fdtree_set_io_depth(DB_index_fdtree *index, size_t io_depth)
+{
+    index->io_depth = io_depth > 0 ? io_depth : 1;
 }
 
 double db_index_fdtree_insert(DB_index_fdtree *index, size_t entries)
 {
     double time = 0.0;
+    double merge_time;
     FDHead* headtree = &index->headtree;
+    const size_t head_entries = db_index_fdtree_head_entries(index);
+    const size_t entries_to_merge = db_index_fdtree_entries_to_head_merge(index);
 
-    for (size_t i = 0; i < entries; ++i)
+    db_index_fdtree_write_start(index);
+    if (index->keys != NULL)
     {
-        ++index->num_entries;
+        for (size_t i = 0; i < entries; ++i)
+            time += db_index_fdtree_keys_insert(index, index->keys->next_insert_key++);
 
-        /* insert into HEAD is free (head tree is in RAM) */
-        ++headtree->num_entries;
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
 
-        /* merge with LVL0 */
-        if (headtree->num_entries + headtree->num_entries_to_delete >= headtree->max_entries)
-            time += db_index_fdtree_merge_headtree(index);
+    index->num_entries += entries;
+    index->index_stat.entries_written += entries;
+
+    /* insert into HEAD costs only CPU (head tree is in RAM) */
+    time += db_index_fdtree_head_put(index, entries);
+    if (index->merge != NULL)
+    {
+        time += db_index_fdtree_merge_put(index, entries, false);
+
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
+
+    if (entries < entries_to_merge)
+    {
+        headtree->num_entries += entries;
+
+        db_stat_update_query_time(index->stat, time);
+        return time;
     }
 
-    db_stat_update_query_time(time);
+    /* merge with LVL0 */
+    headtree->num_entries += entries_to_merge;
+    time += db_index_fdtree_merge_headtree(index);
+    entries -= entries_to_merge;
+
+    /* every next merge flushes full HEAD of new entries */
+    merge_time = db_index_fdtree_merge_runs(index, 0, head_entries, 0, entries / head_entries);
+    index->last_merge_time += merge_time;
+    time += merge_time;
+    headtree->num_entries = entries % head_entries;
+
+    db_stat_update_query_time(index->stat, time);
     return time;
 }
 
 double db_index_fdtree_bulkload(DB_index_fdtree *index, size_t entries)
 {
-    /* Bulkload is the same as insert */
-    return db_index_fdtree_insert(index, entries);
+    double time = 0.0;
+    size_t total;
+    size_t lvl;
+    size_t pages;
+    size_t src_pages = 0;
+    size_t src_runs = 0;
+    FDLvl_stat *lvl_stat;
+
+    if (entries == 0)
+    {
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
+
+    /* bulkload rewrites lvls, merge in progress has to end */
+    time += db_index_fdtree_merge_drain(index);
+
+    /* the first lvl which can hold new entries with HEAD and all lvls above it (like file engine) */
+    total = entries + index->headtree.num_entries + index->headtree.num_entries_to_delete;
+    for (lvl = 0; ; ++lvl)
+    {
+        /* cannot bulkload, mark as invalid */
+        if (lvl == index->num_lvls && db_index_fdtree_add_lvl(index) != 0)
+        {
+            time = DBINDEX_FDTREE_INVALID_TIME;
+            db_stat_update_query_time(index->stat, time);
+            return time;
+        }
+
+        total += index->sortedruns[lvl].num_entries + index->sortedruns[lvl].num_entries_to_delete;
+        if (total <= index->sortedruns[lvl].max_entries)
+            break;
+    }
+
+    lvl_stat = &index->sortedruns[lvl].stat;
+    ++lvl_stat->merges;
+
+    /* input is presorted and comes from RAM like HEAD, only existing runs are read */
+    for (size_t i = 0; i <= lvl; ++i)
+    {
+        const FDLvl *fdlvl = &index->sortedruns[i];
+
+        if (fdlvl->num_entries + fdlvl->num_entries_to_delete == 0)
+            continue;
+
+        src_pages += db_index_fdtree_pages_for_entries(index, fdlvl->num_entries + fdlvl->num_entries_to_delete);
+        ++src_runs;
+    }
+
+    lvl_stat->pages_sread += src_pages;
+    if (index->io_depth > 1 && src_runs > 1)
+        time += ssd_sread_pages_qd(index->ssd, src_pages, src_runs);
+    else
+        time += ssd_sread_pages(index->ssd, src_pages);
+
+    index->num_entries += entries;
+    index->index_stat.entries_written += entries;
+    db_index_fdtree_bulkload_counts(index, lvl, entries);
+
+    /* one sequential pass writes entries with pointers of lvl */
+    pages = db_index_fdtree_pages_for_entries(index, index->sortedruns[lvl].num_entries + index->sortedruns[lvl].num_entries_to_delete);
+    lvl_stat->pages_swrite += pages;
+    lvl_stat->entries_moved += index->sortedruns[lvl].num_entries;
+    lvl_stat->tombstones_moved += index->sortedruns[lvl].num_entries_to_delete;
+    time += db_index_fdtree_write_run(index, lvl, pages);
+
+    /* lvls above are empty, fences of lvl are written into lvl - 1 */
+    for (size_t i = 0; i + 1 < lvl; ++i)
+        db_index_fdtree_free_run(index, i);
+
+    if (lvl > 0)
+    {
+        db_index_fdtree_free_run(index, lvl - 1);
+
+        ++lvl_stat->fence_pages;
+        time += db_index_fdtree_write_run(index, lvl - 1, 1);
+    }
+
+    if (index->height < lvl + 1)
+        index->height = lvl + 1;
+
+    time += db_index_fdtree_bloom_rebuild(index, lvl);
+
+    /* every rewritten lvl is dropped from pool, not only lvl and lvl - 1 */
+    if (index->pool != NULL)
+        for (size_t i = 0; i <= lvl; ++i)
+            (void)db_bufpool_invalidate(index->pool->pool, i);
+
+    lvl_stat->time += time;
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
 }
 
 double db_index_fdtree_point_search(DB_index_fdtree *index, size_t entries)
 {
     double time = 0.0;
 
-    time += ssd_rread_pages(index->ssd, index->height) * (double)entries;
+    if (index->pool != NULL || index->bloom != NULL)
+    {
+        time = index->pool != NULL ? db_index_fdtree_pool_point_search(index, entries) : db_index_fdtree_bloom_point_search(index, entries);
+
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
+
+    /* one page from every lvl */
+    for (size_t i = 0; i < index->height; ++i)
+        index->sortedruns[i].stat.pages_rread += entries;
 
-    db_stat_update_query_time(time);
+    index->index_stat.point_lookups += entries;
+
+    /* searches are independent, but pages of one search are read one by one */
+    if (index->io_depth > 1)
+        time += ssd_rread_pages_qd(index->ssd, index->height * entries, index->io_depth < entries ? index->io_depth : entries);
+    else
+        time += ssd_rread_pages(index->ssd, index->height) * (double)entries;
+
+    db_stat_update_query_time(index->stat, time);
     return time;
 }
 
 double db_index_fdtree_range_search(DB_index_fdtree *index, size_t entries)
+{
+    return db_index_fdtree_range_search_repeat(index, entries, 1);
+}
+
+double db_index_fdtree_range_search_repeat(DB_index_fdtree *index, size_t entries, size_t queries)
 {
     double time = 0.0;
+    const size_t pages = db_index_fdtree_pages_for_entries(index, entries);
+    const size_t in_flight = index->io_depth < queries ? index->io_depth : queries;
+
+    if (index->pool != NULL)
+    {
+        size_t misses = 0;
+
+        /* start points go through pool, entries are streamed from SSD */
+        db_index_fdtree_pool_sync(index);
+        for (size_t i = 0; i < queries; ++i)
+            for (size_t j = 0; j < index->height; ++j)
+                if (db_index_fdtree_pool_read(index, j))
+                    ++misses;
+
+        if (in_flight > 1)
+        {
+            time += ssd_rread_pages_qd(index->ssd, misses, in_flight);
+            time += ssd_sread_pages_qd(index->ssd, pages * queries, in_flight);
+        }
+        else
+        {
+            time += ssd_rread_pages(index->ssd, misses);
+            time += ssd_sread_pages(index->ssd, pages) * (double)queries;
+        }
+    }
+    else if (in_flight > 1)
+    {
+        /* searches run in parallel: find start points, then read all entries */
+        time += ssd_rread_pages_qd(index->ssd, index->height * queries, in_flight);
+        time += ssd_sread_pages_qd(index->ssd, pages * queries, in_flight);
+    }
+    else
+    {
+        /* find start point */
+        time += ssd_rread_pages(index->ssd, index->height);
+
+        /* read all entries */
+        time += ssd_sread_pages(index->ssd, pages);
+
+        /* index is not changed, so each search costs the same */
+        time *= (double)queries;
+    }
 
-    /* find start point */
-    time += ssd_rread_pages(index->ssd, index->height);
+    if (index->pool == NULL)
+        for (size_t i = 0; i < index->height; ++i)
+            index->sortedruns[i].stat.pages_rread += queries;
 
-    /* read all entries */
-    time += ssd_sread_pages(index->ssd, db_index_fdtree_pages_for_entries(index, entries));
+    index->index_stat.range_searches += queries;
+    index->index_stat.range_pages_sread += pages * queries;
 
-    db_stat_update_query_time(time);
+    db_stat_update_query_time(index->stat, time);
     return time;
 }
 
 double db_index_fdtree_delete(DB_index_fdtree *index, size_t entries)
 {
     double time = 0.0;
+    double merge_time;
     FDHead* headtree = &index->headtree;
+    const size_t head_entries = db_index_fdtree_head_entries(index);
+    const size_t entries_to_merge = db_index_fdtree_entries_to_head_merge(index);
 
-    for (size_t i = 0; i < entries; ++i)
+    db_index_fdtree_write_start(index);
+    if (index->keys != NULL)
     {
-        --index->num_entries;
+        FDKeys *keys = index->keys;
 
-        /* insert into HEAD is free (head tree is in RAM) */
-        ++headtree->num_entries_to_delete;
+        /* the oldest key inserted without key */
+        for (size_t i = 0; i < entries; ++i)
+            time += db_index_fdtree_keys_delete(index, keys->next_delete_key < keys->next_insert_key ? keys->next_delete_key++ : keys->next_insert_key);
 
-        /* merge with LVL0 */
-        if (headtree->num_entries + headtree->num_entries_to_delete >= headtree->max_entries)
-            time += db_index_fdtree_merge_headtree(index);
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
+
+    index->num_entries -= entries;
+    index->index_stat.entries_written += entries;
+
+    /* insert into HEAD costs only CPU (head tree is in RAM) */
+    time += db_index_fdtree_head_put(index, entries);
+    if (index->merge != NULL)
+    {
+        time += db_index_fdtree_merge_put(index, entries, true);
+
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
+
+    if (entries < entries_to_merge)
+    {
+        headtree->num_entries_to_delete += entries;
+
+        db_stat_update_query_time(index->stat, time);
+        return time;
     }
 
-    db_stat_update_query_time(time);
+    /* merge with LVL0 */
+    headtree->num_entries_to_delete += entries_to_merge;
+    time += db_index_fdtree_merge_headtree(index);
+    entries -= entries_to_merge;
+
+    /* every next merge flushes full HEAD of entries to delete */
+    merge_time = db_index_fdtree_merge_runs(index, 0, 0, head_entries, entries / head_entries);
+    index->last_merge_time += merge_time;
+    time += merge_time;
+    headtree->num_entries_to_delete = entries % head_entries;
+
+    db_stat_update_query_time(index->stat, time);
     return time;
 }
 
 double db_index_fdtree_update(DB_index_fdtree *index, size_t entries)
 {
     double time = 0.0;
+    FDHead *headtree = &index->headtree;
+
+    db_index_fdtree_write_start(index);
+    if (index->keys != NULL)
+    {
+        FDKeys *keys = index->keys;
+
+        /* round robin over live keys inserted without key */
+        for (size_t i = 0; i < entries; ++i)
+        {
+            if (keys->next_update_key < keys->next_delete_key || keys->next_update_key >= keys->next_insert_key)
+                keys->next_update_key = keys->next_delete_key;
+
+            if (keys->next_update_key < keys->next_insert_key)
+                time += db_index_fdtree_keys_update(index, keys->next_update_key++);
+            else
+                time += db_index_fdtree_keys_update(index, keys->next_insert_key);
+        }
+
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
+
+    index->index_stat.entries_written += entries;
+    index->index_stat.updates += entries;
+
+    /* every update finds its place in HEAD */
+    time += db_index_fdtree_head_put(index, entries);
 
     for (size_t i = 0; i < entries; ++i)
     {
-        time += db_index_fdtree_delete(index, 1);
-        time += db_index_fdtree_insert(index, 1);
+        time += db_index_fdtree_merge_step(index, 1);
+
+        /* key is in HEAD with probability of buffered live entries */
+        if (index->num_entries > 0)
+            headtree->absorbed_carry += (double)headtree->num_entries / (double)index->num_entries;
+
+        if (headtree->absorbed_carry >= 1.0)
+        {
+            headtree->absorbed_carry -= 1.0;
+            ++index->index_stat.updates_absorbed;
+            continue;
+        }
+
+        ++headtree->num_entries;
+        ++headtree->num_updates;
+        if (db_index_fdtree_entries_to_head_merge(index) == 0)
+            time += db_index_fdtree_merge_headtree(index);
     }
 
+    db_stat_update_query_time(index->stat, time);
     return time;
-}
\ No newline at end of file
+}
+
+double db_index_fdtree_write_amplification(const DB_index_fdtree *index)
+{
+    size_t pages = 0;
+
+    if (index->index_stat.entries_written == 0)
+        return 0.0;
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        pages += index->sortedruns[i].stat.pages_swrite + index->sortedruns[i].stat.pages_rwrite + index->sortedruns[i].stat.fence_pages;
+
+    return (double)(pages * index->ssd->page_size) / (double)(index->index_stat.entries_written * index->entry_size);
+}
+
+double db_index_fdtree_read_amplification(const DB_index_fdtree *index)
+{
+    size_t pages = 0;
+    const size_t searches = index->index_stat.point_lookups + index->index_stat.range_searches;
+
+    if (searches == 0)
+        return 0.0;
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        pages += index->sortedruns[i].stat.pages_rread;
+
+    return (double)pages / (double)searches;
+}
+
+double db_index_fdtree_space_amplification(const DB_index_fdtree *index)
+{
+    size_t pages = 0;
+
+    if (index->num_entries == 0)
+        return 0.0;
+
+    /* HeadTree is in RAM */
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        pages += db_index_fdtree_pages_for_entries(index, index->sortedruns[i].num_entries + index->sortedruns[i].num_entries_to_delete);
+
+    return (double)(pages * index->ssd->page_size) / (double)(index->num_entries * index->entry_size);
+}
+
+void db_index_fdtree_stat_print(const DB_index_fdtree *index)
+{
+    printf("HEAD\n");
+    printf("\tPAGES                  = %zu\n", index->headtree.pages);
+    printf("\tMAX           ENTRIES  = %zu\n", index->headtree.max_entries);
+    printf("\tSORT          TIME     = %lfs\n", index->headtree.time);
+
+    for (size_t i = 0; i < index->height; ++i)
+    {
+        const FDLvl_stat *lvl_stat = &index->sortedruns[i].stat;
+
+        printf("LVL %zu\n", i);
+        printf("\tRUNS          RATIO    = %zu\n", index->sortedruns[i].runs_ratio);
+        printf("\tMAX           ENTRIES  = %zu\n", index->sortedruns[i].max_entries);
+        printf("\tMERGES                 = %zu\n", lvl_stat->merges);
+        printf("\tSEQ   READ    PAGES    = %zu\n", lvl_stat->pages_sread);
+        printf("\tRAND  READ    PAGES    = %zu\n", lvl_stat->pages_rread);
+        printf("\tSEQ   WRITE   PAGES    = %zu\n", lvl_stat->pages_swrite);
+        printf("\tRAND  WRITE   PAGES    = %zu\n", lvl_stat->pages_rwrite);
+        printf("\tFENCE WRITE   PAGES    = %zu\n", lvl_stat->fence_pages);
+        printf("\tENTRIES       MOVED    = %zu\n", lvl_stat->entries_moved);
+        printf("\tTOMBSTONES    MOVED    = %zu\n", lvl_stat->tombstones_moved);
+        printf("\tMERGE         TIME     = %lfs\n", lvl_stat->time);
+    }
+
+    if (index->max_runs_ratio > 0)
+    {
+        printf("RELEVELING\n");
+        printf("\tMAX           RATIO    = %zu\n", index->max_runs_ratio);
+        printf("\tRATIO         CHANGES  = %zu\n", index->relevels);
+    }
+
+    if (index->bloom != NULL)
+    {
+        size_t keys = 0;
+
+        if (index->bloom->stale)
+            db_index_fdtree_bloom_allocate(index);
+
+        printf("BLOOM\n");
+        printf("\tBUDGET                 = %zuB\n", index->bloom->budget / 8);
+        for (size_t i = 0; i < index->height; ++i)
+        {
+            printf("\tLVL %zu BITS PER KEY     = %lf\n", i, index->bloom->bits_per_key[i]);
+            printf("\tLVL %zu FPR              = %lf\n", i, index->bloom->fpr[i]);
+            keys += index->sortedruns[i].stat.bloom_keys;
+        }
+
+        printf("\tFALSE POSITIVE PAGES   = %lf\n", index->bloom->false_positives);
+        printf("\tKEYS          HASHED   = %zu\n", keys);
+        printf("\tREBUILD       TIME     = %lfs\n", (double)keys * DBINDEX_FDTREE_BLOOM_KEY_TIME);
+    }
+
+    if (index->keys != NULL)
+    {
+        printf("KEYS\n");
+        printf("\tABSORBED  IN HEAD       = %zu\n", index->keys->absorbed_in_head);
+        printf("\tCANCELLED IN HEAD       = %zu\n", index->keys->cancelled_in_head);
+        printf("\tCANCELLED IN MERGE      = %zu\n", index->keys->cancelled_in_merge);
+        printf("\tVERSIONS  DROPPED       = %zu\n", index->keys->versions_dropped);
+    }
+
+    if (index->pool != NULL)
+    {
+        const DB_bufpool *pool = index->pool->pool;
+        const size_t accesses = pool->hits + pool->misses;
+
+        printf("BUFFER POOL %s\n", db_bufpool_policy_name(pool->policy));
+        printf("\tCAPACITY      PAGES    = %zu\n", pool->capacity);
+        printf("\tHEAD          PAGES    = %zu\n", index->pool->head_pages);
+        printf("\tHITS                   = %zu\n", pool->hits);
+        printf("\tMISSES                 = %zu\n", pool->misses);
+        printf("\tHIT           RATIO    = %lf\n", accesses > 0 ? (double)pool->hits / (double)accesses : 0.0);
+        printf("\tEVICTED       PAGES    = %zu\n", pool->evicted);
+        printf("\tINVALIDATED   PAGES    = %zu\n", pool->invalidated);
+        for (size_t i = 0; i < index->height; ++i)
+        {
+            const FDLvl_stat *lvl_stat = &index->sortedruns[i].stat;
+            const size_t lvl_accesses = lvl_stat->pages_hit + lvl_stat->pages_rread;
+
+            printf("\tLVL %zu RESIDENT PAGES   = %zu\n", i, db_bufpool_resident(pool, i));
+            printf("\tLVL %zu HIT RATIO        = %lf\n", i, lvl_accesses > 0 ? (double)lvl_stat->pages_hit / (double)lvl_accesses : 0.0);
+        }
+    }
+
+    if (index->index_stat.updates > 0)
+    {
+        printf("UPDATES\n");
+        printf("\tUPDATES                = %zu\n", index->index_stat.updates);
+        printf("\tABSORBED      IN HEAD  = %zu\n", index->index_stat.updates_absorbed);
+        printf("\tFLUSHED       TO DISK  = %zu\n", index->index_stat.updates_flushed);
+        printf("\tBUFFERED      IN HEAD  = %zu\n", index->headtree.num_updates);
+    }
+
+    if (index->merge != NULL)
+    {
+        printf("INCREMENTAL MERGE\n");
+        printf("\tBUDGET        PAGES    = %zu per write\n", index->merge->budget);
+        printf("\tDEFERRED      MERGES   = %zu\n", index->merge->deferred);
+        printf("\tSTEPS                  = %zu\n", index->merge->steps);
+        printf("\tSTALLS                 = %zu\n", index->merge->stalls);
+        printf("\tSTALLED       PAGES    = %.0lf\n", index->merge->stalled_pages);
+        printf("\tSTALL         TIME     = %lfs\n", index->merge->stall_time);
+        printf("\tPENDING       PAGES    = %.0lf\n", index->merge->pending_pages);
+    }
+
+    printf("AMPLIFICATION\n");
+    printf("\tWRITE                  = %lf\n", db_index_fdtree_write_amplification(index));
+    printf("\tREAD                   = %lf\n", db_index_fdtree_read_amplification(index));
+    printf("\tSPACE                  = %lf\n", db_index_fdtree_space_amplification(index));
+}
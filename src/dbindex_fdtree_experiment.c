@@ -1,85 +1,904 @@
 #include <dbindex_fdtree.h>
+#include <dbindex.h>
+#include <dbindex_fdtree_file.h>
 #include <experiments.h>
 #include <dbstat.h>
+#include <dbsim.h>
+#include <dbtrace.h>
+#include <dbworkload.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 
 #define LOG2(n) floor(((log((double)n)) / (log(2.0))))
 
-void db_index_fdtree_experiment_workload(size_t queries)
+/* pages of merge done by one write in check of simulation with incremental merge */
+#define DB_EXPERIMENT_SIM_CHECK_BUDGET 256
+
+/* One phase of normal workload, used by validation */
+typedef struct DB_experiment_phase
 {
-    DB_index_fdtree *index;
-    SSD *ssd;
+    const char *name;
+    DB_stat_op op;
+    size_t queries;
+    size_t selectivity_div; /* range search reads 1 / selectivity_div of entries */
+} DB_experiment_phase;
+
+/* Keys of engine: i-th inserted entry has key splitmix64(i) */
+typedef struct DB_experiment_keys
+{
+    size_t inserted;
+    uint64_t rand_state;
+} DB_experiment_keys;
+
+/*
+    Get key of i-th entry (splitmix64)
+
+    PARAMS
+    @IN i - number of entry
+
+    RETURN
+    Key
+*/
+static uint64_t db_experiment_key(uint64_t i);
+
+/*
+    Get random number
+
+    PARAMS
+    @IN keys - pointer to keys state
+
+    RETURN
+    Random number
+*/
+static uint64_t db_experiment_rand(DB_experiment_keys *keys);
+
+/*
+    Create index with parameters of profile
+
+    PARAMS
+    @IN profile - pointer to profile
+    @IN ssd - SSD of index
+    @IN stat - statistics context
+
+    RETURN
+    NULL iff failure
+    Pointer to new index
+*/
+static DB_index_fdtree *db_experiment_index_create(const DB_profile *profile, SSD *ssd, DB_stat *stat);
+
+/*
+    Get time of monotonic clock
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    Time in seconds
+*/
+static double db_experiment_now(void);
+
+/*
+    Run phase on model
+
+    PARAMS
+    @IN index - pointer to model
+    @IN phase - pointer to phase
+
+    RETURN
+    Predicted time of phase
+*/
+static double db_experiment_validate_model(DB_index_fdtree *index, const DB_experiment_phase *phase);
+
+/*
+    Run phase on engine
+
+    PARAMS
+    @IN engine - pointer to engine
+    @IN phase - pointer to phase
+    @IN executed - number of queries to execute
+    @IN keys - pointer to keys state
+    @OUT time - measured time of executed queries
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_experiment_validate_engine(DB_index_fdtree_file *engine, const DB_experiment_phase *phase, size_t executed, DB_experiment_keys *keys, double *time);
+
+/*
+    Run simulation (see dbsim.h) with default mix on samsung840 and check that device
+    is used only by merges: every flush of HEAD is one merge and writes wait only for merges
+
+    PARAMS
+    @IN name - name of check
+    @IN preload - entries bulkloaded before simulation
+    @IN queries - number of queries
+    @IN head_only - true iff queries are limited to writes which fit into HEAD (no merge)
+    @IN merge_budget - pages of merge done by one write (0 - merge is done at once)
+
+    RETURN
+    0 iff check has passed
+    Non-zero value iff check has failed
+*/
+static int db_experiment_sim_check(const char *name, size_t preload, size_t queries, bool head_only, size_t merge_budget);
+
+/*
+    Normal workload experiment on created index
+
+    PARAMS
+    @IN index - empty index
+    @IN queries - number of queries in batch (N)
+    @OUT op_time - (can be NULL) time of every operation (array of DB_STAT_OP_NUM)
+
+    RETURN
+    This is a void function
+*/
+static void db_index_experiment_workload_on_index(const DB_index *index, size_t queries, double *op_time);
+
+/*
+    Normal workload experiment on created FDTree
+
+    PARAMS
+    @IN index - empty index
+    @IN queries - number of queries in batch (N)
+
+    RETURN
+    This is a void function
+*/
+static void db_index_fdtree_experiment_workload_on_index(DB_index_fdtree *index, size_t queries);
+
+static void db_index_experiment_workload_on_index(const DB_index *index, size_t queries, double *op_time)
+{
+    DB_stat *stat = index->stat;
     size_t i;
     double _sqrt_n = ceil(sqrt((double)queries));
     size_t sqrt_n = (size_t)_sqrt_n;
     size_t nlogn = (size_t)((double)queries * LOG2(queries));
+    double time[DB_STAT_OP_NUM] = {0.0};
 
-    ssd = ssd_create_samsung840();
-    index = db_index_fdtree_create(ssd, sizeof(long), 140, DBINDEX_FDTREE_RUNS_RATIO);
-    db_stat_reset();
+    db_stat_reset(stat);
 
     /* bukload N / 2 */
-    db_stat_start_query();
-    db_index_fdtree_bulkload(index, queries / 2);
-    db_stat_finish_query();
+    db_stat_start_query(stat, DB_STAT_OP_BULKLOAD);
+    time[DB_STAT_OP_BULKLOAD] += db_index_bulkload(index, queries / 2);
+    db_stat_finish_query(stat);
 
     /* sqrt(N) point search */
-    for (i = 0; i < sqrt_n; ++i)
-    {
-        db_stat_start_query();
-        db_index_fdtree_point_search(index, 1);
-        db_stat_finish_query();
-    }
+    db_stat_start_queries(stat, DB_STAT_OP_POINT_SEARCH, sqrt_n);
+    time[DB_STAT_OP_POINT_SEARCH] += db_index_point_search(index, sqrt_n);
+    db_stat_finish_query(stat);
 
     /* Normal Insert N / 2 */
     for (i = 0; i < queries / 2; ++i)
     {
-        db_stat_start_query();
-        db_index_fdtree_insert(index, 1);
-        db_stat_finish_query();
+        db_stat_start_query(stat, DB_STAT_OP_INSERT);
+        time[DB_STAT_OP_INSERT] += db_index_insert(index, 1);
+        db_stat_finish_query(stat);
     }
 
     /* NlogN range search with 10% selecivity */
-    for (i = 0; i < nlogn; ++i)
-    {
-        db_stat_start_query();
-        db_index_fdtree_range_search(index, (index->num_entries + 9) / 10);
-        db_stat_finish_query();
-    }
+    db_stat_start_queries(stat, DB_STAT_OP_RANGE_SEARCH, nlogn);
+    time[DB_STAT_OP_RANGE_SEARCH] += db_index_range_search_repeat(index, (db_index_num_entries(index) + 9) / 10, nlogn);
+    db_stat_finish_query(stat);
 
     /* sqrt(N) delete */
     for (i = 0; i < sqrt_n; ++i)
     {
-        db_stat_start_query();
-        db_index_fdtree_delete(index, 1);
-        db_stat_finish_query();
+        db_stat_start_query(stat, DB_STAT_OP_DELETE);
+        time[DB_STAT_OP_DELETE] += db_index_delete(index, 1);
+        db_stat_finish_query(stat);
     }
 
     /* sqrt(N) point search */
-    for (i = 0; i < sqrt_n; ++i)
-    {
-        db_stat_start_query();
-        db_index_fdtree_point_search(index, 1);
-        db_stat_finish_query();
-    }
+    db_stat_start_queries(stat, DB_STAT_OP_POINT_SEARCH, sqrt_n);
+    time[DB_STAT_OP_POINT_SEARCH] += db_index_point_search(index, sqrt_n);
+    db_stat_finish_query(stat);
 
     /* sqrt(N) update */
     for (i = 0; i < sqrt_n; ++i)
     {
-        db_stat_start_query();
-        db_index_fdtree_update(index, 1);
-        db_stat_finish_query();
+        db_stat_start_query(stat, DB_STAT_OP_UPDATE);
+        time[DB_STAT_OP_UPDATE] += db_index_update(index, 1);
+        db_stat_finish_query(stat);
     }
 
     /* NlogN range search with 5% selectivity */
-    for (i = 0; i < nlogn; ++i)
+    db_stat_start_queries(stat, DB_STAT_OP_RANGE_SEARCH, nlogn);
+    time[DB_STAT_OP_RANGE_SEARCH] += db_index_range_search_repeat(index, (db_index_num_entries(index) + 19) / 20, nlogn);
+    db_stat_finish_query(stat);
+
+    if (op_time != NULL)
+        for (i = 0; i < DB_STAT_OP_NUM; ++i)
+            op_time[i] = time[i];
+}
+
+static void db_index_fdtree_experiment_workload_on_index(DB_index_fdtree *index, size_t queries)
+{
+    DB_index generic;
+
+    db_index_from_fdtree(&generic, index);
+    db_index_experiment_workload_on_index(&generic, queries, NULL);
+}
+
+static uint64_t db_experiment_key(uint64_t i)
+{
+    uint64_t z = i + 0x9E3779B97F4A7C15ULL;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+static uint64_t db_experiment_rand(DB_experiment_keys *keys)
+{
+    return db_experiment_key(keys->rand_state++ ^ 0xD1B54A32D192ED03ULL);
+}
+
+static DB_index_fdtree *db_experiment_index_create(const DB_profile *profile, SSD *ssd, DB_stat *stat)
+{
+    DB_index_fdtree *index;
+
+    index = db_index_fdtree_create(ssd, stat, profile->key_size, profile->entry_size, profile->runs_ratio);
+    if (index == NULL)
+        return NULL;
+
+    db_index_fdtree_set_io_depth(index, profile->io_depth);
+    db_index_fdtree_set_relevel(index, profile->max_runs_ratio);
+    if ((profile->num_runs_ratios > 0 && db_index_fdtree_set_runs_ratios(index, profile->runs_ratios, profile->num_runs_ratios) != 0) ||
+        db_index_fdtree_set_head_pages(index, profile->head_pages) != 0 ||
+        db_index_fdtree_set_bloom(index, profile->bloom_bytes) != 0 ||
+        db_index_fdtree_set_buffer_pool(index, profile->pool_policy, profile->pool_bytes) != 0 ||
+        db_index_fdtree_set_merge_budget(index, profile->merge_budget) != 0)
+    {
+        db_index_fdtree_destroy(index);
+        return NULL;
+    }
+
+    return index;
+}
+
+static double db_experiment_now(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static double db_experiment_validate_model(DB_index_fdtree *index, const DB_experiment_phase *phase)
+{
+    double time = 0.0;
+    size_t i;
+
+    switch (phase->op)
+    {
+        case DB_STAT_OP_BULKLOAD:
+        {
+            time = db_index_fdtree_bulkload(index, phase->queries);
+            break;
+        }
+        case DB_STAT_OP_INSERT:
+        {
+            for (i = 0; i < phase->queries; ++i)
+                time += db_index_fdtree_insert(index, 1);
+            break;
+        }
+        case DB_STAT_OP_DELETE:
+        {
+            for (i = 0; i < phase->queries; ++i)
+                time += db_index_fdtree_delete(index, 1);
+            break;
+        }
+        case DB_STAT_OP_UPDATE:
+        {
+            for (i = 0; i < phase->queries; ++i)
+                time += db_index_fdtree_update(index, 1);
+            break;
+        }
+        case DB_STAT_OP_POINT_SEARCH:
+        {
+            time = db_index_fdtree_point_search(index, phase->queries);
+            break;
+        }
+        case DB_STAT_OP_RANGE_SEARCH:
+        {
+            time = db_index_fdtree_range_search_repeat(index, (index->num_entries + phase->selectivity_div - 1) / phase->selectivity_div, phase->queries);
+            break;
+        }
+        case DB_STAT_OP_NUM:
+        default:
+            break;
+    }
+
+    return time;
+}
+
+static int db_experiment_validate_engine(DB_index_fdtree_file *engine, const DB_experiment_phase *phase, size_t executed, DB_experiment_keys *keys, double *time)
+{
+    const double start = db_experiment_now();
+    int ret = 0;
+    size_t i;
+
+    switch (phase->op)
+    {
+        case DB_STAT_OP_BULKLOAD:
+        {
+            uint64_t *bulk = (uint64_t *)calloc(executed > 0 ? executed : 1, sizeof(uint64_t));
+
+            if (bulk == NULL)
+                return 1;
+
+            for (i = 0; i < executed; ++i)
+                bulk[i] = db_experiment_key(keys->inserted + i);
+
+            ret = db_index_fdtree_file_bulkload(engine, bulk, executed);
+            keys->inserted += executed;
+            free(bulk);
+            break;
+        }
+        case DB_STAT_OP_INSERT:
+        {
+            for (i = 0; i < executed && ret == 0; ++i)
+                ret = db_index_fdtree_file_insert(engine, db_experiment_key(keys->inserted++));
+            break;
+        }
+        case DB_STAT_OP_DELETE:
+        {
+            for (i = 0; i < executed && ret == 0; ++i)
+                ret = db_index_fdtree_file_delete(engine, db_experiment_key(db_experiment_rand(keys) % keys->inserted));
+            break;
+        }
+        case DB_STAT_OP_UPDATE:
+        {
+            for (i = 0; i < executed && ret == 0; ++i)
+                ret = db_index_fdtree_file_update(engine, db_experiment_key(db_experiment_rand(keys) % keys->inserted));
+            break;
+        }
+        case DB_STAT_OP_POINT_SEARCH:
+        {
+            bool found;
+
+            for (i = 0; i < executed && ret == 0; ++i)
+                ret = db_index_fdtree_file_point_search(engine, db_experiment_key(db_experiment_rand(keys) % keys->inserted), &found);
+            break;
+        }
+        case DB_STAT_OP_RANGE_SEARCH:
+        {
+            /* keys are uniform, so start before last 1 / selectivity_div of key space */
+            const uint64_t max_start = UINT64_MAX - UINT64_MAX / phase->selectivity_div;
+            const size_t entries = (keys->inserted + phase->selectivity_div - 1) / phase->selectivity_div;
+            size_t found;
+
+            for (i = 0; i < executed && ret == 0; ++i)
+                ret = db_index_fdtree_file_range_search(engine, db_experiment_rand(keys) % max_start, entries, &found);
+            break;
+        }
+        case DB_STAT_OP_NUM:
+        default:
+            break;
+    }
+
+    *time = db_experiment_now() - start;
+
+    return ret;
+}
+
+static int db_experiment_sim_check(const char *name, size_t preload, size_t queries, bool head_only, size_t merge_budget)
+{
+    DB_index_fdtree *index;
+    DB_sim_result *result;
+    DB_sim_config config;
+    SSD *ssd;
+    DB_stat *stat;
+    size_t flushes;
+    int ret;
+
+    ssd = ssd_create_samsung840();
+    stat = db_stat_create();
+    index = ssd != NULL && stat != NULL ? db_index_fdtree_create(ssd, stat, DB_PROFILE_KEY_SIZE, DB_PROFILE_ENTRY_SIZE, DBINDEX_FDTREE_RUNS_RATIO) : NULL;
+    if (index == NULL || (merge_budget > 0 && db_index_fdtree_set_merge_budget(index, merge_budget) != 0))
+    {
+        printf("Cannot create index\n");
+        db_index_fdtree_destroy(index);
+        db_stat_destroy(stat);
+        ssd_destroy(ssd);
+        return 1;
+    }
+
+    db_stat_start_query(stat, DB_STAT_OP_BULKLOAD);
+    db_index_fdtree_bulkload(index, preload);
+    db_stat_finish_query(stat);
+
+    if (head_only)
+    {
+        const FDHead *headtree = &index->headtree;
+        const size_t free_entries = headtree->max_entries - (headtree->num_entries + headtree->num_entries_to_delete);
+
+        queries = free_entries > 0 ? free_entries - 1 : 0;
+    }
+
+    /* merges into LVL0 are flushes of HEAD */
+    flushes = index->num_lvls > 0 ? index->sortedruns[0].stat.merges : 0;
+
+    config = db_sim_config_default(ssd, queries, 2000.0);
+    config.preload = 0;
+    result = db_sim_run(index, &config);
+    if (result == NULL)
+    {
+        printf("Cannot run simulation\n");
+        db_index_fdtree_destroy(index);
+        db_stat_destroy(stat);
+        ssd_destroy(ssd);
+        return 1;
+    }
+
+    flushes = (index->num_lvls > 0 ? index->sortedruns[0].stat.merges : 0) - flushes;
+
+    ret = result->merges != flushes || result->stalls > result->merges;
+    if (flushes == 0)
+        ret |= result->background_time != 0.0 ||
+               result->stalls != 0 ||
+               db_hist_max(&result->queueing[DB_STAT_OP_INSERT]) != 0.0 ||
+               db_hist_max(&result->queueing[DB_STAT_OP_DELETE]) != 0.0;
+
+    if (head_only)
+        ret |= flushes != 0;
+
+    printf("SIM CHECK %s\n", name);
+    printf("\tQUERIES                = %zu\n", result->queries);
+    printf("\tHEAD          FLUSHES  = %zu\n", flushes);
+    printf("\tMERGES                 = %zu\n", result->merges);
+    printf("\tSTALLS                 = %zu\n", result->stalls);
+    printf("\tMERGE         TIME     = %lfs\n", result->background_time);
+    printf("\tRESULT                 = %s\n", ret == 0 ? "OK" : "FAILED");
+
+    db_sim_result_destroy(result);
+    db_index_fdtree_destroy(index);
+    db_stat_destroy(stat);
+    ssd_destroy(ssd);
+
+    return ret;
+}
+
+void db_index_fdtree_experiment_workload(size_t queries)
+{
+    DB_profile profile;
+
+    if (db_profile_default(&profile) != 0)
+        return;
+
+    db_index_fdtree_experiment_workload_profile(&profile, queries);
+}
+
+void db_index_fdtree_experiment_workload_profile(const DB_profile *profile, size_t queries)
+{
+    DB_index_fdtree *index;
+    SSD *ssd;
+    DB_stat *stat;
+
+    ssd = db_profile_ssd_create(profile);
+    stat = db_stat_create();
+    index = ssd != NULL && stat != NULL ? db_experiment_index_create(profile, ssd, stat) : NULL;
+    if (index == NULL)
+    {
+        printf("Cannot create index\n");
+        db_stat_destroy(stat);
+        ssd_destroy(ssd);
+        return;
+    }
+
+    db_index_fdtree_experiment_workload_on_index(index, queries);
+
+    db_stat_summary_print(stat);
+    db_index_fdtree_stat_print(index);
+    ssd_wear_print(ssd, (double)stat->total.queries, DB_EXPERIMENT_OPS_PER_SECOND);
+
+    db_index_fdtree_destroy(index);
+    db_stat_destroy(stat);
+    ssd_destroy(ssd);
+}
+
+int db_index_fdtree_experiment_replay(const DB_profile *profile, const char *path)
+{
+    DB_index_fdtree *index;
+    DB_trace_summary summary;
+    SSD *ssd;
+    DB_stat *stat;
+    double ops_per_second;
+    int ret;
+
+    ssd = db_profile_ssd_create(profile);
+    stat = db_stat_create();
+    index = ssd != NULL && stat != NULL ? db_experiment_index_create(profile, ssd, stat) : NULL;
+    if (index == NULL)
+    {
+        printf("Cannot create index\n");
+        db_stat_destroy(stat);
+        ssd_destroy(ssd);
+        return 1;
+    }
+
+    db_stat_reset(stat);
+    ret = db_trace_replay(index, path, &summary);
+    if (ret == 0)
+    {
+        /* lifetime is projected with rate of traffic from trace if it is known */
+        ops_per_second = db_trace_ops_per_second(&summary);
+        if (ops_per_second <= 0.0)
+            ops_per_second = DB_EXPERIMENT_OPS_PER_SECOND;
+
+        db_trace_summary_print(&summary);
+        db_stat_summary_print(stat);
+        db_index_fdtree_stat_print(index);
+        ssd_wear_print(ssd, (double)stat->total.queries, ops_per_second);
+    }
+
+    db_index_fdtree_destroy(index);
+    db_stat_destroy(stat);
+    ssd_destroy(ssd);
+
+    return ret;
+}
+
+int db_index_fdtree_experiment_ycsb(const DB_profile *profile, const DB_workload_config *config, bool key_level)
+{
+    DB_index_fdtree *index;
+    DB_workload *workload;
+    SSD *ssd;
+    DB_stat *stat;
+
+    workload = db_workload_create(config);
+    if (workload == NULL)
+        return 1;
+
+    ssd = db_profile_ssd_create(profile);
+    stat = db_stat_create();
+    index = ssd != NULL && stat != NULL ? db_experiment_index_create(profile, ssd, stat) : NULL;
+    if (index == NULL || (key_level && db_index_fdtree_enable_keys(index) != 0))
+    {
+        printf(index == NULL ? "Cannot create index\n" : "Cannot enable key level mode\n");
+        db_index_fdtree_destroy(index);
+        db_stat_destroy(stat);
+        ssd_destroy(ssd);
+        db_workload_destroy(workload);
+        return 1;
+    }
+
+    db_stat_reset(stat);
+    db_workload_run(workload, index);
+
+    db_workload_summary_print(workload);
+    db_stat_summary_print(stat);
+    db_index_fdtree_stat_print(index);
+    ssd_wear_print(ssd, (double)stat->total.queries, DB_EXPERIMENT_OPS_PER_SECOND);
+
+    db_index_fdtree_destroy(index);
+    db_stat_destroy(stat);
+    ssd_destroy(ssd);
+    db_workload_destroy(workload);
+
+    return 0;
+}
+
+void db_index_fdtree_experiment_workload_ftl(size_t queries, size_t blocks, double over_provisioning, SSD_ftl_gc_policy policy,
+                                             SSD_ftl_wl_policy wl_policy, size_t wl_threshold)
+{
+    DB_index_fdtree *index;
+    SSD *ssd;
+    DB_stat *stat;
+
+    ssd = ssd_create_samsung840();
+    if (ssd_ftl_enable(ssd, blocks, over_provisioning, policy) != 0)
+    {
+        printf("Cannot enable FTL\n");
+        ssd_destroy(ssd);
+        return;
+    }
+
+    ssd_ftl_set_wear_leveling(ssd, wl_policy, wl_threshold);
+
+    stat = db_stat_create();
+    index = stat != NULL ? db_index_fdtree_create(ssd, stat, DB_PROFILE_KEY_SIZE, DB_PROFILE_ENTRY_SIZE, DBINDEX_FDTREE_RUNS_RATIO) : NULL;
+    if (index == NULL)
+    {
+        printf("Cannot create index\n");
+        db_stat_destroy(stat);
+        ssd_destroy(ssd);
+        return;
+    }
+
+    db_index_fdtree_experiment_workload_on_index(index, queries);
+
+    db_stat_summary_print(stat);
+    db_index_fdtree_stat_print(index);
+    ssd_wear_print(ssd, (double)stat->total.queries, DB_EXPERIMENT_OPS_PER_SECOND);
+    ssd_ftl_stat_print(ssd);
+
+    db_index_fdtree_destroy(index);
+    db_stat_destroy(stat);
+    ssd_destroy(ssd);
+}
+
+void db_index_fdtree_experiment_validate(SSD *ssd, const char *path, size_t queries, size_t samples, bool direct, size_t head_pages)
+{
+    const double _sqrt_n = ceil(sqrt((double)queries));
+    const size_t sqrt_n = (size_t)_sqrt_n;
+    const size_t nlogn = (size_t)((double)queries * LOG2(queries));
+    const DB_experiment_phase phases[] =
+    {
+        {"BULKLOAD", DB_STAT_OP_BULKLOAD, queries / 2, 1},
+        {"POINT SEARCH", DB_STAT_OP_POINT_SEARCH, sqrt_n, 1},
+        {"INSERT", DB_STAT_OP_INSERT, queries / 2, 1},
+        {"RANGE SEARCH 10%", DB_STAT_OP_RANGE_SEARCH, nlogn, 10},
+        {"DELETE", DB_STAT_OP_DELETE, sqrt_n, 1},
+        {"POINT SEARCH", DB_STAT_OP_POINT_SEARCH, sqrt_n, 1},
+        {"UPDATE", DB_STAT_OP_UPDATE, sqrt_n, 1},
+        {"RANGE SEARCH 5%", DB_STAT_OP_RANGE_SEARCH, nlogn, 20}
+    };
+
+    DB_experiment_keys keys = {.inserted = 0, .rand_state = 1};
+    DB_index_fdtree *index;
+    DB_index_fdtree_file *engine;
+    DB_stat *stat;
+    double model_total = 0.0;
+    double measured_total = 0.0;
+
+    stat = db_stat_create();
+    index = stat != NULL ? db_index_fdtree_create(ssd, stat, DB_PROFILE_KEY_SIZE, DB_PROFILE_ENTRY_SIZE, DBINDEX_FDTREE_RUNS_RATIO) : NULL;
+    engine = db_index_fdtree_file_create(path, ssd->page_size, DB_PROFILE_KEY_SIZE, DB_PROFILE_ENTRY_SIZE, DBINDEX_FDTREE_RUNS_RATIO, direct);
+
+    if (stat == NULL || index == NULL || engine == NULL ||
+        db_index_fdtree_set_head_pages(index, head_pages) != 0 || db_index_fdtree_file_set_head_pages(engine, head_pages) != 0)
+    {
+        printf("Cannot create index on %s\n", path);
+
+        db_index_fdtree_file_destroy(engine);
+        db_index_fdtree_destroy(index);
+        db_stat_destroy(stat);
+        return;
+    }
+
+    printf("PHASE\tQUERIES\tEXECUTED\tMODEL_TIME\tMEASURED_TIME\tMEASURED/MODEL\n");
+    for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); ++i)
     {
-        db_stat_start_query();
-        db_index_fdtree_range_search(index, (index->num_entries + 19) / 20);
-        db_stat_finish_query();
+        const DB_experiment_phase *phase = &phases[i];
+        const bool search = phase->op == DB_STAT_OP_POINT_SEARCH || phase->op == DB_STAT_OP_RANGE_SEARCH;
+        const size_t executed = search && phase->queries > samples ? samples : phase->queries;
+        double model_time;
+        double measured_time;
+
+        db_stat_start_queries(stat, phase->op, phase->queries);
+        model_time = db_experiment_validate_model(index, phase);
+        db_stat_finish_query(stat);
+
+        if (db_experiment_validate_engine(engine, phase, executed, &keys, &measured_time) != 0)
+        {
+            printf("I/O error in phase %s\n", phase->name);
+            break;
+        }
+
+        /* searches do not change index, so each one costs about the same */
+        if (executed > 0)
+            measured_time *= (double)phase->queries / (double)executed;
+
+        model_total += model_time;
+        measured_total += measured_time;
+
+        printf("%s\t%zu\t%zu\t%lf\t%lf\t%lf\n", phase->name, phase->queries, executed, model_time, measured_time,
+               model_time > 0.0 ? measured_time / model_time : 0.0);
     }
 
-    db_stat_summary_print();
+    printf("TOTAL\t%zu\t-\t%lf\t%lf\t%lf\n", queries, model_total, measured_total, model_total > 0.0 ? measured_total / model_total : 0.0);
+    printf("ENGINE %s%s\n", path, direct ? " (O_DIRECT)" : "");
+    printf("\tREAD          PAGES    = %zu\n", engine->stat.pages_read);
+    printf("\tWRITE         PAGES    = %zu\n", engine->stat.pages_written);
+    printf("\tMERGES                 = %zu\n", engine->stat.merges);
+    printf("\tHEIGHT                 = %zu\n", engine->height);
+
+    db_index_fdtree_file_destroy(engine);
     db_index_fdtree_destroy(index);
+    db_stat_destroy(stat);
+}
+
+void db_index_fdtree_experiment_workload_qd(size_t queries)
+{
+    static SSD *(*const ssds[])(void) = {ssd_create_samsung840, ssd_create_intelDCP4511, ssd_create_toshibaVX500};
+    static const size_t depths[] = {1, 2, 4, 8, 16, 32, 64, 128};
+
+    printf("SSD\tIO_DEPTH\tTOTAL_TIME\tSPEEDUP\n");
+    for (size_t i = 0; i < sizeof(ssds) / sizeof(ssds[0]); ++i)
+    {
+        double qd1_time = 0.0;
+
+        for (size_t j = 0; j < sizeof(depths) / sizeof(depths[0]); ++j)
+        {
+            DB_index_fdtree *index;
+            SSD *ssd;
+            DB_stat *stat;
+
+            ssd = ssds[i]();
+            stat = db_stat_create();
+            index = ssd != NULL && stat != NULL ? db_index_fdtree_create(ssd, stat, DB_PROFILE_KEY_SIZE, DB_PROFILE_ENTRY_SIZE, DBINDEX_FDTREE_RUNS_RATIO) : NULL;
+            if (index == NULL)
+            {
+                printf("Cannot create index\n");
+                db_stat_destroy(stat);
+                ssd_destroy(ssd);
+                return;
+            }
+
+            db_index_fdtree_set_io_depth(index, depths[j]);
+
+            db_index_fdtree_experiment_workload_on_index(index, queries);
+
+            if (depths[j] == 1)
+                qd1_time = stat->total.query_time;
+
+            printf("%s\t%zu\t%lf\t%lf\n", ssd->name, depths[j], stat->total.query_time, qd1_time / stat->total.query_time);
+
+            db_index_fdtree_destroy(index);
+            db_stat_destroy(stat);
+            ssd_destroy(ssd);
+        }
+    }
+}
+
+void db_index_fdtree_experiment_sim(size_t queries, double arrival_rate)
+{
+    static const double rates[] = {1000.0, 5000.0, 10000.0, 20000.0, 40000.0, 60000.0, 80000.0, 100000.0};
+    const size_t num_rates = arrival_rate > 0.0 ? 1 : sizeof(rates) / sizeof(rates[0]);
+
+    if (arrival_rate <= 0.0)
+        printf("RATE\tTHROUGHPUT\tUTILIZATION\tSTALLS\tPOINT_P50\tPOINT_P99\tINSERT_P99\n");
+
+    for (size_t i = 0; i < num_rates; ++i)
+    {
+        DB_index_fdtree *index;
+        DB_sim_result *result;
+        DB_sim_config config;
+        SSD *ssd;
+        DB_stat *stat;
+
+        ssd = ssd_create_samsung840();
+        stat = db_stat_create();
+        index = ssd != NULL && stat != NULL ? db_index_fdtree_create(ssd, stat, DB_PROFILE_KEY_SIZE, DB_PROFILE_ENTRY_SIZE, DBINDEX_FDTREE_RUNS_RATIO) : NULL;
+        if (index == NULL)
+        {
+            printf("Cannot create index\n");
+            db_stat_destroy(stat);
+            ssd_destroy(ssd);
+            return;
+        }
+
+        config = db_sim_config_default(ssd, queries, arrival_rate > 0.0 ? arrival_rate : rates[i]);
+        result = db_sim_run(index, &config);
+
+        if (result == NULL)
+            printf("Cannot run simulation\n");
+        else if (arrival_rate > 0.0)
+            db_sim_result_print(result);
+        else
+            printf("%lf\t%lf\t%lf\t%zu\t%lf\t%lf\t%lf\n",
+                   config.arrival_rate,
+                   db_sim_result_throughput(result),
+                   (result->foreground_time + result->background_time) / result->clock,
+                   result->stalls,
+                   db_hist_percentile(&result->response[DB_STAT_OP_POINT_SEARCH], 50.0),
+                   db_hist_percentile(&result->response[DB_STAT_OP_POINT_SEARCH], 99.0),
+                   db_hist_percentile(&result->response[DB_STAT_OP_INSERT], 99.0));
+
+        db_sim_result_destroy(result);
+        db_index_fdtree_destroy(index);
+        db_stat_destroy(stat);
+        ssd_destroy(ssd);
+    }
+}
+
+int db_index_fdtree_experiment_sim_check(size_t queries)
+{
+    int ret = 0;
+
+    ret |= db_experiment_sim_check("NO MERGES", queries, 0, true, 0);
+    ret |= db_experiment_sim_check("MERGES", queries, queries, false, 0);
+    ret |= db_experiment_sim_check("NO MERGES INCREMENTAL", queries, 0, true, DB_EXPERIMENT_SIM_CHECK_BUDGET);
+    ret |= db_experiment_sim_check("MERGES INCREMENTAL", queries, queries, false, DB_EXPERIMENT_SIM_CHECK_BUDGET);
+
+    return ret;
+}
+
+DB_snapshot db_index_fdtree_experiment_workload_run(DB_stat *stat, SSD *ssd, size_t key_size, size_t entry_size, size_t runs_ratio, size_t queries)
+{
+    DB_index_fdtree *index;
+
+    db_stat_reset(stat);
+    index = db_index_fdtree_create(ssd, stat, key_size, entry_size, runs_ratio);
+    if (index == NULL)
+        return stat->total;
+
+    db_index_fdtree_experiment_workload_on_index(index, queries);
+    db_index_fdtree_destroy(index);
+
+    return stat->total;
+}
+
+void db_index_experiment_workload(DB_index_type type, const DB_profile *profile, size_t queries)
+{
+    DB_index index;
+    SSD *ssd;
+    DB_stat *stat;
+
+    if (type == DB_INDEX_TYPE_FDTREE)
+    {
+        db_index_fdtree_experiment_workload_profile(profile, queries);
+        return;
+    }
+
+    ssd = db_profile_ssd_create(profile);
+    stat = db_stat_create();
+    if (ssd == NULL || stat == NULL || db_index_create(&index, type, ssd, stat, profile->key_size, profile->entry_size, profile->runs_ratio) != 0)
+    {
+        printf("Cannot create index %s\n", db_index_type_name(type));
+        db_stat_destroy(stat);
+        ssd_destroy(ssd);
+        return;
+    }
+
+    db_index_experiment_workload_on_index(&index, queries, NULL);
+
+    db_stat_summary_print(stat);
+    index.ops->stat_print(index.index);
+    ssd_wear_print(ssd, (double)stat->total.queries, DB_EXPERIMENT_OPS_PER_SECOND);
+
+    db_index_destroy(&index);
+    db_stat_destroy(stat);
     ssd_destroy(ssd);
-}
\ No newline at end of file
+}
+
+void db_index_experiment_compare(const DB_profile *profile, size_t queries)
+{
+    printf("INDEX\tTOTAL_TIME\tBULKLOAD\tINSERT\tPOINT_SEARCH\tRANGE_SEARCH\tDELETE\tUPDATE\tWRITE_AMP\tREAD_AMP\tSPACE_AMP\tPAGES_WRITTEN\tBLOCKS_ERASED\tLIFETIME_DAYS\n");
+    for (size_t i = 0; i < DB_INDEX_TYPE_NUM_TYPES; ++i)
+    {
+        const DB_index_type type = (DB_index_type)i;
+        double op_time[DB_STAT_OP_NUM];
+        DB_index index;
+        SSD *ssd;
+        DB_stat *stat;
+
+        ssd = db_profile_ssd_create(profile);
+        stat = db_stat_create();
+        if (ssd == NULL || stat == NULL || db_index_create(&index, type, ssd, stat, profile->key_size, profile->entry_size, profile->runs_ratio) != 0)
+        {
+            printf("Cannot create index %s\n", db_index_type_name(type));
+            db_stat_destroy(stat);
+            ssd_destroy(ssd);
+            continue;
+        }
+
+        db_index_experiment_workload_on_index(&index, queries, op_time);
+
+        printf("%s\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\t%zu\t%zu\t%lf\n",
+               db_index_type_name(type),
+               stat->total.query_time,
+               op_time[DB_STAT_OP_BULKLOAD],
+               op_time[DB_STAT_OP_INSERT],
+               op_time[DB_STAT_OP_POINT_SEARCH],
+               op_time[DB_STAT_OP_RANGE_SEARCH],
+               op_time[DB_STAT_OP_DELETE],
+               op_time[DB_STAT_OP_UPDATE],
+               index.ops->write_amplification(index.index),
+               index.ops->read_amplification(index.index),
+               index.ops->space_amplification(index.index),
+               ssd->stat.pages_written,
+               ssd->stat.blocks_erased,
+               ssd_lifetime_days(ssd, (double)stat->total.queries, DB_EXPERIMENT_OPS_PER_SECOND));
+
+        db_index_destroy(&index);
+        db_stat_destroy(stat);
+        ssd_destroy(ssd);
+    }
+}
@@ -0,0 +1,1106 @@
+#define _GNU_SOURCE
+
+#include <dbindex_fdtree_file.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+/* streams read and write this number of pages at once */
+#define FDFILE_CHUNK_PAGES 64
+
+/* alignment of buffers (enough for O_DIRECT) */
+#define FDFILE_ALIGNMENT 4096
+
+#define FDFILE_TOMBSTONE 1
+
+/* Sequential reader of run, reads up to FDFILE_CHUNK_PAGES pages at once */
+typedef struct FDFile_reader
+{
+    DB_index_fdtree_file *index;
+    size_t lvl; /* lvls can be reallocated, so pointer cannot be kept */
+
+    uint8_t *buffer;
+    size_t buffer_first_page;
+    size_t buffer_pages;
+
+    size_t chunk_pages; /* pages read at once */
+    size_t pos; /* current entry in run */
+} FDFile_reader;
+
+/* Source of sorted entries: head tree or run */
+typedef struct FDFile_source
+{
+    bool is_mem;
+    const uint8_t *mem;
+    size_t mem_entries;
+    size_t mem_pos;
+
+    FDFile_reader reader;
+    const uint8_t *entry; /* current entry, NULL iff source is empty */
+} FDFile_source;
+
+/* Sequential writer of new run */
+typedef struct FDFile_writer
+{
+    DB_index_fdtree_file *index;
+    int fd;
+
+    uint8_t *buffer;
+    size_t buffer_first_page;
+
+    size_t entries;
+    uint64_t *fences;
+    size_t max_fences;
+} FDFile_writer;
+
+/*
+    Get key of entry
+
+    PARAMS
+    @IN entry - pointer to entry
+
+    RETURN
+    Key
+*/
+static inline uint64_t fdfile_key(const uint8_t *entry);
+
+/*
+    Check if entry is tombstone
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entry - pointer to entry
+
+    RETURN
+    true iff entry is tombstone
+*/
+static inline bool fdfile_is_tombstone(const DB_index_fdtree_file *index, const uint8_t *entry);
+
+/*
+    Allocate buffer aligned for O_DIRECT
+
+    PARAMS
+    @IN size - size in bytes
+
+    RETURN
+    NULL iff failure
+    Pointer to buffer
+*/
+static uint8_t *fdfile_alloc(size_t size);
+
+/*
+    Get path of lvl file
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+    @IN tmp - true iff path of new run is needed
+    @OUT path - buffer for path
+    @IN size - size of buffer
+
+    RETURN
+    This is a void function
+*/
+static void fdfile_lvl_path(const DB_index_fdtree_file *index, size_t lvl, bool tmp, char *path, size_t size);
+
+/*
+    Read / write pages of file
+
+    PARAMS
+    @IN index - pointer to index
+    @IN fd - file
+    @IN buffer - aligned buffer
+    @IN first_page - first page in file
+    @IN pages - number of pages
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_pread(DB_index_fdtree_file *index, int fd, uint8_t *buffer, size_t first_page, size_t pages);
+static int fdfile_pwrite(DB_index_fdtree_file *index, int fd, const uint8_t *buffer, size_t first_page, size_t pages);
+
+/*
+    Make sure that lvl exists
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_lvl_prepare(DB_index_fdtree_file *index, size_t lvl);
+
+/*
+    Remove all entries from lvl
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_lvl_clear(DB_index_fdtree_file *index, size_t lvl);
+
+/*
+    Find the last page of lvl which can contain key
+
+    PARAMS
+    @IN lvl - pointer to lvl
+    @IN key - key
+
+    RETURN
+    SIZE_MAX iff all keys in lvl are bigger than key
+    Page
+*/
+static size_t fdfile_lvl_find_page(const FDFile_lvl *lvl, uint64_t key);
+
+/*
+    Init source reading run from entry
+
+    PARAMS
+    @IN index - pointer to index
+    @IN src - pointer to source
+    @IN lvl - lvl with run
+    @IN first_entry - first entry to read
+    @IN chunk_pages - pages read at once
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_source_init_run(DB_index_fdtree_file *index, FDFile_source *src, size_t lvl, size_t first_entry, size_t chunk_pages);
+
+/*
+    Init source reading entries from memory
+
+    PARAMS
+    @IN src - pointer to source
+    @IN mem - sorted entries
+    @IN entries - number of entries
+
+    RETURN
+    This is a void function
+*/
+static void fdfile_source_init_mem(FDFile_source *src, const uint8_t *mem, size_t entries);
+
+/*
+    Move source to next entry
+
+    PARAMS
+    @IN index - pointer to index
+    @IN src - pointer to source
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_source_next(DB_index_fdtree_file *index, FDFile_source *src);
+
+/*
+    Free memory of source
+
+    PARAMS
+    @IN src - pointer to source
+
+    RETURN
+    This is a void function
+*/
+static void fdfile_source_destroy(FDFile_source *src);
+
+/*
+    Writer functions: init, append entry, write rest of pages
+
+    PARAMS
+    @IN index - pointer to index
+    @IN writer - pointer to writer
+    @IN fd - file of new run
+    @IN entry - entry to append
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_writer_init(DB_index_fdtree_file *index, FDFile_writer *writer, int fd);
+static int fdfile_writer_append(FDFile_writer *writer, const uint8_t *entry);
+static int fdfile_writer_finish(FDFile_writer *writer);
+
+/*
+    Write new run of lvl from sources (smaller source has newer entries) and replace old run.
+    Only the newest version of key is written, tombstones are dropped if lvl is the last lvl
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+    @IN srcs - sources
+    @IN num_srcs - number of sources
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_write_run(DB_index_fdtree_file *index, size_t lvl, FDFile_source **srcs, size_t num_srcs);
+
+/*
+    Compare keys (for qsort)
+
+    PARAMS
+    @IN a - pointer to first key
+    @IN b - pointer to second key
+
+    RETURN
+    -1 iff a < b, 0 iff a == b, 1 iff a > b
+*/
+static int fdfile_key_cmp(const void *a, const void *b);
+
+/*
+    Merge run from source into lvl. If lvl is full, lvl is merged with lvl + 1 before
+
+    PARAMS
+    @IN index - pointer to index
+    @IN lvl - lvl
+    @IN src - pointer to source
+    @IN src_entries - entries in source
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_merge_into_lvl(DB_index_fdtree_file *index, size_t lvl, FDFile_source *src, size_t src_entries);
+
+/*
+    Merge head tree into lvl 0
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_merge_head(DB_index_fdtree_file *index);
+
+/*
+    Put entry into head tree, merge head if it is full
+
+    PARAMS
+    @IN index - pointer to index
+    @IN key - key
+    @IN tombstone - true iff entry is tombstone
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int fdfile_head_put(DB_index_fdtree_file *index, uint64_t key, bool tombstone);
+
+/*
+    Find first entry with key >= key in sorted entries
+
+    PARAMS
+    @IN entries - sorted entries
+    @IN num_entries - number of entries
+    @IN entry_size - size of entry
+    @IN key - key
+
+    RETURN
+    Position of entry (num_entries iff there is no such entry)
+*/
+static size_t fdfile_lower_bound(const uint8_t *entries, size_t num_entries, size_t entry_size, uint64_t key);
+
+static inline uint64_t fdfile_key(const uint8_t *entry)
+{
+    uint64_t key;
+
+    (void)memcpy(&key, entry, sizeof(key));
+    return key;
+}
+
+static inline bool fdfile_is_tombstone(const DB_index_fdtree_file *index, const uint8_t *entry)
+{
+    return entry[index->key_size] == FDFILE_TOMBSTONE;
+}
+
+static uint8_t *fdfile_alloc(size_t size)
+{
+    void *ptr;
+
+    if (posix_memalign(&ptr, FDFILE_ALIGNMENT, size) != 0)
+        return NULL;
+
+    return (uint8_t *)ptr;
+}
+
+static void fdfile_lvl_path(const DB_index_fdtree_file *index, size_t lvl, bool tmp, char *path, size_t size)
+{
+    (void)snprintf(path, size, "%s.lvl%zu%s", index->path, lvl, tmp ? ".tmp" : "");
+}
+
+static int fdfile_pread(DB_index_fdtree_file *index, int fd, uint8_t *buffer, size_t first_page, size_t pages)
+{
+    size_t done = 0;
+    const size_t bytes = pages * index->page_size;
+    const off_t offset = (off_t)(first_page * index->page_size);
+
+    while (done < bytes)
+    {
+        const ssize_t ret = pread(fd, buffer + done, bytes - done, offset + (off_t)done);
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        if (ret <= 0)
+            return 1;
+
+        done += (size_t)ret;
+    }
+
+    index->stat.pages_read += pages;
+
+    return 0;
+}
+
+static int fdfile_pwrite(DB_index_fdtree_file *index, int fd, const uint8_t *buffer, size_t first_page, size_t pages)
+{
+    size_t done = 0;
+    const size_t bytes = pages * index->page_size;
+    const off_t offset = (off_t)(first_page * index->page_size);
+
+    while (done < bytes)
+    {
+        const ssize_t ret = pwrite(fd, buffer + done, bytes - done, offset + (off_t)done);
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        if (ret <= 0)
+            return 1;
+
+        done += (size_t)ret;
+    }
+
+    index->stat.pages_written += pages;
+
+    return 0;
+}
+
+static int fdfile_lvl_prepare(DB_index_fdtree_file *index, size_t lvl)
+{
+    while (index->max_height <= lvl)
+    {
+        const size_t max_height = index->max_height == 0 ? 4 : index->max_height * 2;
+        FDFile_lvl *lvls = (FDFile_lvl *)realloc(index->lvls, max_height * sizeof(FDFile_lvl));
+
+        if (lvls == NULL)
+            return 1;
+
+        for (size_t i = index->max_height; i < max_height; ++i)
+        {
+            lvls[i].fd = -1;
+            lvls[i].num_entries = 0;
+            lvls[i].max_entries = (i == 0 ? index->head_max_entries : lvls[i - 1].max_entries) * index->runs_ratio;
+            lvls[i].fences = NULL;
+            lvls[i].num_pages = 0;
+        }
+
+        index->lvls = lvls;
+        index->max_height = max_height;
+    }
+
+    if (index->height <= lvl)
+        index->height = lvl + 1;
+
+    return 0;
+}
+
+static int fdfile_lvl_clear(DB_index_fdtree_file *index, size_t lvl)
+{
+    FDFile_lvl *fdlvl = &index->lvls[lvl];
+
+    fdlvl->num_entries = 0;
+    fdlvl->num_pages = 0;
+
+    if (fdlvl->fd >= 0 && ftruncate(fdlvl->fd, 0) != 0)
+        return 1;
+
+    return 0;
+}
+
+static size_t fdfile_lvl_find_page(const FDFile_lvl *lvl, uint64_t key)
+{
+    size_t left = 0;
+    size_t right = lvl->num_pages;
+
+    /* first page with fence > key */
+    while (left < right)
+    {
+        const size_t mid = left + (right - left) / 2;
+
+        if (lvl->fences[mid] <= key)
+            left = mid + 1;
+        else
+            right = mid;
+    }
+
+    return left == 0 ? SIZE_MAX : left - 1;
+}
+
+static size_t fdfile_lower_bound(const uint8_t *entries, size_t num_entries, size_t entry_size, uint64_t key)
+{
+    size_t left = 0;
+    size_t right = num_entries;
+
+    while (left < right)
+    {
+        const size_t mid = left + (right - left) / 2;
+
+        if (fdfile_key(entries + mid * entry_size) < key)
+            left = mid + 1;
+        else
+            right = mid;
+    }
+
+    return left;
+}
+
+static int fdfile_source_init_run(DB_index_fdtree_file *index, FDFile_source *src, size_t lvl, size_t first_entry, size_t chunk_pages)
+{
+    FDFile_reader *reader = &src->reader;
+
+    src->is_mem = false;
+    src->mem = NULL;
+    src->entry = NULL;
+
+    reader->index = index;
+    reader->lvl = lvl;
+    reader->buffer_first_page = 0;
+    reader->buffer_pages = 0;
+    reader->pos = first_entry;
+    reader->chunk_pages = chunk_pages < FDFILE_CHUNK_PAGES ? chunk_pages : FDFILE_CHUNK_PAGES;
+
+    reader->buffer = fdfile_alloc(reader->chunk_pages * index->page_size);
+    if (reader->buffer == NULL)
+        return 1;
+
+    /* step back, next moves to first_entry */
+    --reader->pos;
+
+    return fdfile_source_next(index, src);
+}
+
+static void fdfile_source_init_mem(FDFile_source *src, const uint8_t *mem, size_t entries)
+{
+    src->is_mem = true;
+    src->mem = mem;
+    src->mem_entries = entries;
+    src->mem_pos = 0;
+    src->reader.buffer = NULL;
+    src->entry = entries > 0 ? mem : NULL;
+}
+
+static int fdfile_source_next(DB_index_fdtree_file *index, FDFile_source *src)
+{
+    FDFile_reader *reader = &src->reader;
+    const FDFile_lvl *fdlvl;
+    size_t page;
+
+    if (src->is_mem)
+    {
+        ++src->mem_pos;
+        src->entry = src->mem_pos < src->mem_entries ? src->mem + src->mem_pos * index->entry_size : NULL;
+
+        return 0;
+    }
+
+    fdlvl = &index->lvls[reader->lvl];
+    ++reader->pos;
+    page = reader->pos / index->entries_per_page;
+
+    if (reader->pos >= fdlvl->num_entries)
+    {
+        src->entry = NULL;
+        return 0;
+    }
+
+    /* load next chunk */
+    if (page < reader->buffer_first_page || page >= reader->buffer_first_page + reader->buffer_pages)
+    {
+        size_t pages = fdlvl->num_pages - page;
+
+        if (pages > reader->chunk_pages)
+            pages = reader->chunk_pages;
+
+        if (fdfile_pread(index, fdlvl->fd, reader->buffer, page, pages) != 0)
+            return 1;
+
+        reader->buffer_first_page = page;
+        reader->buffer_pages = pages;
+    }
+
+    src->entry = reader->buffer + (page - reader->buffer_first_page) * index->page_size + (reader->pos % index->entries_per_page) * index->entry_size;
+
+    return 0;
+}
+
+static void fdfile_source_destroy(FDFile_source *src)
+{
+    free(src->reader.buffer);
+    src->reader.buffer = NULL;
+}
+
+static int fdfile_writer_init(DB_index_fdtree_file *index, FDFile_writer *writer, int fd)
+{
+    writer->index = index;
+    writer->fd = fd;
+    writer->buffer_first_page = 0;
+    writer->entries = 0;
+    writer->fences = NULL;
+    writer->max_fences = 0;
+
+    writer->buffer = fdfile_alloc(FDFILE_CHUNK_PAGES * index->page_size);
+    if (writer->buffer == NULL)
+        return 1;
+
+    /* padding of pages is written too */
+    (void)memset(writer->buffer, 0, FDFILE_CHUNK_PAGES * index->page_size);
+
+    return 0;
+}
+
+static int fdfile_writer_append(FDFile_writer *writer, const uint8_t *entry)
+{
+    DB_index_fdtree_file *index = writer->index;
+    const size_t page = writer->entries / index->entries_per_page;
+    const size_t slot = writer->entries % index->entries_per_page;
+
+    if (slot == 0)
+    {
+        /* buffer is full */
+        if (page == writer->buffer_first_page + FDFILE_CHUNK_PAGES)
+        {
+            if (fdfile_pwrite(index, writer->fd, writer->buffer, writer->buffer_first_page, FDFILE_CHUNK_PAGES) != 0)
+                return 1;
+
+            (void)memset(writer->buffer, 0, FDFILE_CHUNK_PAGES * index->page_size);
+            writer->buffer_first_page = page;
+        }
+
+        if (page == writer->max_fences)
+        {
+            const size_t max_fences = writer->max_fences == 0 ? 64 : writer->max_fences * 2;
+            uint64_t *fences = (uint64_t *)realloc(writer->fences, max_fences * sizeof(uint64_t));
+
+            if (fences == NULL)
+                return 1;
+
+            writer->fences = fences;
+            writer->max_fences = max_fences;
+        }
+
+        writer->fences[page] = fdfile_key(entry);
+    }
+
+    (void)memcpy(writer->buffer + (page - writer->buffer_first_page) * index->page_size + slot * index->entry_size, entry, index->entry_size);
+    ++writer->entries;
+
+    return 0;
+}
+
+static int fdfile_writer_finish(FDFile_writer *writer)
+{
+    DB_index_fdtree_file *index = writer->index;
+    const size_t pages = (writer->entries + index->entries_per_page - 1) / index->entries_per_page;
+    int ret = 0;
+
+    if (pages > writer->buffer_first_page)
+        ret = fdfile_pwrite(index, writer->fd, writer->buffer, writer->buffer_first_page, pages - writer->buffer_first_page);
+
+    free(writer->buffer);
+    writer->buffer = NULL;
+
+    return ret;
+}
+
+static int fdfile_write_run(DB_index_fdtree_file *index, size_t lvl, FDFile_source **srcs, size_t num_srcs)
+{
+    FDFile_lvl *fdlvl = &index->lvls[lvl];
+    FDFile_writer writer = {0};
+    char path[4096];
+    char tmp_path[4096];
+    bool last_lvl = true;
+    int fd;
+    int ret = 0;
+
+    for (size_t i = lvl + 1; i < index->height; ++i)
+        if (index->lvls[i].num_entries > 0)
+            last_lvl = false;
+
+    fdfile_lvl_path(index, lvl, true, tmp_path, sizeof(tmp_path));
+    fdfile_lvl_path(index, lvl, false, path, sizeof(path));
+
+    fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC | (index->direct ? O_DIRECT : 0), 0644);
+    if (fd < 0)
+        return 1;
+
+    ret = fdfile_writer_init(index, &writer, fd);
+
+    while (ret == 0)
+    {
+        const uint8_t *newest = NULL;
+        uint64_t min_key = UINT64_MAX;
+
+        for (size_t i = 0; i < num_srcs; ++i)
+            if (srcs[i]->entry != NULL && (newest == NULL || fdfile_key(srcs[i]->entry) < min_key))
+            {
+                newest = srcs[i]->entry;
+                min_key = fdfile_key(newest);
+            }
+
+        if (newest == NULL)
+            break;
+
+        /* there is nothing to delete below the last lvl */
+        if (!(last_lvl && fdfile_is_tombstone(index, newest)))
+            ret = fdfile_writer_append(&writer, newest);
+
+        /* entry is in reader buffer, so move readers after append, older versions are overwritten */
+        for (size_t i = 0; i < num_srcs && ret == 0; ++i)
+            if (srcs[i]->entry != NULL && fdfile_key(srcs[i]->entry) == min_key)
+                ret = fdfile_source_next(index, srcs[i]);
+    }
+
+    if (writer.buffer != NULL)
+        ret |= fdfile_writer_finish(&writer);
+
+    if (ret != 0 || rename(tmp_path, path) != 0)
+    {
+        free(writer.fences);
+        (void)close(fd);
+        (void)unlink(tmp_path);
+
+        return 1;
+    }
+
+    if (fdlvl->fd >= 0)
+        (void)close(fdlvl->fd);
+
+    free(fdlvl->fences);
+
+    fdlvl->fd = fd;
+    fdlvl->fences = writer.fences;
+    fdlvl->num_entries = writer.entries;
+    fdlvl->num_pages = (writer.entries + index->entries_per_page - 1) / index->entries_per_page;
+
+    ++index->stat.merges;
+
+    return 0;
+}
+
+static int fdfile_key_cmp(const void *a, const void *b)
+{
+    const uint64_t ka = *(const uint64_t *)a;
+    const uint64_t kb = *(const uint64_t *)b;
+
+    return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+static int fdfile_merge_into_lvl(DB_index_fdtree_file *index, size_t lvl, FDFile_source *src, size_t src_entries)
+{
+    FDFile_lvl *fdlvl;
+    FDFile_source dst;
+    FDFile_source *srcs[2];
+    int ret = 0;
+
+    if (fdfile_lvl_prepare(index, lvl) != 0)
+        return 1;
+
+    fdlvl = &index->lvls[lvl];
+
+    /* lvl is full, push it down (the same condition as in the model) */
+    if (fdlvl->num_entries > 0 && fdlvl->num_entries + src_entries >= fdlvl->max_entries)
+    {
+        FDFile_source lvl_src;
+
+        if (fdfile_source_init_run(index, &lvl_src, lvl, 0, FDFILE_CHUNK_PAGES) != 0)
+        {
+            fdfile_source_destroy(&lvl_src);
+            return 1;
+        }
+
+        ret = fdfile_merge_into_lvl(index, lvl + 1, &lvl_src, index->lvls[lvl].num_entries);
+        fdfile_source_destroy(&lvl_src);
+
+        if (ret != 0 || fdfile_lvl_clear(index, lvl) != 0)
+            return 1;
+    }
+
+    /* lvls can be reallocated by recursion */
+    fdlvl = &index->lvls[lvl];
+
+    if (fdlvl->num_entries > 0)
+    {
+        if (fdfile_source_init_run(index, &dst, lvl, 0, FDFILE_CHUNK_PAGES) != 0)
+            ret = 1;
+    }
+    else
+        fdfile_source_init_mem(&dst, NULL, 0);
+
+    /* src is newer than dst */
+    srcs[0] = src;
+    srcs[1] = &dst;
+    if (ret == 0)
+        ret = fdfile_write_run(index, lvl, srcs, 2);
+
+    fdfile_source_destroy(&dst);
+
+    return ret;
+}
+
+static int fdfile_merge_head(DB_index_fdtree_file *index)
+{
+    FDFile_source src;
+
+    fdfile_source_init_mem(&src, index->head, index->head_entries);
+    if (fdfile_merge_into_lvl(index, 0, &src, index->head_entries) != 0)
+        return 1;
+
+    index->head_entries = 0;
+
+    return 0;
+}
+
+static int fdfile_head_put(DB_index_fdtree_file *index, uint64_t key, bool tombstone)
+{
+    const size_t pos = fdfile_lower_bound(index->head, index->head_entries, index->entry_size, key);
+    uint8_t *entry = index->head + pos * index->entry_size;
+
+    if (pos == index->head_entries || fdfile_key(entry) != key)
+    {
+        (void)memmove(entry + index->entry_size, entry, (index->head_entries - pos) * index->entry_size);
+        (void)memset(entry, 0, index->entry_size);
+        (void)memcpy(entry, &key, sizeof(key));
+        ++index->head_entries;
+    }
+
+    entry[index->key_size] = tombstone ? FDFILE_TOMBSTONE : 0;
+
+    if (index->head_entries == index->head_max_entries)
+        return fdfile_merge_head(index);
+
+    return 0;
+}
+
+DB_index_fdtree_file *db_index_fdtree_file_create(const char *path, size_t page_size, size_t key_size, size_t entry_size, size_t runs_ratio, bool direct)
+{
+    DB_index_fdtree_file *index;
+
+    if (key_size < sizeof(uint64_t) || entry_size <= key_size || entry_size > page_size || runs_ratio < 2)
+        return NULL;
+
+    if (direct && page_size % 512 != 0)
+        return NULL;
+
+    index = (DB_index_fdtree_file *)calloc(1, sizeof(DB_index_fdtree_file));
+    if (index == NULL)
+        return NULL;
+
+    index->path = strdup(path);
+    index->direct = direct;
+    index->page_size = page_size;
+    index->key_size = key_size;
+    index->entry_size = entry_size;
+    index->entries_per_page = page_size / entry_size;
+    index->runs_ratio = runs_ratio;
+    index->head_max_entries = index->entries_per_page;
+
+    /* one more entry for insert before merge */
+    index->head = (uint8_t *)calloc(index->head_max_entries + 1, entry_size);
+    index->page = fdfile_alloc(page_size);
+
+    if (index->path == NULL || index->head == NULL || index->page == NULL)
+    {
+        db_index_fdtree_file_destroy(index);
+        return NULL;
+    }
+
+    return index;
+}
+
+int db_index_fdtree_file_set_head_pages(DB_index_fdtree_file *index, size_t pages)
+{
+    uint8_t *head;
+
+    if (index->head_entries > 0 || index->height > 0)
+        return 1;
+
+    pages = pages > 0 ? pages : 1;
+
+    /* one more entry for insert before merge */
+    head = (uint8_t *)realloc(index->head, (index->entries_per_page * pages + 1) * index->entry_size);
+    if (head == NULL)
+        return 1;
+
+    index->head = head;
+    index->head_max_entries = index->entries_per_page * pages;
+
+    for (size_t i = 0; i < index->max_height; ++i)
+        index->lvls[i].max_entries = (i == 0 ? index->head_max_entries : index->lvls[i - 1].max_entries) * index->runs_ratio;
+
+    return 0;
+}
+
+void db_index_fdtree_file_destroy(DB_index_fdtree_file *index)
+{
+    char path[4096];
+
+    if (index == NULL)
+        return;
+
+    for (size_t i = 0; i < index->max_height; ++i)
+    {
+        if (index->lvls[i].fd >= 0)
+        {
+            (void)close(index->lvls[i].fd);
+
+            fdfile_lvl_path(index, i, false, path, sizeof(path));
+            (void)unlink(path);
+        }
+
+        free(index->lvls[i].fences);
+    }
+
+    free(index->lvls);
+    free(index->head);
+    free(index->page);
+    free(index->path);
+    free(index);
+}
+
+int db_index_fdtree_file_insert(DB_index_fdtree_file *index, uint64_t key)
+{
+    return fdfile_head_put(index, key, false);
+}
+
+int db_index_fdtree_file_bulkload(DB_index_fdtree_file *index, const uint64_t *keys, size_t entries)
+{
+    FDFile_source *sources;
+    FDFile_source **srcs;
+    uint64_t *sorted;
+    uint8_t *bulk;
+    size_t bulk_entries = 0;
+    size_t total;
+    size_t lvl;
+    size_t num_srcs;
+    int ret = 0;
+
+    if (entries == 0)
+        return 0;
+
+    /* input is sorted and deduplicated in RAM */
+    sorted = (uint64_t *)malloc(entries * sizeof(uint64_t));
+    bulk = (uint8_t *)calloc(entries, index->entry_size);
+    if (sorted == NULL || bulk == NULL)
+    {
+        free(sorted);
+        free(bulk);
+        return 1;
+    }
+
+    (void)memcpy(sorted, keys, entries * sizeof(uint64_t));
+    qsort(sorted, entries, sizeof(uint64_t), fdfile_key_cmp);
+    for (size_t i = 0; i < entries; ++i)
+        if (i == 0 || sorted[i] != sorted[i - 1])
+            (void)memcpy(bulk + bulk_entries++ * index->entry_size, &sorted[i], sizeof(uint64_t));
+
+    free(sorted);
+
+    /* the first lvl which can hold bulk with head and all lvls above it */
+    total = bulk_entries + index->head_entries;
+    for (lvl = 0; ; ++lvl)
+    {
+        if (fdfile_lvl_prepare(index, lvl) != 0)
+        {
+            free(bulk);
+            return 1;
+        }
+
+        total += index->lvls[lvl].num_entries;
+        if (total <= index->lvls[lvl].max_entries)
+            break;
+    }
+
+    /* src 0 is bulk (the newest), src 1 is head, src i + 2 is lvl i */
+    num_srcs = lvl + 3;
+    sources = (FDFile_source *)calloc(num_srcs, sizeof(FDFile_source));
+    srcs = (FDFile_source **)malloc(num_srcs * sizeof(FDFile_source *));
+    if (sources == NULL || srcs == NULL)
+    {
+        free(sources);
+        free(srcs);
+        free(bulk);
+        return 1;
+    }
+
+    fdfile_source_init_mem(&sources[0], bulk, bulk_entries);
+    fdfile_source_init_mem(&sources[1], index->head, index->head_entries);
+    for (size_t i = 0; i <= lvl && ret == 0; ++i)
+    {
+        if (index->lvls[i].num_entries > 0)
+            ret = fdfile_source_init_run(index, &sources[i + 2], i, 0, FDFILE_CHUNK_PAGES);
+        else
+            fdfile_source_init_mem(&sources[i + 2], NULL, 0);
+    }
+
+    for (size_t i = 0; i < num_srcs; ++i)
+        srcs[i] = &sources[i];
+
+    /* one sequential pass writes lvl, lvls above it are empty */
+    if (ret == 0)
+        ret = fdfile_write_run(index, lvl, srcs, num_srcs);
+
+    for (size_t i = 0; i < num_srcs; ++i)
+        fdfile_source_destroy(&sources[i]);
+
+    for (size_t i = 0; i < lvl && ret == 0; ++i)
+        ret = fdfile_lvl_clear(index, i);
+
+    if (ret == 0)
+        index->head_entries = 0;
+
+    free(sources);
+    free(srcs);
+    free(bulk);
+
+    return ret;
+}
+
+int db_index_fdtree_file_point_search(DB_index_fdtree_file *index, uint64_t key, bool *found)
+{
+    size_t pos = fdfile_lower_bound(index->head, index->head_entries, index->entry_size, key);
+
+    *found = false;
+
+    /* newest version wins */
+    if (pos < index->head_entries && fdfile_key(index->head + pos * index->entry_size) == key)
+    {
+        *found = !fdfile_is_tombstone(index, index->head + pos * index->entry_size);
+        return 0;
+    }
+
+    /* fences are in RAM, so one page per lvl */
+    for (size_t i = 0; i < index->height; ++i)
+    {
+        const FDFile_lvl *fdlvl = &index->lvls[i];
+        const size_t page = fdfile_lvl_find_page(fdlvl, key);
+        size_t entries;
+
+        if (fdlvl->num_entries == 0 || page == SIZE_MAX)
+            continue;
+
+        if (fdfile_pread(index, fdlvl->fd, index->page, page, 1) != 0)
+            return 1;
+
+        entries = fdlvl->num_entries - page * index->entries_per_page;
+        if (entries > index->entries_per_page)
+            entries = index->entries_per_page;
+
+        pos = fdfile_lower_bound(index->page, entries, index->entry_size, key);
+        if (pos < entries && fdfile_key(index->page + pos * index->entry_size) == key)
+        {
+            *found = !fdfile_is_tombstone(index, index->page + pos * index->entry_size);
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+int db_index_fdtree_file_range_search(DB_index_fdtree_file *index, uint64_t key, size_t entries, size_t *found)
+{
+    FDFile_source *srcs;
+    const size_t num_srcs = index->height + 1;
+    size_t pos;
+    int ret = 0;
+
+    *found = 0;
+
+    srcs = (FDFile_source *)calloc(num_srcs, sizeof(FDFile_source));
+    if (srcs == NULL)
+        return 1;
+
+    /* src 0 is head, src i is lvl i - 1, so smaller src has newer entries */
+    pos = fdfile_lower_bound(index->head, index->head_entries, index->entry_size, key);
+    fdfile_source_init_mem(&srcs[0], index->head + pos * index->entry_size, index->head_entries - pos);
+
+    for (size_t i = 0; i < index->height && ret == 0; ++i)
+    {
+        const FDFile_lvl *fdlvl = &index->lvls[i];
+        size_t page;
+
+        if (fdlvl->num_entries == 0)
+        {
+            fdfile_source_init_mem(&srcs[i + 1], NULL, 0);
+            continue;
+        }
+
+        page = fdfile_lvl_find_page(fdlvl, key);
+        if (page == SIZE_MAX)
+            page = 0;
+
+        /* page by page, so run is read only as far as the scanned key range reaches */
+        ret = fdfile_source_init_run(index, &srcs[i + 1], i, page * index->entries_per_page, 1);
+        while (ret == 0 && srcs[i + 1].entry != NULL && fdfile_key(srcs[i + 1].entry) < key)
+            ret = fdfile_source_next(index, &srcs[i + 1]);
+    }
+
+    while (ret == 0 && *found < entries)
+    {
+        const uint8_t *newest = NULL;
+        uint64_t min_key = UINT64_MAX;
+
+        for (size_t i = 0; i < num_srcs; ++i)
+            if (srcs[i].entry != NULL && (newest == NULL || fdfile_key(srcs[i].entry) < min_key))
+            {
+                newest = srcs[i].entry;
+                min_key = fdfile_key(newest);
+            }
+
+        if (newest == NULL)
+            break;
+
+        if (!fdfile_is_tombstone(index, newest))
+            ++*found;
+
+        /* skip older versions */
+        for (size_t i = 0; i < num_srcs && ret == 0; ++i)
+            if (srcs[i].entry != NULL && fdfile_key(srcs[i].entry) == min_key)
+                ret = fdfile_source_next(index, &srcs[i]);
+    }
+
+    for (size_t i = 0; i < num_srcs; ++i)
+        fdfile_source_destroy(&srcs[i]);
+
+    free(srcs);
+
+    return ret;
+}
+
+int db_index_fdtree_file_delete(DB_index_fdtree_file *index, uint64_t key)
+{
+    return fdfile_head_put(index, key, true);
+}
+
+int db_index_fdtree_file_update(DB_index_fdtree_file *index, uint64_t key)
+{
+    if (db_index_fdtree_file_delete(index, key) != 0)
+        return 1;
+
+    return db_index_fdtree_file_insert(index, key);
+}
@@ -0,0 +1,478 @@
+#include <dbindex_lsm.h>
+#include <dbindex_fdtree.h>
+#include <ssd.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <dbutils.h>
+#include <dbstat.h>
+
+/*
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - number of entries
+
+    RETURN
+    Number of pages used by run of entries (entries and fences like lvl of FDTree)
+*/
+static inline size_t db_index_lsm_pages_for_entries(const DB_index_lsm *index, size_t entries);
+
+/*
+    Add new deepest lvl
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_index_lsm_add_lvl(DB_index_lsm *index);
+
+/*
+    Merge src (buffer or lvl - 1) into lvl, src is empty after merge
+
+    PARAMS
+    @IN index - pointer to index
+    @IN src - pointer to buffer or lvl - 1
+    @IN lvl - destination lvl
+
+    RETURN
+    Time of merge
+*/
+static double db_index_lsm_merge_into_lvl(DB_index_lsm *index, LSMLvl *src, size_t lvl);
+
+/*
+    Flush full buffer into lvl 0 and merge every lvl which overflows
+
+    PARAMS
+    @IN index - pointer to index
+
+    RETURN
+    Time of flush and merges
+*/
+static double db_index_lsm_flush(DB_index_lsm *index);
+
+/*
+    Put entries into buffer, buffer is flushed every time it is full
+
+    PARAMS
+    @IN index - pointer to index
+    @IN entries - entries to put
+    @IN garbage - (can be NULL) counter of buffer increased by entries (tombstones or versions)
+
+    RETURN
+    Time of writes
+*/
+static double db_index_lsm_put(DB_index_lsm *index, size_t entries, size_t *garbage);
+
+static inline size_t db_index_lsm_pages_for_entries(const DB_index_lsm *index, size_t entries)
+{
+    const size_t pages_for_entries = db_utils_pages_for_entries(index->ssd->page_size, index->entry_size, entries);
+    const size_t pages_for_pointers = db_utils_pages_for_entries(index->ssd->page_size, index->key_size + sizeof(void *), pages_for_entries);
+
+    return pages_for_entries + pages_for_pointers;
+}
+
+static int db_index_lsm_add_lvl(DB_index_lsm *index)
+{
+    const size_t prev = index->num_lvls > 0 ? index->lvls[index->num_lvls - 1].max_entries : index->buffer.max_entries;
+    LSMLvl *lvls;
+    LSMLvl *lvl;
+
+    lvls = (LSMLvl *)realloc(index->lvls, (index->num_lvls + 1) * sizeof(LSMLvl));
+    if (lvls == NULL)
+        return 1;
+
+    index->lvls = lvls;
+    lvl = &index->lvls[index->num_lvls];
+    (void)memset(lvl, 0, sizeof(LSMLvl));
+
+    /* run of TIERING lvl 0 is a flushed buffer, LEVELING lvl 0 holds size_ratio of them */
+    if (index->policy == DB_INDEX_LSM_TIERING && index->num_lvls == 0)
+        lvl->max_entries = prev;
+    else
+        lvl->max_entries = prev > (size_t)SSIZE_MAX / index->size_ratio ? (size_t)SSIZE_MAX : prev * index->size_ratio;
+
+    ++index->num_lvls;
+
+    return 0;
+}
+
+static double db_index_lsm_merge_into_lvl(DB_index_lsm *index, LSMLvl *src, size_t lvl)
+{
+    LSMLvl *dst = &index->lvls[lvl];
+    LSMLvl_stat *lvl_stat = &dst->stat;
+    size_t src_pages = 0;
+    size_t dst_pages = 0;
+    size_t written;
+    double time = 0.0;
+
+    ++lvl_stat->merges;
+
+    /* buffer is in RAM, LEVELING reads run of lvl too */
+    if (src != &index->buffer)
+        src_pages = db_index_lsm_pages_for_entries(index, src->num_entries);
+
+    if (index->policy == DB_INDEX_LSM_LEVELING)
+        dst_pages = db_index_lsm_pages_for_entries(index, dst->num_entries);
+
+    lvl_stat->pages_sread += src_pages + dst_pages;
+    time += ssd_sread_pages(index->ssd, src_pages + dst_pages);
+
+    written = src->num_entries + (index->policy == DB_INDEX_LSM_LEVELING ? dst->num_entries : 0);
+
+    dst->num_entries += src->num_entries;
+    dst->tombstones += src->tombstones;
+    dst->versions += src->versions;
+
+    /* in the deepest lvl tombstone removes itself and its entry, new version removes older one */
+    if (lvl + 1 == index->num_lvls)
+    {
+        size_t garbage = 2 * dst->tombstones + dst->versions;
+
+        if (garbage > dst->num_entries)
+            garbage = dst->num_entries;
+
+        dst->num_entries -= garbage;
+        written -= garbage < written ? garbage : written;
+        dst->tombstones = 0;
+        dst->versions = 0;
+        index->index_stat.garbage_dropped += garbage;
+    }
+
+    if (index->policy == DB_INDEX_LSM_LEVELING)
+        dst->runs = dst->num_entries > 0 ? 1 : 0;
+    else if (written > 0)
+        ++dst->runs;
+
+    if (written > 0)
+    {
+        const size_t pages = db_index_lsm_pages_for_entries(index, written);
+
+        lvl_stat->pages_swrite += pages;
+        time += ssd_swrite_pages(index->ssd, pages);
+    }
+
+    src->num_entries = 0;
+    src->tombstones = 0;
+    src->versions = 0;
+    src->runs = 0;
+
+    lvl_stat->time += time;
+
+    return time;
+}
+
+static double db_index_lsm_flush(DB_index_lsm *index)
+{
+    double time = 0.0;
+
+    if (index->num_lvls == 0 && db_index_lsm_add_lvl(index) != 0)
+        return DBINDEX_FDTREE_INVALID_TIME;
+
+    time += db_index_lsm_merge_into_lvl(index, &index->buffer, 0);
+
+    for (size_t lvl = 0; lvl < index->num_lvls; ++lvl)
+    {
+        const LSMLvl *lsmlvl = &index->lvls[lvl];
+        const bool full = index->policy == DB_INDEX_LSM_LEVELING ? lsmlvl->num_entries > lsmlvl->max_entries : lsmlvl->runs >= index->size_ratio;
+
+        if (!full)
+            break;
+
+        if (lvl + 1 == index->num_lvls && db_index_lsm_add_lvl(index) != 0)
+            return DBINDEX_FDTREE_INVALID_TIME;
+
+        time += db_index_lsm_merge_into_lvl(index, &index->lvls[lvl], lvl + 1);
+    }
+
+    return time;
+}
+
+static double db_index_lsm_put(DB_index_lsm *index, size_t entries, size_t *garbage)
+{
+    LSMLvl *buffer = &index->buffer;
+    const double cmps = buffer->max_entries > 1 ? log2((double)buffer->max_entries) : 1.0;
+    double time = 0.0;
+
+    index->index_stat.entries_written += entries;
+
+    /* the same CPU cost as HEAD of FDTree */
+    time += (double)entries * cmps * DBINDEX_FDTREE_HEAD_CMP_TIME;
+    index->buffer_time += time;
+
+    while (entries > 0)
+    {
+        const size_t room = buffer->max_entries - buffer->num_entries;
+        const size_t put = entries < room ? entries : room;
+
+        buffer->num_entries += put;
+        if (garbage != NULL)
+            *garbage += put;
+
+        entries -= put;
+
+        if (buffer->num_entries >= buffer->max_entries)
+            time += db_index_lsm_flush(index);
+    }
+
+    return time;
+}
+
+DB_index_lsm *db_index_lsm_create(SSD *ssd, DB_stat *stat, size_t key_size, size_t entry_size, size_t size_ratio, DB_index_lsm_policy policy)
+{
+    DB_index_lsm *index;
+
+    if (size_ratio < 2)
+        return NULL;
+
+    index = (DB_index_lsm *)calloc(1, sizeof(DB_index_lsm));
+    if (index == NULL)
+        return NULL;
+
+    index->ssd = ssd;
+    index->stat = stat;
+    index->key_size = key_size;
+    index->entry_size = entry_size;
+    index->size_ratio = size_ratio;
+    index->policy = policy;
+
+    index->buffer.max_entries = DBINDEX_LSM_BUFFER_PAGES * db_utils_entries_per_page(ssd->page_size, entry_size);
+    if (index->buffer.max_entries == 0)
+        index->buffer.max_entries = 1;
+
+    return index;
+}
+
+void db_index_lsm_destroy(DB_index_lsm *index)
+{
+    if (index == NULL)
+        return;
+
+    free(index->lvls);
+    free(index);
+}
+
+double db_index_lsm_insert(DB_index_lsm *index, size_t entries)
+{
+    double time;
+
+    index->num_entries += entries;
+    time = db_index_lsm_put(index, entries, NULL);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_lsm_bulkload(DB_index_lsm *index, size_t entries)
+{
+    double time = 0.0;
+    size_t pages;
+    size_t lvl;
+
+    if (entries == 0)
+    {
+        db_stat_update_query_time(index->stat, time);
+        return time;
+    }
+
+    if (index->num_entries > 0 || index->buffer.num_entries > 0)
+        return db_index_lsm_insert(index, entries);
+
+    /* the first lvl which can hold entries in one run */
+    for (lvl = 0; ; ++lvl)
+    {
+        if (lvl == index->num_lvls && db_index_lsm_add_lvl(index) != 0)
+        {
+            time = DBINDEX_FDTREE_INVALID_TIME;
+            db_stat_update_query_time(index->stat, time);
+            return time;
+        }
+
+        if (entries <= index->lvls[lvl].max_entries)
+            break;
+    }
+
+    index->num_entries = entries;
+    index->index_stat.entries_written += entries;
+
+    index->lvls[lvl].num_entries = entries;
+    index->lvls[lvl].runs = 1;
+    ++index->lvls[lvl].stat.merges;
+
+    pages = db_index_lsm_pages_for_entries(index, entries);
+    index->lvls[lvl].stat.pages_swrite += pages;
+    time += ssd_swrite_pages(index->ssd, pages);
+    index->lvls[lvl].stat.time += time;
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_lsm_point_search(DB_index_lsm *index, size_t entries)
+{
+    size_t pages = 0;
+    double time;
+
+    /* one page from every run */
+    for (size_t i = 0; i < index->num_lvls; ++i)
+    {
+        index->lvls[i].stat.pages_rread += index->lvls[i].runs * entries;
+        pages += index->lvls[i].runs;
+    }
+
+    index->index_stat.point_lookups += entries;
+
+    time = ssd_rread_pages(index->ssd, pages) * (double)entries;
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_lsm_range_search(DB_index_lsm *index, size_t entries)
+{
+    return db_index_lsm_range_search_repeat(index, entries, 1);
+}
+
+double db_index_lsm_range_search_repeat(DB_index_lsm *index, size_t entries, size_t queries)
+{
+    size_t runs = 0;
+    size_t stored = 0;
+    size_t pages;
+    double time = 0.0;
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+    {
+        index->lvls[i].stat.pages_rread += index->lvls[i].runs * queries;
+        runs += index->lvls[i].runs;
+        stored += index->lvls[i].num_entries;
+    }
+
+    /* range of live entries comes with garbage of runs */
+    if (index->num_entries > 0 && stored > index->num_entries)
+        entries = (size_t)((double)entries * (double)stored / (double)index->num_entries);
+
+    pages = db_index_lsm_pages_for_entries(index, entries);
+
+    /* find start point in every run */
+    time += ssd_rread_pages(index->ssd, runs);
+
+    /* read all entries */
+    time += ssd_sread_pages(index->ssd, pages);
+
+    /* index is not changed, so each search costs the same */
+    time *= (double)queries;
+
+    index->index_stat.range_searches += queries;
+    index->index_stat.range_pages_sread += pages * queries;
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_lsm_delete(DB_index_lsm *index, size_t entries)
+{
+    double time;
+
+    index->num_entries -= entries < index->num_entries ? entries : index->num_entries;
+    time = db_index_lsm_put(index, entries, &index->buffer.tombstones);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_lsm_update(DB_index_lsm *index, size_t entries)
+{
+    const double time = db_index_lsm_put(index, entries, &index->buffer.versions);
+
+    db_stat_update_query_time(index->stat, time);
+    return time;
+}
+
+double db_index_lsm_write_amplification(const DB_index_lsm *index)
+{
+    size_t pages = 0;
+
+    if (index->index_stat.entries_written == 0)
+        return 0.0;
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        pages += index->lvls[i].stat.pages_swrite;
+
+    return (double)(pages * index->ssd->page_size) / (double)(index->index_stat.entries_written * index->entry_size);
+}
+
+double db_index_lsm_read_amplification(const DB_index_lsm *index)
+{
+    size_t pages = 0;
+    const size_t searches = index->index_stat.point_lookups + index->index_stat.range_searches;
+
+    if (searches == 0)
+        return 0.0;
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        pages += index->lvls[i].stat.pages_rread;
+
+    return (double)pages / (double)searches;
+}
+
+double db_index_lsm_space_amplification(const DB_index_lsm *index)
+{
+    size_t pages = 0;
+
+    if (index->num_entries == 0)
+        return 0.0;
+
+    /* buffer is in RAM */
+    for (size_t i = 0; i < index->num_lvls; ++i)
+        pages += db_index_lsm_pages_for_entries(index, index->lvls[i].num_entries);
+
+    return (double)(pages * index->ssd->page_size) / (double)(index->num_entries * index->entry_size);
+}
+
+void db_index_lsm_stat_print(const DB_index_lsm *index)
+{
+    printf("LSM %s\n", db_index_lsm_policy_name(index->policy));
+    printf("\tSIZE          RATIO    = %zu\n", index->size_ratio);
+    printf("\tBUFFER        ENTRIES  = %zu\n", index->buffer.max_entries);
+    printf("\tBUFFER SORT   TIME     = %lfs\n", index->buffer_time);
+    printf("\tGARBAGE       DROPPED  = %zu\n", index->index_stat.garbage_dropped);
+
+    for (size_t i = 0; i < index->num_lvls; ++i)
+    {
+        const LSMLvl *lvl = &index->lvls[i];
+
+        printf("LVL %zu\n", i);
+        printf("\tRUNS                   = %zu\n", lvl->runs);
+        printf("\tENTRIES                = %zu\n", lvl->num_entries);
+        printf("\tMAX           ENTRIES  = %zu\n", lvl->max_entries);
+        printf("\tMERGES                 = %zu\n", lvl->stat.merges);
+        printf("\tSEQ   READ    PAGES    = %zu\n", lvl->stat.pages_sread);
+        printf("\tRAND  READ    PAGES    = %zu\n", lvl->stat.pages_rread);
+        printf("\tSEQ   WRITE   PAGES    = %zu\n", lvl->stat.pages_swrite);
+        printf("\tMERGE         TIME     = %lfs\n", lvl->stat.time);
+    }
+
+    printf("AMPLIFICATION\n");
+    printf("\tWRITE                  = %lf\n", db_index_lsm_write_amplification(index));
+    printf("\tREAD                   = %lf\n", db_index_lsm_read_amplification(index));
+    printf("\tSPACE                  = %lf\n", db_index_lsm_space_amplification(index));
+}
+
+const char *db_index_lsm_policy_name(DB_index_lsm_policy policy)
+{
+    switch (policy)
+    {
+        case DB_INDEX_LSM_LEVELING:
+            return "LEVELING";
+        case DB_INDEX_LSM_TIERING:
+            return "TIERING";
+        case DB_INDEX_LSM_NUM_POLICIES:
+        default:
+            return "UNKNOWN";
+    }
+}
@@ -0,0 +1,197 @@
+#include <dbkeyset.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define DB_KEYSET_MIN_CAPACITY 16
+
+/*
+    Get home slot of key
+
+    PARAMS
+    @IN set - pointer to set
+    @IN key - key
+
+    RETURN
+    Slot
+*/
+static inline size_t db_keyset_slot(const DB_keyset *set, uint64_t key);
+
+/*
+    Find slot of key or empty slot where key should be
+
+    PARAMS
+    @IN set - pointer to set
+    @IN key - key
+
+    RETURN
+    Slot
+*/
+static size_t db_keyset_find(const DB_keyset *set, uint64_t key);
+
+/*
+    Double capacity of set
+
+    PARAMS
+    @IN set - pointer to set
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_keyset_grow(DB_keyset *set);
+
+static inline size_t db_keyset_slot(const DB_keyset *set, uint64_t key)
+{
+    /* murmur3 finalizer */
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ULL;
+    key ^= key >> 33;
+
+    return (size_t)key & (set->capacity - 1);
+}
+
+static size_t db_keyset_find(const DB_keyset *set, uint64_t key)
+{
+    size_t slot = db_keyset_slot(set, key);
+
+    while (set->states[slot] != DB_KEYSET_NONE && set->keys[slot] != key)
+        slot = (slot + 1) & (set->capacity - 1);
+
+    return slot;
+}
+
+static int db_keyset_grow(DB_keyset *set)
+{
+    DB_keyset bigger;
+
+    if (db_keyset_init(&bigger, set->capacity * 2) != 0)
+        return 1;
+
+    for (size_t i = 0; i < set->capacity; ++i)
+        if (set->states[i] != DB_KEYSET_NONE)
+        {
+            const size_t slot = db_keyset_find(&bigger, set->keys[i]);
+
+            bigger.keys[slot] = set->keys[i];
+            bigger.states[slot] = set->states[i];
+        }
+
+    bigger.size = set->size;
+    bigger.tombstones = set->tombstones;
+
+    db_keyset_free(set);
+    *set = bigger;
+
+    return 0;
+}
+
+int db_keyset_init(DB_keyset *set, size_t capacity)
+{
+    size_t cap = DB_KEYSET_MIN_CAPACITY;
+
+    while (cap < capacity)
+        cap *= 2;
+
+    set->keys = (uint64_t *)malloc(sizeof(uint64_t) * cap);
+    set->states = (uint8_t *)calloc(cap, sizeof(uint8_t));
+    if (set->keys == NULL || set->states == NULL)
+    {
+        free(set->keys);
+        free(set->states);
+        set->keys = NULL;
+        set->states = NULL;
+        return 1;
+    }
+
+    set->capacity = cap;
+    set->size = 0;
+    set->tombstones = 0;
+
+    return 0;
+}
+
+void db_keyset_free(DB_keyset *set)
+{
+    free(set->keys);
+    free(set->states);
+    set->keys = NULL;
+    set->states = NULL;
+    set->capacity = 0;
+    set->size = 0;
+    set->tombstones = 0;
+}
+
+void db_keyset_clear(DB_keyset *set)
+{
+    if (set->size == 0)
+        return;
+
+    (void)memset(set->states, DB_KEYSET_NONE, set->capacity);
+    set->size = 0;
+    set->tombstones = 0;
+}
+
+DB_keyset_state db_keyset_get(const DB_keyset *set, uint64_t key)
+{
+    return (DB_keyset_state)set->states[db_keyset_find(set, key)];
+}
+
+int db_keyset_put(DB_keyset *set, uint64_t key, DB_keyset_state state)
+{
+    size_t slot;
+
+    if ((set->size + 1) * 4 > set->capacity * 3 && db_keyset_grow(set) != 0)
+        return 1;
+
+    slot = db_keyset_find(set, key);
+    if (set->states[slot] == DB_KEYSET_NONE)
+    {
+        set->keys[slot] = key;
+        ++set->size;
+    }
+    else if (set->states[slot] == DB_KEYSET_TOMBSTONE)
+        --set->tombstones;
+
+    if (state == DB_KEYSET_TOMBSTONE)
+        ++set->tombstones;
+
+    set->states[slot] = (uint8_t)state;
+
+    return 0;
+}
+
+void db_keyset_remove(DB_keyset *set, uint64_t key)
+{
+    size_t slot = db_keyset_find(set, key);
+    size_t next;
+
+    if (set->states[slot] == DB_KEYSET_NONE)
+        return;
+
+    if (set->states[slot] == DB_KEYSET_TOMBSTONE)
+        --set->tombstones;
+
+    --set->size;
+    set->states[slot] = DB_KEYSET_NONE;
+
+    /* shift back keys which cannot be found behind new hole */
+    next = (slot + 1) & (set->capacity - 1);
+    while (set->states[next] != DB_KEYSET_NONE)
+    {
+        const size_t home = db_keyset_slot(set, set->keys[next]);
+        const bool movable = slot <= next ? (home <= slot || home > next) : (home <= slot && home > next);
+
+        if (movable)
+        {
+            set->keys[slot] = set->keys[next];
+            set->states[slot] = set->states[next];
+            set->states[next] = DB_KEYSET_NONE;
+            slot = next;
+        }
+
+        next = (next + 1) & (set->capacity - 1);
+    }
+}
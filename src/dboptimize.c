@@ -0,0 +1,585 @@
+#include <dboptimize.h>
+#include <dbindex_fdtree.h>
+#include <dbstat.h>
+#include <dbutils.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* runs_ratio >= 2, so N < 2^64 needs less lvls */
+#define DB_OPTIMIZE_MAX_LVLS 64
+
+/*
+    Get wall time
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    Time in seconds
+*/
+static double db_optimize_now(void);
+
+/*
+    Get pages of entries with pointers of lvl (fractional, like in closed form)
+
+    PARAMS
+    @IN profile - pointer to profile
+    @IN entries - number of entries
+
+    RETURN
+    Number of pages
+*/
+static double db_optimize_pages(const DB_profile *profile, double entries);
+
+/*
+    Get bits needed by Bloom filters of lvls for fpr of lvl = min(1, lambda * keys of lvl)
+
+    PARAMS
+    @IN keys - keys of lvls
+    @IN lvls - number of lvls
+    @IN log_lambda - ln(lambda)
+
+    RETURN
+    Number of bits
+*/
+static double db_optimize_bloom_bits(const double *keys, size_t lvls, double log_lambda);
+
+/*
+    Allocate budget of Bloom filters over lvls like in Monkey (see FDBloom)
+
+    PARAMS
+    @IN keys - keys of lvls
+    @IN lvls - number of lvls
+    @IN bits - budget in bits
+    @OUT fpr - false positive rate of lvls
+
+    RETURN
+    This is a void function
+*/
+static void db_optimize_bloom_fpr(const double *keys, size_t lvls, double bits, double *fpr);
+
+/*
+    Compute closed form cost of configuration
+
+    PARAMS
+    @IN profile - pointer to profile
+    @IN request - pointer to request
+    @IN config - configuration, op_cost and cost are set
+
+    RETURN
+    This is a void function
+*/
+static void db_optimize_cost(const DB_profile *profile, const DB_optimize_request *request, DB_optimize_config *config);
+
+/*
+    Simulate mix on index model with configuration
+
+    PARAMS
+    @IN profile - pointer to profile
+    @IN request - pointer to request
+    @IN config - configuration, sim_cost and simulated are set
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_optimize_simulate(const DB_profile *profile, const DB_optimize_request *request, DB_optimize_config *config);
+
+/*
+    Put candidate into array of the best candidates sorted by closed form cost
+
+    PARAMS
+    @IN top - array of candidates
+    @IN num_top - number of candidates in array
+    @IN max_top - capacity of array
+    @IN config - candidate
+
+    RETURN
+    New number of candidates in array
+*/
+static size_t db_optimize_top_put(DB_optimize_config *top, size_t num_top, size_t max_top, const DB_optimize_config *config);
+
+static double db_optimize_now(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static double db_optimize_pages(const DB_profile *profile, double entries)
+{
+    const size_t entries_in_page = db_utils_entries_per_page(profile->ssd.page_size, profile->entry_size);
+    const size_t pointers_in_page = db_utils_entries_per_page(profile->ssd.page_size, profile->key_size + sizeof(void *));
+    const double entries_per_page = (double)entries_in_page;
+    const double pointers_per_page = (double)pointers_in_page;
+
+    return entries / entries_per_page * (1.0 + 1.0 / pointers_per_page);
+}
+
+static double db_optimize_bloom_bits(const double *keys, size_t lvls, double log_lambda)
+{
+    const double ln2_2 = log(2.0) * log(2.0);
+    double bits = 0.0;
+
+    for (size_t i = 0; i < lvls; ++i)
+        if (keys[i] > 0.0 && log_lambda + log(keys[i]) < 0.0)
+            bits += -keys[i] * (log_lambda + log(keys[i])) / ln2_2;
+
+    return bits;
+}
+
+static void db_optimize_bloom_fpr(const double *keys, size_t lvls, double bits, double *fpr)
+{
+    double min_keys = 0.0;
+    double max_keys = 0.0;
+    double lo;
+    double hi;
+
+    for (size_t i = 0; i < lvls; ++i)
+    {
+        fpr[i] = 1.0;
+        if (keys[i] > 0.0 && (min_keys == 0.0 || keys[i] < min_keys))
+            min_keys = keys[i];
+
+        if (keys[i] > max_keys)
+            max_keys = keys[i];
+    }
+
+    if (max_keys == 0.0 || bits <= 0.0)
+        return;
+
+    /* the same bisection as index does (see FDBloom) */
+    hi = -log(min_keys);
+    lo = -log(max_keys) - 64.0;
+    if (db_optimize_bloom_bits(keys, lvls, lo) > bits)
+        for (size_t iter = 0; iter < 100; ++iter)
+        {
+            const double mid = (lo + hi) / 2.0;
+
+            if (db_optimize_bloom_bits(keys, lvls, mid) > bits)
+                lo = mid;
+            else
+                hi = mid;
+        }
+    else
+        hi = lo;
+
+    for (size_t i = 0; i < lvls; ++i)
+        if (keys[i] > 0.0)
+            fpr[i] = exp(hi) * keys[i] < 1.0 ? exp(hi) * keys[i] : 1.0;
+}
+
+static void db_optimize_cost(const DB_profile *profile, const DB_optimize_request *request, DB_optimize_config *config)
+{
+    const SSD *ssd = &profile->ssd;
+    const double records = (double)request->records;
+    const double head = (double)(config->head_pages * db_utils_entries_per_page(ssd->page_size, profile->entry_size));
+    const size_t lvls = config->lvls;
+    const DB_workload_mix *mix = &request->mix;
+
+    double keys[DB_OPTIMIZE_MAX_LVLS];
+    double fpr[DB_OPTIMIZE_MAX_LVLS];
+    double cached[DB_OPTIMIZE_MAX_LVLS];
+    double capacity = head;
+    double left = records;
+    double src = head;
+    double write_io = 0.0;
+    double hashed = 0.0;
+    double write_cpu;
+    double below = 1.0;
+    double read = 0.0;
+    double scan = 0.0;
+    double pool_pages;
+    double scan_entries;
+    double absorbed;
+    double ratios = 0.0;
+
+    /* upper lvls are half full on average, the last lvl keeps rest of N */
+    for (size_t i = 0; i < lvls; ++i)
+    {
+        capacity *= (double)config->runs_ratio;
+        keys[i] = i + 1 < lvls ? (capacity / 2.0 < left ? capacity / 2.0 : left) : left;
+        left -= keys[i];
+    }
+
+    /* merge into lvl reads run of lvl - 1 (HEAD is in RAM) and lvl, then writes both */
+    capacity = head;
+    for (size_t i = 0; i < lvls; ++i)
+    {
+        const double ratio = keys[i] / src;
+        const double pages = db_optimize_pages(profile, 1.0);
+
+        write_io += pages * ((i > 0 ? 1.0 : 0.0) + ratio) * ssd->s_read_time;
+        write_io += pages * (1.0 + ratio) * ssd->s_write_time;
+        hashed += 1.0 + ratio;
+
+        capacity *= (double)config->runs_ratio;
+        src = capacity;
+    }
+
+    write_cpu = (head > 1.0 ? log2(head) : 1.0) * DBINDEX_FDTREE_HEAD_CMP_TIME;
+    if (config->bloom_bytes > 0)
+        write_cpu += hashed * DBINDEX_FDTREE_BLOOM_KEY_TIME;
+
+    /* pool keeps the upper lvls, they are read by every search */
+    pool_pages = config->pool_bytes > 0 ? (double)(config->pool_bytes / ssd->page_size) - (double)config->head_pages : 0.0;
+    for (size_t i = 0; i < lvls; ++i)
+    {
+        double pages = db_optimize_pages(profile, keys[i]);
+
+        if (pages < 1.0)
+            pages = 1.0;
+
+        cached[i] = pool_pages <= 0.0 ? 0.0 : (pool_pages >= pages ? 1.0 : pool_pages / pages);
+        pool_pages -= pages;
+    }
+
+    /* without filters every lvl is read, with filters lvl with key and false positives above it */
+    if (config->bloom_bytes > 0)
+        db_optimize_bloom_fpr(keys, lvls, (double)config->bloom_bytes * 8.0, fpr);
+
+    for (size_t i = 0; i < lvls; ++i)
+    {
+        double probes = 1.0;
+
+        if (config->bloom_bytes > 0)
+        {
+            const double found = records > 0.0 ? keys[i] / records : 0.0;
+
+            below -= found;
+            if (below < 0.0)
+                below = 0.0;
+
+            probes = found + fpr[i] * (records > 0.0 ? below : 1.0);
+        }
+
+        read += probes * (1.0 - cached[i]) * ssd->r_read_time;
+    }
+
+    scan_entries = request->selectivity > 0.0 ? request->selectivity * records : (double)(mix->scan_min + mix->scan_max) / 2.0;
+
+    /* scan finds start point in every lvl and streams whole pages of its part of range from SSD */
+    for (size_t i = 0; i < lvls; ++i)
+    {
+        const double entries = ceil(records > 0.0 ? scan_entries * keys[i] / records : 0.0);
+        const size_t pages = db_utils_pages_for_entries(ssd->page_size, profile->entry_size, entries > 1.0 ? (size_t)entries : 1);
+        const size_t pointer_pages = db_utils_pages_for_entries(ssd->page_size, profile->key_size + sizeof(void *), pages);
+
+        scan += (1.0 - cached[i]) * ssd->r_read_time + (double)(pages + pointer_pages) * ssd->s_read_time;
+    }
+
+    /* update of key buffered in HEAD does not reach SSD */
+    absorbed = records > 0.0 && head < records ? head / records : 1.0;
+
+    config->op_cost[DB_WORKLOAD_READ] = read;
+    config->op_cost[DB_WORKLOAD_INSERT] = write_io + write_cpu;
+    config->op_cost[DB_WORKLOAD_DELETE] = write_io + write_cpu;
+    config->op_cost[DB_WORKLOAD_UPDATE] = write_io * (1.0 - absorbed) + write_cpu;
+    config->op_cost[DB_WORKLOAD_SCAN] = scan;
+    config->op_cost[DB_WORKLOAD_RMW] = read + config->op_cost[DB_WORKLOAD_UPDATE];
+
+    config->cost = 0.0;
+    for (size_t i = 0; i < DB_WORKLOAD_OP_NUM; ++i)
+    {
+        config->cost += mix->ratio[i] * config->op_cost[i];
+        ratios += mix->ratio[i];
+    }
+
+    if (ratios > 0.0)
+        config->cost /= ratios;
+}
+
+static int db_optimize_simulate(const DB_profile *profile, const DB_optimize_request *request, DB_optimize_config *config)
+{
+    const DB_workload_mix *mix = &request->mix;
+    const size_t scan_entries = request->selectivity > 0.0 ? (size_t)(request->selectivity * (double)request->records) : (mix->scan_min + mix->scan_max) / 2;
+    double carry[DB_WORKLOAD_OP_NUM] = {0.0};
+    double ratios = 0.0;
+    double writes = 0.0;
+    double time = 0.0;
+    size_t sim_ops = request->sim_ops;
+    size_t done = 0;
+    size_t issued = 0;
+
+    DB_index_fdtree *index;
+    DB_stat *stat;
+    SSD *ssd;
+    int ret = 1;
+
+    for (size_t i = 0; i < DB_WORKLOAD_OP_NUM; ++i)
+        ratios += mix->ratio[i];
+
+    writes = mix->ratio[DB_WORKLOAD_INSERT] + mix->ratio[DB_WORKLOAD_DELETE] + mix->ratio[DB_WORKLOAD_UPDATE] + mix->ratio[DB_WORKLOAD_RMW];
+
+    /* writes have to flush HEAD a few times, otherwise big HEAD looks free */
+    if (writes > 0.0)
+    {
+        const double head = (double)(config->head_pages * db_utils_entries_per_page(profile->ssd.page_size, profile->entry_size));
+        const double flushes = DB_OPTIMIZE_SIM_FLUSHES * head * ratios / writes;
+        const double max_ops = (double)request->sim_ops * DB_OPTIMIZE_SIM_MAX_SCALE;
+
+        if (flushes > (double)sim_ops)
+            sim_ops = flushes < max_ops ? (size_t)flushes : (size_t)max_ops;
+    }
+
+    ssd = db_profile_ssd_create(profile);
+    stat = db_stat_create();
+    index = ssd != NULL && stat != NULL ? db_index_fdtree_create(ssd, stat, profile->key_size, profile->entry_size, config->runs_ratio) : NULL;
+    if (index == NULL)
+        goto out;
+
+    db_index_fdtree_set_io_depth(index, profile->io_depth);
+    if (db_index_fdtree_set_head_pages(index, config->head_pages) != 0 ||
+        db_index_fdtree_set_bloom(index, config->bloom_bytes) != 0 ||
+        db_index_fdtree_set_buffer_pool(index, profile->pool_policy, config->pool_bytes) != 0)
+        goto out;
+
+    (void)db_index_fdtree_insert(index, request->records);
+
+    /* mix is issued in rounds, part of operation which does not fit into round goes to next one */
+    while (done < sim_ops)
+    {
+        const size_t round = sim_ops - done < DB_OPTIMIZE_SIM_ROUND ? sim_ops - done : DB_OPTIMIZE_SIM_ROUND;
+
+        for (size_t i = 0; i < DB_WORKLOAD_OP_NUM; ++i)
+        {
+            const double expected = mix->ratio[i] / ratios * (double)round + carry[i];
+            const size_t ops = (size_t)expected;
+
+            carry[i] = expected - (double)ops;
+            if (ops == 0)
+                continue;
+
+            switch ((DB_workload_op_type)i)
+            {
+                case DB_WORKLOAD_READ:
+                    time += db_index_fdtree_point_search(index, ops);
+                    break;
+                case DB_WORKLOAD_UPDATE:
+                    time += db_index_fdtree_update(index, ops);
+                    break;
+                case DB_WORKLOAD_INSERT:
+                    time += db_index_fdtree_insert(index, ops);
+                    break;
+                case DB_WORKLOAD_DELETE:
+                    time += db_index_fdtree_delete(index, ops);
+                    break;
+                case DB_WORKLOAD_SCAN:
+                    time += db_index_fdtree_range_search_repeat(index, scan_entries, ops);
+                    break;
+                case DB_WORKLOAD_RMW:
+                    time += db_index_fdtree_point_search(index, ops);
+                    time += db_index_fdtree_update(index, ops);
+                    break;
+                case DB_WORKLOAD_OP_NUM:
+                default:
+                    break;
+            }
+
+            issued += ops;
+        }
+
+        done += round;
+    }
+
+    config->sim_cost = issued > 0 ? time / (double)issued : 0.0;
+    config->simulated = true;
+    ret = 0;
+
+out:
+    db_index_fdtree_destroy(index);
+    if (stat != NULL)
+        db_stat_destroy(stat);
+
+    if (ssd != NULL)
+        ssd_destroy(ssd);
+
+    return ret;
+}
+
+static size_t db_optimize_top_put(DB_optimize_config *top, size_t num_top, size_t max_top, const DB_optimize_config *config)
+{
+    size_t i;
+
+    if (num_top == max_top && config->cost >= top[num_top - 1].cost)
+        return num_top;
+
+    if (num_top < max_top)
+        ++num_top;
+
+    /* insertion sort, the worst candidate falls out */
+    for (i = num_top - 1; i > 0 && top[i - 1].cost > config->cost; --i)
+        top[i] = top[i - 1];
+
+    top[i] = *config;
+
+    return num_top;
+}
+
+DB_optimize_request db_optimize_request_default(const DB_workload_mix *mix, size_t records)
+{
+    DB_optimize_request request =
+    {
+        .mix = *mix,
+        .records = records,
+        .selectivity = 0.0,
+        .memory = 64 * 1024 * 1024,
+        .sim_ops = DB_OPTIMIZE_SIM_OPS,
+        .sim_candidates = DB_OPTIMIZE_SIM_CANDIDATES
+    };
+
+    return request;
+}
+
+int db_optimize_run(const DB_profile *profile, const DB_optimize_request *request, DB_optimize_result *result)
+{
+    const size_t page_size = profile->ssd.page_size;
+    const size_t entries_per_page = db_utils_entries_per_page(page_size, profile->entry_size);
+    const double start = db_optimize_now();
+    DB_optimize_config top[DB_OPTIMIZE_MAX_SIM];
+    size_t max_top = request->sim_candidates;
+    size_t num_top = 0;
+    double ratios = 0.0;
+
+    for (size_t i = 0; i < DB_WORKLOAD_OP_NUM; ++i)
+        ratios += request->mix.ratio[i];
+
+    if (request->records == 0 || ratios <= 0.0 || entries_per_page == 0)
+    {
+        fprintf(stderr, "optimize: records, mix and entries per page have to be positive\n");
+        return 1;
+    }
+
+    if (request->selectivity < 0.0 || request->selectivity > 1.0)
+    {
+        fprintf(stderr, "optimize: selectivity has to be in [0, 1]\n");
+        return 1;
+    }
+
+    if (max_top == 0)
+        max_top = 1;
+
+    if (max_top > DB_OPTIMIZE_MAX_SIM)
+        max_top = DB_OPTIMIZE_MAX_SIM;
+
+    (void)memset(result, 0, sizeof(*result));
+
+    /* HEAD takes at least 1 page even if RAM is smaller */
+    for (size_t head_pages = 1; head_pages == 1 || head_pages * page_size <= request->memory; head_pages *= 2)
+    {
+        const double head = (double)(head_pages * entries_per_page);
+        const size_t left = request->memory > head_pages * page_size ? request->memory - head_pages * page_size : 0;
+        size_t prev_ratio = 0;
+
+        /* ratio is given by number of lvls: capacity of the last lvl is just above N */
+        for (size_t lvls = 1; lvls <= DB_OPTIMIZE_MAX_LVLS; ++lvls)
+        {
+            DB_optimize_config config;
+            double ratio = ceil(pow((double)request->records / head, 1.0 / (double)lvls));
+
+            if (ratio < 2.0)
+                ratio = 2.0;
+
+            if ((size_t)ratio == prev_ratio)
+            {
+                if (ratio == 2.0)
+                    break;
+
+                continue;
+            }
+
+            prev_ratio = (size_t)ratio;
+
+            (void)memset(&config, 0, sizeof(config));
+            config.runs_ratio = (size_t)ratio;
+            config.head_pages = head_pages;
+
+            /* the fewest lvls with ratio which hold N */
+            config.lvls = 1;
+            for (double capacity = head * ratio; capacity < (double)request->records && config.lvls < DB_OPTIMIZE_MAX_LVLS; capacity *= ratio)
+                ++config.lvls;
+
+            for (size_t step = 0; step <= DB_OPTIMIZE_BLOOM_STEPS; ++step)
+            {
+                const size_t pool = left - left / DB_OPTIMIZE_BLOOM_STEPS * step;
+
+                config.bloom_bytes = left / DB_OPTIMIZE_BLOOM_STEPS * step;
+                config.pool_bytes = pool >= page_size ? pool + head_pages * page_size : 0;
+
+                db_optimize_cost(profile, request, &config);
+                num_top = db_optimize_top_put(top, num_top, max_top, &config);
+                ++result->candidates;
+            }
+        }
+    }
+
+    result->best = top[0];
+    if (request->sim_ops > 0)
+    {
+        for (size_t i = 0; i < num_top; ++i)
+        {
+            if (db_optimize_simulate(profile, request, &top[i]) != 0)
+            {
+                fprintf(stderr, "optimize: cannot simulate candidate\n");
+                return 1;
+            }
+
+            result->sim[result->num_sim++] = top[i];
+            if (top[i].sim_cost < result->best.sim_cost || !result->best.simulated)
+                result->best = top[i];
+        }
+    }
+
+    result->time = db_optimize_now() - start;
+
+    return 0;
+}
+
+void db_optimize_print(const DB_optimize_result *result)
+{
+    const DB_optimize_config *best = &result->best;
+
+    printf("OPTIMIZER\n");
+    printf("\tCANDIDATES             = %zu\n", result->candidates);
+    printf("\tSIMULATED              = %zu\n", result->num_sim);
+    printf("\tTIME                   = %lfs\n", result->time);
+
+    for (size_t i = 0; i < result->num_sim; ++i)
+    {
+        const DB_optimize_config *config = &result->sim[i];
+
+        printf("CANDIDATE %zu\n", i);
+        printf("\tRUNS          RATIO    = %zu (%zu lvls)\n", config->runs_ratio, config->lvls);
+        printf("\tHEAD          PAGES    = %zu\n", config->head_pages);
+        printf("\tBLOOM         BUDGET   = %zuB\n", config->bloom_bytes);
+        printf("\tBUFFER POOL            = %zuB\n", config->pool_bytes);
+        printf("\tPREDICTED     COST     = %lfus per op\n", config->cost * 1000000.0);
+        printf("\tSIMULATED     COST     = %lfus per op\n", config->sim_cost * 1000000.0);
+    }
+
+    printf("BEST\n");
+    printf("\tRUNS          RATIO    = %zu (%zu lvls)\n", best->runs_ratio, best->lvls);
+    printf("\tHEAD          PAGES    = %zu\n", best->head_pages);
+    printf("\tBLOOM         BUDGET   = %zuB\n", best->bloom_bytes);
+    printf("\tBUFFER POOL            = %zuB\n", best->pool_bytes);
+    for (size_t i = 0; i < DB_WORKLOAD_OP_NUM; ++i)
+        printf("\t%-6s        COST     = %lfus\n", db_workload_op_name((DB_workload_op_type)i), best->op_cost[i] * 1000000.0);
+
+    printf("\tPREDICTED     COST     = %lfus per op\n", best->cost * 1000000.0);
+    if (best->simulated)
+        printf("\tSIMULATED     COST     = %lfus per op\n", best->sim_cost * 1000000.0);
+
+    /* ready to paste into profile */
+    printf("PROFILE\n");
+    printf("\truns_ratio = %zu\n", best->runs_ratio);
+    printf("\thead_pages = %zu\n", best->head_pages);
+    if (best->bloom_bytes > 0)
+        printf("\tbloom_bytes = %zu\n", best->bloom_bytes);
+
+    if (best->pool_bytes > 0)
+        printf("\tpool_bytes = %zu\n", best->pool_bytes);
+}
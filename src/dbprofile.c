@@ -0,0 +1,746 @@
+#include <dbprofile.h>
+#include <dbindex_fdtree.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+
+#define DB_PROFILE_LINE_MAX 512
+#define DB_PROFILE_MICROSEC(n) ((n) / 1000000.0)
+
+typedef enum DB_profile_key
+{
+    DB_PROFILE_KEY_SSD,
+    DB_PROFILE_KEY_NAME,
+    DB_PROFILE_KEY_PAGE_SIZE,
+    DB_PROFILE_KEY_BLOCK_SIZE,
+    DB_PROFILE_KEY_BLOCKS,
+    DB_PROFILE_KEY_R_READ,
+    DB_PROFILE_KEY_R_WRITE,
+    DB_PROFILE_KEY_S_READ,
+    DB_PROFILE_KEY_S_WRITE,
+    DB_PROFILE_KEY_ERASE,
+    DB_PROFILE_KEY_BUS,
+    DB_PROFILE_KEY_CHANNELS,
+    DB_PROFILE_KEY_DIES_PER_CHANNEL,
+    DB_PROFILE_KEY_QUEUE_DEPTH,
+    DB_PROFILE_KEY_ENDURANCE,
+    DB_PROFILE_KEY_KEY_SIZE,
+    DB_PROFILE_KEY_ENTRY_SIZE,
+    DB_PROFILE_KEY_RUNS_RATIO,
+    DB_PROFILE_KEY_IO_DEPTH,
+    DB_PROFILE_KEY_MEMORY_BYTES,
+    DB_PROFILE_KEY_HEAD_PAGES,
+    DB_PROFILE_KEY_HEAD_BYTES,
+    DB_PROFILE_KEY_BLOOM_BYTES,
+    DB_PROFILE_KEY_POOL_BYTES,
+    DB_PROFILE_KEY_POOL_POLICY,
+    DB_PROFILE_KEY_MERGE_BUDGET,
+    DB_PROFILE_KEY_RUNS_RATIOS,
+    DB_PROFILE_KEY_MAX_RUNS_RATIO,
+    DB_PROFILE_NUM_KEYS
+} DB_profile_key;
+
+typedef enum DB_profile_type
+{
+    DB_PROFILE_TEXT,
+    DB_PROFILE_SIZE, /* positive integer */
+    DB_PROFILE_TIME /* positive time in microseconds */
+} DB_profile_type;
+
+typedef struct DB_profile_key_desc
+{
+    const char *key;
+    DB_profile_type type;
+    bool required; /* required iff SSD has no base */
+} DB_profile_key_desc;
+
+/* parsed but not validated profile */
+typedef struct DB_profile_values
+{
+    bool set[DB_PROFILE_NUM_KEYS];
+    size_t line[DB_PROFILE_NUM_KEYS];
+    size_t size[DB_PROFILE_NUM_KEYS];
+    double time[DB_PROFILE_NUM_KEYS];
+    char text[DB_PROFILE_NUM_KEYS][DB_PROFILE_NAME_MAX];
+} DB_profile_values;
+
+typedef struct DB_profile_base
+{
+    const char *name;
+    SSD *(*create)(void);
+} DB_profile_base;
+
+static const DB_profile_key_desc db_profile_keys[DB_PROFILE_NUM_KEYS] =
+{
+    [DB_PROFILE_KEY_SSD] = {"ssd", DB_PROFILE_TEXT, false},
+    [DB_PROFILE_KEY_NAME] = {"name", DB_PROFILE_TEXT, false},
+    [DB_PROFILE_KEY_PAGE_SIZE] = {"page_size", DB_PROFILE_SIZE, true},
+    [DB_PROFILE_KEY_BLOCK_SIZE] = {"block_size", DB_PROFILE_SIZE, true},
+    [DB_PROFILE_KEY_BLOCKS] = {"blocks", DB_PROFILE_SIZE, true},
+    [DB_PROFILE_KEY_R_READ] = {"r_read_us", DB_PROFILE_TIME, true},
+    [DB_PROFILE_KEY_R_WRITE] = {"r_write_us", DB_PROFILE_TIME, true},
+    [DB_PROFILE_KEY_S_READ] = {"s_read_us", DB_PROFILE_TIME, true},
+    [DB_PROFILE_KEY_S_WRITE] = {"s_write_us", DB_PROFILE_TIME, true},
+    [DB_PROFILE_KEY_ERASE] = {"erase_us", DB_PROFILE_TIME, false},
+    [DB_PROFILE_KEY_BUS] = {"bus_us", DB_PROFILE_TIME, false},
+    [DB_PROFILE_KEY_CHANNELS] = {"channels", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_DIES_PER_CHANNEL] = {"dies_per_channel", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_QUEUE_DEPTH] = {"queue_depth", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_ENDURANCE] = {"endurance", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_KEY_SIZE] = {"key_size", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_ENTRY_SIZE] = {"entry_size", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_RUNS_RATIO] = {"runs_ratio", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_IO_DEPTH] = {"io_depth", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_MEMORY_BYTES] = {"memory_bytes", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_HEAD_PAGES] = {"head_pages", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_HEAD_BYTES] = {"head_bytes", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_BLOOM_BYTES] = {"bloom_bytes", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_POOL_BYTES] = {"pool_bytes", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_POOL_POLICY] = {"pool_policy", DB_PROFILE_TEXT, false},
+    [DB_PROFILE_KEY_MERGE_BUDGET] = {"merge_budget_pages", DB_PROFILE_SIZE, false},
+    [DB_PROFILE_KEY_RUNS_RATIOS] = {"runs_ratios", DB_PROFILE_TEXT, false},
+    [DB_PROFILE_KEY_MAX_RUNS_RATIO] = {"max_runs_ratio", DB_PROFILE_SIZE, false}
+};
+
+static const DB_profile_base db_profile_bases[] =
+{
+    {"samsung840", ssd_create_samsung840},
+    {"intelDCP4511", ssd_create_intelDCP4511},
+    {"toshibaVX500", ssd_create_toshibaVX500}
+};
+
+/*
+    Print error of profile on stderr
+
+    PARAMS
+    @IN path - path of profile file
+    @IN line - line of error (0 - error of whole profile)
+    @IN fmt - printf format of message
+    @IN ... - arguments of format
+
+    RETURN
+    This is a void function
+*/
+static void db_profile_error(const char *path, size_t line, const char *fmt, ...);
+
+/*
+    Remove white characters from both sides of string
+
+    PARAMS
+    @IN str - string (modified in place)
+
+    RETURN
+    Pointer to first not white character of str
+*/
+static char *db_profile_trim(char *str);
+
+/*
+    Parse positive integer
+
+    PARAMS
+    @IN str - string
+    @OUT val - parsed value
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_profile_parse_size(const char *str, size_t *val);
+
+/*
+    Parse positive finite real number
+
+    PARAMS
+    @IN str - string
+    @OUT val - parsed value
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_profile_parse_time(const char *str, double *val);
+
+/*
+    Parse list of ratios of lvls "r0,r1,..."
+
+    PARAMS
+    @IN str - string
+    @OUT profile - runs_ratios and num_runs_ratios are set
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_profile_parse_ratios(const char *str, DB_profile *profile);
+
+/*
+    Parse one "key = value" line
+
+    PARAMS
+    @IN path - path of profile file
+    @IN line - number of line
+    @IN str - line without comment
+    @OUT values - values of profile
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_profile_parse_line(const char *path, size_t line, char *str, DB_profile_values *values);
+
+/*
+    Build profile from parsed values
+
+    PARAMS
+    @IN path - path of profile file
+    @IN values - values of profile
+    @OUT profile - profile (not validated)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_profile_build(const char *path, const DB_profile_values *values, DB_profile *profile);
+
+/*
+    Check if profile describes valid SSD and index
+
+    PARAMS
+    @IN path - path of profile file
+    @IN profile - pointer to profile
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_profile_validate(const char *path, const DB_profile *profile);
+
+static void db_profile_error(const char *path, size_t line, const char *fmt, ...)
+{
+    va_list args;
+
+    if (line > 0)
+        fprintf(stderr, "%s:%zu: ", path, line);
+    else
+        fprintf(stderr, "%s: ", path);
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+
+    fprintf(stderr, "\n");
+}
+
+static char *db_profile_trim(char *str)
+{
+    size_t len;
+
+    while (isspace((unsigned char)*str))
+        ++str;
+
+    len = strlen(str);
+    while (len > 0 && isspace((unsigned char)str[len - 1]))
+        str[--len] = '\0';
+
+    return str;
+}
+
+static int db_profile_parse_size(const char *str, size_t *val)
+{
+    unsigned long long v;
+    char *end;
+
+    if (!isdigit((unsigned char)*str))
+        return 1;
+
+    errno = 0;
+    v = strtoull(str, &end, 10);
+    if (errno != 0 || *end != '\0' || v == 0 || v > (unsigned long long)SIZE_MAX)
+        return 1;
+
+    *val = (size_t)v;
+
+    return 0;
+}
+
+static int db_profile_parse_ratios(const char *str, DB_profile *profile)
+{
+    char buf[DB_PROFILE_NAME_MAX];
+    char *save;
+    size_t num = 0;
+
+    (void)strncpy(buf, str, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    for (char *tok = strtok_r(buf, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save))
+    {
+        size_t ratio;
+
+        if (num == DB_PROFILE_MAX_RUNS_RATIOS || db_profile_parse_size(db_profile_trim(tok), &ratio) != 0 || ratio < 2)
+            return 1;
+
+        profile->runs_ratios[num++] = ratio;
+    }
+
+    if (num == 0)
+        return 1;
+
+    profile->num_runs_ratios = num;
+
+    return 0;
+}
+
+static int db_profile_parse_time(const char *str, double *val)
+{
+    double v;
+    char *end;
+
+    if (*str == '\0')
+        return 1;
+
+    errno = 0;
+    v = strtod(str, &end);
+    if (errno != 0 || *end != '\0' || !isfinite(v) || v <= 0.0)
+        return 1;
+
+    *val = v;
+
+    return 0;
+}
+
+static int db_profile_parse_line(const char *path, size_t line, char *str, DB_profile_values *values)
+{
+    char *eq;
+    char *key;
+    char *val;
+    size_t i;
+
+    eq = strchr(str, '=');
+    if (eq == NULL)
+    {
+        db_profile_error(path, line, "expected \"key = value\", got \"%s\"", str);
+        return 1;
+    }
+
+    *eq = '\0';
+    key = db_profile_trim(str);
+    val = db_profile_trim(eq + 1);
+
+    for (i = 0; i < DB_PROFILE_NUM_KEYS; ++i)
+        if (strcmp(key, db_profile_keys[i].key) == 0)
+            break;
+
+    if (i == DB_PROFILE_NUM_KEYS)
+    {
+        db_profile_error(path, line, "unknown key \"%s\"", key);
+        return 1;
+    }
+
+    if (values->set[i])
+    {
+        db_profile_error(path, line, "duplicate key \"%s\" (first set in line %zu)", key, values->line[i]);
+        return 1;
+    }
+
+    switch (db_profile_keys[i].type)
+    {
+        case DB_PROFILE_TEXT:
+        {
+            if (*val == '\0' || strlen(val) >= DB_PROFILE_NAME_MAX)
+            {
+                db_profile_error(path, line, "\"%s\" has to have from 1 to %d characters", key, DB_PROFILE_NAME_MAX - 1);
+                return 1;
+            }
+
+            (void)strcpy(values->text[i], val);
+
+            break;
+        }
+        case DB_PROFILE_SIZE:
+        {
+            if (db_profile_parse_size(val, &values->size[i]) != 0)
+            {
+                db_profile_error(path, line, "\"%s\" has to be positive integer, got \"%s\"", key, val);
+                return 1;
+            }
+
+            break;
+        }
+        case DB_PROFILE_TIME:
+        {
+            if (db_profile_parse_time(val, &values->time[i]) != 0)
+            {
+                db_profile_error(path, line, "\"%s\" has to be positive number of microseconds, got \"%s\"", key, val);
+                return 1;
+            }
+
+            break;
+        }
+        default:
+        {
+            return 1;
+        }
+    }
+
+    values->set[i] = true;
+    values->line[i] = line;
+
+    return 0;
+}
+
+static int db_profile_build(const char *path, const DB_profile_values *values, DB_profile *profile)
+{
+    SSD *ssd = &profile->ssd;
+    int ret = 0;
+
+    (void)memset(profile, 0, sizeof(*profile));
+
+    if (values->set[DB_PROFILE_KEY_SSD])
+    {
+        SSD *base = NULL;
+
+        for (size_t i = 0; i < sizeof(db_profile_bases) / sizeof(db_profile_bases[0]); ++i)
+            if (strcmp(values->text[DB_PROFILE_KEY_SSD], db_profile_bases[i].name) == 0)
+                base = db_profile_bases[i].create();
+
+        if (base == NULL)
+        {
+            db_profile_error(path, values->line[DB_PROFILE_KEY_SSD], "unknown ssd \"%s\" (samsung840, intelDCP4511, toshibaVX500)", values->text[DB_PROFILE_KEY_SSD]);
+            return 1;
+        }
+
+        *ssd = *base;
+        (void)strcpy(profile->name, base->name);
+        ssd_destroy(base);
+    }
+    else
+    {
+        for (size_t i = 0; i < DB_PROFILE_NUM_KEYS; ++i)
+            if (db_profile_keys[i].required && !values->set[i])
+            {
+                db_profile_error(path, 0, "missing key \"%s\" (required without \"ssd\" base)", db_profile_keys[i].key);
+                ret = 1;
+            }
+
+        if (ret != 0)
+            return ret;
+
+        (void)strcpy(profile->name, "custom");
+        ssd->channels = 1;
+        ssd->dies_per_channel = 1;
+        ssd->queue_depth = 1;
+        ssd->endurance = DB_PROFILE_ENDURANCE;
+    }
+
+    ssd->ftl = NULL;
+    ssd->dirty_pages = 0;
+    ssd->stat.pages_written = 0;
+    ssd->stat.blocks_erased = 0;
+
+#define DB_PROFILE_SET_SIZE(key, field) do { if (values->set[key]) field = values->size[key]; } while (0)
+#define DB_PROFILE_SET_TIME(key, field) do { if (values->set[key]) field = DB_PROFILE_MICROSEC(values->time[key]); } while (0)
+
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_PAGE_SIZE, ssd->page_size);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_BLOCK_SIZE, ssd->block_size);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_BLOCKS, ssd->blocks);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_CHANNELS, ssd->channels);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_DIES_PER_CHANNEL, ssd->dies_per_channel);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_QUEUE_DEPTH, ssd->queue_depth);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_ENDURANCE, ssd->endurance);
+    DB_PROFILE_SET_TIME(DB_PROFILE_KEY_R_READ, ssd->r_read_time);
+    DB_PROFILE_SET_TIME(DB_PROFILE_KEY_R_WRITE, ssd->r_write_time);
+    DB_PROFILE_SET_TIME(DB_PROFILE_KEY_S_READ, ssd->s_read_time);
+    DB_PROFILE_SET_TIME(DB_PROFILE_KEY_S_WRITE, ssd->s_write_time);
+    DB_PROFILE_SET_TIME(DB_PROFILE_KEY_ERASE, ssd->erase_time);
+    DB_PROFILE_SET_TIME(DB_PROFILE_KEY_BUS, ssd->bus_time);
+
+    profile->key_size = DB_PROFILE_KEY_SIZE;
+    profile->entry_size = DB_PROFILE_ENTRY_SIZE;
+    profile->runs_ratio = DBINDEX_FDTREE_RUNS_RATIO;
+    profile->io_depth = 1;
+    profile->memory_bytes = DB_PROFILE_MEMORY_BYTES;
+    profile->head_pages = 1;
+
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_KEY_SIZE, profile->key_size);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_ENTRY_SIZE, profile->entry_size);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_RUNS_RATIO, profile->runs_ratio);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_IO_DEPTH, profile->io_depth);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_MEMORY_BYTES, profile->memory_bytes);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_HEAD_PAGES, profile->head_pages);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_BLOOM_BYTES, profile->bloom_bytes);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_POOL_BYTES, profile->pool_bytes);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_MERGE_BUDGET, profile->merge_budget);
+    DB_PROFILE_SET_SIZE(DB_PROFILE_KEY_MAX_RUNS_RATIO, profile->max_runs_ratio);
+
+#undef DB_PROFILE_SET_SIZE
+#undef DB_PROFILE_SET_TIME
+
+    /* defaults which depend on other parameters */
+    if (!values->set[DB_PROFILE_KEY_SSD])
+    {
+        if (!values->set[DB_PROFILE_KEY_ERASE] && ssd->page_size > 0)
+            ssd->erase_time = ssd->r_write_time * 10.0 * (double)(ssd->block_size / ssd->page_size);
+
+        /* interface is at least SATA, but cannot be slower than sequential read */
+        if (!values->set[DB_PROFILE_KEY_BUS])
+        {
+            ssd->bus_time = SSD_BUS_TIME(ssd->page_size, SSD_SATA_BANDWIDTH);
+            if (ssd->bus_time > ssd->s_read_time)
+                ssd->bus_time = ssd->s_read_time;
+        }
+    }
+
+    if (values->set[DB_PROFILE_KEY_HEAD_BYTES])
+    {
+        if (values->set[DB_PROFILE_KEY_HEAD_PAGES])
+        {
+            db_profile_error(path, values->line[DB_PROFILE_KEY_HEAD_BYTES], "\"head_bytes\" cannot be used with \"head_pages\" (line %zu)", values->line[DB_PROFILE_KEY_HEAD_PAGES]);
+            return 1;
+        }
+
+        /* HEAD has at least 1 page */
+        profile->head_pages = ssd->page_size > 0 ? values->size[DB_PROFILE_KEY_HEAD_BYTES] / ssd->page_size : 0;
+        if (profile->head_pages == 0)
+            profile->head_pages = 1;
+    }
+
+    /* HEAD lives in RAM */
+    if (ssd->page_size > 0 && profile->head_pages > profile->memory_bytes / ssd->page_size)
+    {
+        const DB_profile_key key = values->set[DB_PROFILE_KEY_HEAD_BYTES] ? DB_PROFILE_KEY_HEAD_BYTES : DB_PROFILE_KEY_HEAD_PAGES;
+
+        db_profile_error(path, values->line[key], "HEAD (%zu pages of %zu bytes) cannot be bigger than memory_bytes (%zu)", profile->head_pages, ssd->page_size, profile->memory_bytes);
+        return 1;
+    }
+
+    if (values->set[DB_PROFILE_KEY_NAME])
+        (void)strcpy(profile->name, values->text[DB_PROFILE_KEY_NAME]);
+
+    profile->pool_policy = DB_BUFPOOL_LRU;
+    if (values->set[DB_PROFILE_KEY_POOL_POLICY] && db_bufpool_policy_parse(values->text[DB_PROFILE_KEY_POOL_POLICY], &profile->pool_policy) != 0)
+    {
+        db_profile_error(path, values->line[DB_PROFILE_KEY_POOL_POLICY], "unknown pool_policy \"%s\" (lru, clock, pinned)", values->text[DB_PROFILE_KEY_POOL_POLICY]);
+        return 1;
+    }
+
+    if (values->set[DB_PROFILE_KEY_RUNS_RATIOS])
+    {
+        if (values->set[DB_PROFILE_KEY_RUNS_RATIO])
+        {
+            db_profile_error(path, values->line[DB_PROFILE_KEY_RUNS_RATIOS], "\"runs_ratios\" cannot be used with \"runs_ratio\" (line %zu)", values->line[DB_PROFILE_KEY_RUNS_RATIO]);
+            return 1;
+        }
+
+        if (db_profile_parse_ratios(values->text[DB_PROFILE_KEY_RUNS_RATIOS], profile) != 0)
+        {
+            db_profile_error(path, values->line[DB_PROFILE_KEY_RUNS_RATIOS], "\"runs_ratios\" has to be list of at most %d integers >= 2 separated by ',', got \"%s\"", DB_PROFILE_MAX_RUNS_RATIOS, values->text[DB_PROFILE_KEY_RUNS_RATIOS]);
+            return 1;
+        }
+
+        /* index is created with ratio of lvl 0 */
+        profile->runs_ratio = profile->runs_ratios[0];
+    }
+
+    ssd->name = profile->name;
+
+    return 0;
+}
+
+static int db_profile_validate(const char *path, const DB_profile *profile)
+{
+    const SSD *ssd = &profile->ssd;
+    int ret = 0;
+
+    if (ssd->block_size % ssd->page_size != 0)
+    {
+        db_profile_error(path, 0, "block_size (%zu) has to be multiple of page_size (%zu)", ssd->block_size, ssd->page_size);
+        ret = 1;
+    }
+
+    if (ssd->s_read_time > ssd->r_read_time)
+    {
+        db_profile_error(path, 0, "s_read_us (%lf) cannot be bigger than r_read_us (%lf)", ssd->s_read_time * 1000000.0, ssd->r_read_time * 1000000.0);
+        ret = 1;
+    }
+
+    if (ssd->s_write_time > ssd->r_write_time)
+    {
+        db_profile_error(path, 0, "s_write_us (%lf) cannot be bigger than r_write_us (%lf)", ssd->s_write_time * 1000000.0, ssd->r_write_time * 1000000.0);
+        ret = 1;
+    }
+
+    if (ssd->bus_time > ssd->s_read_time)
+    {
+        db_profile_error(path, 0, "bus_us (%lf) cannot be bigger than s_read_us (%lf)", ssd->bus_time * 1000000.0, ssd->s_read_time * 1000000.0);
+        ret = 1;
+    }
+
+    if (profile->entry_size <= profile->key_size)
+    {
+        db_profile_error(path, 0, "entry_size (%zu) has to be bigger than key_size (%zu)", profile->entry_size, profile->key_size);
+        ret = 1;
+    }
+
+    if (profile->entry_size > ssd->page_size)
+    {
+        db_profile_error(path, 0, "entry_size (%zu) cannot be bigger than page_size (%zu)", profile->entry_size, ssd->page_size);
+        ret = 1;
+    }
+
+    if (profile->runs_ratio < 2)
+    {
+        db_profile_error(path, 0, "runs_ratio (%zu) has to be at least 2", profile->runs_ratio);
+        ret = 1;
+    }
+
+    return ret;
+}
+
+int db_profile_default(DB_profile *profile)
+{
+    SSD *ssd;
+
+    ssd = ssd_create_samsung840();
+    if (ssd == NULL)
+        return 1;
+
+    (void)memset(profile, 0, sizeof(*profile));
+    profile->ssd = *ssd;
+    (void)strcpy(profile->name, ssd->name);
+    profile->ssd.name = profile->name;
+    profile->key_size = DB_PROFILE_KEY_SIZE;
+    profile->entry_size = DB_PROFILE_ENTRY_SIZE;
+    profile->runs_ratio = DBINDEX_FDTREE_RUNS_RATIO;
+    profile->io_depth = 1;
+    profile->memory_bytes = DB_PROFILE_MEMORY_BYTES;
+    profile->head_pages = 1;
+
+    ssd_destroy(ssd);
+
+    return 0;
+}
+
+int db_profile_load(const char *path, DB_profile *profile)
+{
+    DB_profile_values values;
+    char buf[DB_PROFILE_LINE_MAX];
+    FILE *file;
+    size_t line = 0;
+    int ret = 0;
+
+    file = fopen(path, "r");
+    if (file == NULL)
+    {
+        db_profile_error(path, 0, "cannot open: %s", strerror(errno));
+        return 1;
+    }
+
+    (void)memset(&values, 0, sizeof(values));
+
+    while (fgets(buf, sizeof(buf), file) != NULL)
+    {
+        char *comment;
+        char *str;
+
+        ++line;
+
+        if (strchr(buf, '\n') == NULL && !feof(file))
+        {
+            int c;
+
+            db_profile_error(path, line, "line is longer than %d characters", DB_PROFILE_LINE_MAX - 2);
+            ret = 1;
+
+            /* skip rest of line */
+            while ((c = fgetc(file)) != EOF && c != '\n')
+                ;
+
+            continue;
+        }
+
+        comment = strchr(buf, '#');
+        if (comment != NULL)
+            *comment = '\0';
+
+        str = db_profile_trim(buf);
+        if (*str == '\0')
+            continue;
+
+        if (db_profile_parse_line(path, line, str, &values) != 0)
+            ret = 1;
+    }
+
+    if (ferror(file))
+    {
+        db_profile_error(path, 0, "cannot read: %s", strerror(errno));
+        ret = 1;
+    }
+
+    (void)fclose(file);
+
+    if (ret != 0)
+        return ret;
+
+    if (db_profile_build(path, &values, profile) != 0)
+        return 1;
+
+    return db_profile_validate(path, profile);
+}
+
+SSD *db_profile_ssd_create(const DB_profile *profile)
+{
+    SSD *ssd;
+
+    ssd = ssd_create_empty(profile->name);
+    if (ssd == NULL)
+        return NULL;
+
+    *ssd = profile->ssd;
+    ssd->name = profile->name;
+
+    return ssd;
+}
+
+void db_profile_print(const DB_profile *profile)
+{
+    const SSD *ssd = &profile->ssd;
+
+    printf("PROFILE %s\n", profile->name);
+    printf("\tPAGE          SIZE     = %zu\n", ssd->page_size);
+    printf("\tBLOCK         SIZE     = %zu\n", ssd->block_size);
+    printf("\tBLOCKS                 = %zu\n", ssd->blocks);
+    printf("\tRAND  READ    TIME     = %lfus\n", ssd->r_read_time * 1000000.0);
+    printf("\tRAND  WRITE   TIME     = %lfus\n", ssd->r_write_time * 1000000.0);
+    printf("\tSEQ   READ    TIME     = %lfus\n", ssd->s_read_time * 1000000.0);
+    printf("\tSEQ   WRITE   TIME     = %lfus\n", ssd->s_write_time * 1000000.0);
+    printf("\tERASE         TIME     = %lfus\n", ssd->erase_time * 1000000.0);
+    printf("\tBUS           TIME     = %lfus\n", ssd->bus_time * 1000000.0);
+    printf("\tPARALLELISM            = %zu x %zu, QD %zu\n", ssd->channels, ssd->dies_per_channel, ssd->queue_depth);
+    printf("\tENDURANCE     P/E      = %zu\n", ssd->endurance);
+    printf("\tKEY           SIZE     = %zu\n", profile->key_size);
+    printf("\tENTRY         SIZE     = %zu\n", profile->entry_size);
+    if (profile->num_runs_ratios > 0)
+    {
+        printf("\tRUNS          RATIOS   =");
+        for (size_t i = 0; i < profile->num_runs_ratios; ++i)
+            printf(" %zu", profile->runs_ratios[i]);
+
+        printf("\n");
+    }
+    else
+        printf("\tRUNS          RATIO    = %zu\n", profile->runs_ratio);
+
+    printf("\tMAX   RUNS    RATIO    = %zu\n", profile->max_runs_ratio);
+    printf("\tIO            DEPTH    = %zu\n", profile->io_depth);
+    printf("\tMEMORY                 = %zuB\n", profile->memory_bytes);
+    printf("\tHEAD          PAGES    = %zu\n", profile->head_pages);
+    printf("\tBLOOM         BUDGET   = %zuB\n", profile->bloom_bytes);
+    printf("\tBUFFER POOL            = %zuB %s\n", profile->pool_bytes, db_bufpool_policy_name(profile->pool_policy));
+    printf("\tMERGE         BUDGET   = %zu pages per write\n", profile->merge_budget);
+}
@@ -0,0 +1,643 @@
+#include <dbsim.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+/* Query waiting for device or for end of merge */
+typedef struct DB_sim_query
+{
+    double arrival;
+    double service; /* device time of search, remaining time of merge */
+    double merge; /* time of merge started by write */
+    double cpu; /* CPU time of write, it does not need device */
+    DB_stat_op op;
+} DB_sim_query;
+
+typedef struct DB_sim_fifo
+{
+    DB_sim_query *queries;
+    size_t head;
+    size_t tail;
+    size_t max_queries;
+} DB_sim_fifo;
+
+typedef struct DB_sim
+{
+    DB_index_fdtree *index;
+    const DB_sim_config *config;
+    DB_sim_result *result;
+
+    DB_sim_queue events;
+
+    DB_sim_fifo searches;
+    DB_sim_fifo merges; /* service is remaining time of merge */
+    DB_sim_fifo stalled;
+
+    /* device state */
+    bool busy;
+    bool serving_search;
+    DB_sim_query current;
+    double current_start;
+
+    size_t arrived;
+    uint64_t rand_state;
+} DB_sim;
+
+/*
+    Get next pseudo random number (xorshift64*)
+
+    PARAMS
+    @IN state - pointer to generator state
+
+    RETURN
+    Uniform random number in range [0.0, 1.0)
+*/
+static double db_sim_rand(uint64_t *state);
+
+/*
+    Add query at the end of FIFO
+
+    PARAMS
+    @IN fifo - pointer to FIFO
+    @IN query - pointer to query
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_sim_fifo_push(DB_sim_fifo *fifo, const DB_sim_query *query);
+
+/*
+    Get number of queries in FIFO
+
+    PARAMS
+    @IN fifo - pointer to FIFO
+
+    RETURN
+    Number of queries
+*/
+static size_t db_sim_fifo_size(const DB_sim_fifo *fifo);
+
+/*
+    Draw operation from workload mix
+
+    PARAMS
+    @IN sim - pointer to simulation
+
+    RETURN
+    Operation
+*/
+static DB_stat_op db_sim_draw_op(DB_sim *sim);
+
+/*
+    Run query on index cost model
+
+    PARAMS
+    @IN sim - pointer to simulation
+    @IN op - operation
+
+    RETURN
+    Time returned by index
+*/
+static double db_sim_index_query(DB_sim *sim, DB_stat_op op);
+
+/*
+    Record response and queueing time of query
+
+    PARAMS
+    @IN sim - pointer to simulation
+    @IN query - pointer to query
+    @IN start - time when service has started
+    @IN finish - time when query has finished
+
+    RETURN
+    This is a void function
+*/
+static void db_sim_record(DB_sim *sim, const DB_sim_query *query, double start, double finish);
+
+/*
+    Release stalled writes which do not have to wait for merge
+
+    PARAMS
+    @IN sim - pointer to simulation
+    @IN now - current time
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_sim_release_stalled(DB_sim *sim, double now);
+
+/*
+    Start next job on idle device: search first, then slice of the oldest merge
+
+    PARAMS
+    @IN sim - pointer to simulation
+    @IN now - current time
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_sim_dispatch(DB_sim *sim, double now);
+
+/*
+    Handle arrival of query
+
+    PARAMS
+    @IN sim - pointer to simulation
+    @IN now - current time
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_sim_arrival(DB_sim *sim, double now);
+
+/*
+    Handle end of job on device
+
+    PARAMS
+    @IN sim - pointer to simulation
+    @IN now - current time
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_sim_device_done(DB_sim *sim, double now);
+
+static double db_sim_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+
+    return (double)((x * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int db_sim_fifo_push(DB_sim_fifo *fifo, const DB_sim_query *query)
+{
+    if (fifo->tail == fifo->max_queries)
+    {
+        const size_t size = fifo->tail - fifo->head;
+
+        /* compact or grow */
+        if (fifo->head >= fifo->max_queries / 2 && fifo->head > 0)
+        {
+            for (size_t i = 0; i < size; ++i)
+                fifo->queries[i] = fifo->queries[fifo->head + i];
+        }
+        else
+        {
+            const size_t max_queries = fifo->max_queries == 0 ? 64 : fifo->max_queries * 2;
+            DB_sim_query *queries = (DB_sim_query *)realloc(fifo->queries, max_queries * sizeof(DB_sim_query));
+
+            if (queries == NULL)
+                return 1;
+
+            for (size_t i = 0; i < size; ++i)
+                queries[i] = queries[fifo->head + i];
+
+            fifo->queries = queries;
+            fifo->max_queries = max_queries;
+        }
+
+        fifo->head = 0;
+        fifo->tail = size;
+    }
+
+    fifo->queries[fifo->tail++] = *query;
+
+    return 0;
+}
+
+static size_t db_sim_fifo_size(const DB_sim_fifo *fifo)
+{
+    return fifo->tail - fifo->head;
+}
+
+static DB_stat_op db_sim_draw_op(DB_sim *sim)
+{
+    const double *mix = sim->config->mix;
+    double sum = 0.0;
+    double r;
+
+    for (size_t i = 0; i < DB_STAT_OP_NUM; ++i)
+        if (i != DB_STAT_OP_BULKLOAD)
+            sum += mix[i];
+
+    r = db_sim_rand(&sim->rand_state) * sum;
+    for (size_t i = 0; i < DB_STAT_OP_NUM; ++i)
+    {
+        if (i == DB_STAT_OP_BULKLOAD || mix[i] <= 0.0)
+            continue;
+
+        if (r < mix[i])
+            return (DB_stat_op)i;
+
+        r -= mix[i];
+    }
+
+    return DB_STAT_OP_POINT_SEARCH;
+}
+
+static double db_sim_index_query(DB_sim *sim, DB_stat_op op)
+{
+    DB_index_fdtree *index = sim->index;
+    double time = 0.0;
+
+    db_stat_start_query(index->stat, op);
+    switch (op)
+    {
+        case DB_STAT_OP_INSERT:
+        {
+            time = db_index_fdtree_insert(index, 1);
+            break;
+        }
+        case DB_STAT_OP_DELETE:
+        {
+            time = db_index_fdtree_delete(index, 1);
+            break;
+        }
+        case DB_STAT_OP_UPDATE:
+        {
+            time = db_index_fdtree_update(index, 1);
+            break;
+        }
+        case DB_STAT_OP_RANGE_SEARCH:
+        {
+            time = db_index_fdtree_range_search(index, sim->config->range_entries);
+            break;
+        }
+        case DB_STAT_OP_POINT_SEARCH:
+        case DB_STAT_OP_BULKLOAD:
+        case DB_STAT_OP_NUM:
+        default:
+        {
+            time = db_index_fdtree_point_search(index, 1);
+            break;
+        }
+    }
+    db_stat_finish_query(index->stat);
+
+    return time;
+}
+
+static void db_sim_record(DB_sim *sim, const DB_sim_query *query, double start, double finish)
+{
+    db_hist_record(&sim->result->queueing[query->op], start - query->arrival, 1);
+    db_hist_record(&sim->result->response[query->op], finish - query->arrival, 1);
+    ++sim->result->queries;
+}
+
+static int db_sim_release_stalled(DB_sim *sim, double now)
+{
+    DB_sim_fifo *stalled = &sim->stalled;
+
+    while (db_sim_fifo_size(stalled) > 0)
+    {
+        DB_sim_query *query = &stalled->queries[stalled->head];
+
+        /* next head flush still has to wait */
+        if (query->merge > 0.0 && db_sim_fifo_size(&sim->merges) > 0)
+            break;
+
+        if (query->merge > 0.0)
+        {
+            const DB_sim_query merge = {.arrival = now, .service = query->merge, .merge = query->merge, .cpu = 0.0, .op = query->op};
+
+            if (db_sim_fifo_push(&sim->merges, &merge) != 0)
+                return 1;
+        }
+
+        db_sim_record(sim, query, now, now + query->cpu);
+        ++stalled->head;
+    }
+
+    return 0;
+}
+
+static int db_sim_dispatch(DB_sim *sim, double now)
+{
+    double finish;
+
+    if (sim->busy)
+        return 0;
+
+    if (db_sim_fifo_size(&sim->searches) > 0)
+    {
+        sim->current = sim->searches.queries[sim->searches.head++];
+        sim->serving_search = true;
+        finish = now + sim->current.service;
+    }
+    else if (db_sim_fifo_size(&sim->merges) > 0)
+    {
+        const double remaining = sim->merges.queries[sim->merges.head].service;
+        const double slice = sim->config->merge_slice > 0.0 && sim->config->merge_slice < remaining ? sim->config->merge_slice : remaining;
+
+        sim->current.service = slice;
+        sim->serving_search = false;
+        finish = now + slice;
+    }
+    else
+        return 0;
+
+    sim->busy = true;
+    sim->current_start = now;
+
+    return db_sim_queue_push(&sim->events, finish, DB_SIM_EVENT_DEVICE_DONE);
+}
+
+static int db_sim_arrival(DB_sim *sim, double now)
+{
+    const DB_stat_op op = db_sim_draw_op(sim);
+    const double time = db_sim_index_query(sim, op);
+    DB_sim_query query = {.arrival = now, .service = 0.0, .merge = 0.0, .cpu = 0.0, .op = op};
+
+    ++sim->arrived;
+
+    if (op == DB_STAT_OP_POINT_SEARCH || op == DB_STAT_OP_RANGE_SEARCH)
+    {
+        query.service = time;
+        if (db_sim_fifo_push(&sim->searches, &query) != 0)
+            return 1;
+
+        if (db_sim_fifo_size(&sim->searches) > sim->result->max_queue)
+            sim->result->max_queue = db_sim_fifo_size(&sim->searches);
+    }
+    else
+    {
+        /* write goes to head tree in RAM (only CPU), only merge needs device */
+        const double merge = sim->index->last_merge_time;
+
+        query.merge = merge;
+        query.cpu = sim->index->last_head_time;
+
+        if (db_sim_fifo_size(&sim->stalled) > 0 || (merge > 0.0 && db_sim_fifo_size(&sim->merges) > 0))
+        {
+            if (merge > 0.0)
+                ++sim->result->stalls;
+
+            if (db_sim_fifo_push(&sim->stalled, &query) != 0)
+                return 1;
+        }
+        else
+        {
+            if (merge > 0.0)
+            {
+                query.service = merge;
+                if (db_sim_fifo_push(&sim->merges, &query) != 0)
+                    return 1;
+            }
+
+            db_sim_record(sim, &query, now, now + query.cpu);
+        }
+    }
+
+    if (sim->arrived < sim->config->queries)
+    {
+        /* exponential interarrival time */
+        const double next = now - log(1.0 - db_sim_rand(&sim->rand_state)) / sim->config->arrival_rate;
+
+        if (db_sim_queue_push(&sim->events, next, DB_SIM_EVENT_ARRIVAL) != 0)
+            return 1;
+    }
+
+    return db_sim_dispatch(sim, now);
+}
+
+static int db_sim_device_done(DB_sim *sim, double now)
+{
+    sim->busy = false;
+
+    if (sim->serving_search)
+    {
+        sim->result->foreground_time += now - sim->current_start;
+        db_sim_record(sim, &sim->current, sim->current_start, now);
+    }
+    else
+    {
+        DB_sim_query *merge = &sim->merges.queries[sim->merges.head];
+
+        sim->result->background_time += now - sim->current_start;
+        merge->service -= sim->current.service;
+
+        if (merge->service <= 0.0)
+        {
+            ++sim->merges.head;
+            ++sim->result->merges;
+
+            if (db_sim_release_stalled(sim, now) != 0)
+                return 1;
+        }
+    }
+
+    return db_sim_dispatch(sim, now);
+}
+
+void db_sim_queue_init(DB_sim_queue *queue)
+{
+    queue->events = NULL;
+    queue->num_events = 0;
+    queue->max_events = 0;
+    queue->seq = 0;
+}
+
+void db_sim_queue_destroy(DB_sim_queue *queue)
+{
+    free(queue->events);
+    db_sim_queue_init(queue);
+}
+
+int db_sim_queue_push(DB_sim_queue *queue, double time, DB_sim_event_type type)
+{
+    DB_sim_event *events;
+    size_t pos;
+
+    if (queue->num_events == queue->max_events)
+    {
+        const size_t max_events = queue->max_events == 0 ? 16 : queue->max_events * 2;
+
+        events = (DB_sim_event *)realloc(queue->events, max_events * sizeof(DB_sim_event));
+        if (events == NULL)
+            return 1;
+
+        queue->events = events;
+        queue->max_events = max_events;
+    }
+
+    events = queue->events;
+    pos = queue->num_events++;
+
+    while (pos > 0)
+    {
+        const size_t parent = (pos - 1) / 2;
+
+        if (events[parent].time <= time)
+            break;
+
+        events[pos] = events[parent];
+        pos = parent;
+    }
+
+    events[pos].time = time;
+    events[pos].seq = queue->seq++;
+    events[pos].type = type;
+
+    return 0;
+}
+
+bool db_sim_queue_pop(DB_sim_queue *queue, DB_sim_event *event)
+{
+    DB_sim_event *events = queue->events;
+    DB_sim_event last;
+    size_t pos = 0;
+
+    if (queue->num_events == 0)
+        return false;
+
+    *event = events[0];
+    last = events[--queue->num_events];
+
+    for (;;)
+    {
+        size_t child = 2 * pos + 1;
+
+        if (child >= queue->num_events)
+            break;
+
+        if (child + 1 < queue->num_events &&
+            (events[child + 1].time < events[child].time || (events[child + 1].time == events[child].time && events[child + 1].seq < events[child].seq)))
+            ++child;
+
+        if (last.time < events[child].time || (last.time == events[child].time && last.seq < events[child].seq))
+            break;
+
+        events[pos] = events[child];
+        pos = child;
+    }
+
+    events[pos] = last;
+
+    return true;
+}
+
+DB_sim_config db_sim_config_default(const SSD *ssd, size_t queries, double arrival_rate)
+{
+    const size_t pages_per_block = ssd_pages_per_block(ssd);
+    DB_sim_config config =
+    {
+        .preload = queries,
+        .queries = queries,
+        .arrival_rate = arrival_rate,
+        .mix = {0},
+        .range_entries = 1000,
+        .merge_slice = ssd->s_write_time * (double)pages_per_block,
+        .seed = 0x9E3779B97F4A7C15ULL
+    };
+
+    config.mix[DB_STAT_OP_INSERT] = 50.0;
+    config.mix[DB_STAT_OP_POINT_SEARCH] = 40.0;
+    config.mix[DB_STAT_OP_RANGE_SEARCH] = 5.0;
+    config.mix[DB_STAT_OP_DELETE] = 5.0;
+
+    return config;
+}
+
+DB_sim_result *db_sim_run(DB_index_fdtree *index, const DB_sim_config *config)
+{
+    DB_sim sim = {0};
+    DB_sim_event event;
+    int err = 0;
+
+    if (config->arrival_rate <= 0.0)
+        return NULL;
+
+    sim.result = (DB_sim_result *)calloc(1, sizeof(DB_sim_result));
+    if (sim.result == NULL)
+        return NULL;
+
+    sim.index = index;
+    sim.config = config;
+    sim.rand_state = config->seed != 0 ? config->seed : 1;
+    db_sim_queue_init(&sim.events);
+
+    if (config->preload > 0)
+    {
+        db_stat_start_query(index->stat, DB_STAT_OP_BULKLOAD);
+        db_index_fdtree_bulkload(index, config->preload);
+        db_stat_finish_query(index->stat);
+    }
+
+    if (config->queries > 0)
+        err = db_sim_queue_push(&sim.events, 0.0, DB_SIM_EVENT_ARRIVAL);
+
+    while (err == 0 && db_sim_queue_pop(&sim.events, &event))
+    {
+        sim.result->clock = event.time;
+
+        if (event.type == DB_SIM_EVENT_ARRIVAL)
+            err = db_sim_arrival(&sim, event.time);
+        else
+            err = db_sim_device_done(&sim, event.time);
+    }
+
+    db_sim_queue_destroy(&sim.events);
+    free(sim.searches.queries);
+    free(sim.merges.queries);
+    free(sim.stalled.queries);
+
+    if (err != 0)
+    {
+        free(sim.result);
+        return NULL;
+    }
+
+    return sim.result;
+}
+
+void db_sim_result_destroy(DB_sim_result *result)
+{
+    free(result);
+}
+
+double db_sim_result_throughput(const DB_sim_result *result)
+{
+    if (result->clock <= 0.0)
+        return 0.0;
+
+    return (double)result->queries / result->clock;
+}
+
+void db_sim_result_print(const DB_sim_result *result)
+{
+    printf("SIMULATION\n");
+    printf("\tQUERIES                = %zu\n", result->queries);
+    printf("\tCLOCK         TIME     = %lfs\n", result->clock);
+    printf("\tTHROUGHPUT    QPS      = %lf\n", db_sim_result_throughput(result));
+    printf("\tSEARCH        TIME     = %lfs\n", result->foreground_time);
+    printf("\tMERGE         TIME     = %lfs\n", result->background_time);
+    printf("\tUTILIZATION            = %lf\n", result->clock > 0.0 ? (result->foreground_time + result->background_time) / result->clock : 0.0);
+    printf("\tMERGES                 = %zu\n", result->merges);
+    printf("\tSTALLS                 = %zu\n", result->stalls);
+    printf("\tMAX   QUEUE            = %zu\n", result->max_queue);
+
+    for (size_t i = 0; i < DB_STAT_OP_NUM; ++i)
+    {
+        if (result->response[i].count == 0)
+            continue;
+
+        printf("%s\n", db_stat_op_name((DB_stat_op)i));
+        printf("\tCOUNT                  = %zu\n", (size_t)result->response[i].count);
+        printf("\tQUEUE P50     TIME     = %lfs\n", db_hist_percentile(&result->queueing[i], 50.0));
+        printf("\tQUEUE P99     TIME     = %lfs\n", db_hist_percentile(&result->queueing[i], 99.0));
+        printf("\tRESP  P50     TIME     = %lfs\n", db_hist_percentile(&result->response[i], 50.0));
+        printf("\tRESP  P99     TIME     = %lfs\n", db_hist_percentile(&result->response[i], 99.0));
+        printf("\tRESP  P99.9   TIME     = %lfs\n", db_hist_percentile(&result->response[i], 99.9));
+        printf("\tRESP  MAX     TIME     = %lfs\n", db_hist_max(&result->response[i]));
+    }
+}
@@ -1,9 +1,8 @@
 #include <dbstat.h>
 #include <string.h>
 #include <stdio.h>
-
-DB_snapshot db_current_query;
-DB_snapshot db_total;
+#include <stdlib.h>
+#include <inttypes.h>
 
 /*
     Print on stdout info about snapshot
@@ -14,44 +13,201 @@ DB_snapshot db_total;
     RETURN
     This is a void function
 */
-static inline void __db_stat_print(DB_snapshot *sh);
+static inline void __db_stat_print(const DB_snapshot *sh);
+
+/*
+    Print on stdout latency percentiles
+
+    PARAMS
+    @IN name - name of operation
+    @IN hist - pointer to histogram
+
+    RETURN
+    This is a void function
+*/
+static void __db_hist_print(const char *name, const DB_histogram *hist);
 
-static inline void __db_stat_print(DB_snapshot *sh)
+/*
+    Get the highest value in bucket
+
+    PARAMS
+    @IN bucket - index of bucket
+
+    RETURN
+    Highest value in nanoseconds which goes to bucket
+*/
+static uint64_t __db_hist_bucket_highest(size_t bucket);
+
+static const char *const db_stat_op_names[DB_STAT_OP_NUM] =
 {
+    [DB_STAT_OP_INSERT] = "INSERT",
+    [DB_STAT_OP_BULKLOAD] = "BULKLOAD",
+    [DB_STAT_OP_POINT_SEARCH] = "POINT SEARCH",
+    [DB_STAT_OP_RANGE_SEARCH] = "RANGE SEARCH",
+    [DB_STAT_OP_DELETE] = "DELETE",
+    [DB_STAT_OP_UPDATE] = "UPDATE"
+};
+
+static uint64_t __db_hist_bucket_highest(size_t bucket)
+{
+    size_t exp;
+    uint64_t sub;
+
+    if (bucket < DB_HIST_SUB_BUCKETS)
+        return (uint64_t)bucket;
+
+    exp = (bucket >> DB_HIST_SUB_BUCKET_BITS) - 1;
+    sub = (uint64_t)(bucket & (DB_HIST_SUB_BUCKETS - 1)) | (uint64_t)DB_HIST_SUB_BUCKETS;
+
+    /* last bucket is open */
+    if (exp + DB_HIST_SUB_BUCKET_BITS >= 63 && sub == 2 * DB_HIST_SUB_BUCKETS - 1)
+        return UINT64_MAX;
+
+    return ((sub + 1) << exp) - 1;
+}
+
+static void __db_hist_print(const char *name, const DB_histogram *hist)
+{
+    printf("%s\n", name);
+    printf("\tCOUNT                  = %" PRIu64 "\n", hist->count);
+    printf("\tP50           TIME     = %lfs\n", db_hist_percentile(hist, 50.0));
+    printf("\tP99           TIME     = %lfs\n", db_hist_percentile(hist, 99.0));
+    printf("\tP99.9         TIME     = %lfs\n", db_hist_percentile(hist, 99.9));
+    printf("\tMAX           TIME     = %lfs\n", db_hist_max(hist));
+}
+
+static inline void __db_stat_print(const DB_snapshot *sh)
+{
+    printf("\tQUERIES                = %zu\n", sh->queries);
     printf("\tQUERY         TIME     = %lfs\n", sh->query_time);
     printf("\tTOTAL         TIME     = %lfs\n", __db_stat_get_time(sh));
 }
 
-void db_stat_reset(void)
+double db_hist_percentile(const DB_histogram *hist, double percentile)
 {
-    (void)memset(&db_current_query, 0, sizeof(db_current_query));
-    (void)memset(&db_total, 0, sizeof(db_total));
+    uint64_t rank;
+    uint64_t seen = 0;
+    uint64_t ns;
+
+    if (hist->count == 0)
+        return 0.0;
+
+    /* rank of value at percentile, starting from 1 */
+    rank = (uint64_t)((percentile / 100.0) * (double)hist->count + 0.5);
+    if (rank == 0)
+        rank = 1;
+
+    if (rank > hist->count)
+        rank = hist->count;
+
+    for (size_t i = 0; i < DB_HIST_BUCKETS; ++i)
+    {
+        seen += hist->counts[i];
+        if (seen >= rank)
+        {
+            ns = __db_hist_bucket_highest(i);
+            if (ns > hist->max)
+                ns = hist->max;
+
+            return (double)ns / 1000000000.0;
+        }
+    }
+
+    return db_hist_max(hist);
+}
+
+double db_hist_max(const DB_histogram *hist)
+{
+    return (double)hist->max / 1000000000.0;
+}
+
+void db_hist_merge(DB_histogram *dst, const DB_histogram *src)
+{
+    for (size_t i = 0; i < DB_HIST_BUCKETS; ++i)
+        dst->counts[i] += src->counts[i];
+
+    dst->count += src->count;
+    if (src->max > dst->max)
+        dst->max = src->max;
+}
+
+const char *db_stat_op_name(DB_stat_op op)
+{
+    if (op >= DB_STAT_OP_NUM)
+        return "UNKNOWN";
+
+    return db_stat_op_names[op];
+}
+
+DB_stat *db_stat_create(void)
+{
+    return (DB_stat *)calloc(1, sizeof(DB_stat));
+}
+
+void db_stat_destroy(DB_stat *stat)
+{
+    if (stat == NULL)
+        return;
+
+    free(stat);
+}
+
+void db_stat_reset(DB_stat *stat)
+{
+    (void)memset(stat, 0, sizeof(*stat));
+}
+
+void db_stat_reset_query(DB_stat *stat)
+{
+    (void)memset(&stat->current_query, 0, sizeof(stat->current_query));
 }
 
-void db_stat_reset_query(void)
+void db_stat_start_query(DB_stat *stat, DB_stat_op op)
 {
-    (void)memset(&db_current_query, 0, sizeof(db_current_query));
+    db_stat_start_queries(stat, op, 1);
 }
 
-void db_stat_start_query(void)
+void db_stat_start_queries(DB_stat *stat, DB_stat_op op, size_t queries)
 {
-    db_stat_reset_query();
+    db_stat_reset_query(stat);
+    stat->current_query.queries = queries;
+    stat->current_op = op;
 }
 
-void db_stat_finish_query(void)
+void db_stat_finish_query(DB_stat *stat)
 {
     /* update total */
-    db_total.query_time += db_current_query.query_time;
+    stat->total.query_time += stat->current_query.query_time;
+    stat->total.queries += stat->current_query.queries;
+
+    /* all queries in batch are the same */
+    if (stat->current_query.queries > 0)
+        db_hist_record(&stat->latency[stat->current_op],
+                       stat->current_query.query_time / (double)stat->current_query.queries,
+                       stat->current_query.queries);
+}
+
+void db_stat_merge(DB_stat *dst, const DB_stat *src)
+{
+    dst->total.query_time += src->total.query_time;
+    dst->total.queries += src->total.queries;
+
+    for (size_t i = 0; i < DB_STAT_OP_NUM; ++i)
+        db_hist_merge(&dst->latency[i], &src->latency[i]);
 }
 
-void db_stat_current_print(void)
+void db_stat_current_print(const DB_stat *stat)
 {
     printf("CURRENT QUERY\n");
-    __db_stat_print(&db_current_query);
+    __db_stat_print(&stat->current_query);
 }
 
-void db_stat_summary_print(void)
+void db_stat_summary_print(const DB_stat *stat)
 {
     printf("TOTAL\n");
-    __db_stat_print(&db_total);
-}
\ No newline at end of file
+    __db_stat_print(&stat->total);
+
+    for (size_t i = 0; i < DB_STAT_OP_NUM; ++i)
+        if (stat->latency[i].count > 0)
+            __db_hist_print(db_stat_op_names[i], &stat->latency[i]);
+}
@@ -0,0 +1,277 @@
+#include <dbsweep.h>
+#include <experiments.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+/* Tasks of one worker: owner takes from bottom, thieves take from top */
+typedef struct DB_sweep_deque
+{
+    pthread_mutex_t lock;
+    size_t *tasks;
+    size_t top;
+    size_t bottom;
+} DB_sweep_deque;
+
+typedef struct DB_sweep_pool
+{
+    const DB_sweep_grid *grid;
+    DB_sweep_result *results;
+    DB_sweep_deque *deques;
+    size_t num_workers;
+} DB_sweep_pool;
+
+typedef struct DB_sweep_worker
+{
+    DB_sweep_pool *pool;
+    size_t id;
+
+    /* statistics of all points run by worker, only worker writes here */
+    DB_stat shard;
+} DB_sweep_worker;
+
+/*
+    Fill grid parameters of point
+
+    PARAMS
+    @IN grid - pointer to grid
+    @IN point - index of point in grid
+    @OUT result - result with parameters of point
+    @OUT ssd - index of SSD of point (constructors first, then profiles)
+
+    RETURN
+    This is a void function
+*/
+static void db_sweep_grid_point(const DB_sweep_grid *grid, size_t point, DB_sweep_result *result, size_t *ssd);
+
+/*
+    Take task from own deque (bottom) or steal from another one (top)
+
+    PARAMS
+    @IN pool - pointer to pool
+    @IN id - id of worker
+    @OUT task - taken task
+
+    RETURN
+    false iff there is no task in pool
+*/
+static bool db_sweep_pool_take(DB_sweep_pool *pool, size_t id, size_t *task);
+
+/*
+    Run experiment for grid point
+
+    PARAMS
+    @IN worker - pointer to worker
+    @IN point - index of point in grid
+
+    RETURN
+    This is a void function
+*/
+static void db_sweep_run_point(DB_sweep_worker *worker, size_t point);
+
+/*
+    Worker main loop
+
+    PARAMS
+    @IN arg - pointer to DB_sweep_worker
+
+    RETURN
+    NULL
+*/
+static void *db_sweep_worker_main(void *arg);
+
+static void db_sweep_grid_point(const DB_sweep_grid *grid, size_t point, DB_sweep_result *result, size_t *ssd)
+{
+    const size_t q = point % grid->num_queries;
+    point /= grid->num_queries;
+
+    const size_t e = point % grid->num_entries;
+    point /= grid->num_entries;
+
+    const size_t r = point % grid->num_runs_ratios;
+    point /= grid->num_runs_ratios;
+
+    *ssd = point;
+
+    result->runs_ratio = grid->runs_ratios[r];
+    result->key_size = grid->key_sizes[e];
+    result->entry_size = grid->entry_sizes[e];
+    result->queries = grid->queries[q];
+}
+
+static bool db_sweep_pool_take(DB_sweep_pool *pool, size_t id, size_t *task)
+{
+    DB_sweep_deque *deque = &pool->deques[id];
+    bool found = false;
+
+    (void)pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top)
+    {
+        *task = deque->tasks[--deque->bottom];
+        found = true;
+    }
+    (void)pthread_mutex_unlock(&deque->lock);
+
+    /* own deque is empty, try to steal */
+    for (size_t i = 1; i < pool->num_workers && !found; ++i)
+    {
+        deque = &pool->deques[(id + i) % pool->num_workers];
+
+        (void)pthread_mutex_lock(&deque->lock);
+        if (deque->bottom > deque->top)
+        {
+            *task = deque->tasks[deque->top++];
+            found = true;
+        }
+        (void)pthread_mutex_unlock(&deque->lock);
+    }
+
+    return found;
+}
+
+static void db_sweep_run_point(DB_sweep_worker *worker, size_t point)
+{
+    DB_sweep_result *result = &worker->pool->results[point];
+    const DB_sweep_grid *grid = worker->pool->grid;
+    DB_stat stat;
+    SSD *ssd;
+    size_t i;
+
+    db_sweep_grid_point(grid, point, result, &i);
+
+    result->ssd_name = "";
+
+    ssd = i < grid->num_ssds ? grid->ssds[i]() : db_profile_ssd_create(&grid->profiles[i - grid->num_ssds]);
+    if (ssd == NULL)
+        return;
+
+    result->ssd_name = ssd->name;
+    result->total = db_index_fdtree_experiment_workload_run(&stat, ssd, result->key_size, result->entry_size, result->runs_ratio, result->queries);
+    result->lifetime_days = ssd_lifetime_days(ssd, (double)result->total.queries, grid->ops_per_second);
+    db_stat_merge(&worker->shard, &stat);
+
+    ssd_destroy(ssd);
+}
+
+static void *db_sweep_worker_main(void *arg)
+{
+    DB_sweep_worker *worker = (DB_sweep_worker *)arg;
+    size_t point;
+
+    while (db_sweep_pool_take(worker->pool, worker->id, &point))
+        db_sweep_run_point(worker, point);
+
+    return NULL;
+}
+
+size_t db_sweep_grid_size(const DB_sweep_grid *grid)
+{
+    return (grid->num_ssds + grid->num_profiles) * grid->num_runs_ratios * grid->num_entries * grid->num_queries;
+}
+
+DB_sweep_result *db_sweep_run(const DB_sweep_grid *grid, size_t threads, DB_stat *total)
+{
+    DB_sweep_pool pool;
+    DB_sweep_worker *workers;
+    pthread_t *tids;
+    size_t *tasks;
+    size_t started = 0;
+    const size_t points = db_sweep_grid_size(grid);
+
+    if (threads == 0)
+    {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    if (points == 0)
+        return NULL;
+
+    if (threads > points)
+        threads = points;
+
+    pool.grid = grid;
+    pool.num_workers = threads;
+    pool.results = (DB_sweep_result *)calloc(points, sizeof(DB_sweep_result));
+    pool.deques = (DB_sweep_deque *)calloc(threads, sizeof(DB_sweep_deque));
+    workers = (DB_sweep_worker *)calloc(threads, sizeof(DB_sweep_worker));
+    tids = (pthread_t *)calloc(threads, sizeof(pthread_t));
+    tasks = (size_t *)malloc(points * sizeof(size_t));
+
+    if (pool.results == NULL || pool.deques == NULL || workers == NULL || tids == NULL || tasks == NULL)
+    {
+        free(pool.results);
+        free(pool.deques);
+        free(workers);
+        free(tids);
+        free(tasks);
+
+        return NULL;
+    }
+
+    /* give every worker contiguous part of grid, neighbours have similar cost */
+    for (size_t i = 0; i < threads; ++i)
+    {
+        const size_t first = points * i / threads;
+        const size_t last = points * (i + 1) / threads;
+
+        (void)pthread_mutex_init(&pool.deques[i].lock, NULL);
+        pool.deques[i].tasks = &tasks[first];
+        pool.deques[i].top = 0;
+        pool.deques[i].bottom = last - first;
+
+        /* owner takes from bottom, so keep grid order */
+        for (size_t j = first; j < last; ++j)
+            tasks[j] = last - 1 - (j - first);
+    }
+
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers[i].pool = &pool;
+        workers[i].id = i;
+
+        if (pthread_create(&tids[i], NULL, db_sweep_worker_main, &workers[i]) != 0)
+            break;
+
+        ++started;
+    }
+
+    /* not all threads have started, calling thread helps */
+    if (started < threads)
+        (void)db_sweep_worker_main(&workers[started]);
+
+    for (size_t i = 0; i < started; ++i)
+        (void)pthread_join(tids[i], NULL);
+
+    for (size_t i = 0; i < threads; ++i)
+        (void)pthread_mutex_destroy(&pool.deques[i].lock);
+
+    /* all workers have finished, shards can be merged without locks */
+    if (total != NULL)
+        for (size_t i = 0; i < threads; ++i)
+            db_stat_merge(total, &workers[i].shard);
+
+    free(pool.deques);
+    free(workers);
+    free(tids);
+    free(tasks);
+
+    return pool.results;
+}
+
+void db_sweep_print(const DB_sweep_result *results, size_t num_results)
+{
+    printf("SSD\tRUNS_RATIO\tKEY_SIZE\tENTRY_SIZE\tN\tQUERIES\tTOTAL_TIME\tLIFETIME_DAYS\n");
+    for (size_t i = 0; i < num_results; ++i)
+        printf("%s\t%zu\t%zu\t%zu\t%zu\t%zu\t%lf\t%lf\n",
+               results[i].ssd_name,
+               results[i].runs_ratio,
+               results[i].key_size,
+               results[i].entry_size,
+               results[i].queries,
+               results[i].total.queries,
+               results[i].total.query_time,
+               results[i].lifetime_days);
+}
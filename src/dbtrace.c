@@ -0,0 +1,495 @@
+#define _GNU_SOURCE
+
+#include <dbtrace.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DB_TRACE_LINE_MAX 512
+
+/* size of stdio buffer of writer */
+#define DB_TRACE_WRITE_BUFFER ((size_t)1 << 20)
+
+/* replayed part of mapping is dropped every DB_TRACE_RELEASE_BYTES, so RSS does not grow with trace */
+#define DB_TRACE_RELEASE_BYTES ((size_t)64 << 20)
+
+static const char *const db_trace_op_names[DB_STAT_OP_NUM] =
+{
+    [DB_STAT_OP_INSERT] = "insert",
+    [DB_STAT_OP_BULKLOAD] = "bulkload",
+    [DB_STAT_OP_POINT_SEARCH] = "point",
+    [DB_STAT_OP_RANGE_SEARCH] = "range",
+    [DB_STAT_OP_DELETE] = "delete",
+    [DB_STAT_OP_UPDATE] = "update"
+};
+
+/*
+    Parse unsigned integer
+
+    PARAMS
+    @IN str - string
+    @OUT val - parsed value
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_trace_parse_u64(const char *str, uint64_t *val);
+
+/*
+    Parse one line of text trace
+
+    PARAMS
+    @IN str - line without comment
+    @OUT record - parsed record
+    @OUT err - message of error
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int db_trace_parse_line(char *str, DB_trace_record *record, const char **err);
+
+/*
+    Replay one record on index
+
+    PARAMS
+    @IN index - pointer to index
+    @IN record - pointer to record
+
+    RETURN
+    This is a void function
+*/
+static void db_trace_replay_record(DB_index_fdtree *index, const DB_trace_record *record);
+
+static int db_trace_parse_u64(const char *str, uint64_t *val)
+{
+    unsigned long long v;
+    char *end;
+
+    if (!isdigit((unsigned char)*str))
+        return 1;
+
+    errno = 0;
+    v = strtoull(str, &end, 10);
+    if (errno != 0 || *end != '\0')
+        return 1;
+
+    *val = (uint64_t)v;
+
+    return 0;
+}
+
+static int db_trace_parse_line(char *str, DB_trace_record *record, const char **err)
+{
+    char *save = NULL;
+    char *token;
+    size_t numbers = 0;
+    size_t op;
+
+    (void)memset(record, 0, sizeof(*record));
+    record->count = 1;
+
+    token = strtok_r(str, " \t\r\n", &save);
+    for (op = 0; op < DB_STAT_OP_NUM; ++op)
+        if (strcmp(token, db_trace_op_names[op]) == 0)
+            break;
+
+    if (op == DB_STAT_OP_NUM)
+    {
+        *err = "unknown operation (insert, bulkload, point, range, delete, update)";
+        return 1;
+    }
+
+    record->op = (uint8_t)op;
+
+    while ((token = strtok_r(NULL, " \t\r\n", &save)) != NULL)
+    {
+        if (*token == '@')
+        {
+            if (record->flags & DB_TRACE_TIMESTAMP || db_trace_parse_u64(token + 1, &record->timestamp) != 0)
+            {
+                *err = "timestamp has to be one @<nanoseconds>";
+                return 1;
+            }
+
+            record->flags |= DB_TRACE_TIMESTAMP;
+            continue;
+        }
+
+        if (numbers == 0 && db_trace_parse_u64(token, &record->count) == 0 && record->count > 0)
+        {
+            ++numbers;
+            continue;
+        }
+
+        if (numbers == 1 && op == DB_STAT_OP_RANGE_SEARCH && db_trace_parse_u64(token, &record->range) == 0 && record->range > 0)
+        {
+            ++numbers;
+            continue;
+        }
+
+        *err = numbers == 0 ? "count has to be positive integer" : op == DB_STAT_OP_RANGE_SEARCH ? "range has to be positive integer" : "too many fields";
+        return 1;
+    }
+
+    if (op == DB_STAT_OP_RANGE_SEARCH && record->range == 0)
+    {
+        *err = "range search needs range";
+        return 1;
+    }
+
+    return 0;
+}
+
+static void db_trace_replay_record(DB_index_fdtree *index, const DB_trace_record *record)
+{
+    DB_stat *stat = index->stat;
+    const size_t count = (size_t)record->count;
+
+    switch (record->op)
+    {
+        case DB_STAT_OP_BULKLOAD:
+        {
+            db_stat_start_query(stat, DB_STAT_OP_BULKLOAD);
+            db_index_fdtree_bulkload(index, count);
+            db_stat_finish_query(stat);
+            break;
+        }
+        case DB_STAT_OP_POINT_SEARCH:
+        {
+            db_stat_start_queries(stat, DB_STAT_OP_POINT_SEARCH, count);
+            db_index_fdtree_point_search(index, count);
+            db_stat_finish_query(stat);
+            break;
+        }
+        case DB_STAT_OP_RANGE_SEARCH:
+        {
+            db_stat_start_queries(stat, DB_STAT_OP_RANGE_SEARCH, count);
+            db_index_fdtree_range_search_repeat(index, (size_t)record->range, count);
+            db_stat_finish_query(stat);
+            break;
+        }
+        case DB_STAT_OP_INSERT:
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                db_stat_start_query(stat, DB_STAT_OP_INSERT);
+                db_index_fdtree_insert(index, 1);
+                db_stat_finish_query(stat);
+            }
+            break;
+        }
+        case DB_STAT_OP_DELETE:
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                db_stat_start_query(stat, DB_STAT_OP_DELETE);
+                db_index_fdtree_delete(index, 1);
+                db_stat_finish_query(stat);
+            }
+            break;
+        }
+        case DB_STAT_OP_UPDATE:
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                db_stat_start_query(stat, DB_STAT_OP_UPDATE);
+                db_index_fdtree_update(index, 1);
+                db_stat_finish_query(stat);
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+int db_trace_writer_open(const char *path, DB_trace_writer *writer)
+{
+    const DB_trace_header header = {DB_TRACE_MAGIC, DB_TRACE_VERSION, (uint32_t)sizeof(DB_trace_record), 0, 0};
+
+    writer->num_records = 0;
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL)
+        return 1;
+
+    if (setvbuf(writer->file, NULL, _IOFBF, DB_TRACE_WRITE_BUFFER) != 0 ||
+        fwrite(&header, sizeof(header), 1, writer->file) != 1)
+    {
+        (void)fclose(writer->file);
+        writer->file = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+int db_trace_writer_append(DB_trace_writer *writer, const DB_trace_record *record)
+{
+    if (fwrite(record, sizeof(*record), 1, writer->file) != 1)
+        return 1;
+
+    ++writer->num_records;
+
+    return 0;
+}
+
+int db_trace_writer_close(DB_trace_writer *writer)
+{
+    const DB_trace_header header = {DB_TRACE_MAGIC, DB_TRACE_VERSION, (uint32_t)sizeof(DB_trace_record), writer->num_records, 0};
+    int ret = 0;
+
+    if (writer->file == NULL)
+        return 1;
+
+    /* header is written at the end, so unfinished trace has 0 records and does not match file size */
+    if (fseek(writer->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, writer->file) != 1)
+        ret = 1;
+
+    if (fclose(writer->file) != 0)
+        ret = 1;
+
+    writer->file = NULL;
+
+    return ret;
+}
+
+int db_trace_convert(const char *text_path, const char *trace_path, size_t *records)
+{
+    DB_trace_writer writer;
+    DB_trace_record record;
+    char buf[DB_TRACE_LINE_MAX];
+    FILE *file;
+    uint64_t last_timestamp = 0;
+    size_t line = 0;
+    int ret = 0;
+
+    file = fopen(text_path, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "%s: cannot open: %s\n", text_path, strerror(errno));
+        return 1;
+    }
+
+    if (db_trace_writer_open(trace_path, &writer) != 0)
+    {
+        fprintf(stderr, "%s: cannot create: %s\n", trace_path, strerror(errno));
+        (void)fclose(file);
+        return 1;
+    }
+
+    while (fgets(buf, sizeof(buf), file) != NULL)
+    {
+        const char *err = NULL;
+        char *comment;
+        char *str;
+
+        ++line;
+
+        if (strchr(buf, '\n') == NULL && !feof(file))
+        {
+            fprintf(stderr, "%s:%zu: line is longer than %d characters\n", text_path, line, DB_TRACE_LINE_MAX - 2);
+            ret = 1;
+            break;
+        }
+
+        comment = strchr(buf, '#');
+        if (comment != NULL)
+            *comment = '\0';
+
+        str = buf;
+        while (isspace((unsigned char)*str))
+            ++str;
+
+        if (*str == '\0')
+            continue;
+
+        if (db_trace_parse_line(str, &record, &err) != 0)
+        {
+            fprintf(stderr, "%s:%zu: %s\n", text_path, line, err);
+            ret = 1;
+            continue;
+        }
+
+        if (record.flags & DB_TRACE_TIMESTAMP)
+        {
+            if (record.timestamp < last_timestamp)
+            {
+                fprintf(stderr, "%s:%zu: timestamp %" PRIu64 " is older than previous one %" PRIu64 "\n", text_path, line, record.timestamp, last_timestamp);
+                ret = 1;
+                continue;
+            }
+
+            last_timestamp = record.timestamp;
+        }
+
+        if (ret == 0 && db_trace_writer_append(&writer, &record) != 0)
+        {
+            fprintf(stderr, "%s: cannot write: %s\n", trace_path, strerror(errno));
+            ret = 1;
+            break;
+        }
+    }
+
+    (void)fclose(file);
+
+    if (records != NULL)
+        *records = (size_t)writer.num_records;
+
+    if (db_trace_writer_close(&writer) != 0)
+    {
+        fprintf(stderr, "%s: cannot write: %s\n", trace_path, strerror(errno));
+        ret = 1;
+    }
+
+    /* do not leave partial trace */
+    if (ret != 0)
+        (void)unlink(trace_path);
+
+    return ret;
+}
+
+int db_trace_replay(DB_index_fdtree *index, const char *path, DB_trace_summary *summary)
+{
+    DB_trace_summary sum;
+    DB_trace_header header;
+    const DB_trace_record *records;
+    struct stat st;
+    uint8_t *map;
+    size_t page_size;
+    size_t released = 0;
+    int fd;
+    int ret = 0;
+
+    (void)memset(&sum, 0, sizeof(sum));
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "%s: cannot open: %s\n", path, strerror(errno));
+        if (fd >= 0)
+            (void)close(fd);
+
+        return 1;
+    }
+
+    if ((size_t)st.st_size < sizeof(header))
+    {
+        fprintf(stderr, "%s: file is too small for trace header\n", path);
+        (void)close(fd);
+        return 1;
+    }
+
+    map = (uint8_t *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    (void)close(fd);
+    if (map == MAP_FAILED)
+    {
+        fprintf(stderr, "%s: cannot map: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    (void)madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    (void)memcpy(&header, map, sizeof(header));
+    if (memcmp(header.magic, DB_TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != DB_TRACE_VERSION ||
+        header.record_size != sizeof(DB_trace_record))
+    {
+        fprintf(stderr, "%s: not a trace of version %d\n", path, DB_TRACE_VERSION);
+        (void)munmap(map, (size_t)st.st_size);
+        return 1;
+    }
+
+    if (((size_t)st.st_size - sizeof(header)) / sizeof(DB_trace_record) != header.num_records ||
+        ((size_t)st.st_size - sizeof(header)) % sizeof(DB_trace_record) != 0)
+    {
+        fprintf(stderr, "%s: header has %" PRIu64 " records, file has %zu bytes of records (unfinished trace?)\n",
+                path, header.num_records, (size_t)st.st_size - sizeof(header));
+        (void)munmap(map, (size_t)st.st_size);
+        return 1;
+    }
+
+    page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    /* header has size of record, so records are aligned */
+    records = (const DB_trace_record *)(map + sizeof(header));
+    for (size_t i = 0; i < header.num_records; ++i)
+    {
+        const DB_trace_record *record = &records[i];
+        const size_t consumed = sizeof(header) + i * sizeof(DB_trace_record);
+
+        if (record->op >= DB_STAT_OP_NUM || record->count == 0 || (record->op == DB_STAT_OP_RANGE_SEARCH && record->range == 0))
+        {
+            fprintf(stderr, "%s: record %zu is corrupted\n", path, i);
+            ret = 1;
+            break;
+        }
+
+        db_trace_replay_record(index, record);
+
+        ++sum.records;
+        sum.ops[record->op] += record->op == DB_STAT_OP_BULKLOAD ? 1 : (size_t)record->count;
+
+        if (record->flags & DB_TRACE_TIMESTAMP)
+        {
+            if (sum.timestamps == 0)
+                sum.first_timestamp = record->timestamp;
+
+            sum.last_timestamp = record->timestamp;
+            ++sum.timestamps;
+        }
+
+        if (consumed - released >= DB_TRACE_RELEASE_BYTES)
+        {
+            const size_t end = consumed - consumed % page_size;
+
+            (void)madvise(map + released, end - released, MADV_DONTNEED);
+            released = end;
+        }
+    }
+
+    (void)munmap(map, (size_t)st.st_size);
+
+    if (summary != NULL)
+        *summary = sum;
+
+    return ret;
+}
+
+double db_trace_ops_per_second(const DB_trace_summary *summary)
+{
+    size_t ops = 0;
+
+    if (summary->timestamps < 2 || summary->last_timestamp == summary->first_timestamp)
+        return 0.0;
+
+    for (size_t i = 0; i < DB_STAT_OP_NUM; ++i)
+        ops += summary->ops[i];
+
+    return (double)ops / ((double)(summary->last_timestamp - summary->first_timestamp) / 1000000000.0);
+}
+
+void db_trace_summary_print(const DB_trace_summary *summary)
+{
+    printf("TRACE\n");
+    printf("\tRECORDS                = %zu\n", summary->records);
+
+    for (size_t i = 0; i < DB_STAT_OP_NUM; ++i)
+        if (summary->ops[i] > 0)
+            printf("\t%-22s = %zu\n", db_stat_op_name((DB_stat_op)i), summary->ops[i]);
+
+    if (summary->timestamps >= 2)
+    {
+        printf("\tDURATION               = %lfs\n", (double)(summary->last_timestamp - summary->first_timestamp) / 1000000000.0);
+        printf("\tOPS PER SECOND         = %lf\n", db_trace_ops_per_second(summary));
+    }
+}
@@ -0,0 +1,618 @@
+#include <dbworkload.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <strings.h>
+#include <math.h>
+
+static const char *const db_workload_op_names[DB_WORKLOAD_OP_NUM] =
+{
+    [DB_WORKLOAD_READ] = "read",
+    [DB_WORKLOAD_UPDATE] = "update",
+    [DB_WORKLOAD_INSERT] = "insert",
+    [DB_WORKLOAD_DELETE] = "delete",
+    [DB_WORKLOAD_SCAN] = "scan",
+    [DB_WORKLOAD_RMW] = "rmw"
+};
+
+static const char *const db_workload_dist_names[] =
+{
+    [DB_WORKLOAD_DIST_UNIFORM] = "uniform",
+    [DB_WORKLOAD_DIST_ZIPFIAN] = "zipfian",
+    [DB_WORKLOAD_DIST_LATEST] = "latest"
+};
+
+/*
+    Rotate left 64 bit word
+
+    PARAMS
+    @IN x - word
+    @IN k - bits
+
+    RETURN
+    Rotated word
+*/
+static inline uint64_t db_rand_rotl(uint64_t x, int k);
+
+/*
+    Get next splitmix64 number
+
+    PARAMS
+    @IN state - pointer to state
+
+    RETURN
+    Random number
+*/
+static uint64_t db_rand_splitmix64(uint64_t *state);
+
+/*
+    Init zipfian distribution
+
+    PARAMS
+    @IN zipf - pointer to distribution
+    @IN items - number of items
+    @IN theta - skew
+
+    RETURN
+    This is a void function
+*/
+static void db_zipf_init(DB_zipf *zipf, size_t items, double theta);
+
+/*
+    Grow zipfian distribution by new items (zeta is extended, not recomputed)
+
+    PARAMS
+    @IN zipf - pointer to distribution
+    @IN items - new number of items
+
+    RETURN
+    This is a void function
+*/
+static void db_zipf_grow(DB_zipf *zipf, size_t items);
+
+/*
+    Draw rank from zipfian distribution (0 is the most popular)
+
+    PARAMS
+    @IN zipf - pointer to distribution
+    @IN rand - pointer to generator
+
+    RETURN
+    Rank from [0, items)
+*/
+static size_t db_zipf_next(const DB_zipf *zipf, DB_rand *rand);
+
+/*
+    Draw key of existing record
+
+    PARAMS
+    @IN workload - pointer to workload
+
+    RETURN
+    Key
+*/
+static uint64_t db_workload_key(DB_workload *workload);
+
+/*
+    Issue run of operations of the same kind on index, in key level mode writes use keys of operations
+
+    PARAMS
+    @IN index - pointer to index
+    @IN ops - operations of run
+    @IN count - length of run
+
+    RETURN
+    This is a void function
+*/
+static void db_workload_issue(DB_index_fdtree *index, const DB_workload_op *ops, size_t count);
+
+static inline uint64_t db_rand_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t db_rand_splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+void db_rand_seed(DB_rand *rand, uint64_t seed)
+{
+    for (size_t i = 0; i < 4; ++i)
+        rand->s[i] = db_rand_splitmix64(&seed);
+}
+
+uint64_t db_rand_next(DB_rand *rand)
+{
+    uint64_t *s = rand->s;
+    const uint64_t result = db_rand_rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = db_rand_rotl(s[3], 45);
+
+    return result;
+}
+
+double db_rand_double(DB_rand *rand)
+{
+    /* 53 bits of mantissa */
+    return (double)(db_rand_next(rand) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void db_zipf_init(DB_zipf *zipf, size_t items, double theta)
+{
+    zipf->theta = theta;
+    zipf->alpha = 1.0 / (1.0 - theta);
+    zipf->zeta2 = 1.0 + pow(0.5, theta);
+    zipf->zetan = 0.0;
+    zipf->items = 0;
+
+    db_zipf_grow(zipf, items);
+}
+
+static void db_zipf_grow(DB_zipf *zipf, size_t items)
+{
+    if (items <= zipf->items)
+        return;
+
+    for (size_t i = zipf->items + 1; i <= items; ++i)
+        zipf->zetan += 1.0 / pow((double)i, zipf->theta);
+
+    zipf->items = items;
+    zipf->eta = (1.0 - pow(2.0 / (double)items, 1.0 - zipf->theta)) / (1.0 - zipf->zeta2 / zipf->zetan);
+}
+
+static size_t db_zipf_next(const DB_zipf *zipf, DB_rand *rand)
+{
+    const double u = db_rand_double(rand);
+    const double uz = u * zipf->zetan;
+    double rank;
+
+    if (uz < 1.0)
+        return 0;
+
+    if (uz < zipf->zeta2 && zipf->items > 1)
+        return 1;
+
+    rank = (double)zipf->items * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha);
+    if (rank >= (double)zipf->items)
+        return zipf->items - 1;
+
+    return (size_t)rank;
+}
+
+static uint64_t db_workload_key(DB_workload *workload)
+{
+    const size_t hot = workload->records / 100 > 0 ? workload->records / 100 : 1;
+    uint64_t state;
+    size_t rank;
+
+    switch (workload->config.mix.dist)
+    {
+        case DB_WORKLOAD_DIST_ZIPFIAN:
+        {
+            rank = db_zipf_next(&workload->zipf, &workload->rand);
+            if (rank < hot)
+                ++workload->summary.hot_ops;
+
+            /* scramble, so popular keys are not neighbours */
+            state = (uint64_t)rank;
+            return db_rand_splitmix64(&state) % workload->records;
+        }
+        case DB_WORKLOAD_DIST_LATEST:
+        {
+            rank = db_zipf_next(&workload->zipf, &workload->rand);
+            if (rank < hot)
+                ++workload->summary.hot_ops;
+
+            return (uint64_t)(workload->records - 1 - rank);
+        }
+        case DB_WORKLOAD_DIST_UNIFORM:
+        default:
+        {
+            rank = (size_t)(db_rand_next(&workload->rand) % workload->records);
+            if (rank < hot)
+                ++workload->summary.hot_ops;
+
+            return (uint64_t)rank;
+        }
+    }
+}
+
+static void db_workload_issue(DB_index_fdtree *index, const DB_workload_op *ops, size_t count)
+{
+    DB_stat *stat = index->stat;
+    const bool keys = index->keys != NULL;
+
+    switch (ops[0].type)
+    {
+        case DB_WORKLOAD_READ:
+        {
+            db_stat_start_queries(stat, DB_STAT_OP_POINT_SEARCH, count);
+            db_index_fdtree_point_search(index, count);
+            db_stat_finish_query(stat);
+            break;
+        }
+        case DB_WORKLOAD_SCAN:
+        {
+            db_stat_start_queries(stat, DB_STAT_OP_RANGE_SEARCH, count);
+            db_index_fdtree_range_search_repeat(index, ops[0].scan_length, count);
+            db_stat_finish_query(stat);
+            break;
+        }
+        case DB_WORKLOAD_UPDATE:
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                db_stat_start_query(stat, DB_STAT_OP_UPDATE);
+                if (keys)
+                    db_index_fdtree_update_key(index, ops[i].key);
+                else
+                    db_index_fdtree_update(index, 1);
+                db_stat_finish_query(stat);
+            }
+            break;
+        }
+        case DB_WORKLOAD_INSERT:
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                db_stat_start_query(stat, DB_STAT_OP_INSERT);
+                if (keys)
+                    db_index_fdtree_insert_key(index, ops[i].key);
+                else
+                    db_index_fdtree_insert(index, 1);
+                db_stat_finish_query(stat);
+            }
+            break;
+        }
+        case DB_WORKLOAD_DELETE:
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                db_stat_start_query(stat, DB_STAT_OP_DELETE);
+                if (keys)
+                    db_index_fdtree_delete_key(index, ops[i].key);
+                else
+                    db_index_fdtree_delete(index, 1);
+                db_stat_finish_query(stat);
+            }
+            break;
+        }
+        case DB_WORKLOAD_RMW:
+        {
+            /* read and write are one request of user */
+            for (size_t i = 0; i < count; ++i)
+            {
+                db_stat_start_query(stat, DB_STAT_OP_UPDATE);
+                db_index_fdtree_point_search(index, 1);
+                if (keys)
+                    db_index_fdtree_update_key(index, ops[i].key);
+                else
+                    db_index_fdtree_update(index, 1);
+                db_stat_finish_query(stat);
+            }
+            break;
+        }
+        case DB_WORKLOAD_OP_NUM:
+        default:
+        {
+            break;
+        }
+    }
+}
+
+int db_workload_mix_preset(const char *name, DB_workload_mix *mix)
+{
+    if (name[0] == '\0' || name[1] != '\0')
+        return 1;
+
+    (void)memset(mix, 0, sizeof(*mix));
+    mix->scan_min = 1;
+    mix->scan_max = 100;
+    mix->dist = DB_WORKLOAD_DIST_ZIPFIAN;
+
+    switch (name[0])
+    {
+        case 'a':
+        case 'A':
+        {
+            mix->ratio[DB_WORKLOAD_READ] = 0.5;
+            mix->ratio[DB_WORKLOAD_UPDATE] = 0.5;
+            break;
+        }
+        case 'b':
+        case 'B':
+        {
+            mix->ratio[DB_WORKLOAD_READ] = 0.95;
+            mix->ratio[DB_WORKLOAD_UPDATE] = 0.05;
+            break;
+        }
+        case 'c':
+        case 'C':
+        {
+            mix->ratio[DB_WORKLOAD_READ] = 1.0;
+            break;
+        }
+        case 'd':
+        case 'D':
+        {
+            mix->ratio[DB_WORKLOAD_READ] = 0.95;
+            mix->ratio[DB_WORKLOAD_INSERT] = 0.05;
+            mix->dist = DB_WORKLOAD_DIST_LATEST;
+            break;
+        }
+        case 'e':
+        case 'E':
+        {
+            mix->ratio[DB_WORKLOAD_SCAN] = 0.95;
+            mix->ratio[DB_WORKLOAD_INSERT] = 0.05;
+            break;
+        }
+        case 'f':
+        case 'F':
+        {
+            mix->ratio[DB_WORKLOAD_READ] = 0.5;
+            mix->ratio[DB_WORKLOAD_RMW] = 0.5;
+            break;
+        }
+        default:
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int db_workload_mix_parse(const char *str, DB_workload_mix *mix)
+{
+    double ratio[DB_WORKLOAD_OP_NUM] = {0.0};
+
+    while (*str != '\0')
+    {
+        const char *eq = strchr(str, '=');
+        char *end;
+        size_t len;
+        size_t i;
+        double v;
+
+        if (eq == NULL)
+        {
+            fprintf(stderr, "mix: expected op=ratio, got \"%s\"\n", str);
+            return 1;
+        }
+
+        len = (size_t)(eq - str);
+        for (i = 0; i < DB_WORKLOAD_OP_NUM; ++i)
+            if (strlen(db_workload_op_names[i]) == len && strncmp(str, db_workload_op_names[i], len) == 0)
+                break;
+
+        if (i == DB_WORKLOAD_OP_NUM)
+        {
+            fprintf(stderr, "mix: unknown operation \"%.*s\" (read, update, insert, delete, scan, rmw)\n", (int)len, str);
+            return 1;
+        }
+
+        v = strtod(eq + 1, &end);
+        if (end == eq + 1 || (*end != ',' && *end != '\0') || !isfinite(v) || v < 0.0)
+        {
+            fprintf(stderr, "mix: ratio of %s has to be non-negative number\n", db_workload_op_names[i]);
+            return 1;
+        }
+
+        ratio[i] = v;
+        str = *end == ',' ? end + 1 : end;
+    }
+
+    (void)memcpy(mix->ratio, ratio, sizeof(ratio));
+
+    return 0;
+}
+
+int db_workload_dist_parse(const char *str, DB_workload_dist *dist)
+{
+    for (size_t i = 0; i < sizeof(db_workload_dist_names) / sizeof(db_workload_dist_names[0]); ++i)
+        if (strcasecmp(str, db_workload_dist_names[i]) == 0)
+        {
+            *dist = (DB_workload_dist)i;
+            return 0;
+        }
+
+    return 1;
+}
+
+const char *db_workload_op_name(DB_workload_op_type op)
+{
+    return db_workload_op_names[op];
+}
+
+DB_workload_config db_workload_config_default(void)
+{
+    DB_workload_config config =
+    {
+        .records = 1000000,
+        .ops = 1000000,
+        .batch = DB_WORKLOAD_BATCH,
+        .zipf_theta = DB_WORKLOAD_ZIPF_THETA,
+        .seed = 0x5EED
+    };
+
+    (void)db_workload_mix_preset("A", &config.mix);
+
+    return config;
+}
+
+DB_workload *db_workload_create(const DB_workload_config *config)
+{
+    const DB_workload_mix *mix = &config->mix;
+    DB_workload *workload;
+    double sum = 0.0;
+
+    for (size_t i = 0; i < DB_WORKLOAD_OP_NUM; ++i)
+        sum += mix->ratio[i];
+
+    if (sum <= 0.0)
+    {
+        fprintf(stderr, "workload: mix has no operations\n");
+        return NULL;
+    }
+
+    if (config->records == 0 || config->batch == 0)
+    {
+        fprintf(stderr, "workload: records and batch have to be positive\n");
+        return NULL;
+    }
+
+    if (mix->ratio[DB_WORKLOAD_SCAN] > 0.0 && (mix->scan_min == 0 || mix->scan_min > mix->scan_max))
+    {
+        fprintf(stderr, "workload: scan length has to be in [1, scan_max]\n");
+        return NULL;
+    }
+
+    if (config->zipf_theta <= 0.0 || config->zipf_theta >= 1.0)
+    {
+        fprintf(stderr, "workload: zipfian theta has to be in (0, 1)\n");
+        return NULL;
+    }
+
+    workload = (DB_workload *)calloc(1, sizeof(DB_workload));
+    if (workload == NULL)
+        return NULL;
+
+    workload->batch = (DB_workload_op *)malloc(sizeof(DB_workload_op) * config->batch);
+    if (workload->batch == NULL)
+    {
+        free(workload);
+        return NULL;
+    }
+
+    workload->config = *config;
+    workload->records = config->records;
+
+    for (size_t i = 0; i < DB_WORKLOAD_OP_NUM; ++i)
+        workload->cdf[i] = (i > 0 ? workload->cdf[i - 1] : 0.0) + mix->ratio[i] / sum;
+
+    /* rounding cannot make last operation unreachable */
+    workload->cdf[DB_WORKLOAD_OP_NUM - 1] = 1.0;
+
+    db_rand_seed(&workload->rand, config->seed);
+
+    if (mix->dist != DB_WORKLOAD_DIST_UNIFORM)
+        db_zipf_init(&workload->zipf, config->records, config->zipf_theta);
+
+    return workload;
+}
+
+void db_workload_destroy(DB_workload *workload)
+{
+    if (workload == NULL)
+        return;
+
+    free(workload->batch);
+    free(workload);
+}
+
+int db_workload_next(DB_workload *workload, DB_workload_op *op)
+{
+    const DB_workload_mix *mix = &workload->config.mix;
+    const double u = db_rand_double(&workload->rand);
+    size_t type = 0;
+
+    if (workload->generated >= workload->config.ops)
+        return 1;
+
+    while (type < DB_WORKLOAD_OP_NUM - 1 && u >= workload->cdf[type])
+        ++type;
+
+    op->type = (DB_workload_op_type)type;
+    op->scan_length = 0;
+
+    if (op->type == DB_WORKLOAD_INSERT)
+    {
+        op->key = (uint64_t)workload->records++;
+        if (mix->dist != DB_WORKLOAD_DIST_UNIFORM)
+            db_zipf_grow(&workload->zipf, workload->records);
+    }
+    else
+        op->key = db_workload_key(workload);
+
+    if (op->type == DB_WORKLOAD_SCAN)
+    {
+        op->scan_length = mix->scan_min + (size_t)(db_rand_next(&workload->rand) % (mix->scan_max - mix->scan_min + 1));
+        workload->summary.scan_entries += op->scan_length;
+    }
+
+    ++workload->summary.ops[op->type];
+    ++workload->generated;
+    workload->summary.records = workload->records;
+
+    return 0;
+}
+
+void db_workload_run(DB_workload *workload, DB_index_fdtree *index)
+{
+    DB_stat *stat = index->stat;
+
+    db_stat_start_query(stat, DB_STAT_OP_BULKLOAD);
+    if (index->keys != NULL)
+    {
+        for (size_t i = 0; i < workload->config.records; ++i)
+            db_index_fdtree_insert_key(index, (uint64_t)i);
+    }
+    else
+        db_index_fdtree_bulkload(index, workload->config.records);
+    db_stat_finish_query(stat);
+
+    for (;;)
+    {
+        size_t num_ops = 0;
+
+        while (num_ops < workload->config.batch && db_workload_next(workload, &workload->batch[num_ops]) == 0)
+            ++num_ops;
+
+        if (num_ops == 0)
+            break;
+
+        for (size_t i = 0; i < num_ops;)
+        {
+            const DB_workload_op *op = &workload->batch[i];
+            size_t run = 1;
+
+            while (i + run < num_ops && workload->batch[i + run].type == op->type && workload->batch[i + run].scan_length == op->scan_length)
+                ++run;
+
+            db_workload_issue(index, op, run);
+            i += run;
+        }
+    }
+}
+
+void db_workload_summary_print(const DB_workload *workload)
+{
+    const DB_workload_summary *summary = &workload->summary;
+    size_t keyed_ops = 0;
+
+    printf("WORKLOAD %s\n", db_workload_dist_names[workload->config.mix.dist]);
+    for (size_t i = 0; i < DB_WORKLOAD_OP_NUM; ++i)
+    {
+        printf("\t%-6s        OPS      = %zu\n", db_workload_op_names[i], summary->ops[i]);
+        if (i != DB_WORKLOAD_INSERT)
+            keyed_ops += summary->ops[i];
+    }
+
+    printf("\tSCAN          ENTRIES  = %zu\n", summary->scan_entries);
+    printf("\tRECORDS                = %zu\n", summary->records);
+    printf("\tHOT 1%%        OPS      = %lf%%\n", keyed_ops > 0 ? (double)summary->hot_ops * 100.0 / (double)keyed_ops : 0.0);
+}
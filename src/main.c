@@ -1,8 +1,457 @@
 #include <experiments.h>
+#include <dbsweep.h>
+#include <ssd_calibrate.h>
+#include <dbtrace.h>
+#include <dboptimize.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int main(void)
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+/*
+    Run sweep over default grid
+
+    PARAMS
+    @IN threads - number of threads (0 - number of online CPUs)
+    @IN paths - paths of profiles (SSDs of profiles replace built-in SSDs)
+    @IN num_paths - number of profiles
+
+    RETURN
+    0 iff success
+*/
+static int main_sweep(size_t threads, char **paths, size_t num_paths);
+
+/*
+    Load profile, print it and run normal workload on it
+
+    PARAMS
+    @IN path - path of profile
+    @IN queries - number of queries in batch (N)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int main_run(const char *path, size_t queries);
+
+static int main_sweep(size_t threads, char **paths, size_t num_paths)
+{
+    static const DB_sweep_ssd_create ssds[] = {ssd_create_samsung840, ssd_create_intelDCP4511, ssd_create_toshibaVX500};
+    static const size_t runs_ratios[] = {2, 4, 8, 10, 16, 25, 50, 100};
+    static const size_t key_sizes[] = {sizeof(long), sizeof(long), 16};
+    static const size_t entry_sizes[] = {64, 140, 256};
+    static const size_t queries[] = {100000, 1000000, 10000000};
+
+    DB_sweep_grid grid =
+    {
+        .ssds = ssds,
+        .num_ssds = ARRAY_SIZE(ssds),
+        .runs_ratios = runs_ratios,
+        .num_runs_ratios = ARRAY_SIZE(runs_ratios),
+        .key_sizes = key_sizes,
+        .entry_sizes = entry_sizes,
+        .num_entries = ARRAY_SIZE(entry_sizes),
+        .queries = queries,
+        .num_queries = ARRAY_SIZE(queries),
+        .profiles = NULL,
+        .num_profiles = 0,
+        .ops_per_second = DB_EXPERIMENT_OPS_PER_SECOND
+    };
+
+    DB_sweep_result *results;
+    DB_stat total = {0};
+    DB_profile *profiles = NULL;
+
+    if (num_paths > 0)
+    {
+        profiles = (DB_profile *)malloc(sizeof(DB_profile) * num_paths);
+        if (profiles == NULL)
+            return 1;
+
+        for (size_t i = 0; i < num_paths; ++i)
+            if (db_profile_load(paths[i], &profiles[i]) != 0)
+            {
+                free(profiles);
+                return 1;
+            }
+
+        grid.num_ssds = 0;
+        grid.profiles = profiles;
+        grid.num_profiles = num_paths;
+    }
+
+    results = db_sweep_run(&grid, threads, &total);
+    if (results == NULL)
+    {
+        free(profiles);
+        return 1;
+    }
+
+    db_sweep_print(results, db_sweep_grid_size(&grid));
+    db_stat_summary_print(&total);
+    free(results);
+    free(profiles);
+
+    return 0;
+}
+
+static int main_run(const char *path, size_t queries)
+{
+    DB_profile profile;
+
+    if (db_profile_load(path, &profile) != 0)
+        return 1;
+
+    db_profile_print(&profile);
+    db_index_fdtree_experiment_workload_profile(&profile, queries);
+
+    return 0;
+}
+
+/*
+    Replay binary trace on profile
+
+    PARAMS
+    @IN path - path of binary trace
+    @IN profile_path - (can be NULL) path of profile, NULL - default profile
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int main_replay(const char *path, const char *profile_path);
+
+static int main_replay(const char *path, const char *profile_path)
 {
+    DB_profile profile;
+
+    if (profile_path == NULL ? db_profile_default(&profile) != 0 : db_profile_load(profile_path, &profile) != 0)
+        return 1;
+
+    return db_index_fdtree_experiment_replay(&profile, path);
+}
+
+/*
+    Run YCSB style workload
+
+    PARAMS
+    @IN mix - preset (A - F) or custom mix (see db_workload_mix_parse)
+    @IN records - keys loaded before run
+    @IN ops - number of operations
+    @IN dist - (can be NULL) name of key distribution, NULL - distribution of mix
+    @IN profile_path - (can be NULL) path of profile, NULL - default profile
+    @IN key_level - true iff index runs in key level mode
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int main_ycsb(const char *mix, size_t records, size_t ops, const char *dist, const char *profile_path, bool key_level);
+
+static int main_ycsb(const char *mix, size_t records, size_t ops, const char *dist, const char *profile_path, bool key_level)
+{
+    DB_workload_config config = db_workload_config_default();
+    DB_profile profile;
+
+    if (strchr(mix, '=') == NULL && db_workload_mix_preset(mix, &config.mix) != 0)
+    {
+        fprintf(stderr, "Unknown YCSB workload %s (A - F)\n", mix);
+        return 1;
+    }
+
+    if (strchr(mix, '=') != NULL && db_workload_mix_parse(mix, &config.mix) != 0)
+        return 1;
+
+    if (dist != NULL && strcmp(dist, "-") != 0 && db_workload_dist_parse(dist, &config.mix.dist) != 0)
+    {
+        fprintf(stderr, "Unknown distribution %s (uniform, zipfian, latest)\n", dist);
+        return 1;
+    }
+
+    if (profile_path == NULL || strcmp(profile_path, "-") == 0 ? db_profile_default(&profile) != 0 : db_profile_load(profile_path, &profile) != 0)
+        return 1;
+
+    config.records = records;
+    config.ops = ops;
+
+    return db_index_fdtree_experiment_ycsb(&profile, &config, key_level);
+}
+
+/*
+    Find the best configuration of index for workload
+
+    PARAMS
+    @IN mix - preset (A - F) or custom mix (see db_workload_mix_parse)
+    @IN records - N
+    @IN selectivity - part of N read by scan (0 - scan length of mix)
+    @IN memory - RAM of HEAD, Bloom filters and buffer pool in bytes
+    @IN profile_path - (can be NULL) path of profile, NULL - default profile
+    @IN sim_ops - operations of simulation of the best candidates (0 - closed form only)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int main_optimize(const char *mix, size_t records, double selectivity, size_t memory, const char *profile_path, size_t sim_ops);
+
+static int main_optimize(const char *mix, size_t records, double selectivity, size_t memory, const char *profile_path, size_t sim_ops)
+{
+    DB_workload_mix workload_mix;
+    DB_optimize_request request;
+    DB_optimize_result result;
+    DB_profile profile;
+
+    if (strchr(mix, '=') == NULL && db_workload_mix_preset(mix, &workload_mix) != 0)
+    {
+        fprintf(stderr, "Unknown YCSB workload %s (A - F)\n", mix);
+        return 1;
+    }
+
+    if (strchr(mix, '=') != NULL)
+    {
+        (void)db_workload_mix_preset("A", &workload_mix);
+        if (db_workload_mix_parse(mix, &workload_mix) != 0)
+            return 1;
+    }
+
+    if (profile_path == NULL || strcmp(profile_path, "-") == 0 ? db_profile_default(&profile) != 0 : db_profile_load(profile_path, &profile) != 0)
+        return 1;
+
+    request = db_optimize_request_default(&workload_mix, records);
+    request.selectivity = selectivity;
+    request.memory = memory;
+    request.sim_ops = sim_ops;
+
+    if (db_optimize_run(&profile, &request, &result) != 0)
+        return 1;
+
+    db_optimize_print(&result);
+
+    return 0;
+}
+
+/*
+    Run normal workload on index of type
+
+    PARAMS
+    @IN type - name of index (see db_index_type_parse)
+    @IN queries - number of queries in batch (N)
+    @IN profile_path - (can be NULL) path of profile, NULL - default profile
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int main_index(const char *type, size_t queries, const char *profile_path);
+
+static int main_index(const char *type, size_t queries, const char *profile_path)
+{
+    DB_index_type index_type;
+    DB_profile profile;
+
+    if (db_index_type_parse(type, &index_type) != 0)
+    {
+        fprintf(stderr, "Unknown index %s (fdtree, btree, lsm-leveling, lsm-tiering, betree)\n", type);
+        return 1;
+    }
+
+    if (profile_path == NULL || strcmp(profile_path, "-") == 0 ? db_profile_default(&profile) != 0 : db_profile_load(profile_path, &profile) != 0)
+        return 1;
+
+    db_index_experiment_workload(index_type, &profile, queries);
+
+    return 0;
+}
+
+/*
+    Run normal workload on every index with the same SSD and parameters
+
+    PARAMS
+    @IN queries - number of queries in batch (N)
+    @IN profile_path - (can be NULL) path of profile, NULL - default profile
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int main_compare(size_t queries, const char *profile_path);
+
+static int main_compare(size_t queries, const char *profile_path)
+{
+    DB_profile profile;
+
+    if (profile_path == NULL || strcmp(profile_path, "-") == 0 ? db_profile_default(&profile) != 0 : db_profile_load(profile_path, &profile) != 0)
+        return 1;
+
+    db_index_experiment_compare(&profile, queries);
+
+    return 0;
+}
+
+/*
+    Calibrate SSD model on drive and save its profile
+
+    PARAMS
+    @IN path - file or block device
+    @IN size - bytes used by benchmarks
+    @IN profile - path of profile file
+    @IN destructive - true iff existing file or block device can be overwritten
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int main_calibrate(const char *path, size_t size, const char *profile, bool destructive);
+
+static int main_calibrate(const char *path, size_t size, const char *profile, bool destructive)
+{
+    SSD_calibrate_config config = ssd_calibrate_config_default();
+    SSD_calibrate_result result;
+    SSD *ssd;
+
+    config.size = size;
+    config.destructive = destructive;
+
+    ssd = ssd_calibrate(path, &config, &result);
+    ssd_calibrate_result_print(&result);
+    if (ssd == NULL)
+        return 1;
+
+    if (ssd_profile_save(ssd, profile) != 0)
+    {
+        fprintf(stderr, "Cannot save profile to %s\n", profile);
+        ssd_destroy(ssd);
+        return 1;
+    }
+
+    printf("PROFILE SAVED TO %s\n", profile);
+
+    ssd_destroy(ssd);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    /* sweep [threads] [profile ...] */
+    if (argc > 1 && strcmp(argv[1], "sweep") == 0)
+        return main_sweep(argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 0, argv + 3, argc > 3 ? (size_t)(argc - 3) : 0);
+
+    /* run profile [queries] */
+    if (argc > 2 && strcmp(argv[1], "run") == 0)
+        return main_run(argv[2], argc > 3 ? (size_t)strtoul(argv[3], NULL, 10) : 1000000);
+
+    /* ftl [blocks] [greedy | cost-benefit] [none | dynamic | static] [wl_threshold] */
+    if (argc > 1 && strcmp(argv[1], "ftl") == 0)
+    {
+        const size_t blocks = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 1024;
+        const SSD_ftl_gc_policy policy = argc > 3 && strcmp(argv[3], "cost-benefit") == 0 ? SSD_FTL_GC_COST_BENEFIT : SSD_FTL_GC_GREEDY;
+        const size_t wl_threshold = argc > 5 ? (size_t)strtoul(argv[5], NULL, 10) : 16;
+        SSD_ftl_wl_policy wl_policy = SSD_FTL_WL_NONE;
+
+        if (argc > 4 && strcmp(argv[4], "dynamic") == 0)
+            wl_policy = SSD_FTL_WL_DYNAMIC;
+        else if (argc > 4 && strcmp(argv[4], "static") == 0)
+            wl_policy = SSD_FTL_WL_STATIC;
+
+        db_index_fdtree_experiment_workload_ftl(1000000, blocks, 0.07, policy, wl_policy, wl_threshold);
+        return 0;
+    }
+
+    /* sim [arrival_rate] [queries] */
+    if (argc > 1 && strcmp(argv[1], "sim") == 0)
+    {
+        const double arrival_rate = argc > 2 ? strtod(argv[2], NULL) : 0.0;
+        const size_t queries = argc > 3 ? (size_t)strtoul(argv[3], NULL, 10) : 1000000;
+
+        db_index_fdtree_experiment_sim(queries, arrival_rate);
+        return 0;
+    }
+
+    /* simcheck [queries] */
+    if (argc > 1 && strcmp(argv[1], "simcheck") == 0)
+        return db_index_fdtree_experiment_sim_check(argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 100000);
+
+    /* validate [path] [queries] [direct] [samples] [head_pages] */
+    if (argc > 1 && strcmp(argv[1], "validate") == 0)
+    {
+        const char *path = argc > 2 ? argv[2] : "fdtree.db";
+        const size_t queries = argc > 3 ? (size_t)strtoul(argv[3], NULL, 10) : 100000;
+        const bool direct = argc > 4 && strcmp(argv[4], "direct") == 0;
+        const size_t samples = argc > 5 ? (size_t)strtoul(argv[5], NULL, 10) : 1000;
+        const size_t head_pages = argc > 6 ? (size_t)strtoul(argv[6], NULL, 10) : 1;
+        SSD *ssd = ssd_create_samsung840();
+
+        if (ssd == NULL)
+            return 1;
+
+        db_index_fdtree_experiment_validate(ssd, path, queries, samples, direct, head_pages);
+        ssd_destroy(ssd);
+
+        return 0;
+    }
+
+    /* qd [queries] */
+    if (argc > 1 && strcmp(argv[1], "qd") == 0)
+    {
+        db_index_fdtree_experiment_workload_qd(argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 1000000);
+        return 0;
+    }
+
+    /* convert text_trace trace */
+    if (argc > 3 && strcmp(argv[1], "convert") == 0)
+    {
+        size_t records;
+
+        if (db_trace_convert(argv[2], argv[3], &records) != 0)
+            return 1;
+
+        printf("CONVERTED %zu RECORDS TO %s\n", records, argv[3]);
+        return 0;
+    }
+
+    /* replay trace [profile] */
+    if (argc > 2 && strcmp(argv[1], "replay") == 0)
+        return main_replay(argv[2], argc > 3 ? argv[3] : NULL);
+
+    /* ycsb A-F | mix [records] [ops] [uniform | zipfian | latest | -] [profile | -] [keys] */
+    if (argc > 2 && strcmp(argv[1], "ycsb") == 0)
+        return main_ycsb(argv[2],
+                         argc > 3 ? (size_t)strtoul(argv[3], NULL, 10) : 1000000,
+                         argc > 4 ? (size_t)strtoul(argv[4], NULL, 10) : 1000000,
+                         argc > 5 ? argv[5] : NULL,
+                         argc > 6 ? argv[6] : NULL,
+                         argc > 7 && strcmp(argv[7], "keys") == 0);
+
+    /* optimize A-F | mix [records] [selectivity] [memory_MB] [profile | -] [sim_ops] */
+    if (argc > 2 && strcmp(argv[1], "optimize") == 0)
+        return main_optimize(argv[2],
+                             argc > 3 ? (size_t)strtoul(argv[3], NULL, 10) : 1000000,
+                             argc > 4 ? strtod(argv[4], NULL) : 0.0,
+                             (argc > 5 ? (size_t)strtoul(argv[5], NULL, 10) : 64) * 1024 * 1024,
+                             argc > 6 ? argv[6] : NULL,
+                             argc > 7 ? (size_t)strtoul(argv[7], NULL, 10) : DB_OPTIMIZE_SIM_OPS);
+
+    /* index fdtree | btree | lsm-leveling | lsm-tiering | betree [queries] [profile | -] */
+    if (argc > 2 && strcmp(argv[1], "index") == 0)
+        return main_index(argv[2], argc > 3 ? (size_t)strtoul(argv[3], NULL, 10) : 1000000, argc > 4 ? argv[4] : NULL);
+
+    /* compare [queries] [profile | -] */
+    if (argc > 1 && strcmp(argv[1], "compare") == 0)
+        return main_compare(argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 1000000, argc > 3 ? argv[3] : NULL);
+
+    /* calibrate path [size_MB] [profile] [destructive] */
+    if (argc > 2 && strcmp(argv[1], "calibrate") == 0)
+    {
+        const size_t size = (argc > 3 ? (size_t)strtoul(argv[3], NULL, 10) : 256) * 1024 * 1024;
+        const char *profile = argc > 4 ? argv[4] : "ssd.profile";
+        const bool destructive = argc > 5 && strcmp(argv[5], "destructive") == 0;
+
+        return main_calibrate(argv[2], size, profile, destructive);
+    }
+
     db_index_fdtree_experiment_workload(1000000);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,7 +1,12 @@
 #include <ssd.h>
+#include <ssd_ftl.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
 
 #define SSD_MICROSEC(n) ((n) / 1000000.0)
+#define SSD_GB(n) ((size_t)(n) * 1000 * 1000 * 1000)
+#define SSD_SECONDS_PER_DAY (24.0 * 60.0 * 60.0)
 
 SSD *ssd_create_samsung840(void)
 {
@@ -15,12 +20,21 @@ SSD *ssd_create_samsung840(void)
 
     ssd->block_size = pages_per_block * page_size;
     ssd->dirty_pages = 0;
+    ssd->ftl = NULL;
+    ssd->stat.pages_written = 0;
+    ssd->stat.blocks_erased = 0;
     ssd->page_size = page_size;
     ssd->r_read_time = SSD_MICROSEC(21);
     ssd->r_write_time = SSD_MICROSEC(45);
     ssd->s_read_time = SSD_MICROSEC(14);
     ssd->s_write_time = SSD_MICROSEC(15.3);
     ssd->erase_time = ssd->r_write_time * 10.0 * (double)pages_per_block;
+    ssd->blocks = SSD_GB(250) / ssd->block_size;
+    ssd->endurance = 1000;
+    ssd->bus_time = SSD_BUS_TIME(page_size, SSD_SATA_BANDWIDTH);
+    ssd->channels = 8;
+    ssd->dies_per_channel = 4;
+    ssd->queue_depth = 32;
     ssd->name = "samsung840";
 
     return ssd;
@@ -38,12 +52,21 @@ SSD *ssd_create_intelDCP4511(void)
 
     ssd->block_size = pages_per_block * page_size;
     ssd->dirty_pages = 0;
+    ssd->ftl = NULL;
+    ssd->stat.pages_written = 0;
+    ssd->stat.blocks_erased = 0;
     ssd->page_size = page_size;
     ssd->r_read_time = SSD_MICROSEC(3.3);
     ssd->r_write_time = SSD_MICROSEC(27.7);
     ssd->s_read_time = SSD_MICROSEC(2);
     ssd->s_write_time = SSD_MICROSEC(2.75);
     ssd->erase_time = ssd->r_write_time * 10.0 * (double)pages_per_block;
+    ssd->blocks = SSD_GB(1000) / ssd->block_size;
+    ssd->endurance = 3000;
+    ssd->bus_time = SSD_BUS_TIME(page_size, SSD_NVME_BANDWIDTH);
+    ssd->channels = 12;
+    ssd->dies_per_channel = 8;
+    ssd->queue_depth = 128;
     ssd->name = "intelDCP4511";
 
     return ssd;
@@ -61,21 +84,115 @@ SSD *ssd_create_toshibaVX500(void)
 
     ssd->block_size = pages_per_block * page_size;
     ssd->dirty_pages = 0;
+    ssd->ftl = NULL;
+    ssd->stat.pages_written = 0;
+    ssd->stat.blocks_erased = 0;
     ssd->page_size = page_size;
     ssd->r_read_time = SSD_MICROSEC(10.8);
     ssd->r_write_time = SSD_MICROSEC(15.3);
     ssd->s_read_time = SSD_MICROSEC(7.2);
     ssd->s_write_time = SSD_MICROSEC(7.8);
     ssd->erase_time = ssd->r_write_time * 10.0 * (double)pages_per_block;
+    ssd->blocks = SSD_GB(512) / ssd->block_size;
+    ssd->endurance = 3000;
+    ssd->bus_time = SSD_BUS_TIME(page_size, SSD_SATA_BANDWIDTH);
+    ssd->channels = 8;
+    ssd->dies_per_channel = 4;
+    ssd->queue_depth = 32;
     ssd->name = "toshibaVX500";
 
     return ssd;
 }
 
+SSD *ssd_create_empty(const char *name)
+{
+    SSD *ssd;
+
+    ssd = (SSD *)calloc(1, sizeof(SSD));
+    if (ssd == NULL)
+        return NULL;
+
+    ssd->ftl = NULL;
+    ssd->name = name;
+
+    return ssd;
+}
+
+int ssd_profile_save(const SSD *ssd, const char *path)
+{
+    FILE *file;
+    int ret = 0;
+
+    file = fopen(path, "w");
+    if (file == NULL)
+        return 1;
+
+    if (fprintf(file, "# SSD profile, times in microseconds\n") < 0 ||
+        fprintf(file, "name = %s\n", ssd->name) < 0 ||
+        fprintf(file, "page_size = %zu\n", ssd->page_size) < 0 ||
+        fprintf(file, "block_size = %zu\n", ssd->block_size) < 0 ||
+        fprintf(file, "blocks = %zu\n", ssd->blocks) < 0 ||
+        fprintf(file, "r_read_us = %lf\n", ssd->r_read_time * 1000000.0) < 0 ||
+        fprintf(file, "r_write_us = %lf\n", ssd->r_write_time * 1000000.0) < 0 ||
+        fprintf(file, "s_read_us = %lf\n", ssd->s_read_time * 1000000.0) < 0 ||
+        fprintf(file, "s_write_us = %lf\n", ssd->s_write_time * 1000000.0) < 0 ||
+        fprintf(file, "erase_us = %lf\n", ssd->erase_time * 1000000.0) < 0 ||
+        fprintf(file, "bus_us = %lf\n", ssd->bus_time * 1000000.0) < 0 ||
+        fprintf(file, "channels = %zu\n", ssd->channels) < 0 ||
+        fprintf(file, "dies_per_channel = %zu\n", ssd->dies_per_channel) < 0 ||
+        fprintf(file, "queue_depth = %zu\n", ssd->queue_depth) < 0 ||
+        fprintf(file, "endurance = %zu\n", ssd->endurance) < 0)
+        ret = 1;
+
+    if (fclose(file) != 0)
+        ret = 1;
+
+    return ret;
+}
+
 void ssd_destroy(SSD *ssd)
 {
     if (ssd == NULL)
         return;
 
+    ssd_ftl_destroy(ssd->ftl);
     free(ssd);
-}
\ No newline at end of file
+}
+
+double ssd_lifetime_days(const SSD *ssd, double ops, double ops_per_second)
+{
+    double pe_cycles;
+
+    if (ssd->ftl != NULL)
+        pe_cycles = (double)ssd->ftl->max_erase_count;
+    else
+    {
+        const size_t pages_erased = ssd->stat.blocks_erased * ssd_pages_per_block(ssd);
+        const size_t pages = ssd->stat.pages_written > pages_erased ? ssd->stat.pages_written : pages_erased;
+
+        pe_cycles = (double)pages / (double)(ssd_pages_per_block(ssd) * ssd->blocks);
+    }
+
+    /* no wear */
+    if (pe_cycles <= 0.0 || ops <= 0.0 || ops_per_second <= 0.0)
+        return HUGE_VAL;
+
+    return (double)ssd->endurance / (pe_cycles / ops) / ops_per_second / SSD_SECONDS_PER_DAY;
+}
+
+void ssd_wear_print(const SSD *ssd, double ops, double ops_per_second)
+{
+    printf("WEAR %s\n", ssd->name);
+    printf("\tENDURANCE     P/E      = %zu\n", ssd->endurance);
+    printf("\tWRITE         PAGES    = %zu\n", ssd->stat.pages_written);
+    printf("\tERASED        BLOCKS   = %zu\n", ssd->stat.blocks_erased);
+
+    if (ssd->ftl != NULL)
+    {
+        printf("\tMAX           P/E      = %zu\n", ssd->ftl->max_erase_count);
+        printf("\tMIN           P/E      = %zu\n", ssd_ftl_min_erase_count(ssd));
+    }
+
+    printf("\tOPS PER SECOND         = %lf\n", ops_per_second);
+    printf("\tLIFETIME      DAYS     = %lf\n", ssd_lifetime_days(ssd, ops, ops_per_second));
+}
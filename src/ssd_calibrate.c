@@ -0,0 +1,587 @@
+#define _GNU_SOURCE
+
+#include <ssd_calibrate.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/statvfs.h>
+#include <linux/fs.h>
+
+#define SSD_CALIBRATE_ALIGNMENT 4096
+#define SSD_CALIBRATE_MIN_REQUEST ((size_t)512)
+#define SSD_CALIBRATE_MIN_CHUNK ((size_t)64 * 1024)
+#define SSD_CALIBRATE_SEQ_REQUEST ((size_t)1024 * 1024)
+
+/* bytes written by every chunk write benchmark */
+#define SSD_CALIBRATE_CHUNK_BYTES ((size_t)32 * 1024 * 1024)
+
+/* endurance cannot be measured */
+#define SSD_CALIBRATE_DEFAULT_ENDURANCE 3000
+
+typedef struct SSD_calibrate_target
+{
+    const char *path;
+    int fd;
+    size_t size; /* bytes used by benchmarks */
+    size_t capacity; /* bytes of drive */
+    bool created; /* true iff file was created by calibration, only such file is removed */
+} SSD_calibrate_target;
+
+typedef struct SSD_calibrate_thread
+{
+    const SSD_calibrate_target *target;
+    size_t request;
+    size_t ops;
+    uint64_t seed;
+    int ret;
+} SSD_calibrate_thread;
+
+/*
+    Get time of monotonic clock
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    Time in seconds
+*/
+static double ssd_calibrate_now(void);
+
+/*
+    Get next pseudo random number (xorshift64)
+
+    PARAMS
+    @IN state - pointer to generator state
+
+    RETURN
+    Random number
+*/
+static uint64_t ssd_calibrate_rand(uint64_t *state);
+
+/*
+    Read or write whole request
+
+    PARAMS
+    @IN fd - file
+    @IN buffer - aligned buffer
+    @IN bytes - size of request
+    @IN offset - offset in file
+    @IN write - true iff request is write
+
+    RETURN
+    0 iff success
+    errno of failure
+*/
+static int ssd_calibrate_io(int fd, uint8_t *buffer, size_t bytes, size_t offset, bool write);
+
+/*
+    Open target and fill benchmark area
+
+    PARAMS
+    @IN path - path of target
+    @IN config - pointer to configuration
+    @OUT target - opened target
+    @OUT s_write_throughput - throughput of filling (bytes per second)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int ssd_calibrate_open(const char *path, const SSD_calibrate_config *config, SSD_calibrate_target *target, double *s_write_throughput);
+
+/*
+    Run random requests of one size
+
+    PARAMS
+    @IN target - pointer to target
+    @IN buffer - aligned buffer of at least request bytes
+    @IN request - size of request
+    @IN ops - number of requests
+    @IN write - true iff requests are writes
+    @IN seed - seed of offsets
+    @OUT time - time of all requests (with sync for writes)
+
+    RETURN
+    0 iff success
+    errno of failure
+*/
+static int ssd_calibrate_random(const SSD_calibrate_target *target, uint8_t *buffer, size_t request, size_t ops, bool write, uint64_t seed, double *time);
+
+/*
+    Thread of parallel read benchmark
+
+    PARAMS
+    @IN arg - pointer to SSD_calibrate_thread
+
+    RETURN
+    NULL
+*/
+static void *ssd_calibrate_thread_main(void *arg);
+
+/*
+    Measure random read time per page with threads in flight
+
+    PARAMS
+    @IN target - pointer to target
+    @IN page_size - size of page
+    @IN config - pointer to configuration
+    @OUT time - time per page
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int ssd_calibrate_parallel(const SSD_calibrate_target *target, size_t page_size, const SSD_calibrate_config *config, double *time);
+
+static double ssd_calibrate_now(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static uint64_t ssd_calibrate_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+
+    return x;
+}
+
+static int ssd_calibrate_io(int fd, uint8_t *buffer, size_t bytes, size_t offset, bool write)
+{
+    size_t done = 0;
+
+    while (done < bytes)
+    {
+        const ssize_t ret = write ? pwrite(fd, buffer + done, bytes - done, (off_t)(offset + done))
+                                  : pread(fd, buffer + done, bytes - done, (off_t)(offset + done));
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        if (ret < 0)
+            return errno;
+
+        if (ret == 0)
+            return EIO;
+
+        done += (size_t)ret;
+    }
+
+    return 0;
+}
+
+static int ssd_calibrate_open(const char *path, const SSD_calibrate_config *config, SSD_calibrate_target *target, double *s_write_throughput)
+{
+    struct stat st;
+    struct statvfs vfs;
+    uint8_t *buffer;
+    double start;
+    int err = 0;
+
+    target->path = path;
+    target->fd = -1;
+    target->created = false;
+    target->size = config->size - config->size % SSD_CALIBRATE_SEQ_REQUEST;
+
+    if (stat(path, &st) == 0)
+    {
+        if (!S_ISBLK(st.st_mode) && !S_ISREG(st.st_mode))
+        {
+            fprintf(stderr, "%s is neither file nor block device\n", path);
+            return 1;
+        }
+
+        if (!config->destructive)
+        {
+            fprintf(stderr, "%s exists, calibration overwrites it, use destructive mode\n", path);
+            return 1;
+        }
+    }
+    else
+        st.st_mode = 0;
+
+    if (S_ISBLK(st.st_mode))
+    {
+        uint64_t bytes;
+
+        target->fd = open(path, O_RDWR | O_DIRECT);
+        if (target->fd < 0 || ioctl(target->fd, BLKGETSIZE64, &bytes) != 0)
+        {
+            fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+            return 1;
+        }
+
+        target->capacity = (size_t)bytes;
+    }
+    else
+    {
+        /* O_EXCL, so file which appeared after stat is not taken as ours */
+        if (S_ISREG(st.st_mode))
+            target->fd = open(path, O_RDWR | O_DIRECT);
+        else
+            target->fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_DIRECT, 0644);
+
+        if (target->fd < 0)
+        {
+            fprintf(stderr, "Cannot open %s with O_DIRECT: %s\n", path, strerror(errno));
+            return 1;
+        }
+
+        target->created = !S_ISREG(st.st_mode);
+
+        /* drive capacity is capacity of file system */
+        target->capacity = target->size;
+        if (fstatvfs(target->fd, &vfs) == 0)
+            target->capacity = (size_t)vfs.f_blocks * (size_t)vfs.f_frsize;
+    }
+
+    if (target->capacity < target->size)
+        target->size = target->capacity - target->capacity % SSD_CALIBRATE_SEQ_REQUEST;
+
+    if (target->size < SSD_CALIBRATE_CHUNK_BYTES)
+    {
+        fprintf(stderr, "%s is too small for calibration\n", path);
+        return 1;
+    }
+
+    if (posix_memalign((void **)&buffer, SSD_CALIBRATE_ALIGNMENT, SSD_CALIBRATE_SEQ_REQUEST) != 0)
+        return 1;
+
+    (void)memset(buffer, 0xA5, SSD_CALIBRATE_SEQ_REQUEST);
+
+    /* filling is sequential write benchmark */
+    start = ssd_calibrate_now();
+    for (size_t offset = 0; offset < target->size && err == 0; offset += SSD_CALIBRATE_SEQ_REQUEST)
+        err = ssd_calibrate_io(target->fd, buffer, SSD_CALIBRATE_SEQ_REQUEST, offset, true);
+
+    if (err == 0 && fdatasync(target->fd) != 0)
+        err = errno;
+
+    *s_write_throughput = (double)target->size / (ssd_calibrate_now() - start);
+
+    free(buffer);
+
+    if (err != 0)
+    {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(err));
+        return 1;
+    }
+
+    return 0;
+}
+
+static int ssd_calibrate_random(const SSD_calibrate_target *target, uint8_t *buffer, size_t request, size_t ops, bool write, uint64_t seed, double *time)
+{
+    const size_t slots = target->size / request;
+    const double start = ssd_calibrate_now();
+    uint64_t state = seed | 1;
+    int err = 0;
+
+    for (size_t i = 0; i < ops && err == 0; ++i)
+        err = ssd_calibrate_io(target->fd, buffer, request, (size_t)(ssd_calibrate_rand(&state) % slots) * request, write);
+
+    if (err == 0 && write && fdatasync(target->fd) != 0)
+        err = errno;
+
+    *time = ssd_calibrate_now() - start;
+
+    return err;
+}
+
+static void *ssd_calibrate_thread_main(void *arg)
+{
+    SSD_calibrate_thread *thread = (SSD_calibrate_thread *)arg;
+    uint8_t *buffer;
+    double time;
+
+    if (posix_memalign((void **)&buffer, SSD_CALIBRATE_ALIGNMENT, thread->request) != 0)
+    {
+        thread->ret = ENOMEM;
+        return NULL;
+    }
+
+    thread->ret = ssd_calibrate_random(thread->target, buffer, thread->request, thread->ops, false, thread->seed, &time);
+    free(buffer);
+
+    return NULL;
+}
+
+static int ssd_calibrate_parallel(const SSD_calibrate_target *target, size_t page_size, const SSD_calibrate_config *config, double *time)
+{
+    SSD_calibrate_thread *threads;
+    pthread_t *tids;
+    size_t started = 0;
+    double start;
+    int ret = 0;
+
+    threads = (SSD_calibrate_thread *)calloc(config->threads, sizeof(SSD_calibrate_thread));
+    tids = (pthread_t *)calloc(config->threads, sizeof(pthread_t));
+    if (threads == NULL || tids == NULL)
+    {
+        free(threads);
+        free(tids);
+        return 1;
+    }
+
+    start = ssd_calibrate_now();
+    for (size_t i = 0; i < config->threads; ++i)
+    {
+        threads[i].target = target;
+        threads[i].request = page_size;
+        threads[i].ops = config->ops;
+        threads[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+
+        if (pthread_create(&tids[i], NULL, ssd_calibrate_thread_main, &threads[i]) != 0)
+            break;
+
+        ++started;
+    }
+
+    for (size_t i = 0; i < started; ++i)
+    {
+        (void)pthread_join(tids[i], NULL);
+        ret |= threads[i].ret;
+    }
+
+    *time = (ssd_calibrate_now() - start) / (double)(started * config->ops);
+
+    free(threads);
+    free(tids);
+
+    return ret != 0 || started == 0;
+}
+
+SSD_calibrate_config ssd_calibrate_config_default(void)
+{
+    const SSD_calibrate_config config =
+    {
+        .size = (size_t)256 * 1024 * 1024,
+        .ops = 2000,
+        .threads = 32,
+        .knee = 0.9,
+        .destructive = false
+    };
+
+    return config;
+}
+
+SSD *ssd_calibrate(const char *path, const SSD_calibrate_config *config, SSD_calibrate_result *result)
+{
+    SSD_calibrate_result res;
+    SSD_calibrate_target target;
+    SSD *ssd = NULL;
+    uint8_t *buffer = NULL;
+    size_t max_chunk;
+    size_t page_size;
+    size_t block_size;
+    size_t pages_per_block;
+    size_t parallelism;
+    double min_latency = 0.0;
+    double time;
+    double start;
+    int err = 0;
+
+    (void)memset(&res, 0, sizeof(res));
+
+    if (config->ops == 0 || config->threads == 0 || config->knee <= 0.0 || config->knee > 1.0)
+    {
+        fprintf(stderr, "Wrong calibration configuration\n");
+        return NULL;
+    }
+
+    if (ssd_calibrate_open(path, config, &target, &res.s_write_throughput) != 0)
+        goto cleanup;
+
+    max_chunk = SSD_CALIBRATE_MIN_CHUNK << (sizeof(res.chunk_write_throughput) / sizeof(res.chunk_write_throughput[0]) - 1);
+    if (posix_memalign((void **)&buffer, SSD_CALIBRATE_ALIGNMENT, max_chunk) != 0)
+        goto cleanup;
+
+    (void)memset(buffer, 0x5A, max_chunk);
+
+    /* sequential read */
+    start = ssd_calibrate_now();
+    for (size_t offset = 0; offset < target.size && err == 0; offset += SSD_CALIBRATE_SEQ_REQUEST)
+        err = ssd_calibrate_io(target.fd, buffer, SSD_CALIBRATE_SEQ_REQUEST, offset, false);
+
+    res.s_read_throughput = (double)target.size / (ssd_calibrate_now() - start);
+    if (err != 0)
+    {
+        fprintf(stderr, "Cannot read %s: %s\n", path, strerror(err));
+        goto cleanup;
+    }
+
+    /* random reads of growing size, page is where latency starts to grow */
+    page_size = 0;
+    for (size_t i = 0; i < sizeof(res.r_read_latency) / sizeof(res.r_read_latency[0]); ++i)
+    {
+        const size_t request = SSD_CALIBRATE_MIN_REQUEST << i;
+
+        if (request > SSD_CALIBRATE_MIN_CHUNK)
+            break;
+
+        err = ssd_calibrate_random(&target, buffer, request, config->ops, false, 0x2545F4914F6CDD1DULL + i, &time);
+
+        /* request is not aligned to logical block of device */
+        if (err == EINVAL)
+        {
+            res.r_read_latency[res.num_r_read_latency++] = 0.0;
+            continue;
+        }
+
+        if (err != 0)
+        {
+            fprintf(stderr, "Cannot read %s: %s\n", path, strerror(err));
+            goto cleanup;
+        }
+
+        res.r_read_latency[res.num_r_read_latency++] = time / (double)config->ops;
+
+        if (min_latency == 0.0)
+            min_latency = time / (double)config->ops;
+
+        if (time / (double)config->ops <= min_latency * (2.0 - config->knee))
+            page_size = request;
+    }
+
+    if (page_size == 0)
+    {
+        fprintf(stderr, "Cannot detect page size of %s\n", path);
+        goto cleanup;
+    }
+
+    /* aligned random writes of growing chunks, block is where they are as fast as sequential writes */
+    block_size = 0;
+    for (size_t i = 0; i < sizeof(res.chunk_write_throughput) / sizeof(res.chunk_write_throughput[0]); ++i)
+    {
+        const size_t chunk = SSD_CALIBRATE_MIN_CHUNK << i;
+        const size_t ops = SSD_CALIBRATE_CHUNK_BYTES / chunk;
+
+        err = ssd_calibrate_random(&target, buffer, chunk, ops, true, 0xD1B54A32D192ED03ULL + i, &time);
+        if (err != 0)
+        {
+            fprintf(stderr, "Cannot write %s: %s\n", path, strerror(err));
+            goto cleanup;
+        }
+
+        res.chunk_write_throughput[res.num_chunk_write_throughput++] = (double)(ops * chunk) / time;
+
+        if (block_size == 0 && (double)(ops * chunk) / time >= config->knee * res.s_write_throughput)
+            block_size = chunk;
+    }
+
+    if (block_size == 0)
+        block_size = max_chunk;
+
+    if (block_size < page_size)
+        block_size = page_size;
+
+    pages_per_block = block_size / page_size;
+
+    ssd = ssd_create_empty("calibrated");
+    if (ssd == NULL)
+        goto cleanup;
+
+    /* random writes of one page */
+    err = ssd_calibrate_random(&target, buffer, page_size, config->ops, true, 0x94D049BB133111EBULL, &time);
+    if (err != 0)
+    {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(err));
+        ssd_destroy(ssd);
+        ssd = NULL;
+        goto cleanup;
+    }
+
+    ssd->r_write_time = time / (double)config->ops;
+
+    if (ssd_calibrate_parallel(&target, page_size, config, &res.parallel_read_time) != 0)
+    {
+        fprintf(stderr, "Parallel read of %s has failed\n", path);
+        ssd_destroy(ssd);
+        ssd = NULL;
+        goto cleanup;
+    }
+
+    ssd->page_size = page_size;
+    ssd->block_size = block_size;
+    ssd->blocks = target.capacity / block_size;
+    ssd->r_read_time = res.r_read_latency[0];
+    for (size_t i = 0; i < res.num_r_read_latency; ++i)
+        if ((SSD_CALIBRATE_MIN_REQUEST << i) == page_size)
+            ssd->r_read_time = res.r_read_latency[i];
+
+    ssd->s_read_time = (double)page_size / res.s_read_throughput;
+    ssd->s_write_time = (double)page_size / res.s_write_throughput;
+
+    /* extra cost of random writes is GC with erase, amortized over block */
+    ssd->erase_time = (ssd->r_write_time - ssd->s_write_time) * (double)pages_per_block;
+    res.erase_time_measured = ssd->erase_time > 0.0;
+    if (!res.erase_time_measured)
+        ssd->erase_time = ssd->r_write_time * 10.0 * (double)pages_per_block;
+
+    /* bus is at least as fast as the best observed throughput and SATA link */
+    ssd->bus_time = SSD_BUS_TIME(page_size, SSD_SATA_BANDWIDTH);
+    if (res.parallel_read_time < ssd->bus_time)
+        ssd->bus_time = res.parallel_read_time;
+
+    if (ssd->s_read_time < ssd->bus_time)
+        ssd->bus_time = ssd->s_read_time;
+
+    parallelism = (size_t)(ssd->r_read_time / res.parallel_read_time + 0.5);
+    if (parallelism < 1)
+        parallelism = 1;
+
+    if (parallelism > config->threads)
+        parallelism = config->threads;
+
+    /* only number of dies working in parallel is visible */
+    ssd->channels = parallelism;
+    ssd->dies_per_channel = 1;
+    ssd->queue_depth = config->threads;
+    ssd->endurance = SSD_CALIBRATE_DEFAULT_ENDURANCE;
+
+cleanup:
+    free(buffer);
+
+    if (target.fd >= 0)
+        (void)close(target.fd);
+
+    if (target.created)
+        (void)unlink(path);
+
+    if (result != NULL)
+        *result = res;
+
+    return ssd;
+}
+
+void ssd_calibrate_result_print(const SSD_calibrate_result *result)
+{
+    printf("CALIBRATION\n");
+    printf("\tSEQ   READ    MB/S     = %lf\n", result->s_read_throughput / 1000000.0);
+    printf("\tSEQ   WRITE   MB/S     = %lf\n", result->s_write_throughput / 1000000.0);
+
+    for (size_t i = 0; i < result->num_r_read_latency; ++i)
+        printf("\tRAND  READ    %7zuB = %lfus\n", SSD_CALIBRATE_MIN_REQUEST << i, result->r_read_latency[i] * 1000000.0);
+
+    for (size_t i = 0; i < result->num_chunk_write_throughput; ++i)
+        printf("\tCHUNK WRITE   %7zuK = %lfMB/s\n", (SSD_CALIBRATE_MIN_CHUNK << i) / 1024, result->chunk_write_throughput[i] / 1000000.0);
+
+    printf("\tPARALLEL READ PAGE     = %lfus\n", result->parallel_read_time * 1000000.0);
+    printf("\tERASE TIME  MEASURED   = %s\n", result->erase_time_measured ? "yes" : "no (10 x random write)");
+}
@@ -0,0 +1,676 @@
+#include <ssd_ftl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SSD_FTL_NONE SIZE_MAX
+
+#define SSD_FTL_BLOCK_FREE   0
+#define SSD_FTL_BLOCK_HOST   1
+#define SSD_FTL_BLOCK_GC     2
+#define SSD_FTL_BLOCK_CLOSED 3
+
+/* static WL checks P/E gap once per this number of erases */
+#define SSD_FTL_WL_CHECK_PERIOD 64
+
+/*
+    Add closed block to list of blocks with the same number of valid pages
+
+    PARAMS
+    @IN ftl - pointer to FTL
+    @IN block - block
+
+    RETURN
+    This is a void function
+*/
+static void ssd_ftl_bucket_insert(SSD_ftl *ftl, size_t block);
+
+/*
+    Remove closed block from list of blocks with the same number of valid pages
+
+    PARAMS
+    @IN ftl - pointer to FTL
+    @IN block - block
+
+    RETURN
+    This is a void function
+*/
+static void ssd_ftl_bucket_remove(SSD_ftl *ftl, size_t block);
+
+/*
+    Put block on free list
+
+    PARAMS
+    @IN ftl - pointer to FTL
+    @IN block - free block
+
+    RETURN
+    This is a void function
+*/
+static void ssd_ftl_free_push(SSD_ftl *ftl, size_t block);
+
+/*
+    Take block from free list (the least worn one when WL is on)
+
+    PARAMS
+    @IN ftl - pointer to FTL
+
+    RETURN
+    Free block
+*/
+static size_t ssd_ftl_free_pop(SSD_ftl *ftl);
+
+/*
+    Restore heap order of free list from position
+
+    PARAMS
+    @IN ftl - pointer to FTL
+    @IN pos - position in free list
+
+    RETURN
+    This is a void function
+*/
+static void ssd_ftl_free_sift_down(SSD_ftl *ftl, size_t pos);
+
+/*
+    Copy valid pages of block to GC frontier and erase block
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+    @IN block - closed block
+
+    RETURN
+    Time spent on copying and erasing
+*/
+static double ssd_ftl_relocate(SSD *ssd, size_t block);
+
+/*
+    Relocate the coldest block if P/E gap is bigger than threshold
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+
+    RETURN
+    Time spent on relocation
+*/
+static double ssd_ftl_static_wear_leveling(SSD *ssd);
+
+/*
+    Mark physical page as invalid
+
+    PARAMS
+    @IN ftl - pointer to FTL
+    @IN ppn - physical page
+
+    RETURN
+    This is a void function
+*/
+static void ssd_ftl_invalidate(SSD_ftl *ftl, size_t ppn);
+
+/*
+    Write logical page on write frontier (host or GC)
+
+    PARAMS
+    @IN ftl - pointer to FTL
+    @IN lpn - logical page
+    @IN gc - true iff page is copied by GC
+
+    RETURN
+    This is a void function
+*/
+static void ssd_ftl_program(SSD_ftl *ftl, size_t lpn, bool gc);
+
+/*
+    Choose victim block for GC
+
+    PARAMS
+    @IN ftl - pointer to FTL
+
+    RETURN
+    SSD_FTL_NONE iff there is no closed block
+    Victim block
+*/
+static size_t ssd_ftl_select_victim(SSD_ftl *ftl);
+
+/*
+    Collect blocks until there are more than reserved free blocks
+
+    PARAMS
+    @IN ssd - pointer to SSD with FTL
+
+    RETURN
+    Time spent on GC
+*/
+static double ssd_ftl_gc(SSD *ssd);
+
+static void ssd_ftl_bucket_insert(SSD_ftl *ftl, size_t block)
+{
+    const size_t head = ftl->bucket_head[ftl->valid[block]];
+
+    ftl->prev[block] = SSD_FTL_NONE;
+    ftl->next[block] = head;
+    if (head != SSD_FTL_NONE)
+        ftl->prev[head] = block;
+
+    ftl->bucket_head[ftl->valid[block]] = block;
+}
+
+static void ssd_ftl_bucket_remove(SSD_ftl *ftl, size_t block)
+{
+    if (ftl->prev[block] != SSD_FTL_NONE)
+        ftl->next[ftl->prev[block]] = ftl->next[block];
+    else
+        ftl->bucket_head[ftl->valid[block]] = ftl->next[block];
+
+    if (ftl->next[block] != SSD_FTL_NONE)
+        ftl->prev[ftl->next[block]] = ftl->prev[block];
+}
+
+static void ssd_ftl_invalidate(SSD_ftl *ftl, size_t ppn)
+{
+    const size_t block = ppn / ftl->pages_per_block;
+
+    ftl->p2l[ppn] = SSD_FTL_NONE;
+
+    if (ftl->state[block] == SSD_FTL_BLOCK_CLOSED)
+    {
+        ssd_ftl_bucket_remove(ftl, block);
+        --ftl->valid[block];
+        ssd_ftl_bucket_insert(ftl, block);
+    }
+    else
+        --ftl->valid[block];
+}
+
+static void ssd_ftl_program(SSD_ftl *ftl, size_t lpn, bool gc)
+{
+    size_t *block = gc ? &ftl->gc_block : &ftl->host_block;
+    size_t *page = gc ? &ftl->gc_page : &ftl->host_page;
+    size_t ppn;
+
+    /* frontier is full, close it and take free block */
+    if (*block == SSD_FTL_NONE || *page == ftl->pages_per_block)
+    {
+        if (*block != SSD_FTL_NONE)
+        {
+            ftl->state[*block] = SSD_FTL_BLOCK_CLOSED;
+            ssd_ftl_bucket_insert(ftl, *block);
+        }
+
+        *block = ssd_ftl_free_pop(ftl);
+        *page = 0;
+        ftl->state[*block] = gc ? SSD_FTL_BLOCK_GC : SSD_FTL_BLOCK_HOST;
+    }
+
+    ppn = *block * ftl->pages_per_block + *page;
+    ++*page;
+
+    ftl->p2l[ppn] = lpn;
+    ftl->l2p[lpn] = ppn;
+    ++ftl->valid[*block];
+    ftl->last_write[*block] = ftl->clock;
+}
+
+static size_t ssd_ftl_select_victim(SSD_ftl *ftl)
+{
+    size_t victim = SSD_FTL_NONE;
+    double best = -1.0;
+
+    /* with WL the least worn empty block is erased, so empty blocks join rotation only when needed */
+    if (ftl->wl_policy != SSD_FTL_WL_NONE && ftl->bucket_head[0] != SSD_FTL_NONE)
+    {
+        victim = ftl->bucket_head[0];
+        for (size_t i = ftl->next[victim]; i != SSD_FTL_NONE; i = ftl->next[i])
+            if (ftl->erase_count[i] < ftl->erase_count[victim])
+                victim = i;
+
+        return victim;
+    }
+
+    if (ftl->policy == SSD_FTL_GC_GREEDY)
+    {
+        for (size_t i = 0; i <= ftl->pages_per_block; ++i)
+            if (ftl->bucket_head[i] != SSD_FTL_NONE)
+                return ftl->bucket_head[i];
+
+        return SSD_FTL_NONE;
+    }
+
+    for (size_t i = 0; i < ftl->physical_blocks; ++i)
+    {
+        double u;
+        double benefit;
+
+        if (ftl->state[i] != SSD_FTL_BLOCK_CLOSED)
+            continue;
+
+        if (ftl->valid[i] == 0)
+            return i;
+
+        u = (double)ftl->valid[i] / (double)ftl->pages_per_block;
+        benefit = (double)(ftl->clock - ftl->last_write[i] + 1) * (1.0 - u) / (2.0 * u);
+        if (benefit > best)
+        {
+            best = benefit;
+            victim = i;
+        }
+    }
+
+    return victim;
+}
+
+static void ssd_ftl_free_sift_down(SSD_ftl *ftl, size_t pos)
+{
+    size_t *heap = ftl->free_blocks;
+
+    for (;;)
+    {
+        size_t min = pos;
+        const size_t left = 2 * pos + 1;
+        const size_t right = 2 * pos + 2;
+        size_t tmp;
+
+        if (left < ftl->num_free_blocks && ftl->erase_count[heap[left]] < ftl->erase_count[heap[min]])
+            min = left;
+
+        if (right < ftl->num_free_blocks && ftl->erase_count[heap[right]] < ftl->erase_count[heap[min]])
+            min = right;
+
+        if (min == pos)
+            return;
+
+        tmp = heap[pos];
+        heap[pos] = heap[min];
+        heap[min] = tmp;
+        pos = min;
+    }
+}
+
+static void ssd_ftl_free_push(SSD_ftl *ftl, size_t block)
+{
+    size_t *heap = ftl->free_blocks;
+    size_t pos = ftl->num_free_blocks++;
+
+    heap[pos] = block;
+    if (ftl->wl_policy == SSD_FTL_WL_NONE)
+        return;
+
+    while (pos > 0 && ftl->erase_count[heap[(pos - 1) / 2]] > ftl->erase_count[heap[pos]])
+    {
+        const size_t parent = (pos - 1) / 2;
+        const size_t tmp = heap[parent];
+
+        heap[parent] = heap[pos];
+        heap[pos] = tmp;
+        pos = parent;
+    }
+}
+
+static size_t ssd_ftl_free_pop(SSD_ftl *ftl)
+{
+    size_t block;
+
+    if (ftl->wl_policy == SSD_FTL_WL_NONE)
+        return ftl->free_blocks[--ftl->num_free_blocks];
+
+    block = ftl->free_blocks[0];
+    ftl->free_blocks[0] = ftl->free_blocks[--ftl->num_free_blocks];
+    ssd_ftl_free_sift_down(ftl, 0);
+
+    return block;
+}
+
+static double ssd_ftl_relocate(SSD *ssd, size_t block)
+{
+    SSD_ftl *ftl = ssd->ftl;
+    double time = 0.0;
+
+    ssd_ftl_bucket_remove(ftl, block);
+    ftl->state[block] = SSD_FTL_BLOCK_GC;
+
+    /* copy valid pages */
+    for (size_t i = 0; i < ftl->pages_per_block; ++i)
+    {
+        const size_t ppn = block * ftl->pages_per_block + i;
+        const size_t lpn = ftl->p2l[ppn];
+
+        if (lpn == SSD_FTL_NONE)
+            continue;
+
+        ssd_ftl_invalidate(ftl, ppn);
+        ssd_ftl_program(ftl, lpn, true);
+
+        time += ssd->r_read_time + ssd->r_write_time;
+        ++ftl->stat.gc_pages_copied;
+    }
+
+    time += ssd_erase_blocks(ssd, 1);
+    ++ftl->stat.erases;
+
+    if (++ftl->erase_count[block] > ftl->max_erase_count)
+        ftl->max_erase_count = ftl->erase_count[block];
+
+    ftl->valid[block] = 0;
+    ftl->state[block] = SSD_FTL_BLOCK_FREE;
+    ssd_ftl_free_push(ftl, block);
+
+    return time;
+}
+
+static double ssd_ftl_static_wear_leveling(SSD *ssd)
+{
+    SSD_ftl *ftl = ssd->ftl;
+    size_t coldest = SSD_FTL_NONE;
+
+    if (ftl->stat.erases - ftl->wl_last_check < SSD_FTL_WL_CHECK_PERIOD)
+        return 0.0;
+
+    ftl->wl_last_check = ftl->stat.erases;
+
+    for (size_t i = 0; i < ftl->physical_blocks; ++i)
+        if (ftl->state[i] == SSD_FTL_BLOCK_CLOSED && (coldest == SSD_FTL_NONE || ftl->erase_count[i] < ftl->erase_count[coldest]))
+            coldest = i;
+
+    if (coldest == SSD_FTL_NONE || ftl->max_erase_count - ftl->erase_count[coldest] < ftl->wl_threshold)
+        return 0.0;
+
+    /* cold data goes to worn block, cold block goes back to rotation */
+    ++ftl->stat.wl_relocations;
+
+    return ssd_ftl_relocate(ssd, coldest);
+}
+
+static double ssd_ftl_gc(SSD *ssd)
+{
+    SSD_ftl *ftl = ssd->ftl;
+    double time = 0.0;
+    size_t victim;
+
+    while (ftl->num_free_blocks <= ftl->reserved_blocks)
+    {
+        victim = ssd_ftl_select_victim(ftl);
+
+        /* nothing to gain */
+        if (victim == SSD_FTL_NONE || ftl->valid[victim] == ftl->pages_per_block)
+            break;
+
+        time += ssd_ftl_relocate(ssd, victim);
+        ++ftl->stat.gc_runs;
+    }
+
+    if (ftl->wl_policy == SSD_FTL_WL_STATIC)
+        time += ssd_ftl_static_wear_leveling(ssd);
+
+    return time;
+}
+
+int ssd_ftl_enable(SSD *ssd, size_t blocks, double over_provisioning, SSD_ftl_gc_policy policy)
+{
+    SSD_ftl *ftl;
+    size_t physical_pages;
+    size_t logical_pages;
+    size_t max_logical_pages;
+
+    if (ssd->ftl != NULL || over_provisioning < 0.0 || over_provisioning >= 1.0)
+        return 1;
+
+    ftl = (SSD_ftl *)calloc(1, sizeof(SSD_ftl));
+    if (ftl == NULL)
+        return 1;
+
+    ftl->policy = policy;
+    ftl->pages_per_block = ssd_pages_per_block(ssd);
+    ftl->physical_blocks = blocks;
+    ftl->reserved_blocks = 2;
+
+    /* GC has to find invalid page in every situation, so 2 frontiers and reserved blocks are hidden */
+    if (blocks <= ftl->reserved_blocks + 2 || ftl->pages_per_block == 0)
+    {
+        free(ftl);
+        return 1;
+    }
+
+    physical_pages = blocks * ftl->pages_per_block;
+    logical_pages = (size_t)((double)physical_pages * (1.0 - over_provisioning));
+    max_logical_pages = (blocks - ftl->reserved_blocks - 2) * ftl->pages_per_block;
+    ftl->logical_pages = logical_pages < max_logical_pages ? logical_pages : max_logical_pages;
+
+    ftl->l2p = (size_t *)malloc(ftl->logical_pages * sizeof(size_t));
+    ftl->p2l = (size_t *)malloc(physical_pages * sizeof(size_t));
+    ftl->valid = (size_t *)calloc(blocks, sizeof(size_t));
+    ftl->last_write = (uint64_t *)calloc(blocks, sizeof(uint64_t));
+    ftl->state = (uint8_t *)calloc(blocks, sizeof(uint8_t));
+    ftl->erase_count = (size_t *)calloc(blocks, sizeof(size_t));
+    ftl->bucket_head = (size_t *)malloc((ftl->pages_per_block + 1) * sizeof(size_t));
+    ftl->next = (size_t *)malloc(blocks * sizeof(size_t));
+    ftl->prev = (size_t *)malloc(blocks * sizeof(size_t));
+    ftl->free_blocks = (size_t *)malloc(blocks * sizeof(size_t));
+    ftl->max_free_extents = 16;
+    ftl->free_extents = (SSD_ftl_extent *)malloc(ftl->max_free_extents * sizeof(SSD_ftl_extent));
+
+    if (ftl->l2p == NULL || ftl->p2l == NULL || ftl->valid == NULL || ftl->last_write == NULL ||
+        ftl->state == NULL || ftl->erase_count == NULL || ftl->bucket_head == NULL || ftl->next == NULL || ftl->prev == NULL ||
+        ftl->free_blocks == NULL || ftl->free_extents == NULL)
+    {
+        ssd_ftl_destroy(ftl);
+        return 1;
+    }
+
+    (void)memset(ftl->l2p, 0xff, ftl->logical_pages * sizeof(size_t));
+    (void)memset(ftl->p2l, 0xff, physical_pages * sizeof(size_t));
+    (void)memset(ftl->bucket_head, 0xff, (ftl->pages_per_block + 1) * sizeof(size_t));
+
+    /* take blocks from the lowest one */
+    for (size_t i = 0; i < blocks; ++i)
+        ftl->free_blocks[i] = blocks - 1 - i;
+
+    ftl->num_free_blocks = blocks;
+    ftl->host_block = SSD_FTL_NONE;
+    ftl->gc_block = SSD_FTL_NONE;
+
+    ftl->free_extents[0].lpn = 0;
+    ftl->free_extents[0].pages = ftl->logical_pages;
+    ftl->num_free_extents = 1;
+
+    ssd->ftl = ftl;
+
+    return 0;
+}
+
+void ssd_ftl_set_wear_leveling(SSD *ssd, SSD_ftl_wl_policy policy, size_t threshold)
+{
+    SSD_ftl *ftl = ssd->ftl;
+
+    ftl->wl_policy = policy;
+    ftl->wl_threshold = threshold;
+
+    /* free list becomes heap */
+    if (policy != SSD_FTL_WL_NONE)
+        for (size_t i = ftl->num_free_blocks / 2; i > 0; --i)
+            ssd_ftl_free_sift_down(ftl, i - 1);
+}
+
+size_t ssd_ftl_min_erase_count(const SSD *ssd)
+{
+    const SSD_ftl *ftl = ssd->ftl;
+    size_t min = ftl->max_erase_count;
+
+    for (size_t i = 0; i < ftl->physical_blocks; ++i)
+        if (ftl->erase_count[i] < min)
+            min = ftl->erase_count[i];
+
+    return min;
+}
+
+void ssd_ftl_destroy(SSD_ftl *ftl)
+{
+    if (ftl == NULL)
+        return;
+
+    free(ftl->l2p);
+    free(ftl->p2l);
+    free(ftl->valid);
+    free(ftl->last_write);
+    free(ftl->state);
+    free(ftl->erase_count);
+    free(ftl->bucket_head);
+    free(ftl->next);
+    free(ftl->prev);
+    free(ftl->free_blocks);
+    free(ftl->free_extents);
+    free(ftl);
+}
+
+bool ssd_ftl_alloc(SSD *ssd, size_t pages, SSD_ftl_extent *extent)
+{
+    SSD_ftl *ftl = ssd->ftl;
+
+    extent->lpn = 0;
+    extent->pages = 0;
+
+    if (pages == 0)
+        return true;
+
+    /* first fit */
+    for (size_t i = 0; i < ftl->num_free_extents; ++i)
+    {
+        SSD_ftl_extent *free_extent = &ftl->free_extents[i];
+
+        if (free_extent->pages < pages)
+            continue;
+
+        extent->lpn = free_extent->lpn;
+        extent->pages = pages;
+
+        free_extent->lpn += pages;
+        free_extent->pages -= pages;
+
+        if (free_extent->pages == 0)
+        {
+            (void)memmove(free_extent, free_extent + 1, (ftl->num_free_extents - i - 1) * sizeof(SSD_ftl_extent));
+            --ftl->num_free_extents;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void ssd_ftl_free(SSD *ssd, SSD_ftl_extent *extent)
+{
+    SSD_ftl *ftl = ssd->ftl;
+    size_t pos = 0;
+
+    if (extent->pages == 0)
+        return;
+
+    /* trim */
+    for (size_t i = extent->lpn; i < extent->lpn + extent->pages; ++i)
+        if (ftl->l2p[i] != SSD_FTL_NONE)
+        {
+            ssd_ftl_invalidate(ftl, ftl->l2p[i]);
+            ftl->l2p[i] = SSD_FTL_NONE;
+        }
+
+    while (pos < ftl->num_free_extents && ftl->free_extents[pos].lpn < extent->lpn)
+        ++pos;
+
+    /* merge with neighbours if possible */
+    if (pos > 0 && ftl->free_extents[pos - 1].lpn + ftl->free_extents[pos - 1].pages == extent->lpn)
+    {
+        ftl->free_extents[pos - 1].pages += extent->pages;
+
+        if (pos < ftl->num_free_extents && extent->lpn + extent->pages == ftl->free_extents[pos].lpn)
+        {
+            ftl->free_extents[pos - 1].pages += ftl->free_extents[pos].pages;
+            (void)memmove(&ftl->free_extents[pos], &ftl->free_extents[pos + 1], (ftl->num_free_extents - pos - 1) * sizeof(SSD_ftl_extent));
+            --ftl->num_free_extents;
+        }
+    }
+    else if (pos < ftl->num_free_extents && extent->lpn + extent->pages == ftl->free_extents[pos].lpn)
+    {
+        ftl->free_extents[pos].lpn = extent->lpn;
+        ftl->free_extents[pos].pages += extent->pages;
+    }
+    else
+    {
+        if (ftl->num_free_extents == ftl->max_free_extents)
+        {
+            SSD_ftl_extent *extents = (SSD_ftl_extent *)realloc(ftl->free_extents, 2 * ftl->max_free_extents * sizeof(SSD_ftl_extent));
+
+            /* logical space is lost, but mapping is still correct */
+            if (extents == NULL)
+            {
+                extent->pages = 0;
+                return;
+            }
+
+            ftl->free_extents = extents;
+            ftl->max_free_extents *= 2;
+        }
+
+        (void)memmove(&ftl->free_extents[pos + 1], &ftl->free_extents[pos], (ftl->num_free_extents - pos) * sizeof(SSD_ftl_extent));
+        ftl->free_extents[pos] = *extent;
+        ++ftl->num_free_extents;
+    }
+
+    extent->lpn = 0;
+    extent->pages = 0;
+}
+
+double ssd_ftl_write(SSD *ssd, size_t lpn, size_t pages, bool sequential)
+{
+    SSD_ftl *ftl = ssd->ftl;
+    double time = sequential ? ssd_swrite_pages(ssd, pages) : ssd_rwrite_pages(ssd, pages);
+
+    for (size_t i = lpn; i < lpn + pages; ++i)
+    {
+        /* host needs new block, make space first */
+        if ((ftl->host_block == SSD_FTL_NONE || ftl->host_page == ftl->pages_per_block) && ftl->num_free_blocks <= ftl->reserved_blocks)
+        {
+            const double stall = ssd_ftl_gc(ssd);
+
+            ftl->stat.gc_time += stall;
+            if (stall > ftl->stat.max_gc_stall)
+                ftl->stat.max_gc_stall = stall;
+
+            time += stall;
+        }
+
+        ++ftl->clock;
+
+        if (ftl->l2p[i] != SSD_FTL_NONE)
+            ssd_ftl_invalidate(ftl, ftl->l2p[i]);
+
+        ssd_ftl_program(ftl, i, false);
+    }
+
+    ftl->stat.host_pages_written += pages;
+
+    return time;
+}
+
+double ssd_ftl_write_amplification(const SSD *ssd)
+{
+    const SSD_ftl *ftl = ssd->ftl;
+
+    if (ftl->stat.host_pages_written == 0)
+        return 0.0;
+
+    return (double)(ftl->stat.host_pages_written + ftl->stat.gc_pages_copied) / (double)ftl->stat.host_pages_written;
+}
+
+void ssd_ftl_stat_print(const SSD *ssd)
+{
+    const SSD_ftl *ftl = ssd->ftl;
+
+    printf("FTL %s\n", ftl->policy == SSD_FTL_GC_GREEDY ? "GREEDY" : "COST-BENEFIT");
+    printf("\tHOST  WRITE   PAGES    = %zu\n", ftl->stat.host_pages_written);
+    printf("\tGC    COPY    PAGES    = %zu\n", ftl->stat.gc_pages_copied);
+    printf("\tERASES                 = %zu\n", ftl->stat.erases);
+    printf("\tWL    RELOCATIONS      = %zu\n", ftl->stat.wl_relocations);
+    printf("\tWRITE AMPLIFICATION    = %lf\n", ssd_ftl_write_amplification(ssd));
+    printf("\tGC            TIME     = %lfs\n", ftl->stat.gc_time);
+    printf("\tMAX GC STALL  TIME     = %lfs\n", ftl->stat.max_gc_stall);
+}